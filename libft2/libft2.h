@@ -71,12 +71,13 @@ typedef char UNICHAR;
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 
 #define MIN_BPM 32
 #define MAX_BPM 255
 #define MAX_SPEED 31
-#define MAX_CHANNELS 32
-#define TRACK_WIDTH (5 * MAX_CHANNELS)
+#define MAX_CHANNELS 128
+#define TRACK_WIDTH(numChannels) (5 * (numChannels)) // patterns are stored at song.numChannels width
 #define C4_FREQ 8363
 #define NOTE_C4 (4*12)
 #define NOTE_OFF 97
@@ -94,6 +95,16 @@ enum // envelope flags
 	ENV_LOOP = 4
 };
 
+enum // sample flags
+{
+	LOOP_OFF = 0,
+	LOOP_FWD = 1,
+	LOOP_BIDI = 2,
+	SAMPLE_16BIT = 16,
+	SAMPLE_STEREO = 32,
+	SAMPLE_ADPCM = 64, // not an existing flag, but used by loader
+};
+
 typedef struct pattNote_t // must be packed!
 {
 	uint8_t note, instr, vol, efx, efxData;
@@ -143,13 +154,167 @@ typedef struct song_t
 	uint64_t playbackSecondsFrac;
 } song_t;
 
-extern int16_t patternNumRows[MAX_PATTERNS];
-extern song_t song;
-extern instr_t* instr[128 + 4];
-extern note_t* pattern[MAX_PATTERNS];
+/* A loaded module. Every module has its own song, instruments, samples and patterns, and
+** modules can be loaded (and read) on several threads at the same time.
+*/
+typedef struct ft2_module_t ft2_module_t;
+
+// loads an XM/MOD/S3M/STM/STK/DIGI module, returns NULL if it couldn't be loaded
+ft2_module_t* libft2_loadModule(const UNICHAR* path);
+void libft2_unloadModule(ft2_module_t* module); // frees everything in the module (NULL is allowed)
+
+/* Loads a module from memory, without going through a file. The samples are still copied
+** out of 'data' (they get decoded in place, and the mixer needs padding around them), so
+** 'data' can be freed as soon as this returns.
+*/
+ft2_module_t* libft2_loadModuleFromMemory(const void* data, size_t size);
+
+// input for libft2_loadModuleFromCallbacks(), 'user' is passed on to the callbacks
+typedef struct libft2_io_t
+{
+	size_t (*read)(void* user, void* buffer, size_t size); // returns the number of bytes read, 0 at the end (or on error)
+	int64_t (*seek)(void* user, int64_t offset, int whence); // whence = SEEK_SET/SEEK_CUR/SEEK_END, returns the new position or -1
+} libft2_io_t;
+
+/* Loads a module from any seekable stream (an archive member, a blob store...). The loaders
+** seek around in the file, so for a stream that can't seek, read it into memory and use
+** libft2_loadModuleFromMemory() instead. The loaders' reads go straight to 'read' (many of
+** them are small header reads), so a stream with slow reads should buffer them.
+*/
+ft2_module_t* libft2_loadModuleFromCallbacks(const libft2_io_t* io, void* user);
+
+/* Metadata-only loading, for when only the song/instrument/sample names, the order list, the
+** channel count and such are needed. All the headers are read, but the sample data is seeked
+** past without being read, allocated or decoded (the samples have their lengths and loops, but
+** dataPtr = NULL). The pattern data is only read if 'loadPatterns' is set, otherwise the
+** patterns are empty (XM patterns still get their lengths). Such a module plays as silence.
+**
+** S3M has no channel count in the header, so without the patterns it's the number of enabled
+** channels (a full load counts the channels that are used in the patterns).
+*/
+ft2_module_t* libft2_loadModuleMetadata(const UNICHAR* path, bool loadPatterns);
+ft2_module_t* libft2_loadModuleMetadataFromMemory(const void* data, size_t size, bool loadPatterns);
+ft2_module_t* libft2_loadModuleMetadataFromCallbacks(const libft2_io_t* io, void* user, bool loadPatterns);
+
+const song_t* libft2_getSong(const ft2_module_t* module);
+const instr_t* libft2_getInstr(const ft2_module_t* module, int32_t insNum); // insNum = 1..MAX_INST, NULL if empty
+// (the samples are prepared for the mixer, the data after the loop end is in smp.fixedSmp[] while smp.isFixed is set)
+bool libft2_hasLinearPeriods(const ft2_module_t* module); // false = Amiga periods
+
+/* Returns the pattern's notes (MAX_PATT_LEN rows at song.numChannels width), or NULL if the
+** pattern is empty. 'numRows' (if not NULL) is set to the pattern's length either way.
+*/
+const note_t* libft2_getPattern(const ft2_module_t* module, int32_t pattNum, int16_t* numRows);
+
+/* Flat copies of the song and sample metadata, with fixed-size fields only, so that they're
+** easy to mirror from other languages (f.ex. Python's ctypes, see libft2/python/libft2.py).
+*/
+typedef struct libft2_songInfo_t
+{
+	char name[20 + 1];
+	uint8_t linearPeriods; // 0 = Amiga periods
+	uint8_t orders[MAX_ORDERS];
+	int16_t numChannels, songLength, songLoopStart, BPM, speed;
+	int16_t numPatterns; // highest pattern number in use (in the order list, or with notes) + 1
+	int16_t numInstruments; // highest instrument number that exists
+	int16_t numSamples; // the number of samples that exist (have a length, a name or flags), in all instruments
+} libft2_songInfo_t;
+
+#define LIBFT2_SAMPLE_FIXED_POINTS 8 // SINC_MAX_RIGHT_TAPS in the mixer
+
+typedef struct libft2_sampleInfo_t
+{
+	/* The sample points, int8_t or int16_t (see 'bits'), NULL if the sample has no data.
+	** This points into the module (no copy), and it's the data the mixer uses: if 'isFixed'
+	** is set, the points at fixedPos.. were replaced by the loop's start (for the interpolation),
+	** and the original points are in fixedPoints[] (only the ones before 'length' are part of
+	** the sample). The data stays valid until the module is unloaded.
+	*/
+	const void* data;
+	int32_t length, loopStart, loopLength; // in sample points
+	int32_t fixedPos;
+	int16_t fixedPoints[LIBFT2_SAMPLE_FIXED_POINTS];
+	int16_t insNum, smpNum; // 1..MAX_INST, 0..MAX_SMP_PER_INST-1
+	uint8_t bits; // 8 or 16
+	uint8_t loopType; // LOOP_OFF/LOOP_FWD/LOOP_BIDI
+	uint8_t volume, panning; // 0..64, 0..255
+	int8_t finetune, relativeNote;
+	uint8_t isFixed;
+	char name[22 + 1];
+} libft2_sampleInfo_t;
+
+void libft2_getSongInfo(const ft2_module_t* module, libft2_songInfo_t* info);
+
+// returns false if the instrument doesn't exist (or is out of range), the sample may still be empty (data = NULL)
+bool libft2_getSampleInfo(const ft2_module_t* module, int32_t insNum, int32_t smpNum, libft2_sampleInfo_t* info);
+
+/* Fills 'infos' with all the samples that exist (have a length, a name or flags), in instrument
+** and sample order, and returns how many there are. At most 'maxInfos' are written, 'infos' can
+** be NULL to only count them (the count is also in libft2_songInfo_t.numSamples). After a
+** metadata-only load, the samples are listed with data = NULL.
+*/
+int32_t libft2_getSampleInfos(const ft2_module_t* module, libft2_sampleInfo_t* infos, int32_t maxInfos);
+
+/* Content fingerprints (64-bit XXH64 hashes), taken once while loading, for finding duplicate
+** songs, patterns and samples across files. They don't change between libft2 versions, and
+** they need a full load (metadata-only loads have no sample data, so the sample hashes are 0).
+**
+** Sample hash: the sample points after decoding (delta, ADPCM, stereo -> mono and such), so
+**   the same sample in an XM and in a MOD gets the same hash. 0 if the sample has no data.
+** Pattern hash: the pattern's rows at the song's channel count. An empty pattern gets the
+**   same hash as one with only empty notes.
+** Song hash: the song's structure, everything that affects playback (order list by pattern
+**   content, tempo, instrument settings and envelopes, sample hashes and settings), but no
+**   names. Two modules with the same song hash play the same.
+*/
+uint64_t libft2_getSongHash(const ft2_module_t* module);
+uint64_t libft2_getPatternHash(const ft2_module_t* module, int32_t pattNum); // 0 if pattNum is out of range
+uint64_t libft2_getSampleHash(const ft2_module_t* module, int32_t insNum, int32_t smpNum); // 0 if empty or out of range
+
+/* Optional sample pool, for keeping many modules loaded at once. When it's enabled, loaded
+** samples with the same data (by sample hash, then compared) share one refcounted buffer,
+** within a module and across modules. Only samples with the same length, loop and bit depth
+** can share a buffer, since it includes the changes done for the mixer's interpolation. The
+** pool is thread-safe, and a buffer is freed when the last module using it is unloaded.
+*/
+typedef struct libft2_samplePoolStats_t
+{
+	uint32_t numBuffers; // shared buffers in the pool
+	uint32_t numSamples; // samples using them
+	uint64_t poolBytes; // the size of the buffers
+	uint64_t savedBytes; // the memory that the samples would have used on top of that without the pool
+} libft2_samplePoolStats_t;
+
+void libft2_setSamplePooling(bool enable); // off by default, only affects modules loaded after this
+void libft2_getSamplePoolStats(libft2_samplePoolStats_t* stats);
+
+/* Changing sample data. libft2_beginSampleEdit() gives the sample its own buffer if it's shared
+** (copy on write), restores the points that were changed for the interpolation, and returns the
+** sample points (int8_t or int16_t, 'length' points) for writing, or NULL if the sample has no
+** data (or on OOM). libft2_endSampleEdit() prepares the sample for the mixer again and updates
+** the sample and song hashes. Don't edit samples of a module that is being played or read
+** on other threads.
+*/
+void* libft2_beginSampleEdit(ft2_module_t* module, int32_t insNum, int32_t smpNum);
+void libft2_endSampleEdit(ft2_module_t* module, int32_t insNum, int32_t smpNum);
 
-int libft2_loadModule(UNICHAR* path);
-void libft2_unloadModule();
+void libft2_free(void* ptr); // free() for memory returned by libft2, for callers that can't use the same C runtime
+
+// compact pattern storage (src/ft2_pattern_pack.c), useful for keeping many modules' patterns resident
+typedef struct packedPatt_t
+{
+	int16_t numRows; // last non-empty row + 1 (rows after this are empty)
+	int16_t numChannels;
+	uint16_t dataSize;
+	uint16_t* rowOffs; // numRows+1 entries, points into the same allocation
+	uint8_t* data;
+} packedPatt_t;
+
+packedPatt_t* encodePackedPattern(const note_t* patt, int32_t numChannels); // returns NULL if the pattern doesn't pack (or on OOM), free() result
+void decodePackedRow(const packedPatt_t* pp, int32_t row, note_t* dst); // dst must hold pp->numChannels notes
+void decodePackedPattern(const packedPatt_t* pp, note_t* dst); // dst must be a zeroed MAX_PATT_LEN row pattern
+bool packedRowsEmpty(const packedPatt_t* pp, int32_t numRows);
+uint32_t getPackedPatternMemSize(const packedPatt_t* pp);
 
 typedef enum libft2_NoteCommands {
 	libft2_Note_NONE = 0,
@@ -234,6 +399,30 @@ typedef struct libft2_notedata_t {
 
 void libft2_notedataFromNote(note_t* src, libft2_notedata_t* dest);
 
+/* Bulk decoding to columns, one byte per note in each column (row-major, song.numChannels
+** notes per row). The values are the same as in libft2_notedata_t. Columns that aren't
+** needed can be NULL, and aren't decoded.
+*/
+typedef struct libft2_patternColumns_t
+{
+	uint8_t *note, *inst, *volCmd, *vol, *efx, *efx_x, *efx_y;
+} libft2_patternColumns_t;
+
+/* Decodes a whole pattern, each column must hold MAX_PATT_LEN * song.numChannels bytes.
+** Returns the number of rows decoded (empty patterns are zeroed), or -1 if 'pattNum' is
+** out of range.
+*/
+int32_t libft2_decodePattern(const ft2_module_t* module, int32_t pattNum, const libft2_patternColumns_t* out);
+
+/* Decodes the patterns in the order list one after the other, each column must hold
+** libft2_getSongNumRows() * song.numChannels bytes. Returns the number of rows decoded.
+*/
+int32_t libft2_decodeSong(const ft2_module_t* module, const libft2_patternColumns_t* out);
+int32_t libft2_getSongNumRows(const ft2_module_t* module); // the total length of the patterns in the order list
+
+#include "libft2_player.h"
+#include "libft2_saver.h"
+
 
 #ifdef __cplusplus
 }
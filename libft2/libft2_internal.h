@@ -0,0 +1,29 @@
+#pragma once
+
+/* Shared between the libft2 source files, not part of the API. libft2.c gets its types from
+** libft2.h, and libft2_player.c from the tracker's headers (they're laid out the same), so
+** include this after either of them.
+*/
+
+struct ft2_module_t
+{
+	bool linearPeriodsFlag;
+	song_t song;
+	int16_t patternNumRows[MAX_PATTERNS];
+	note_t* pattern[MAX_PATTERNS];
+	instr_t* instr[1 + MAX_INST];
+
+	// content fingerprints, taken at load (see libft2_getSongHash() and friends)
+	uint64_t songHash;
+	uint64_t patternHash[MAX_PATTERNS];
+	uint64_t sampleHash[1 + MAX_INST][MAX_SMP_PER_INST];
+
+	bool sampleShared[1 + MAX_INST][MAX_SMP_PER_INST]; // the sample's buffer belongs to the sample pool (libft2_pool.c)
+};
+
+void initLibft2Tables(void); // the period -> Hz tables, needed by the loaders (thread-safe, only does it once)
+
+// the sample pool, for samples that have data and their hash set
+void poolSample(ft2_module_t* m, int32_t insNum, int32_t smpNum); // shares the buffer if pooling is enabled
+void releasePooledSample(ft2_module_t* m, int32_t insNum, int32_t smpNum); // instead of freeSmpData() for shared samples
+bool unsharePooledSample(ft2_module_t* m, int32_t insNum, int32_t smpNum); // gives the sample its own buffer again, false on OOM
@@ -0,0 +1,493 @@
+// libft2 playback (see libft2_player.h), a thin layer over the tracker's replayer and mixer
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../src/ft2_header.h"
+#include "../src/ft2_audio.h"
+#include "../src/ft2_replayer.h"
+#include "../src/ft2_structs.h"
+#include "../src/ft2_tables.h"
+#include "../src/ft2_wav_renderer.h"
+#include "../src/mixer/ft2_windowed_sinc.h"
+#include "libft2_player.h"
+#include "libft2_internal.h"
+
+#define IDLE_AUDIO_FREQ 48000 // the rate of the idle state, every player sets its own
+
+struct ft2_player_t
+{
+	const ft2_module_t* module;
+	replayerState_t* replayerState;
+	mixerState_t* mixerState;
+	uint32_t freq;
+	uint8_t interpolation;
+	int16_t amp;
+	bool looping, ended, oversampling, muted[MAX_CHANNELS];
+	float* tickBuffer; // for the part of a tick that didn't fit in the output buffer
+	uint32_t tickBufferPos, tickBufferLen, maxTickSamples;
+	uint64_t tickSamplesFrac;
+
+	// copied out at the end of every render, so that reading them doesn't need the replayer
+	libft2_playerState_t state;
+	libft2_channelState_t channels[MAX_CHANNELS];
+};
+
+static bool replayerOk;
+
+#ifdef _WIN32
+static INIT_ONCE tablesOnce = INIT_ONCE_STATIC_INIT, replayerOnce = INIT_ONCE_STATIC_INIT;
+static SRWLOCK replayerLock = SRWLOCK_INIT;
+#else
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT, replayerOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t replayerLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void initTables(void)
+{
+	calcReplayerLogTab();
+}
+
+static void initReplayer(void) // the reserved instruments, sinc tables and mixing buffers
+{
+	replayerOk = calcWindowedSincTables() && setupReplayer() && setupHeadlessAudio(IDLE_AUDIO_FREQ);
+	audio.volumeRampingFlag = true; // the tracker's default
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK initTablesOnce(PINIT_ONCE once, PVOID param, PVOID* context)
+{
+	(void)once; (void)param; (void)context;
+
+	initTables();
+	return TRUE;
+}
+
+static BOOL CALLBACK initReplayerOnce(PINIT_ONCE once, PVOID param, PVOID* context)
+{
+	(void)once; (void)param; (void)context;
+
+	initReplayer();
+	return TRUE;
+}
+#endif
+
+void initLibft2Tables(void)
+{
+#ifdef _WIN32
+	InitOnceExecuteOnce(&tablesOnce, initTablesOnce, NULL, NULL);
+#else
+	pthread_once(&tablesOnce, initTables);
+#endif
+}
+
+static bool initPlayback(void)
+{
+	initLibft2Tables();
+
+#ifdef _WIN32
+	InitOnceExecuteOnce(&replayerOnce, initReplayerOnce, NULL, NULL);
+#else
+	pthread_once(&replayerOnce, initReplayer);
+#endif
+
+	return replayerOk;
+}
+
+static void lockReplayer(void)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&replayerLock);
+#else
+	pthread_mutex_lock(&replayerLock);
+#endif
+}
+
+static void unlockReplayer(void)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&replayerLock);
+#else
+	pthread_mutex_unlock(&replayerLock);
+#endif
+}
+
+static void setModulePointers(const ft2_module_t* m) // NULL = remove the module again
+{
+	for (int32_t i = 1; i <= MAX_INST; i++)
+		instr[i] = (m != NULL) ? m->instr[i] : NULL;
+
+	for (int32_t i = 0; i < MAX_PATTERNS; i++)
+	{
+		pattern[i] = (m != NULL) ? m->pattern[i] : NULL;
+		patternNumRows[i] = (m != NULL) ? m->patternNumRows[i] : 64;
+		packedPattern[i] = NULL;
+	}
+
+	if (m != NULL)
+	{
+		audio.linearPeriodsFlag = m->linearPeriodsFlag;
+		note2Period = m->linearPeriodsFlag ? linearPeriods : amigaPeriods;
+	}
+}
+
+static void swapInPlayer(ft2_player_t* p)
+{
+	lockReplayer();
+
+	// stops the voices of the idle state, and locks/unlocks the mixer by itself (so it goes before lockAudio())
+	if (audio.interpolationType != p->interpolation)
+		audioSetInterpolationType(p->interpolation);
+
+	lockAudio();
+	setModulePointers(p->module);
+	swapReplayerState(p->replayerState);
+	swapMixerState(p->mixerState);
+	audio.oversamplingFlag = p->oversampling; // the mixer state has the rates that go with it
+}
+
+static void swapOutPlayer(ft2_player_t* p)
+{
+	swapMixerState(p->mixerState);
+	swapReplayerState(p->replayerState);
+	setModulePointers(NULL);
+	unlockAudio();
+
+	unlockReplayer();
+}
+
+static void updateChannelState(ft2_player_t* p, int32_t chNum) // player must be swapped in
+{
+	const channel_t* ch = &channel[chNum];
+	libft2_channelState_t* s = &p->channels[chNum];
+
+	s->muted = ch->channelOff;
+	s->instrNum = ch->instrNum;
+	s->smpNum = ch->smpNum;
+	s->note = ch->noteNum;
+	s->period = ch->finalPeriod;
+	s->volume = ch->outVol;
+	s->panning = ch->finalPan;
+	s->fFinalVolume = (float)ch->dFinalVol;
+	s->samplePos = getVoicePosition(chNum);
+	s->dFrequency = (s->samplePos >= 0) ? dPeriod2Hz(ch->finalPeriod) : 0.0;
+}
+
+static void updatePlayerState(ft2_player_t* p) // player must be swapped in
+{
+	libft2_playerState_t* s = &p->state;
+
+	s->songPos = song.curReplayerSongPos;
+	s->pattNum = song.curReplayerPattNum;
+	s->row = song.curReplayerRow;
+	s->BPM = song.BPM;
+	s->speed = song.speed;
+	s->globalVolume = song.globalVolume;
+	s->tick = (song.curReplayerTick <= song.speed) ? song.speed - song.curReplayerTick : 0;
+
+	for (int32_t i = 0; i < song.numChannels; i++)
+		updateChannelState(p, i);
+}
+
+static void resetPlayback(ft2_player_t* p, int16_t songPos, int16_t row) // same as the WAV renderer, player must be swapped in
+{
+	song = p->module->song;
+	song.songPos = songPos;
+	song.pattNum = song.orders[song.songPos];
+	song.currNumRows = patternNumRows[song.pattNum];
+	song.row = row;
+	song.tick = 1;
+
+	// what libft2_getPlayerState() returns before the first tick
+	song.curReplayerSongPos = (uint8_t)song.songPos;
+	song.curReplayerPattNum = (uint8_t)song.pattNum;
+	song.curReplayerRow = (uint8_t)song.row;
+	song.curReplayerTick = (uint8_t)song.speed;
+
+	playMode = PLAYMODE_SONG;
+	songPlaying = true;
+	musicPaused = false;
+
+	resetChannels();
+	resetReplayerState();
+	song.globalVolume = 64;
+	editor.wavReachedEndFlag = false;
+
+	for (int32_t i = 0; i < numAllocatedChannels; i++)
+	{
+		if (p->muted[i])
+			setChannelMute(&channel[i], true);
+
+		stopVoice(i);
+	}
+
+	resetCachedMixerVars();
+	resetAudioDither();
+	resetOversamplingFilter();
+
+	audio.freq = p->freq;
+	calcReplayerVars(audio.freq);
+	setMixerBPM(song.BPM);
+	setAudioAmp(p->amp, 256, true);
+
+	p->ended = false;
+	p->tickBufferPos = p->tickBufferLen = 0;
+	p->tickSamplesFrac = 0;
+
+	updatePlayerState(p);
+}
+
+void libft2_freePlayer(ft2_player_t* p)
+{
+	if (p == NULL)
+		return;
+
+	freeReplayerState(p->replayerState);
+	freeMixerState(p->mixerState);
+
+	if (p->tickBuffer != NULL)
+		free(p->tickBuffer);
+
+	free(p);
+}
+
+ft2_player_t* libft2_createPlayer(const ft2_module_t* module, uint32_t freq, uint8_t interpolation)
+{
+	if (module == NULL || freq < MIN_WAV_RENDER_FREQ || freq > MAX_WAV_RENDER_FREQ || interpolation > LIBFT2_INTERPOLATION_SINC16)
+		return NULL;
+
+	if (!initPlayback())
+		return NULL;
+
+	ft2_player_t* p = (ft2_player_t*)calloc(1, sizeof(ft2_player_t));
+	if (p == NULL)
+		return NULL;
+
+	p->maxTickSamples = (uint32_t)ceil(freq / (MIN_BPM / 2.5)) + 1;
+	p->tickBuffer = (float*)malloc(p->maxTickSamples * 2 * sizeof(float));
+
+	// the player's channel arrays are sized for the module, swapping the player in and out only exchanges them
+	lockReplayer();
+	p->replayerState = copyReplayerState(module->song.numChannels);
+	p->mixerState = copyMixerState(module->song.numChannels);
+	unlockReplayer();
+
+	if (p->replayerState == NULL || p->mixerState == NULL || p->tickBuffer == NULL)
+	{
+		libft2_freePlayer(p);
+		return NULL;
+	}
+
+	p->module = module;
+	p->freq = freq;
+	p->interpolation = interpolation;
+	p->amp = LIBFT2_PLAYER_DEFAULT_AMP;
+
+	swapInPlayer(p);
+	resetPlayback(p, 0, 0);
+	swapOutPlayer(p);
+
+	return p;
+}
+
+// plays the next tick, returns its length in samples (0 when the song has ended). Player must be swapped in
+static uint32_t replayTick(ft2_player_t* p)
+{
+	// F00 (speed 0) ends the song even when looping
+	const bool endOfTune = p->looping ? (song.speed == 0) : dump_EndOfTune(song.songLength - 1);
+	if (endOfTune)
+	{
+		p->ended = true;
+		return 0;
+	}
+
+	dump_TickReplayer();
+
+	uint32_t tickSamples = audio.samplesPerTickInt;
+
+	p->tickSamplesFrac += audio.samplesPerTickFrac;
+	if (p->tickSamplesFrac >= BPM_FRAC_SCALE)
+	{
+		p->tickSamplesFrac &= BPM_FRAC_MASK;
+		tickSamples++;
+	}
+
+	return tickSamples;
+}
+
+uint32_t libft2_renderPlayer(ft2_player_t* p, float* out, uint32_t numSamples)
+{
+	if (p == NULL || out == NULL)
+		return 0;
+
+	uint32_t samplesWritten = 0;
+
+	// first use what's left of the last tick
+	if (p->tickBufferPos < p->tickBufferLen)
+	{
+		samplesWritten = MIN(p->tickBufferLen - p->tickBufferPos, numSamples);
+		memcpy(out, &p->tickBuffer[p->tickBufferPos * 2], samplesWritten * 2 * sizeof(float));
+		p->tickBufferPos += samplesWritten;
+	}
+
+	if (samplesWritten >= numSamples || p->ended)
+		return samplesWritten;
+
+	swapInPlayer(p);
+
+	while (samplesWritten < numSamples)
+	{
+		const uint32_t tickSamples = replayTick(p);
+		if (tickSamples == 0)
+			break;
+
+		const uint32_t samplesLeft = numSamples - samplesWritten;
+		if (tickSamples <= samplesLeft)
+		{
+			mixReplayerTickToBuffer(tickSamples, (uint8_t*)&out[samplesWritten * 2], 32);
+			samplesWritten += tickSamples;
+		}
+		else
+		{
+			mixReplayerTickToBuffer(tickSamples, (uint8_t*)p->tickBuffer, 32);
+			memcpy(&out[samplesWritten * 2], p->tickBuffer, samplesLeft * 2 * sizeof(float));
+
+			p->tickBufferPos = samplesLeft;
+			p->tickBufferLen = tickSamples;
+			samplesWritten = numSamples;
+		}
+	}
+
+	updatePlayerState(p);
+	swapOutPlayer(p);
+
+	return samplesWritten;
+}
+
+uint32_t libft2_renderPlayerTick(ft2_player_t* p, float* out)
+{
+	if (p == NULL || out == NULL)
+		return 0;
+
+	// the rest of a tick that libft2_renderPlayer() has started
+	if (p->tickBufferPos < p->tickBufferLen)
+	{
+		const uint32_t samplesLeft = p->tickBufferLen - p->tickBufferPos;
+		memcpy(out, &p->tickBuffer[p->tickBufferPos * 2], samplesLeft * 2 * sizeof(float));
+		p->tickBufferPos = p->tickBufferLen;
+		return samplesLeft;
+	}
+
+	if (p->ended)
+		return 0;
+
+	swapInPlayer(p);
+
+	const uint32_t tickSamples = replayTick(p);
+	if (tickSamples > 0)
+		mixReplayerTickToBuffer(tickSamples, (uint8_t*)out, 32);
+
+	updatePlayerState(p);
+	swapOutPlayer(p);
+
+	return tickSamples;
+}
+
+uint32_t libft2_getMaxTickSamples(const ft2_player_t* p)
+{
+	return (p != NULL) ? p->maxTickSamples : 0;
+}
+
+bool libft2_setPlayerPos(ft2_player_t* p, int16_t songPos, int16_t row)
+{
+	if (p == NULL)
+		return false;
+
+	const song_t* s = &p->module->song;
+	if (songPos < 0 || songPos >= s->songLength || row < 0 || row >= p->module->patternNumRows[s->orders[songPos]])
+		return false;
+
+	swapInPlayer(p);
+	resetPlayback(p, songPos, row);
+	swapOutPlayer(p);
+
+	return true;
+}
+
+void libft2_setPlayerChannelMute(ft2_player_t* p, int32_t chNum, bool mute)
+{
+	if (p == NULL || chNum < 0 || chNum >= MAX_CHANNELS)
+		return;
+
+	p->muted[chNum] = mute;
+	if (chNum >= p->module->song.numChannels)
+	{
+		p->channels[chNum].muted = mute; // not in the song, the player has no channel for it
+		return;
+	}
+
+	swapInPlayer(p);
+	setChannelMute(&channel[chNum], mute);
+	updateChannelState(p, chNum);
+	swapOutPlayer(p);
+}
+
+void libft2_setPlayerLooping(ft2_player_t* p, bool looping)
+{
+	if (p == NULL)
+		return;
+
+	p->looping = looping;
+}
+
+void libft2_setPlayerAmp(ft2_player_t* p, int16_t amp)
+{
+	if (p == NULL)
+		return;
+
+	p->amp = CLAMP(amp, 1, 32);
+
+	swapInPlayer(p);
+	setAudioAmp(p->amp, 256, true);
+	swapOutPlayer(p);
+}
+
+void libft2_setPlayerOversampling(ft2_player_t* p, bool oversampling)
+{
+	if (p == NULL)
+		return;
+
+	swapInPlayer(p);
+
+	// same as audioSetOversampling(), for this player only
+	p->oversampling = audio.oversamplingFlag = oversampling;
+	calcReplayerVars(audio.freq);
+	setMixerBPM(song.BPM);
+	resetCachedMixerVars();
+	resetOversamplingFilter();
+
+	swapOutPlayer(p);
+}
+
+void libft2_getPlayerState(const ft2_player_t* p, libft2_playerState_t* state)
+{
+	if (p == NULL || state == NULL)
+		return;
+
+	*state = p->state;
+	state->ended = p->ended && p->tickBufferPos >= p->tickBufferLen;
+}
+
+bool libft2_getChannelState(const ft2_player_t* p, int32_t chNum, libft2_channelState_t* state)
+{
+	if (p == NULL || state == NULL || chNum < 0 || chNum >= MAX_CHANNELS)
+		return false;
+
+	*state = p->channels[chNum];
+	return true;
+}
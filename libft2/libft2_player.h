@@ -0,0 +1,89 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Playback of loaded modules, with the tracker's own replayer and mixer (bit-exact to
+** the tracker's WAV renderer at the same settings).
+**
+** Players can be created and used on any thread, and several players can share one
+** module. The replayer's state is global though, so the players take turns: only one
+** libft2_renderPlayer() call runs at a time, and the others wait for it. The module
+** must not be unloaded while it has players.
+*/
+
+typedef struct ft2_module_t ft2_module_t;
+typedef struct ft2_player_t ft2_player_t;
+
+enum // interpolation, same values as the tracker's config
+{
+	LIBFT2_INTERPOLATION_NONE = 0,
+	LIBFT2_INTERPOLATION_SINC8 = 1,
+	LIBFT2_INTERPOLATION_LINEAR = 2,
+	LIBFT2_INTERPOLATION_SINC16 = 3
+};
+
+#define LIBFT2_PLAYER_MIN_FREQ 44100
+#define LIBFT2_PLAYER_DEFAULT_AMP 10 // same as the tracker's default
+
+typedef struct libft2_playerState_t
+{
+	bool ended;
+	int16_t songPos, pattNum, row; // the row that was played last
+	uint16_t BPM, speed, globalVolume, tick; // tick = 0..speed-1
+} libft2_playerState_t;
+
+typedef struct libft2_channelState_t
+{
+	bool muted;
+	uint8_t instrNum, smpNum, note; // note = 1..96 (last played note), 0 = none yet
+	uint16_t period; // the final period (with vibrato, arpeggio, portamento etc.), linear or Amiga
+	uint8_t volume, panning; // volume = 0..64, panning = 0..255
+	float fFinalVolume; // with the envelopes, fadeout and global volume applied (0.0f..1.0f)
+	double dFrequency; // sampling rate in Hz, 0.0 if the channel isn't playing
+	int32_t samplePos; // in sample points, -1 if the channel isn't playing
+} libft2_channelState_t;
+
+/* Returns NULL if 'freq' (the output rate) is out of range (LIBFT2_PLAYER_MIN_FREQ up to
+** 384000, or 48000 on 32-bit builds), or on OOM. Playback starts at the first song position,
+** without looping.
+*/
+ft2_player_t* libft2_createPlayer(const ft2_module_t* module, uint32_t freq, uint8_t interpolation);
+void libft2_freePlayer(ft2_player_t* player); // NULL is allowed
+
+/* Renders 'numSamples' stereo sample frames to 'out' (interleaved L/R floats, nominal range
+** -1.0f..1.0f, not clipped). Returns less than 'numSamples' when the song has ended.
+*/
+uint32_t libft2_renderPlayer(ft2_player_t* player, float* out, uint32_t numSamples);
+
+/* Renders exactly one replayer tick (or what's left of a tick that libft2_renderPlayer() has
+** started), so that the state can be read after every tick. 'out' must have room for
+** libft2_getMaxTickSamples() stereo frames. Returns the number of frames, 0 when the song has ended.
+*/
+uint32_t libft2_renderPlayerTick(ft2_player_t* player, float* out);
+uint32_t libft2_getMaxTickSamples(const ft2_player_t* player);
+
+// restarts playback at 'songPos'/'row' (the channels are reset, like when starting playback in the tracker)
+bool libft2_setPlayerPos(ft2_player_t* player, int16_t songPos, int16_t row);
+void libft2_setPlayerChannelMute(ft2_player_t* player, int32_t chNum, bool mute); // chNum = 0..MAX_CHANNELS-1
+void libft2_setPlayerLooping(ft2_player_t* player, bool looping); // loop the song instead of ending at its end
+void libft2_setPlayerAmp(ft2_player_t* player, int16_t amp); // 1..32
+
+/* Mixes the voices at twice the output rate and decimates with a half-band filter (off by
+** default). Adds 31.5 samples of delay and roughly doubles the mixing time. It only helps the
+** notes played faster than the output rate, a sinc interpolator without it is both cleaner and
+** cheaper than linear with it (measured by libft2/tools/libft2_aliasing.c).
+*/
+void libft2_setPlayerOversampling(ft2_player_t* player, bool oversampling);
+
+// the state after the last libft2_renderPlayer() call (or seek)
+void libft2_getPlayerState(const ft2_player_t* player, libft2_playerState_t* state);
+bool libft2_getChannelState(const ft2_player_t* player, int32_t chNum, libft2_channelState_t* state); // false if chNum is out of range
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,285 @@
+// libft2's shared sample pool (see libft2_setSamplePooling() in libft2.h)
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libft2.h"
+#include "libft2_internal.h"
+
+// the same as in libft2.c and the mixer
+#define SINC_MAX_TAPS 16
+#define SINC_MAX_LEFT_TAPS ((SINC_MAX_TAPS/2)-1)
+#define SINC_MAX_RIGHT_TAPS (SINC_MAX_TAPS/2)
+#define SMP_DAT_OFFSET ((SINC_MAX_LEFT_TAPS*2)+1)
+#define SAMPLE_PAD_LENGTH (SMP_DAT_OFFSET+(SINC_MAX_RIGHT_TAPS*2))
+
+#define POOL_BUCKETS 4096 // power of two
+
+/* One shared sample buffer. The buffer includes the changes done by fixSample(), so only
+** samples with the same data, length, loop and bit depth can share it. The original points
+** that fixSample() replaced are kept in every sample_t (fixedSmp[]), and also here so that
+** they can be compared.
+*/
+typedef struct poolEntry_t
+{
+	struct poolEntry_t* next;
+	uint64_t dataHash; // the sample hash (libft2_getSampleHash())
+	int8_t* origDataPtr;
+	int32_t refCount, length, loopStart, loopLength;
+	uint8_t flags;
+	bool isFixed;
+	int16_t fixedSmp[SINC_MAX_RIGHT_TAPS];
+} poolEntry_t;
+
+static bool poolEnabled;
+static poolEntry_t* buckets[POOL_BUCKETS];
+static uint32_t numBuffers, numSamples;
+static uint64_t poolBytes, savedBytes;
+
+#ifdef _WIN32
+static SRWLOCK poolLock = SRWLOCK_INIT;
+#else
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void lockPool(void)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&poolLock);
+#else
+	pthread_mutex_lock(&poolLock);
+#endif
+}
+
+static void unlockPool(void)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&poolLock);
+#else
+	pthread_mutex_unlock(&poolLock);
+#endif
+}
+
+#define POOL_FLAGS(smpFlags) ((smpFlags) & (LOOP_FWD | LOOP_BIDI | SAMPLE_16BIT))
+
+static size_t getBufferSize(const sample_t* s)
+{
+	return ((size_t)s->length << !!(s->flags & SAMPLE_16BIT)) + SAMPLE_PAD_LENGTH;
+}
+
+static bool sameSample(const poolEntry_t* e, const sample_t* s, uint64_t dataHash)
+{
+	if (e->dataHash != dataHash || e->length != s->length || e->loopStart != s->loopStart ||
+		e->loopLength != s->loopLength || e->flags != POOL_FLAGS(s->flags) || e->isFixed != s->isFixed)
+	{
+		return false;
+	}
+
+	if (s->isFixed) // the replaced points, the ones after the sample's end come from the pad bytes and aren't set
+	{
+		for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS && s->fixedPos+i < s->length; i++)
+		{
+			if (e->fixedSmp[i] != s->fixedSmp[i])
+				return false;
+		}
+	}
+
+	/* The sample and the points that fixSample() has set: the left taps, and the right taps
+	** after the end, or after the loop end for looping samples. The pad bytes outside of that
+	** are never set (or read by the mixer).
+	*/
+	int32_t end = s->length + SINC_MAX_RIGHT_TAPS;
+	if (s->isFixed)
+	{
+		end = s->fixedPos + SINC_MAX_RIGHT_TAPS;
+		if (end < s->length)
+			end = s->length;
+	}
+
+	const int32_t bitShift = !!(s->flags & SAMPLE_16BIT);
+	const size_t offset = SMP_DAT_OFFSET - (SINC_MAX_LEFT_TAPS << bitShift);
+	const size_t size = (size_t)(SINC_MAX_LEFT_TAPS + end) << bitShift;
+
+	return memcmp(e->origDataPtr + offset, s->origDataPtr + offset, size) == 0;
+}
+
+static poolEntry_t** findEntry(const sample_t* s, uint64_t dataHash) // by buffer, returns the link to it
+{
+	poolEntry_t** link = &buckets[dataHash & (POOL_BUCKETS-1)];
+	while (*link != NULL && (*link)->origDataPtr != s->origDataPtr)
+		link = &(*link)->next;
+
+	return link;
+}
+
+void libft2_setSamplePooling(bool enable)
+{
+	lockPool();
+	poolEnabled = enable;
+	unlockPool();
+}
+
+void libft2_getSamplePoolStats(libft2_samplePoolStats_t* stats)
+{
+	lockPool();
+	stats->numBuffers = numBuffers;
+	stats->numSamples = numSamples;
+	stats->poolBytes = poolBytes;
+	stats->savedBytes = savedBytes;
+	unlockPool();
+}
+
+void poolSample(ft2_module_t* m, int32_t insNum, int32_t smpNum)
+{
+	sample_t* s = &m->instr[insNum]->smp[smpNum];
+	const uint64_t dataHash = m->sampleHash[insNum][smpNum];
+
+	if (s->dataPtr == NULL || s->length <= 0)
+		return;
+
+	lockPool();
+
+	if (!poolEnabled)
+	{
+		unlockPool();
+		return;
+	}
+
+	const size_t bufferSize = getBufferSize(s);
+
+	poolEntry_t** bucket = &buckets[dataHash & (POOL_BUCKETS-1)];
+	for (poolEntry_t* e = *bucket; e != NULL; e = e->next)
+	{
+		if (sameSample(e, s, dataHash))
+		{
+			e->refCount++;
+			numSamples++;
+			savedBytes += bufferSize;
+			unlockPool();
+
+			free(s->origDataPtr);
+			s->origDataPtr = e->origDataPtr;
+			s->dataPtr = s->origDataPtr + SMP_DAT_OFFSET;
+			m->sampleShared[insNum][smpNum] = true;
+			return;
+		}
+	}
+
+	// not in the pool yet, this sample's buffer becomes the shared one
+	poolEntry_t* e = (poolEntry_t*)malloc(sizeof(poolEntry_t));
+	if (e == NULL) // the sample keeps its own buffer
+	{
+		unlockPool();
+		return;
+	}
+
+	e->dataHash = dataHash;
+	e->origDataPtr = s->origDataPtr;
+	e->refCount = 1;
+	e->length = s->length;
+	e->loopStart = s->loopStart;
+	e->loopLength = s->loopLength;
+	e->flags = POOL_FLAGS(s->flags);
+	e->isFixed = s->isFixed;
+	memcpy(e->fixedSmp, s->fixedSmp, sizeof(e->fixedSmp));
+
+	e->next = *bucket;
+	*bucket = e;
+
+	numBuffers++;
+	numSamples++;
+	poolBytes += bufferSize;
+
+	unlockPool();
+
+	m->sampleShared[insNum][smpNum] = true;
+}
+
+void releasePooledSample(ft2_module_t* m, int32_t insNum, int32_t smpNum)
+{
+	sample_t* s = &m->instr[insNum]->smp[smpNum];
+	const size_t bufferSize = getBufferSize(s);
+
+	lockPool();
+
+	poolEntry_t** link = findEntry(s, m->sampleHash[insNum][smpNum]);
+	poolEntry_t* e = *link;
+
+	numSamples--;
+	if (--e->refCount > 0)
+	{
+		savedBytes -= bufferSize;
+		e = NULL;
+	}
+	else
+	{
+		*link = e->next;
+		numBuffers--;
+		poolBytes -= bufferSize;
+	}
+
+	unlockPool();
+
+	if (e != NULL) // last user
+	{
+		free(e->origDataPtr);
+		free(e);
+	}
+
+	s->origDataPtr = NULL;
+	s->dataPtr = NULL;
+	m->sampleShared[insNum][smpNum] = false;
+}
+
+bool unsharePooledSample(ft2_module_t* m, int32_t insNum, int32_t smpNum)
+{
+	sample_t* s = &m->instr[insNum]->smp[smpNum];
+	const size_t bufferSize = getBufferSize(s);
+
+	if (!m->sampleShared[insNum][smpNum])
+		return true;
+
+	lockPool();
+
+	poolEntry_t** link = findEntry(s, m->sampleHash[insNum][smpNum]);
+	poolEntry_t* e = *link;
+
+	if (e->refCount == 1) // only used here, take the buffer out of the pool
+	{
+		*link = e->next;
+		numBuffers--;
+		numSamples--;
+		poolBytes -= bufferSize;
+		unlockPool();
+
+		free(e);
+	}
+	else // copy on write
+	{
+		int8_t* newData = (int8_t*)malloc(bufferSize);
+		if (newData == NULL)
+		{
+			unlockPool();
+			return false;
+		}
+
+		memcpy(newData, e->origDataPtr, bufferSize);
+		e->refCount--;
+		numSamples--;
+		savedBytes -= bufferSize;
+		unlockPool();
+
+		s->origDataPtr = newData;
+		s->dataPtr = s->origDataPtr + SMP_DAT_OFFSET;
+	}
+
+	m->sampleShared[insNum][smpNum] = false;
+	return true;
+}
@@ -0,0 +1,756 @@
+// libft2 module saving (see libft2_saver.h), the tracker's XM/MOD savers (ft2_module_saver.c) without the GUI
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/ft2_header.h"
+#include "../src/ft2_replayer.h"
+#include "../src/ft2_tables.h"
+#include "../src/ft2_pattern_pack.h"
+#include "libft2_saver.h"
+#include "libft2_internal.h"
+
+#define SMP_CHUNK_LEN 1024 // sample points per write
+
+typedef struct writer_t
+{
+	libft2_writeFunc_t write;
+	void* user;
+} writer_t;
+
+typedef struct memWriter_t
+{
+	uint8_t* data;
+	size_t size, capacity;
+} memWriter_t;
+
+static const char modIDs[32][5] =
+{
+	"1CHN", "2CHN", "3CHN", "4CHN", "5CHN", "6CHN", "7CHN", "8CHN",
+	"9CHN", "10CH", "11CH", "12CH", "13CH", "14CH", "15CH", "16CH",
+	"17CH", "18CH", "19CH", "20CH", "21CH", "22CH", "23CH", "24CH",
+	"25CH", "26CH", "27CH", "28CH", "29CH", "30CH", "31CH", "32CH"
+};
+
+static bool writeData(const writer_t* w, const void* data, size_t size)
+{
+	return size == 0 || w->write(w->user, data, size) == size;
+}
+
+static size_t writeToMemory(void* user, const void* data, size_t size)
+{
+	memWriter_t* mw = (memWriter_t*)user;
+
+	if (mw->size + size > mw->capacity) // only if the size bound was wrong
+	{
+		size_t newCapacity = mw->capacity * 2;
+		if (newCapacity < mw->size + size)
+			newCapacity = mw->size + size;
+
+		uint8_t* newData = (uint8_t*)realloc(mw->data, newCapacity);
+		if (newData == NULL)
+			return 0;
+
+		mw->data = newData;
+		mw->capacity = newCapacity;
+	}
+
+	memcpy(&mw->data[mw->size], data, size);
+	mw->size += size;
+
+	return size;
+}
+
+// the same as getUsedSamples()/getRealUsedSamples()/patternEmpty() in ft2_replayer.c, on a module
+
+static int16_t getModuleUsedSamples(const ft2_module_t* m, int32_t insNum)
+{
+	const instr_t* ins = m->instr[insNum];
+	if (ins == NULL)
+		return 0;
+
+	int16_t i = 16 - 1;
+	while (i >= 0 && ins->smp[i].dataPtr == NULL && ins->smp[i].name[0] == '\0')
+		i--;
+
+	for (int16_t j = 0; j < 96; j++)
+	{
+		if (ins->note2SampleLUT[j] > i)
+			i = ins->note2SampleLUT[j];
+	}
+
+	return i+1;
+}
+
+static int16_t getModuleRealUsedSamples(const ft2_module_t* m, int32_t insNum)
+{
+	const instr_t* ins = m->instr[insNum];
+	if (ins == NULL)
+		return 0;
+
+	int16_t i = 16 - 1;
+	while (i >= 0 && ins->smp[i].dataPtr == NULL)
+		i--;
+
+	return i+1;
+}
+
+static bool modulePatternEmpty(const ft2_module_t* m, int32_t pattNum)
+{
+	const uint8_t* scanPtr = (const uint8_t*)m->pattern[pattNum];
+	if (scanPtr == NULL)
+		return true;
+
+	const uint32_t scanLen = m->patternNumRows[pattNum] * TRACK_WIDTH(m->song.numChannels);
+	for (uint32_t i = 0; i < scanLen; i++)
+	{
+		if (scanPtr[i] != 0)
+			return false;
+	}
+
+	return true;
+}
+
+/* Copies sample points from the module without unfixing the sample first (like the
+** tracker does), so that the module can be saved while it's in use.
+*/
+static void getSampleChunk(const sample_t* s, int32_t pos, int32_t length, void* dst)
+{
+	const bool sample16Bit = !!(s->flags & SAMPLE_16BIT);
+	memcpy(dst, &s->dataPtr[pos << sample16Bit], length << sample16Bit);
+
+	if (!s->isFixed || s->fixedPos+SINC_MAX_RIGHT_TAPS <= pos || s->fixedPos >= pos+length)
+		return;
+
+	// put back the sample points that fixSample() replaced
+	for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
+	{
+		const int32_t dstPos = (s->fixedPos + i) - pos;
+		if (dstPos < 0 || dstPos >= length)
+			continue;
+
+		if (sample16Bit)
+			((int16_t*)dst)[dstPos] = s->fixedSmp[i];
+		else
+			((int8_t*)dst)[dstPos] = (int8_t)s->fixedSmp[i];
+	}
+}
+
+static bool writeXMSampleData(const writer_t* w, const sample_t* s) // delta encoded, like samp2Delta()
+{
+	int16_t buf[SMP_CHUNK_LEN];
+
+	const bool sample16Bit = !!(s->flags & SAMPLE_16BIT);
+	int16_t prev16 = 0;
+	int8_t prev8 = 0;
+
+	for (int32_t pos = 0; pos < s->length; pos += SMP_CHUNK_LEN)
+	{
+		const int32_t length = MIN(SMP_CHUNK_LEN, s->length - pos);
+		getSampleChunk(s, pos, length, buf);
+
+		if (sample16Bit)
+		{
+			for (int32_t i = 0; i < length; i++)
+			{
+				const int16_t smp16 = buf[i];
+				buf[i] -= prev16;
+				prev16 = smp16;
+			}
+		}
+		else
+		{
+			int8_t* buf8 = (int8_t*)buf;
+			for (int32_t i = 0; i < length; i++)
+			{
+				const int8_t smp8 = buf8[i];
+				buf8[i] -= prev8;
+				prev8 = smp8;
+			}
+		}
+
+		if (!writeData(w, buf, length << sample16Bit))
+			return false;
+	}
+
+	return true;
+}
+
+static bool writeMODSampleData(const writer_t* w, const sample_t* s, int32_t sampleBytes) // 8-bit
+{
+	int16_t buf[SMP_CHUNK_LEN];
+
+	const bool sample16Bit = !!(s->flags & SAMPLE_16BIT);
+
+	for (int32_t pos = 0; pos < sampleBytes; pos += SMP_CHUNK_LEN)
+	{
+		const int32_t length = MIN(SMP_CHUNK_LEN, sampleBytes - pos);
+		getSampleChunk(s, pos, length, buf);
+
+		if (sample16Bit) // convert 16-bit to 8-bit
+		{
+			int8_t* buf8 = (int8_t*)buf;
+			for (int32_t i = 0; i < length; i++)
+				buf8[i] = buf[i] >> 8;
+		}
+
+		if (!writeData(w, buf, length))
+			return false;
+	}
+
+	return true;
+}
+
+static int32_t getXMNumPatterns(const ft2_module_t* m)
+{
+	int32_t i = MAX_PATTERNS;
+	while (i > 0 && modulePatternEmpty(m, i-1))
+		i--;
+
+	return i;
+}
+
+static int32_t getXMNumInstr(const ft2_module_t* m)
+{
+	int32_t i = MAX_INST;
+	while (i > 0 && getModuleUsedSamples(m, i) == 0 && m->song.instrName[i][0] == '\0')
+		i--;
+
+	return i;
+}
+
+static size_t getXMSizeBound(const ft2_module_t* m)
+{
+	size_t size = sizeof(xmHdr_t);
+
+	const int32_t numPatterns = getXMNumPatterns(m);
+	for (int32_t i = 0; i < numPatterns; i++)
+	{
+		size += sizeof(xmPatHdr_t);
+		if (m->pattern[i] != NULL)
+			size += XM_PACKED_NOTES_BOUND(m->patternNumRows[i] * m->song.numChannels);
+	}
+
+	const int32_t numInstr = getXMNumInstr(m);
+	for (int32_t i = 1; i <= numInstr; i++)
+	{
+		const int16_t numSamples = getModuleUsedSamples(m, i);
+
+		size += INSTR_HEADER_SIZE + (numSamples * sizeof(xmSmpHdr_t));
+		for (int32_t j = 0; j < numSamples; j++)
+		{
+			const sample_t* s = &m->instr[i]->smp[j];
+			if (s->dataPtr != NULL)
+				size += SAMPLE_LENGTH_BYTES(s);
+		}
+	}
+
+	return size;
+}
+
+static bool saveXM(const ft2_module_t* m, const writer_t* w)
+{
+	xmHdr_t h;
+	xmPatHdr_t ph;
+	xmInsHdr_t ih;
+
+	const song_t* song = &m->song;
+	if (song->numChannels > MAX_XM_CHANNELS)
+		return false;
+
+	memcpy(h.ID, "Extended Module: ", 17);
+
+	// song name
+	int32_t nameLength = (int32_t)strlen(song->name);
+	if (nameLength > 20)
+		nameLength = 20;
+
+	memset(h.name, ' ', 20); // yes, FT2 pads the name with spaces
+	if (nameLength > 0)
+		memcpy(h.name, song->name, nameLength);
+
+	h.x1A = 0x1A;
+
+	// program/tracker name
+	nameLength = (int32_t)strlen(PROG_NAME_STR);
+	if (nameLength > 20)
+		nameLength = 20;
+
+	memset(h.progName, ' ', 20); // yes, FT2 pads the name with spaces
+	if (nameLength > 0)
+		memcpy(h.progName, PROG_NAME_STR, nameLength);
+
+	h.version = 0x0104;
+	h.headerSize = 20 + 256;
+	h.numOrders = song->songLength;
+	h.songLoopStart = song->songLoopStart;
+	h.numChannels = (uint16_t)song->numChannels;
+	h.speed = song->speed;
+	h.BPM = song->BPM;
+	h.numPatterns = (uint16_t)getXMNumPatterns(m);
+	h.numInstr = (uint16_t)getXMNumInstr(m);
+	h.flags = m->linearPeriodsFlag;
+	memcpy(h.orders, song->orders, 256);
+
+	if (!writeData(w, &h, sizeof(h)))
+		return false;
+
+	// all of a pattern is packed in one go (the notes are stored at song width), into a buffer of the worst case size
+	uint8_t* packedPattData = (uint8_t*)malloc(XM_PACKED_NOTES_BOUND(MAX_PATT_LEN * MAX_XM_CHANNELS));
+	if (packedPattData == NULL)
+		return false;
+
+	for (int32_t i = 0; i < h.numPatterns; i++)
+	{
+		ph.headerSize = sizeof(xmPatHdr_t);
+		ph.type = 0;
+
+		if (modulePatternEmpty(m, i)) // the tracker frees empty patterns and sets their length to 64 when saving
+		{
+			ph.numRows = 64;
+			ph.dataSize = 0;
+		}
+		else
+		{
+			ph.numRows = m->patternNumRows[i];
+			ph.dataSize = (uint16_t)packXMNotes(m->pattern[i], ph.numRows * song->numChannels, packedPattData);
+		}
+
+		if (!writeData(w, &ph, ph.headerSize) || !writeData(w, packedPattData, ph.dataSize))
+		{
+			free(packedPattData);
+			return false;
+		}
+	}
+
+	free(packedPattData);
+
+	for (int32_t i = 1; i <= h.numInstr; i++)
+	{
+		memset(&ih, 0, sizeof(ih)); // important, clears reserved stuff
+
+		const int16_t numSamples = getModuleUsedSamples(m, i);
+		const instr_t* ins = m->instr[i];
+
+		nameLength = (int32_t)strlen(song->instrName[i]);
+		if (nameLength > 22)
+			nameLength = 22;
+
+		if (nameLength > 0)
+			memcpy(ih.name, song->instrName[i], nameLength); // padded with zeroes
+
+		ih.type = 0;
+		ih.numSamples = numSamples;
+		ih.sampleSize = sizeof(xmSmpHdr_t);
+
+		if (numSamples > 0)
+		{
+			memcpy(ih.note2SampleLUT, ins->note2SampleLUT, 96);
+			memcpy(ih.volEnvPoints, ins->volEnvPoints, 12*2*sizeof(int16_t));
+			memcpy(ih.panEnvPoints, ins->panEnvPoints, 12*2*sizeof(int16_t));
+			ih.volEnvLength = ins->volEnvLength;
+			ih.panEnvLength = ins->panEnvLength;
+			ih.volEnvSustain = ins->volEnvSustain;
+			ih.volEnvLoopStart = ins->volEnvLoopStart;
+			ih.volEnvLoopEnd = ins->volEnvLoopEnd;
+			ih.panEnvSustain = ins->panEnvSustain;
+			ih.panEnvLoopStart = ins->panEnvLoopStart;
+			ih.panEnvLoopEnd = ins->panEnvLoopEnd;
+			ih.volEnvFlags = ins->volEnvFlags;
+			ih.panEnvFlags = ins->panEnvFlags;
+			ih.vibType = ins->autoVibType;
+			ih.vibSweep = ins->autoVibSweep;
+			ih.vibDepth = ins->autoVibDepth;
+			ih.vibRate = ins->autoVibRate;
+			ih.fadeout = ins->fadeout;
+			ih.midiOn = ins->midiOn ? 1 : 0;
+			ih.midiChannel = ins->midiChannel;
+			ih.midiProgram = ins->midiProgram;
+			ih.midiBend = ins->midiBend;
+			ih.mute = ins->mute ? 1 : 0;
+			ih.instrSize = INSTR_HEADER_SIZE;
+
+			for (int32_t j = 0; j < numSamples; j++)
+			{
+				const sample_t* s = &ins->smp[j];
+				xmSmpHdr_t* dst = &ih.smp[j];
+
+				const bool sample16Bit = !!(s->flags & SAMPLE_16BIT);
+
+				dst->length = s->length << sample16Bit;
+				dst->loopStart = s->loopStart << sample16Bit;
+				dst->loopLength = s->loopLength << sample16Bit;
+				dst->volume = s->volume;
+				dst->finetune = s->finetune;
+				dst->flags = s->flags;
+				dst->panning = s->panning;
+				dst->relativeNote = s->relativeNote;
+
+				nameLength = (int32_t)strlen(s->name);
+				if (nameLength > 22)
+					nameLength = 22;
+
+				dst->nameLength = (uint8_t)nameLength;
+
+				memset(dst->name, ' ', 22); // yes, FT2 pads the name with spaces
+				if (nameLength > 0)
+					memcpy(dst->name, s->name, nameLength);
+
+				if (s->dataPtr == NULL)
+					dst->length = 0;
+			}
+		}
+		else
+		{
+			ih.instrSize = 22 + 11;
+		}
+
+		if (!writeData(w, &ih, ih.instrSize + (numSamples * sizeof(xmSmpHdr_t))))
+			return false;
+
+		for (int32_t j = 0; j < numSamples; j++)
+		{
+			const sample_t* s = &ins->smp[j];
+			if (s->dataPtr != NULL && !writeXMSampleData(w, s))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static int32_t getMODSongLength(const ft2_module_t* m)
+{
+	return MIN(m->song.songLength, 128);
+}
+
+static int32_t getMODNumPatterns(const ft2_module_t* m) // the number of patterns referenced (max 128 orders)
+{
+	int32_t numPatterns = 0;
+
+	const int32_t songLength = getMODSongLength(m);
+	for (int32_t i = 0; i < songLength; i++)
+	{
+		if (m->song.orders[i] > numPatterns)
+			numPatterns = m->song.orders[i];
+	}
+	numPatterns++;
+
+	return numPatterns;
+}
+
+static size_t getMODSizeBound(const ft2_module_t* m)
+{
+	size_t size = sizeof(modHdr_t) + (MIN(getMODNumPatterns(m), 100) * m->song.numChannels * 64 * 4);
+
+	for (int32_t i = 1; i <= 31; i++)
+	{
+		if (getModuleRealUsedSamples(m, i) > 0)
+			size += MIN(m->instr[i]->smp[0].length, 131070);
+	}
+
+	return size;
+}
+
+static bool saveMOD(const ft2_module_t* m, const writer_t* w, uint32_t* warnings)
+{
+	modHdr_t hdr;
+	uint8_t modPattData[64*32*4];
+
+	const song_t* song = &m->song;
+	if (song->numChannels > MAX_XM_CHANNELS)
+		return false;
+
+	*warnings = 0;
+
+	const int32_t songLength = getMODSongLength(m);
+	if (song->songLength > 128)
+		*warnings |= LIBFT2_MOD_WARN_SONG_LENGTH;
+
+	int32_t numPatterns = getMODNumPatterns(m);
+	if (numPatterns > 100)
+	{
+		numPatterns = 100;
+		*warnings |= LIBFT2_MOD_WARN_NUM_PATTERNS;
+	}
+
+	// check if song has more than 31 instruments
+	for (int32_t i = 32; i <= MAX_INST; i++)
+	{
+		if (getModuleRealUsedSamples(m, i) > 0)
+		{
+			*warnings |= LIBFT2_MOD_WARN_NUM_INSTRUMENTS;
+			break;
+		}
+	}
+
+	// check if the first 31 samples have a length above 65534 samples, and if XM instrument features are being used
+	for (int32_t i = 1; i <= 31; i++)
+	{
+		const instr_t* ins = m->instr[i];
+		if (ins == NULL)
+			continue;
+
+		const sample_t* smp = &ins->smp[0];
+
+		if (smp->length > 131070)
+			*warnings |= LIBFT2_MOD_WARN_SAMPLE_LENGTH;
+		else if (smp->length > 65534)
+			*warnings |= LIBFT2_MOD_WARN_SAMPLE_LENGTH_65534;
+
+		const int16_t numSamples = getModuleRealUsedSamples(m, i);
+		if (numSamples > 1 || (numSamples == 1 && (ins->fadeout != 0 || ins->volEnvFlags != 0 || ins->panEnvFlags != 0 ||
+			ins->autoVibRate > 0 || GET_LOOPTYPE(smp->flags) == LOOP_BIDI || smp->relativeNote != 0 || ins->midiOn)))
+		{
+			*warnings |= LIBFT2_MOD_WARN_XM_FEATURES;
+		}
+	}
+
+	if (*warnings & LIBFT2_MOD_WARN_SAMPLE_LENGTH) // the tracker only shows the worst one
+		*warnings &= ~LIBFT2_MOD_WARN_SAMPLE_LENGTH_65534;
+
+	for (int32_t i = 0; i < numPatterns; i++)
+	{
+		if (m->pattern[i] == NULL)
+			continue;
+
+		if (m->patternNumRows[i] < 64)
+			return false;
+
+		if (m->patternNumRows[i] > 64)
+			*warnings |= LIBFT2_MOD_WARN_PATTERN_LENGTH;
+
+		const note_t* p = m->pattern[i];
+		for (int32_t j = 0; j < 64 * song->numChannels; j++, p++)
+		{
+			if (p->instr > 31)
+				*warnings |= LIBFT2_MOD_WARN_PATTERN_INSTRUMENTS;
+
+			if (p->efx > 0xF || p->vol != 0)
+				*warnings |= LIBFT2_MOD_WARN_PATTERN_EFFECTS;
+
+			// added security that wasn't present in FT2
+			if (p->note > 0 && p->note < 10)
+				*warnings |= LIBFT2_MOD_WARN_PATTERN_NOTES;
+		}
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+
+	// song name
+	int32_t nameLength = (int32_t)strlen(song->name);
+	if (nameLength > 20)
+		nameLength = 20;
+
+	if (nameLength > 0)
+		memcpy(hdr.name, song->name, nameLength); // padded with zeroes
+
+	hdr.numOrders = (uint8_t)songLength; // pre-clamped to 0..128
+
+	hdr.songLoopStart = (uint8_t)song->songLoopStart;
+	if (hdr.songLoopStart >= hdr.numOrders) // repeat-point must be lower than the song length
+		hdr.songLoopStart = 0;
+
+	memcpy(hdr.orders, song->orders, hdr.numOrders);
+
+	if (song->numChannels == 4)
+		memcpy(hdr.ID, (numPatterns > 64) ? "M!K!" : "M.K.", 4);
+	else
+		memcpy(hdr.ID, modIDs[song->numChannels-1], 4);
+
+	// fill MOD sample headers
+	for (int32_t i = 1; i <= 31; i++)
+	{
+		modSmpHdr_t* modSmp = &hdr.smp[i-1];
+
+		nameLength = (int32_t)strlen(song->instrName[i]);
+		if (nameLength > 22)
+			nameLength = 22;
+
+		if (nameLength > 0)
+			memcpy(modSmp->name, song->instrName[i], nameLength); // padded with zeroes
+
+		if (getModuleRealUsedSamples(m, i) == 0)
+			continue;
+
+		const sample_t* smp = &m->instr[i]->smp[0];
+
+		int32_t length = smp->length >> 1;
+		int32_t loopStart = smp->loopStart >> 1;
+		int32_t loopLength = smp->loopLength >> 1;
+
+		// length/loopStart/loopLength are now in units of words
+
+		if (length > UINT16_MAX)
+			length = UINT16_MAX;
+
+		if (GET_LOOPTYPE(smp->flags) == LOOP_OFF)
+		{
+			loopStart = 0;
+			loopLength = 1;
+		}
+		else // looped sample
+		{
+			if (loopLength == 0) // ProTracker hates loopLengths of zero
+				loopLength = 1;
+
+			if (loopStart+loopLength > length)
+			{
+				loopStart = 0;
+				loopLength = 1;
+			}
+		}
+
+		modSmp->length = (uint16_t)SWAP16(length);
+		modSmp->finetune = FINETUNE_XM2MOD(smp->finetune);
+		modSmp->volume = smp->volume;
+		modSmp->loopStart = (uint16_t)SWAP16(loopStart);
+		modSmp->loopLength = (uint16_t)SWAP16(loopLength);
+	}
+
+	if (!writeData(w, &hdr, sizeof(hdr)))
+		return false;
+
+	// pattern data
+	const int32_t patternBytes = song->numChannels * 64 * 4;
+	for (int32_t i = 0; i < numPatterns; i++)
+	{
+		if (m->pattern[i] == NULL) // empty pattern
+		{
+			memset(modPattData, 0, patternBytes);
+		}
+		else
+		{
+			const note_t* p = m->pattern[i];
+			uint8_t* dst = modPattData;
+
+			for (int32_t j = 0; j < 64 * song->numChannels; j++, p++, dst += 4)
+			{
+				uint8_t inst = p->instr;
+				uint8_t note = p->note;
+
+				// FT2 bugfix: prevent overflow
+				if (inst > 31)
+					inst = 0;
+
+				// FT2 bugfix: convert note-off into no note for MOD saving
+				if (note == NOTE_OFF)
+					note = 0;
+
+				// FT2 bugfix: clamp notes below 10 (A-0) to prevent 12-bit period overflow
+				if (note > 0 && note < 10)
+					note = 10;
+
+				if (note == 0)
+				{
+					dst[0] = inst & 0xF0;
+					dst[1] = 0;
+				}
+				else
+				{
+					dst[0] = (inst & 0xF0) | ((amigaPeriod[note-1] >> 8) & 0x0F);
+					dst[1] = amigaPeriod[note-1] & 0xFF;
+				}
+
+				// FT2 bugfix: if effect is overflowing (0xF in .MOD), set effect and param to 0
+				if (p->efx > 0x0F)
+				{
+					dst[2] = (inst & 0x0F) << 4;
+					dst[3] = 0;
+				}
+				else
+				{
+					dst[2] = ((inst & 0x0F) << 4) | (p->efx & 0x0F);
+					dst[3] = p->efxData;
+				}
+			}
+		}
+
+		if (!writeData(w, modPattData, patternBytes))
+			return false;
+	}
+
+	// sample data
+	for (int32_t i = 1; i <= 31; i++)
+	{
+		if (getModuleRealUsedSamples(m, i) == 0)
+			continue;
+
+		const sample_t* smp = &m->instr[i]->smp[0];
+		if (smp->dataPtr == NULL || smp->length <= 0)
+			continue;
+
+		const int32_t sampleBytes = SWAP16(hdr.smp[i-1].length) * 2;
+		if (!writeMODSampleData(w, smp, sampleBytes))
+			return false;
+	}
+
+	return true;
+}
+
+static void* saveToMemory(const ft2_module_t* m, size_t* size, uint32_t* warnings, bool modFormat)
+{
+	memWriter_t mw;
+	writer_t w;
+
+	mw.size = 0;
+	mw.capacity = modFormat ? getMODSizeBound(m) : getXMSizeBound(m);
+	mw.data = (uint8_t*)malloc(mw.capacity);
+	if (mw.data == NULL)
+		return NULL;
+
+	w.write = writeToMemory;
+	w.user = &mw;
+
+	const bool saved = modFormat ? saveMOD(m, &w, warnings) : saveXM(m, &w);
+	if (!saved)
+	{
+		free(mw.data);
+		return NULL;
+	}
+
+	if (mw.size < mw.capacity) // the bound is not exact (the patterns pack, and so on)
+	{
+		uint8_t* data = (uint8_t*)realloc(mw.data, (mw.size > 0) ? mw.size : 1);
+		if (data != NULL)
+			mw.data = data;
+	}
+
+	if (size != NULL)
+		*size = mw.size;
+
+	return mw.data;
+}
+
+bool libft2_saveXM(const ft2_module_t* module, libft2_writeFunc_t write, void* user)
+{
+	writer_t w;
+
+	w.write = write;
+	w.user = user;
+
+	return saveXM(module, &w);
+}
+
+bool libft2_saveMOD(const ft2_module_t* module, libft2_writeFunc_t write, void* user, uint32_t* warnings)
+{
+	uint32_t dummyWarnings;
+	writer_t w;
+
+	w.write = write;
+	w.user = user;
+
+	return saveMOD(module, &w, (warnings != NULL) ? warnings : &dummyWarnings);
+}
+
+void* libft2_saveXMToMemory(const ft2_module_t* module, size_t* size)
+{
+	return saveToMemory(module, size, NULL, false);
+}
+
+void* libft2_saveMODToMemory(const ft2_module_t* module, size_t* size, uint32_t* warnings)
+{
+	uint32_t dummyWarnings;
+	return saveToMemory(module, size, (warnings != NULL) ? warnings : &dummyWarnings, true);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Saving of loaded modules as XM or MOD, the same files as the tracker saves. The module
+** isn't modified, so it can be saved while it's being played or read on other threads.
+*/
+
+typedef struct ft2_module_t ft2_module_t;
+
+// output callback, returns the number of bytes written ('size' unless there was an error)
+typedef size_t (*libft2_writeFunc_t)(void* user, const void* data, size_t size);
+
+enum // MOD saving warnings, the module is saved anyway (the same warnings as in the tracker)
+{
+	LIBFT2_MOD_WARN_SONG_LENGTH = 1, // song length above 128, only the first 128 orders are saved
+	LIBFT2_MOD_WARN_NUM_PATTERNS = 2, // more than 100 patterns, only the first 100 are saved
+	LIBFT2_MOD_WARN_NUM_INSTRUMENTS = 4, // instruments above 31 are used, they aren't saved
+	LIBFT2_MOD_WARN_SAMPLE_LENGTH = 8, // sample lengths above 131070, they get cut
+	LIBFT2_MOD_WARN_SAMPLE_LENGTH_65534 = 16, // sample lengths above 65534, not all MOD players support this
+	LIBFT2_MOD_WARN_XM_FEATURES = 32, // envelopes, several samples per instrument and such
+	LIBFT2_MOD_WARN_PATTERN_LENGTH = 64, // pattern lengths above 64, only the first 64 rows are saved
+	LIBFT2_MOD_WARN_PATTERN_INSTRUMENTS = 128, // instrument numbers above 31 in the patterns, they're removed
+	LIBFT2_MOD_WARN_PATTERN_EFFECTS = 256, // volume column or effects above F in the patterns, they're removed
+	LIBFT2_MOD_WARN_PATTERN_NOTES = 512 // notes below A-0 in the patterns, they're raised to A-0
+};
+
+/* Writes the module as an XM. Returns false if the module has more than 32 channels, or
+** if 'write' fails.
+*/
+bool libft2_saveXM(const ft2_module_t* module, libft2_writeFunc_t write, void* user);
+
+/* Writes the module as a MOD. Returns false if the module has more than 32 channels, if
+** a used pattern is shorter than 64 rows, or if 'write' fails. 'warnings' (if not NULL) is
+** set to the LIBFT2_MOD_WARN_* flags for what couldn't be saved as is.
+*/
+bool libft2_saveMOD(const ft2_module_t* module, libft2_writeFunc_t write, void* user, uint32_t* warnings);
+
+// the same, but to memory, returns NULL on failure (or OOM), free() result (or libft2_free())
+void* libft2_saveXMToMemory(const ft2_module_t* module, size_t* size);
+void* libft2_saveMODToMemory(const ft2_module_t* module, size_t* size, uint32_t* warnings);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,381 @@
+"""Python bindings for libft2 (ctypes, no compiling needed).
+
+Loads modules with libft2 and exposes their sample data and patterns as
+zero-copy, read-only memoryviews into the loaded module, so they can be
+wrapped without copying, f.ex. with numpy.asarray(sample.data) or
+numpy.asarray(module.pattern(0)).
+
+The shared library is looked up in the LIBFT2_PATH environment variable,
+then next to this file, then on the system library path. Build it with
+CMake (the 'ft2' target, libft2.so / ft2.dll).
+
+    import libft2, numpy as np
+
+    with libft2.Module("song.xm") as mod:
+        print(mod.song_info()["name"], mod.song_info()["numChannels"])
+        for smp in mod.samples():
+            pcm = np.asarray(smp.data)  # int8 or int16, no copy
+        notes = np.asarray(mod.pattern(0))  # uint8 [rows, channels, 5]
+        cols = mod.decode_song()  # columns: note, inst, volCmd, vol, efx, efx_x, efx_y
+
+The views point into the module's memory and keep it loaded: after
+close() (or the end of the 'with' block), the module is only freed when the
+last view is gone. The Module's own methods raise ValueError after close().
+"""
+
+import ctypes
+import ctypes.util
+import os
+import sys
+
+MAX_PATTERNS = 256
+MAX_ORDERS = 256
+SAMPLE_FIXED_POINTS = 8  # LIBFT2_SAMPLE_FIXED_POINTS
+
+LOOP_OFF, LOOP_FWD, LOOP_BIDI = 0, 1, 2
+
+# LIBFT2_MOD_WARN_* (libft2_saver.h)
+MOD_WARNINGS = {
+    1: "song length above 128",
+    2: "more than 100 patterns",
+    4: "instruments above 31 are used",
+    8: "sample lengths too long for the MOD format",
+    16: "sample lengths above 65534",
+    32: "XM instrument features are used",
+    64: "pattern lengths above 64",
+    128: "instrument numbers above 31 in the patterns",
+    256: "incompatible effects in the patterns",
+    512: "notes below A-0 in the patterns",
+}
+
+COLUMNS = ("note", "inst", "volCmd", "vol", "efx", "efx_x", "efx_y")
+
+
+class _SongInfo(ctypes.Structure):  # libft2_songInfo_t
+    _fields_ = [
+        ("name", ctypes.c_char * 21),
+        ("linearPeriods", ctypes.c_uint8),
+        ("orders", ctypes.c_uint8 * MAX_ORDERS),
+        ("numChannels", ctypes.c_int16),
+        ("songLength", ctypes.c_int16),
+        ("songLoopStart", ctypes.c_int16),
+        ("BPM", ctypes.c_int16),
+        ("speed", ctypes.c_int16),
+        ("numPatterns", ctypes.c_int16),
+        ("numInstruments", ctypes.c_int16),
+        ("numSamples", ctypes.c_int16),
+    ]
+
+
+class _SampleInfo(ctypes.Structure):  # libft2_sampleInfo_t
+    _fields_ = [
+        ("data", ctypes.c_void_p),
+        ("length", ctypes.c_int32),
+        ("loopStart", ctypes.c_int32),
+        ("loopLength", ctypes.c_int32),
+        ("fixedPos", ctypes.c_int32),
+        ("fixedPoints", ctypes.c_int16 * SAMPLE_FIXED_POINTS),
+        ("insNum", ctypes.c_int16),
+        ("smpNum", ctypes.c_int16),
+        ("bits", ctypes.c_uint8),
+        ("loopType", ctypes.c_uint8),
+        ("volume", ctypes.c_uint8),
+        ("panning", ctypes.c_uint8),
+        ("finetune", ctypes.c_int8),
+        ("relativeNote", ctypes.c_int8),
+        ("isFixed", ctypes.c_uint8),
+        ("name", ctypes.c_char * 23),
+    ]
+
+
+class _PatternColumns(ctypes.Structure):  # libft2_patternColumns_t
+    _fields_ = [(name, ctypes.c_void_p) for name in COLUMNS]
+
+
+class _SamplePoolStats(ctypes.Structure):  # libft2_samplePoolStats_t
+    _fields_ = [
+        ("numBuffers", ctypes.c_uint32),
+        ("numSamples", ctypes.c_uint32),
+        ("poolBytes", ctypes.c_uint64),
+        ("savedBytes", ctypes.c_uint64),
+    ]
+
+
+def _find_library():
+    path = os.environ.get("LIBFT2_PATH")
+    if path:
+        return path
+
+    here = os.path.dirname(os.path.abspath(__file__))
+    for name in ("libft2.so", "libft2.dylib", "ft2.dll", "libft2.dll"):
+        for folder in (here, os.path.join(here, "..", "..", "build")):
+            candidate = os.path.join(folder, name)
+            if os.path.exists(candidate):
+                return candidate
+
+    path = ctypes.util.find_library("ft2")
+    if path is None:
+        raise OSError("libft2 shared library not found, set LIBFT2_PATH")
+
+    return path
+
+
+def _load_library():
+    lib = ctypes.CDLL(_find_library())
+
+    c_module = ctypes.c_void_p
+    path_type = ctypes.c_wchar_p if sys.platform == "win32" else ctypes.c_char_p
+
+    def declare(name, restype, *argtypes):
+        func = getattr(lib, name)
+        func.restype = restype
+        func.argtypes = argtypes
+
+    declare("libft2_loadModule", c_module, path_type)
+    declare("libft2_loadModuleFromMemory", c_module, ctypes.c_void_p, ctypes.c_size_t)
+    declare("libft2_loadModuleMetadata", c_module, path_type, ctypes.c_bool)
+    declare("libft2_loadModuleMetadataFromMemory", c_module, ctypes.c_void_p, ctypes.c_size_t, ctypes.c_bool)
+    declare("libft2_unloadModule", None, c_module)
+    declare("libft2_getSongInfo", None, c_module, ctypes.POINTER(_SongInfo))
+    declare("libft2_getSampleInfo", ctypes.c_bool, c_module, ctypes.c_int32, ctypes.c_int32, ctypes.POINTER(_SampleInfo))
+    declare("libft2_getSampleInfos", ctypes.c_int32, c_module, ctypes.POINTER(_SampleInfo), ctypes.c_int32)
+    declare("libft2_getPattern", ctypes.c_void_p, c_module, ctypes.c_int32, ctypes.POINTER(ctypes.c_int16))
+    declare("libft2_decodePattern", ctypes.c_int32, c_module, ctypes.c_int32, ctypes.POINTER(_PatternColumns))
+    declare("libft2_decodeSong", ctypes.c_int32, c_module, ctypes.POINTER(_PatternColumns))
+    declare("libft2_getSongNumRows", ctypes.c_int32, c_module)
+    declare("libft2_saveXMToMemory", ctypes.c_void_p, c_module, ctypes.POINTER(ctypes.c_size_t))
+    declare("libft2_saveMODToMemory", ctypes.c_void_p, c_module, ctypes.POINTER(ctypes.c_size_t), ctypes.POINTER(ctypes.c_uint32))
+    declare("libft2_getSongHash", ctypes.c_uint64, c_module)
+    declare("libft2_getPatternHash", ctypes.c_uint64, c_module, ctypes.c_int32)
+    declare("libft2_getSampleHash", ctypes.c_uint64, c_module, ctypes.c_int32, ctypes.c_int32)
+    declare("libft2_setSamplePooling", None, ctypes.c_bool)
+    declare("libft2_getSamplePoolStats", None, ctypes.POINTER(_SamplePoolStats))
+    declare("libft2_free", None, ctypes.c_void_p)
+
+    return lib
+
+
+_lib = None
+
+
+def _get_lib():
+    global _lib
+    if _lib is None:
+        _lib = _load_library()
+    return _lib
+
+
+def set_sample_pooling(enable):
+    """Share identical sample data between the modules loaded after this (see libft2_setSamplePooling())."""
+    _get_lib().libft2_setSamplePooling(enable)
+
+
+def sample_pool_stats():
+    stats = _SamplePoolStats()
+    _get_lib().libft2_getSamplePoolStats(ctypes.byref(stats))
+    return {name: getattr(stats, name) for name, _ in _SamplePoolStats._fields_}
+
+
+class _Handle:
+    """A loaded module. The Module and every view into the module's memory hold a reference,
+    so the module is unloaded when the last of them is gone."""
+
+    def __init__(self, lib, address):
+        self._lib = lib
+        self.address = address
+
+    def __del__(self):
+        self._lib.libft2_unloadModule(self.address)
+
+
+def _view(owner, address, ctype, count):
+    """Read-only memoryview of 'count' ctype items at 'address', keeping 'owner' (a _Handle) alive."""
+    array = (ctype * count).from_address(address)
+    array._owner = owner  # the memoryview keeps the array alive, and the array keeps the module loaded
+    return memoryview(array).cast("B").cast(ctype._type_).toreadonly()
+
+
+class Sample:
+    """One sample of a module. 'data' is a zero-copy view (int8 'b' or int16 'h' items)."""
+
+    def __init__(self, module, info):
+        self.insNum = info.insNum
+        self.smpNum = info.smpNum
+        self.name = info.name.decode("cp437")
+        self.length = info.length
+        self.loopStart = info.loopStart
+        self.loopLength = info.loopLength
+        self.loopType = info.loopType
+        self.bits = info.bits
+        self.volume = info.volume
+        self.panning = info.panning
+        self.finetune = info.finetune
+        self.relativeNote = info.relativeNote
+        self.isFixed = bool(info.isFixed)
+        self.fixedPos = info.fixedPos
+        self.fixedPoints = list(info.fixedPoints)
+        self.hash = module._lib.libft2_getSampleHash(module._handle, info.insNum, info.smpNum)  # 0 = no data
+
+        if info.data and info.length > 0:
+            ctype = ctypes.c_int16 if info.bits == 16 else ctypes.c_int8
+            self.data = _view(module._native, info.data, ctype, info.length)
+        else:
+            self.data = None
+
+    def original_data(self):
+        """A copy of the sample data with the points that the mixer replaced after the loop put back."""
+        if self.data is None:
+            return None
+
+        copy = bytearray(self.data.cast("B"))
+        view = memoryview(copy).cast(self.data.format)
+        if self.isFixed:
+            for i, point in enumerate(self.fixedPoints):
+                if 0 <= self.fixedPos + i < self.length:
+                    view[self.fixedPos + i] = point if self.bits == 16 else ((point + 128) & 255) - 128
+
+        return view
+
+    def __repr__(self):
+        return "<Sample %d/%d %r, %d-bit, %d points>" % (self.insNum, self.smpNum, self.name, self.bits, self.length)
+
+
+class Module:
+    """A loaded XM/MOD/S3M/STM/STK/DIGI module.
+
+    'source' is a path or a bytes-like object with the file. With 'metadata_only', the
+    sample data isn't loaded (and the patterns only with 'load_patterns').
+    """
+
+    def __init__(self, source, metadata_only=False, load_patterns=True):
+        lib = _get_lib()
+        self._lib = lib
+
+        if isinstance(source, (bytes, bytearray, memoryview)):
+            data = bytes(source)
+            if metadata_only:
+                handle = lib.libft2_loadModuleMetadataFromMemory(data, len(data), load_patterns)
+            else:
+                handle = lib.libft2_loadModuleFromMemory(data, len(data))
+        else:
+            path = os.fspath(source)
+            if sys.platform != "win32":
+                path = os.fsencode(path)
+            if metadata_only:
+                handle = lib.libft2_loadModuleMetadata(path, load_patterns)
+            else:
+                handle = lib.libft2_loadModule(path)
+
+        if not handle:
+            raise ValueError("couldn't load module")
+
+        self._native = _Handle(lib, handle)
+
+    @property
+    def _handle(self):
+        if self._native is None:
+            raise ValueError("the module is closed")
+        return self._native.address
+
+    @property
+    def closed(self):
+        return self._native is None
+
+    def close(self):
+        """Closes the module. Views of its samples and patterns stay valid, the memory is freed with the last of them."""
+        self._native = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def song_info(self):
+        info = _SongInfo()
+        self._lib.libft2_getSongInfo(self._handle, ctypes.byref(info))
+
+        result = {name: getattr(info, name) for name, _ in _SongInfo._fields_}
+        result["name"] = info.name.decode("cp437")
+        result["linearPeriods"] = bool(info.linearPeriods)
+        result["orders"] = list(info.orders[:info.songLength])
+        return result
+
+    def samples(self):
+        """All the samples that exist, in one call (after a metadata-only load, their 'data' is None)."""
+        count = self._lib.libft2_getSampleInfos(self._handle, None, 0)
+        infos = (_SampleInfo * count)()
+        self._lib.libft2_getSampleInfos(self._handle, infos, count)
+        return [Sample(self, info) for info in infos]
+
+    def sample(self, insNum, smpNum):
+        info = _SampleInfo()
+        if not self._lib.libft2_getSampleInfo(self._handle, insNum, smpNum, ctypes.byref(info)):
+            return None
+        return Sample(self, info)
+
+    def song_hash(self):
+        """Fingerprint of everything that affects playback, without the names (see libft2_getSongHash())."""
+        return self._lib.libft2_getSongHash(self._handle)
+
+    def pattern_hash(self, pattNum):
+        return self._lib.libft2_getPatternHash(self._handle, pattNum)
+
+    def pattern_rows(self, pattNum):
+        numRows = ctypes.c_int16()
+        self._lib.libft2_getPattern(self._handle, pattNum, ctypes.byref(numRows))
+        return numRows.value
+
+    def pattern(self, pattNum):
+        """Zero-copy view of a pattern's notes, uint8 [rows][channels][note, instr, vol, efx, efxData], None if empty."""
+        numRows = ctypes.c_int16()
+        address = self._lib.libft2_getPattern(self._handle, pattNum, ctypes.byref(numRows))
+        if not address or numRows.value <= 0:
+            return None
+
+        numChannels = self.song_info()["numChannels"]
+        view = _view(self._native, address, ctypes.c_uint8, numRows.value * numChannels * 5)
+        return view.cast("B", (numRows.value, numChannels, 5))
+
+    def _decode(self, numRows, decode):
+        numChannels = self.song_info()["numChannels"]
+        buffers = {name: bytearray(numRows * numChannels) for name in COLUMNS}
+
+        columns = _PatternColumns()
+        for name in COLUMNS:
+            setattr(columns, name, ctypes.addressof(ctypes.c_uint8.from_buffer(buffers[name])) if numRows > 0 else None)
+
+        numRows = decode(ctypes.byref(columns))
+        if numRows < 0:
+            return None
+
+        return {name: memoryview(buffers[name])[:numRows * numChannels].cast("B", (numRows, numChannels)) for name in COLUMNS}
+
+    def decode_pattern(self, pattNum):
+        """The pattern decoded to columns (see libft2_decodePattern()), each uint8 [rows][channels]."""
+        return self._decode(256, lambda columns: self._lib.libft2_decodePattern(self._handle, pattNum, columns))
+
+    def decode_song(self):
+        """All the patterns in the order list decoded to columns, each uint8 [rows][channels]."""
+        numRows = self._lib.libft2_getSongNumRows(self._handle)
+        return self._decode(numRows, lambda columns: self._lib.libft2_decodeSong(self._handle, columns))
+
+    def _take(self, address, size):
+        if not address:
+            return None
+        try:
+            return ctypes.string_at(address, size.value)
+        finally:
+            self._lib.libft2_free(address)
+
+    def save_xm(self):
+        """The module as an XM file (bytes), None if it can't be saved as XM."""
+        size = ctypes.c_size_t()
+        return self._take(self._lib.libft2_saveXMToMemory(self._handle, ctypes.byref(size)), size)
+
+    def save_mod(self):
+        """The module as a MOD file (bytes, or None), and the list of warnings."""
+        size = ctypes.c_size_t()
+        warnings = ctypes.c_uint32()
+        data = self._take(self._lib.libft2_saveMODToMemory(self._handle, ctypes.byref(size), ctypes.byref(warnings)), size)
+        return data, [text for bit, text in MOD_WARNINGS.items() if warnings.value & bit]
@@ -0,0 +1,403 @@
+/* Aliasing vs. cost of the interpolators, with and without 2x oversampled mixing.
+**
+** Usage: libft2_aliasing [--rate hz] [--passes n] [-v]
+**   --rate    output rate (default 48000)
+**   --passes  timed renders per mode, the fastest one counts (default 5)
+**   -v        print the result of every note too
+**
+** The test song is a stepped sine sweep, made here: a looped 16-bit sine sample with 8 points
+** per period is played on 32 channels at once, on every note from C-2 to B-7. That's sampling
+** rates from ~2.1kHz to ~127kHz, so the played tone goes from ~260Hz to ~15.8kHz (below the
+** oversampling filter's passband edge at 48kHz). The upper notes are played faster than the
+** output rate, which is where the interpolators alias.
+**
+** For every note, the left channel (after the first tick and without the last one, so that the
+** volume ramps are left out) is fitted with a sinusoid at the tone's frequency. Whatever is left
+** is spurious: aliases, images and interpolation noise. It's given in dB relative to the tone,
+** as the mean over all the notes and the worst note. The 16-bit sample puts the floor at
+** about -100dB. The time is for rendering the whole song (32 voices), without the analysis.
+**
+** Build with -DLIBFT2_TOOLS=ON and CMAKE_BUILD_TYPE=Release for meaningful timings.
+*/
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../libft2.h"
+#include "../libft2_player.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SWEEP_CHANNELS 32
+#define SWEEP_FIRST_NOTE 25 // C-2
+#define SWEEP_LAST_NOTE 96 // B-7
+#define SWEEP_ROWS ((SWEEP_LAST_NOTE - SWEEP_FIRST_NOTE) + 1)
+#define SWEEP_SPEED 12 // ticks per note
+#define SINE_PERIOD 8 // sample points per period of the test tone
+#define SINE_LENGTH (SINE_PERIOD * 128)
+#define DEFAULT_FREQ 48000
+#define DEFAULT_PASSES 5
+
+typedef struct noteResult_t
+{
+	double dToneHz, dSpuriousDb;
+} noteResult_t;
+
+typedef struct sweepMode_t
+{
+	const char* name;
+	uint8_t interpolation;
+	bool oversampling;
+} sweepMode_t;
+
+static const sweepMode_t modes[] =
+{
+	{ "none", LIBFT2_INTERPOLATION_NONE, false },
+	{ "linear", LIBFT2_INTERPOLATION_LINEAR, false },
+	{ "sinc8", LIBFT2_INTERPOLATION_SINC8, false },
+	{ "sinc16", LIBFT2_INTERPOLATION_SINC16, false },
+	{ "none 2x", LIBFT2_INTERPOLATION_NONE, true },
+	{ "linear 2x", LIBFT2_INTERPOLATION_LINEAR, true },
+	{ "sinc8 2x", LIBFT2_INTERPOLATION_SINC8, true },
+	{ "sinc16 2x", LIBFT2_INTERPOLATION_SINC16, true }
+};
+
+#define NUM_MODES (int32_t)(sizeof(modes) / sizeof(modes[0]))
+
+static double getTime(void) // in seconds
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, now;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart / freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec * (1.0 / 1000000000.0));
+#endif
+}
+
+static void put16(uint8_t** p, uint16_t x) // little-endian
+{
+	(*p)[0] = (uint8_t)x;
+	(*p)[1] = (uint8_t)(x >> 8);
+	*p += 2;
+}
+
+static void put32(uint8_t** p, uint32_t x)
+{
+	put16(p, (uint16_t)x);
+	put16(p, (uint16_t)(x >> 16));
+}
+
+static void putBytes(uint8_t** p, const char* s, size_t len) // zero-padded
+{
+	memset(*p, 0, len);
+	memcpy(*p, s, strlen(s));
+	*p += len;
+}
+
+// the sweep as an XM file, returns its size (xm must have room for it)
+static size_t makeSweepXM(uint8_t* xm)
+{
+	uint8_t* p = xm;
+
+	// header
+	putBytes(&p, "Extended Module: ", 17);
+	putBytes(&p, "aliasing sweep", 20);
+	*p++ = 0x1A;
+	putBytes(&p, "libft2_aliasing", 20);
+	put16(&p, 0x0104);
+	put32(&p, 276);
+	put16(&p, 1); // song length
+	put16(&p, 0); // restart position
+	put16(&p, SWEEP_CHANNELS);
+	put16(&p, 1); // patterns
+	put16(&p, 1); // instruments
+	put16(&p, 1); // linear periods
+	put16(&p, SWEEP_SPEED);
+	put16(&p, 125);
+	memset(p, 0, 256); // order list: pattern 0
+	p += 256;
+
+	// pattern, unpacked notes
+	put32(&p, 9);
+	*p++ = 0;
+	put16(&p, SWEEP_ROWS);
+	put16(&p, SWEEP_ROWS * SWEEP_CHANNELS * 5);
+	for (int32_t row = 0; row < SWEEP_ROWS; row++)
+	{
+		for (int32_t ch = 0; ch < SWEEP_CHANNELS; ch++)
+		{
+			*p++ = (uint8_t)(SWEEP_FIRST_NOTE + row);
+			*p++ = 1; // instrument
+			*p++ = 0;
+			*p++ = 0;
+			*p++ = 0;
+		}
+	}
+
+	// instrument (no envelopes, no vibrato) with one sample
+	put32(&p, 263);
+	putBytes(&p, "sine", 22);
+	*p++ = 0;
+	put16(&p, 1);
+	put32(&p, 40);
+	memset(p, 0, 96 + 48 + 48 + 14 + 2 + 22); // note map, envelopes, envelope settings, vibrato, fadeout, reserved
+	p += 96 + 48 + 48 + 14 + 2 + 22;
+
+	put32(&p, SINE_LENGTH * 2);
+	put32(&p, 0);
+	put32(&p, SINE_LENGTH * 2);
+	*p++ = 16; // volume (32 voices of this at amp 1 don't clip)
+	*p++ = 0; // finetune
+	*p++ = 1 | 16; // forward loop, 16-bit
+	*p++ = 128; // panning
+	*p++ = 0; // relative note
+	*p++ = 0;
+	putBytes(&p, "sine", 22);
+
+	int16_t last = 0;
+	for (int32_t i = 0; i < SINE_LENGTH; i++)
+	{
+		const int16_t point = (int16_t)lrint(30000.0 * sin((2.0 * M_PI * i) / SINE_PERIOD));
+		put16(&p, (uint16_t)(point - last)); // delta coded
+		last = point;
+	}
+
+	return p - xm;
+}
+
+// energy left over after fitting a sinusoid of the tone's frequency, relative to the sinusoid (in dB)
+static double spuriousDb(const float* x, int32_t n, double dToneHz, uint32_t freq)
+{
+	const double dOmega = (2.0 * M_PI * dToneHz) / freq;
+
+	// least squares fit of a*cos + b*sin (2x2 normal equations)
+	double cc = 0.0, ss = 0.0, cs = 0.0, xc = 0.0, xs = 0.0;
+	for (int32_t i = 0; i < n; i++)
+	{
+		const double c = cos(dOmega * i), s = sin(dOmega * i);
+		cc += c * c;
+		ss += s * s;
+		cs += c * s;
+		xc += x[i] * c;
+		xs += x[i] * s;
+	}
+
+	const double det = (cc * ss) - (cs * cs);
+	const double a = ((xc * ss) - (xs * cs)) / det;
+	const double b = ((xs * cc) - (xc * cs)) / det;
+
+	double toneEnergy = 0.0, spuriousEnergy = 0.0;
+	for (int32_t i = 0; i < n; i++)
+	{
+		const double fit = (a * cos(dOmega * i)) + (b * sin(dOmega * i));
+		const double err = x[i] - fit;
+
+		toneEnergy += fit * fit;
+		spuriousEnergy += err * err;
+	}
+
+	if (toneEnergy <= 0.0)
+		return 0.0;
+
+	return 10.0 * log10((spuriousEnergy + 1e-30) / toneEnergy);
+}
+
+// renders the sweep once, returns the render time. With 'results', every note is analyzed too
+static double renderSweep(const ft2_module_t* m, const sweepMode_t* mode, uint32_t freq, noteResult_t* results, bool* ok)
+{
+	libft2_playerState_t state;
+	libft2_channelState_t ch;
+
+	*ok = false;
+
+	ft2_player_t* player = libft2_createPlayer(m, freq, mode->interpolation);
+	if (player == NULL)
+		return 0.0;
+
+	libft2_setPlayerOversampling(player, mode->oversampling);
+	libft2_setPlayerAmp(player, 1);
+
+	const uint32_t maxTickSamples = libft2_getMaxTickSamples(player);
+	float* tickBuffer = (float*)malloc(maxTickSamples * 2 * sizeof(float));
+	float* noteBuffer = (float*)malloc(maxTickSamples * SWEEP_SPEED * sizeof(float)); // left channel
+	if (tickBuffer == NULL || noteBuffer == NULL)
+	{
+		free(tickBuffer);
+		free(noteBuffer);
+		libft2_freePlayer(player);
+		return 0.0;
+	}
+
+	int32_t lastRow = -1, tickInRow = 0, noteLength = 0;
+	bool clipped = false; // the output is clipped, that would be measured as aliasing
+	double dToneHz = 0.0, renderTime = 0.0;
+
+	for (;;)
+	{
+		const double startTime = getTime();
+		const uint32_t tickSamples = libft2_renderPlayerTick(player, tickBuffer);
+		renderTime += getTime() - startTime;
+
+		libft2_getPlayerState(player, &state);
+		const bool newRow = (tickSamples == 0 || state.row != lastRow);
+
+		if (newRow && results != NULL && lastRow >= 0 && lastRow < SWEEP_ROWS)
+		{
+			results[lastRow].dToneHz = dToneHz;
+			results[lastRow].dSpuriousDb = spuriousDb(noteBuffer, noteLength, dToneHz, freq);
+		}
+
+		if (tickSamples == 0)
+			break;
+
+		if (newRow)
+		{
+			lastRow = state.row;
+			tickInRow = 0;
+			noteLength = 0;
+
+			libft2_getChannelState(player, 0, &ch);
+			dToneHz = ch.dFrequency / SINE_PERIOD;
+		}
+
+		// leave out the first tick (volume ramp-in and the last note's fade-out) and the last tick
+		if (results != NULL && tickInRow >= 1 && tickInRow < SWEEP_SPEED-1)
+		{
+			for (uint32_t i = 0; i < tickSamples; i++)
+				noteBuffer[noteLength++] = tickBuffer[i * 2];
+		}
+
+		for (uint32_t i = 0; i < tickSamples * 2; i++)
+		{
+			if (fabsf(tickBuffer[i]) >= 1.0f)
+				clipped = true;
+		}
+
+		tickInRow++;
+	}
+
+	free(tickBuffer);
+	free(noteBuffer);
+	libft2_freePlayer(player);
+
+	*ok = (lastRow == SWEEP_ROWS-1 && !clipped);
+	return renderTime;
+}
+
+int main(int argc, char* argv[])
+{
+	noteResult_t results[NUM_MODES][SWEEP_ROWS];
+	uint32_t freq = DEFAULT_FREQ;
+	int32_t passes = DEFAULT_PASSES;
+	bool verbose = false;
+
+	for (int32_t i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--rate") && i+1 < argc)
+		{
+			freq = (uint32_t)atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--passes") && i+1 < argc)
+		{
+			passes = atoi(argv[++i]);
+			if (passes < 1)
+				passes = 1;
+		}
+		else if (!strcmp(argv[i], "-v"))
+		{
+			verbose = true;
+		}
+		else
+		{
+			fprintf(stderr, "Usage: libft2_aliasing [--rate hz] [--passes n] [-v]\n");
+			return 1;
+		}
+	}
+
+	uint8_t* xm = (uint8_t*)malloc(65536);
+	if (xm == NULL)
+	{
+		fprintf(stderr, "aliasing: Not enough memory!\n");
+		return 1;
+	}
+
+	const size_t xmSize = makeSweepXM(xm);
+	ft2_module_t* m = libft2_loadModuleFromMemory(xm, xmSize);
+	free(xm);
+
+	if (m == NULL)
+	{
+		fprintf(stderr, "aliasing: couldn't load the sweep\n");
+		return 1;
+	}
+
+	const double songSeconds = (SWEEP_ROWS * SWEEP_SPEED) / (125 / 2.5);
+
+	printf("stepped sine sweep, %d notes, %d channels, %u Hz, %.1f s\n\n", SWEEP_ROWS, SWEEP_CHANNELS, freq, songSeconds);
+	printf("mode         spurious dB (mean / worst)   render ms   x realtime\n");
+
+	for (int32_t i = 0; i < NUM_MODES; i++)
+	{
+		bool ok;
+
+		double bestTime = renderSweep(m, &modes[i], freq, results[i], &ok);
+		for (int32_t j = 1; ok && j < passes; j++)
+		{
+			const double time = renderSweep(m, &modes[i], freq, NULL, &ok);
+			if (time < bestTime)
+				bestTime = time;
+		}
+
+		if (!ok)
+		{
+			fprintf(stderr, "aliasing: rendering failed or clipped (mode \"%s\")\n", modes[i].name);
+			libft2_unloadModule(m);
+			return 1;
+		}
+
+		double sumDb = 0.0, worstDb = -1000.0;
+		for (int32_t j = 0; j < SWEEP_ROWS; j++)
+		{
+			sumDb += results[i][j].dSpuriousDb;
+			if (results[i][j].dSpuriousDb > worstDb)
+				worstDb = results[i][j].dSpuriousDb;
+		}
+
+		printf("%-12s %8.1f / %6.1f           %8.1f   %8.1f\n", modes[i].name, sumDb / SWEEP_ROWS, worstDb,
+			bestTime * 1000.0, songSeconds / bestTime);
+	}
+
+	if (verbose)
+	{
+		printf("\nnote tone Hz");
+		for (int32_t i = 0; i < NUM_MODES; i++)
+			printf(" %10s", modes[i].name);
+		printf("\n");
+
+		for (int32_t j = 0; j < SWEEP_ROWS; j++)
+		{
+			printf("%4d %7.0f", SWEEP_FIRST_NOTE + j, results[0][j].dToneHz);
+			for (int32_t i = 0; i < NUM_MODES; i++)
+				printf(" %10.1f", results[i][j].dSpuriousDb);
+			printf("\n");
+		}
+	}
+
+	libft2_unloadModule(m);
+	return 0;
+}
@@ -0,0 +1,210 @@
+/* Load throughput benchmark for libft2.
+**
+** Usage: libft2_bench [-m] [-p] [-n passes] <files/directories...>
+**   -m  metadata-only loading (libft2_loadModuleMetadataFromMemory())
+**   -p  with -m, load the patterns too
+**   -n  number of passes over the corpus (default 10)
+**
+** The corpus is read into memory first (directories are scanned, not recursively), so only
+** the loaders are measured, not the disk.
+*/
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../libft2.h"
+
+typedef struct corpusFile_t
+{
+	uint8_t* data;
+	size_t size;
+} corpusFile_t;
+
+static corpusFile_t* corpus;
+static int32_t corpusFiles, corpusCapacity;
+
+static double getTime(void) // in seconds
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, now;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart / freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec * (1.0 / 1000000000.0));
+#endif
+}
+
+static bool addFile(const char* path)
+{
+	FILE* f = fopen(path, "rb");
+	if (f == NULL)
+		return false;
+
+	fseek(f, 0, SEEK_END);
+	const long size = ftell(f);
+	rewind(f);
+
+	if (size <= 0)
+	{
+		fclose(f);
+		return false;
+	}
+
+	if (corpusFiles == corpusCapacity)
+	{
+		corpusCapacity = (corpusCapacity == 0) ? 256 : corpusCapacity * 2;
+		corpusFile_t* newCorpus = (corpusFile_t*)realloc(corpus, corpusCapacity * sizeof(corpusFile_t));
+		if (newCorpus == NULL)
+		{
+			fclose(f);
+			return false;
+		}
+
+		corpus = newCorpus;
+	}
+
+	uint8_t* data = (uint8_t*)malloc(size);
+	if (data == NULL || fread(data, 1, size, f) != (size_t)size)
+	{
+		free(data);
+		fclose(f);
+		return false;
+	}
+
+	fclose(f);
+
+	corpus[corpusFiles].data = data;
+	corpus[corpusFiles].size = size;
+	corpusFiles++;
+
+	return true;
+}
+
+static void addPath(const char* path)
+{
+#ifdef _WIN32
+	char pattern[MAX_PATH];
+	snprintf(pattern, sizeof(pattern), "%s\\*", path);
+
+	WIN32_FIND_DATAA fd;
+	HANDLE h = FindFirstFileA(pattern, &fd);
+	if (h == INVALID_HANDLE_VALUE)
+	{
+		addFile(path);
+		return;
+	}
+
+	do
+	{
+		if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			char filePath[MAX_PATH];
+			snprintf(filePath, sizeof(filePath), "%s\\%s", path, fd.cFileName);
+			addFile(filePath);
+		}
+	}
+	while (FindNextFileA(h, &fd));
+
+	FindClose(h);
+#else
+	DIR* dir = opendir(path);
+	if (dir == NULL)
+	{
+		addFile(path);
+		return;
+	}
+
+	struct dirent* ent;
+	while ((ent = readdir(dir)) != NULL)
+	{
+		char filePath[4096];
+		snprintf(filePath, sizeof(filePath), "%s/%s", path, ent->d_name);
+
+		struct stat st;
+		if (stat(filePath, &st) == 0 && S_ISREG(st.st_mode))
+			addFile(filePath);
+	}
+
+	closedir(dir);
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+	bool metadataOnly = false, loadPatterns = false;
+	int32_t numPasses = 10;
+
+	for (int32_t i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-m"))
+			metadataOnly = true;
+		else if (!strcmp(argv[i], "-p"))
+			loadPatterns = true;
+		else if (!strcmp(argv[i], "-n") && i+1 < argc)
+			numPasses = atoi(argv[++i]);
+		else
+			addPath(argv[i]);
+	}
+
+	if (corpusFiles == 0 || numPasses < 1)
+	{
+		fprintf(stderr, "Usage: libft2_bench [-m] [-p] [-n passes] <files/directories...>\n");
+		return 1;
+	}
+
+	uint64_t corpusBytes = 0;
+	for (int32_t i = 0; i < corpusFiles; i++)
+		corpusBytes += corpus[i].size;
+
+	int32_t numFailed = 0;
+
+	const double startTime = getTime();
+	for (int32_t pass = 0; pass < numPasses; pass++)
+	{
+		for (int32_t i = 0; i < corpusFiles; i++)
+		{
+			ft2_module_t* m;
+			if (metadataOnly)
+				m = libft2_loadModuleMetadataFromMemory(corpus[i].data, corpus[i].size, loadPatterns);
+			else
+				m = libft2_loadModuleFromMemory(corpus[i].data, corpus[i].size);
+
+			if (m == NULL)
+			{
+				if (pass == 0)
+					numFailed++;
+			}
+			else
+			{
+				libft2_unloadModule(m);
+			}
+		}
+	}
+	const double time = getTime() - startTime;
+
+	const double numFiles = (double)corpusFiles * numPasses;
+	const double MB = ((double)corpusBytes * numPasses) / (1024.0 * 1024.0);
+
+	printf("%d files (%d failed to load), %.2f MB, %d passes, %s\n", corpusFiles, numFailed,
+		corpusBytes / (1024.0 * 1024.0), numPasses, metadataOnly ? (loadPatterns ? "metadata+patterns" : "metadata") : "full load");
+	printf("%.3f s, %.1f files/sec, %.1f MB/sec\n", time, numFiles / time, MB / time);
+
+	for (int32_t i = 0; i < corpusFiles; i++)
+		free(corpus[i].data);
+	free(corpus);
+
+	return 0;
+}
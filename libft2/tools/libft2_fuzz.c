@@ -0,0 +1,182 @@
+/* Fuzzing harness for the module loaders, through libft2's memory loader.
+**
+** libFuzzer: build with -DLIBFT2_TOOLS=ON -DLIBFT2_LIBFUZZER=ON using clang, then run
+**   libft2_fuzz corpus_dir/
+** AFL++: build with -DLIBFT2_TOOLS=ON and CC=afl-clang-fast, then run
+**   afl-fuzz -i corpus_dir -o findings -- libft2_fuzz @@
+** (without an argument, the input is read from stdin). AFL's persistent mode is used when
+** it's available.
+**
+** Every input is loaded fully and metadata-only, and a loaded module is also decoded,
+** saved as XM and played for a little while, since the replayer and the saver see whatever
+** the loaders let through.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../libft2.h"
+
+#define MAX_INPUT_SIZE (64 * 1024 * 1024)
+#define MAX_SAVE_SAMPLE_BYTES (32 * 1024 * 1024)
+#define PLAY_FRAMES 4096
+
+static void exerciseModule(ft2_module_t* m)
+{
+	static uint8_t columnData[7][MAX_PATT_LEN * MAX_CHANNELS];
+	static float playBuffer[PLAY_FRAMES * 2];
+
+	libft2_songInfo_t songInfo;
+	libft2_getSongInfo(m, &songInfo);
+
+	/* Sample lengths come from the headers, so a small input can have huge (zero padded)
+	** samples. Don't save those, or the save and the reload would run into the fuzzer's
+	** memory limit.
+	*/
+	uint64_t sampleBytes = 0;
+
+	const int32_t numSamples = libft2_getSampleInfos(m, NULL, 0);
+	libft2_sampleInfo_t* sampleInfos = (libft2_sampleInfo_t*)malloc((numSamples + 1) * sizeof(libft2_sampleInfo_t));
+	if (sampleInfos != NULL)
+	{
+		libft2_getSampleInfos(m, sampleInfos, numSamples);
+		for (int32_t i = 0; i < numSamples; i++)
+			sampleBytes += (uint64_t)sampleInfos[i].length * (sampleInfos[i].bits / 8);
+
+		free(sampleInfos);
+	}
+
+	libft2_patternColumns_t columns;
+	columns.note = columnData[0];
+	columns.inst = columnData[1];
+	columns.volCmd = columnData[2];
+	columns.vol = columnData[3];
+	columns.efx = columnData[4];
+	columns.efx_x = columnData[5];
+	columns.efx_y = columnData[6];
+
+	for (int32_t i = 0; i < songInfo.numPatterns; i++)
+		libft2_decodePattern(m, i, &columns);
+
+	size_t size;
+	void* xm = (sampleBytes <= MAX_SAVE_SAMPLE_BYTES) ? libft2_saveXMToMemory(m, &size) : NULL;
+	if (xm != NULL)
+	{
+		ft2_module_t* m2 = libft2_loadModuleFromMemory(xm, size); // a saved module must load again
+		if (m2 == NULL)
+			abort();
+
+		libft2_unloadModule(m2);
+		free(xm);
+	}
+
+	ft2_player_t* player = libft2_createPlayer(m, 48000, LIBFT2_INTERPOLATION_SINC16);
+	if (player != NULL)
+	{
+		libft2_renderPlayer(player, playBuffer, PLAY_FRAMES);
+		libft2_freePlayer(player);
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	ft2_module_t* m = libft2_loadModuleFromMemory(data, size);
+	if (m != NULL)
+	{
+		exerciseModule(m);
+		libft2_unloadModule(m);
+	}
+
+	m = libft2_loadModuleMetadataFromMemory(data, size, true);
+	if (m != NULL)
+	{
+		exerciseModule(m);
+		libft2_unloadModule(m);
+	}
+
+	return 0;
+}
+
+#ifndef LIBFT2_LIBFUZZER
+
+#ifdef __AFL_FUZZ_TESTCASE_LEN
+__AFL_FUZZ_INIT();
+#endif
+
+static uint8_t* readInput(const char* path, size_t* size)
+{
+	FILE* f = (path != NULL) ? fopen(path, "rb") : stdin;
+	if (f == NULL)
+		return NULL;
+
+	size_t capacity = 65536;
+	uint8_t* data = (uint8_t*)malloc(capacity);
+
+	*size = 0;
+	while (data != NULL && *size < MAX_INPUT_SIZE)
+	{
+		if (*size == capacity)
+		{
+			capacity *= 2;
+			uint8_t* newData = (uint8_t*)realloc(data, capacity);
+			if (newData == NULL)
+			{
+				free(data);
+				data = NULL;
+				break;
+			}
+
+			data = newData;
+		}
+
+		const size_t bytesRead = fread(&data[*size], 1, capacity - *size, f);
+		if (bytesRead == 0)
+			break;
+
+		*size += bytesRead;
+	}
+
+	if (f != stdin)
+		fclose(f);
+
+	return data;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef __AFL_FUZZ_TESTCASE_LEN
+	if (argc < 2) // persistent mode, the test cases come in shared memory
+	{
+		__AFL_INIT();
+		const uint8_t* buf = __AFL_FUZZ_TESTCASE_BUF;
+
+		while (__AFL_LOOP(10000))
+			LLVMFuzzerTestOneInput(buf, __AFL_FUZZ_TESTCASE_LEN);
+
+		return 0;
+	}
+#endif
+
+	// one input from stdin, or each file given (f.ex. to reproduce a crash)
+	for (int32_t i = (argc < 2) ? 0 : 1; i < ((argc < 2) ? 1 : argc); i++)
+	{
+		const char* path = (argc < 2) ? NULL : argv[i];
+
+		size_t size;
+		uint8_t* data = readInput(path, &size);
+		if (data == NULL)
+		{
+			fprintf(stderr, "Couldn't read %s\n", (path != NULL) ? path : "stdin");
+			return 1;
+		}
+
+		LLVMFuzzerTestOneInput(data, size);
+		free(data);
+	}
+
+	return 0;
+}
+
+#endif
@@ -0,0 +1,333 @@
+/* Replayer regression check for libft2 (the tracker's replayer and mixer, without the GUI).
+**
+** Usage: libft2_tickhash <module> <hashfile>
+**        libft2_tickhash --write [--rate hz] [--interp none|linear] <module> <hashfile>
+**
+** The song is played once, tick by tick. After every tick, one line is written (or compared
+** against the golden hash file): the tick number, the song position and row, a hash of the
+** replayer state and a hash of the mixed audio. Check mode reports the first tick that differs,
+** and the exit code is 0 if everything matched. The rate and interpolation of a check come
+** from the hash file's first line.
+**
+** The hashes are made portable by only hashing integers: the periods, volumes, panning and
+** voice positions, the final volume in 1/65535 steps and the output as rounded 16-bit PCM
+** (no dither). The sinc interpolators aren't offered, their tables come from the C library's
+** math functions, which can differ in the last bit between platforms.
+**
+** libft2/tools/tickhash has the corpus and its golden files (ctest runs them when
+** built with -DLIBFT2_TOOLS=ON).
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+#include "../libft2.h"
+#include "../libft2_player.h"
+#include "../../src/ft2_hash.h"
+
+#define TICKHASH_HEADER "libft2 tick hash v1"
+#define DEFAULT_FREQ 48000
+#define MAX_SECONDS (60*60) // for songs that loop forever without wrapping the order list
+
+typedef struct tickHashOpts_t
+{
+	bool writeFlag;
+	uint32_t freq;
+	uint8_t interpolation;
+} tickHashOpts_t;
+
+static const char* interpNames[4] = { "none", "sinc8", "linear", "sinc16" }; // LIBFT2_INTERPOLATION_* order
+
+static void put16(uint8_t** p, uint16_t x) // little-endian, so the hashes don't depend on the CPU
+{
+	(*p)[0] = (uint8_t)x;
+	(*p)[1] = (uint8_t)(x >> 8);
+	*p += 2;
+}
+
+static void put32(uint8_t** p, uint32_t x)
+{
+	put16(p, (uint16_t)x);
+	put16(p, (uint16_t)(x >> 16));
+}
+
+static uint64_t hashState(const ft2_player_t* player, int32_t numChannels)
+{
+	uint8_t data[16], *p;
+	libft2_playerState_t s;
+	libft2_channelState_t ch;
+	hash64_t h;
+
+	hash64Init(&h, 0);
+
+	libft2_getPlayerState(player, &s);
+	p = data;
+	put16(&p, s.BPM);
+	put16(&p, s.speed);
+	put16(&p, s.globalVolume);
+	put16(&p, s.tick);
+	hash64Update(&h, data, p - data);
+
+	for (int32_t i = 0; i < numChannels; i++)
+	{
+		libft2_getChannelState(player, i, &ch);
+
+		p = data;
+		put16(&p, ch.period);
+		*p++ = ch.volume;
+		*p++ = ch.panning;
+		put16(&p, (uint16_t)floorf((ch.fFinalVolume * 65535.0f) + 0.5f));
+		put32(&p, (uint32_t)ch.samplePos); // the sample position also shows retriggers and offsets
+		*p++ = ch.note;
+		*p++ = ch.instrNum;
+		hash64Update(&h, data, p - data);
+	}
+
+	return hash64Final(&h);
+}
+
+static uint64_t hashAudio(const float* in, uint32_t numSamples, uint8_t* pcm)
+{
+	uint8_t* p = pcm;
+	for (uint32_t i = 0; i < numSamples * 2; i++)
+	{
+		float fOut = floorf((in[i] * 32768.0f) + 0.5f);
+		if (fOut < -32768.0f) fOut = -32768.0f;
+		if (fOut >  32767.0f) fOut =  32767.0f;
+
+		put16(&p, (uint16_t)(int16_t)fOut);
+	}
+
+	return hash64(pcm, numSamples * 2 * sizeof(int16_t), 0);
+}
+
+// writes the line in write mode, or compares it against the next line of the hash file
+static bool handleLine(FILE* f, const char* line, bool writeFlag)
+{
+	char expectedLine[128];
+
+	if (writeFlag)
+		return fputs(line, f) >= 0;
+
+	if (fgets(expectedLine, sizeof(expectedLine), f) == NULL)
+	{
+		fprintf(stderr, "tickhash: hash file ended early, first extra tick:\n  got:      %s", line);
+		return false;
+	}
+
+	if (strcmp(expectedLine, line) != 0)
+	{
+		fprintf(stderr, "tickhash: mismatch!\n  expected: %s  got:      %s", expectedLine, line);
+		return false;
+	}
+
+	return true;
+}
+
+static bool readHeader(FILE* f, tickHashOpts_t* opts)
+{
+	char line[128], interpName[16];
+	unsigned int freq;
+
+	if (fgets(line, sizeof(line), f) == NULL || strncmp(line, TICKHASH_HEADER " ", sizeof(TICKHASH_HEADER)) != 0 ||
+		sscanf(line + sizeof(TICKHASH_HEADER), "%u %15s", &freq, interpName) != 2)
+	{
+		return false;
+	}
+
+	opts->freq = freq;
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		if (!strcmp(interpName, interpNames[i]))
+		{
+			opts->interpolation = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static ft2_module_t* loadModuleFile(const char* path) // from memory, so the path needn't be converted to UNICHAR
+{
+	FILE* f = fopen(path, "rb");
+	if (f == NULL)
+		return NULL;
+
+	fseek(f, 0, SEEK_END);
+	const long size = ftell(f);
+	rewind(f);
+
+	uint8_t* data = (size > 0) ? (uint8_t*)malloc(size) : NULL;
+	if (data == NULL || fread(data, 1, size, f) != (size_t)size)
+	{
+		free(data);
+		fclose(f);
+		return NULL;
+	}
+
+	fclose(f);
+
+	ft2_module_t* m = libft2_loadModuleFromMemory(data, size);
+	free(data);
+
+	return m;
+}
+
+static int32_t tickHash(const char* modulePath, const char* hashPath, tickHashOpts_t* opts)
+{
+	char line[128];
+	libft2_songInfo_t info;
+	libft2_playerState_t state;
+
+	FILE* f = fopen(hashPath, opts->writeFlag ? "w" : "r");
+	if (f == NULL)
+	{
+		fprintf(stderr, "tickhash: couldn't open \"%s\"\n", hashPath);
+		return 1;
+	}
+
+	if (!opts->writeFlag && !readHeader(f, opts))
+	{
+		fprintf(stderr, "tickhash: \"%s\" isn't a tick hash file\n", hashPath);
+		fclose(f);
+		return 1;
+	}
+
+	ft2_module_t* m = loadModuleFile(modulePath);
+	if (m == NULL)
+	{
+		fprintf(stderr, "tickhash: couldn't load \"%s\"\n", modulePath);
+		fclose(f);
+		return 1;
+	}
+
+	libft2_getSongInfo(m, &info);
+
+	ft2_player_t* player = libft2_createPlayer(m, opts->freq, opts->interpolation);
+	float* tickBuffer = NULL;
+	uint8_t* pcm = NULL;
+
+	if (player != NULL)
+	{
+		tickBuffer = (float*)malloc(libft2_getMaxTickSamples(player) * 2 * sizeof(float));
+		pcm = (uint8_t*)malloc(libft2_getMaxTickSamples(player) * 2 * sizeof(int16_t));
+	}
+
+	bool ok = (player != NULL && tickBuffer != NULL && pcm != NULL);
+	if (!ok)
+		fprintf(stderr, "tickhash: Not enough memory (or unsupported rate)!\n");
+
+	if (ok && opts->writeFlag)
+	{
+		sprintf(line, "%s %u %s\n", TICKHASH_HEADER, opts->freq, interpNames[opts->interpolation]);
+		ok = handleLine(f, line, true);
+	}
+
+	const uint64_t maxSamples = (uint64_t)opts->freq * MAX_SECONDS;
+	uint64_t totalSamples = 0;
+
+	for (uint32_t tickNum = 0; ok; tickNum++)
+	{
+		if (totalSamples >= maxSamples)
+		{
+			fprintf(stderr, "tickhash: the song didn't end within %d minutes, stopping there\n", MAX_SECONDS / 60);
+			break;
+		}
+
+		const uint32_t tickSamples = libft2_renderPlayerTick(player, tickBuffer);
+		if (tickSamples == 0)
+			break; // end of song
+
+		totalSamples += tickSamples;
+
+		libft2_getPlayerState(player, &state);
+		const uint64_t stateHash = hashState(player, info.numChannels);
+		const uint64_t pcmHash = hashAudio(tickBuffer, tickSamples, pcm);
+
+		sprintf(line, "%" PRIu32 " %d %d %016" PRIX64 " %016" PRIX64 "\n", tickNum, state.songPos, state.row, stateHash, pcmHash);
+		ok = handleLine(f, line, opts->writeFlag);
+	}
+
+	if (ok && !opts->writeFlag && fgets(line, sizeof(line), f) != NULL)
+	{
+		fprintf(stderr, "tickhash: the song ended early, next expected tick:\n  expected: %s", line);
+		ok = false;
+	}
+
+	free(pcm);
+	free(tickBuffer);
+	libft2_freePlayer(player);
+	libft2_unloadModule(m);
+
+	if (fclose(f) != 0)
+		ok = false;
+
+	if (!ok)
+		return 1;
+
+	printf("tickhash: \"%s\" %s\n", modulePath, opts->writeFlag ? "written" : "OK");
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	tickHashOpts_t opts;
+	const char* paths[2];
+	int32_t numPaths = 0;
+
+	opts.writeFlag = false;
+	opts.freq = DEFAULT_FREQ;
+	opts.interpolation = LIBFT2_INTERPOLATION_LINEAR;
+
+	for (int32_t i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--write"))
+		{
+			opts.writeFlag = true;
+		}
+		else if (!strcmp(argv[i], "--rate") && i+1 < argc)
+		{
+			opts.freq = (uint32_t)atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--interp") && i+1 < argc)
+		{
+			i++;
+			if (!strcmp(argv[i], "none"))
+			{
+				opts.interpolation = LIBFT2_INTERPOLATION_NONE;
+			}
+			else if (!strcmp(argv[i], "linear"))
+			{
+				opts.interpolation = LIBFT2_INTERPOLATION_LINEAR;
+			}
+			else
+			{
+				fprintf(stderr, "tickhash: only \"none\" and \"linear\" interpolation give portable hashes\n");
+				return 1;
+			}
+		}
+		else if (numPaths < 2)
+		{
+			paths[numPaths++] = argv[i];
+		}
+		else
+		{
+			numPaths = 0;
+			break;
+		}
+	}
+
+	if (numPaths != 2)
+	{
+		fprintf(stderr, "Usage: libft2_tickhash <module> <hashfile>\n"
+		                "       libft2_tickhash --write [--rate hz] [--interp none|linear] <module> <hashfile>\n");
+		return 1;
+	}
+
+	return tickHash(paths[0], paths[1], &opts);
+}
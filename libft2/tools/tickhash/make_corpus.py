@@ -0,0 +1,339 @@
+#!/usr/bin/env python3
+"""Writes the synthetic modules of the tick hash regression corpus (see README.txt).
+
+The modules are small and made up here, so that they can be checked in. Between
+them they use every effect, the volume column, envelopes, auto-vibrato, bidi/forward
+loops, 8-bit and 16-bit samples, and linear and Amiga periods.
+
+Usage: make_corpus.py [output directory]   (default: this script's directory)
+"""
+
+import math
+import os
+import struct
+import sys
+
+# XM effect numbers (0..F, then G = 16 and so on)
+EFX = {c: i for i, c in enumerate("0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ")}
+
+NOTE_OFF = 97
+
+
+def note_num(name):  # "C-4" -> 49
+    names = ["C-", "C#", "D-", "D#", "E-", "F-", "F#", "G-", "G#", "A-", "A#", "B-"]
+    return 1 + names.index(name[:2]) + (int(name[2]) * 12)
+
+
+# sample data
+
+def sine(length, period, amp=110):
+    return [int(round(amp * math.sin(2 * math.pi * i / period))) for i in range(length)]
+
+
+def square(length, period, amp=20000):
+    return [amp if (i % period) < (period // 2) else -amp for i in range(length)]
+
+
+def noise(length, seed=12345, amp=120):  # decaying noise, an LCG so it's the same everywhere
+    out = []
+    for i in range(length):
+        seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+        out.append(int(((seed >> 16) % (2 * amp + 1) - amp) * (length - i) / length))
+    return out
+
+
+def saw16(length, period, amp=24000):
+    return [int(amp * (2 * (i % period) / period - 1)) for i in range(length)]
+
+
+def delta8(points):
+    out, last = bytearray(), 0
+    for s in points:
+        out.append((s - last) & 0xFF)
+        last = s
+    return bytes(out)
+
+
+def delta16(points):
+    out, last = bytearray(), 0
+    for s in points:
+        out += struct.pack("<H", (s - last) & 0xFFFF)
+        last = s
+    return bytes(out)
+
+
+# XM
+
+class XMSample:
+    def __init__(self, points, bits=8, loop=0, loop_start=0, loop_len=0, volume=64, finetune=0,
+                 panning=128, rel_note=0):
+        self.points, self.bits, self.loop = points, bits, loop
+        self.loop_start, self.loop_len = loop_start, loop_len
+        self.volume, self.finetune, self.panning, self.rel_note = volume, finetune, panning, rel_note
+
+    def header(self, name):
+        n = 2 if self.bits == 16 else 1
+        flags = self.loop | (0x10 if self.bits == 16 else 0)
+        return struct.pack("<IIIBbBBbB", len(self.points) * n, self.loop_start * n, self.loop_len * n,
+                           self.volume, self.finetune, flags, self.panning, self.rel_note, 0) + name.ljust(22, b"\0")
+
+    def data(self):
+        return delta16(self.points) if self.bits == 16 else delta8(self.points)
+
+
+class XMInstrument:
+    def __init__(self, name, samples, vol_env=None, pan_env=None, vol_sustain=None, vol_loop=None,
+                 pan_sustain=None, pan_loop=None, fadeout=0, vibrato=(0, 0, 0, 0), note_map=None):
+        self.name, self.samples = name, samples
+        self.vol_env, self.pan_env = vol_env, pan_env
+        self.vol_sustain, self.vol_loop = vol_sustain, vol_loop
+        self.pan_sustain, self.pan_loop = pan_sustain, pan_loop
+        self.fadeout, self.vibrato = fadeout, vibrato
+        self.note_map = note_map or [0] * 96
+
+    @staticmethod
+    def env_points(env):
+        env = env or []
+        return b"".join(struct.pack("<HH", x, y) for x, y in env).ljust(48, b"\0")
+
+    @staticmethod
+    def env_type(env, sustain, loop):
+        if not env:
+            return 0
+        return 1 | (2 if sustain is not None else 0) | (4 if loop is not None else 0)
+
+    def encode(self):
+        body = self.name.ljust(22, b"\0") + bytes([0]) + struct.pack("<H", len(self.samples))
+        if not self.samples:
+            return struct.pack("<I", 4 + len(body)) + body
+
+        vol_loop = self.vol_loop or (0, 0)
+        pan_loop = self.pan_loop or (0, 0)
+        body += struct.pack("<I", 40) + bytes(self.note_map)
+        body += self.env_points(self.vol_env) + self.env_points(self.pan_env)
+        body += bytes([len(self.vol_env or []), len(self.pan_env or []),
+                       self.vol_sustain or 0, vol_loop[0], vol_loop[1],
+                       self.pan_sustain or 0, pan_loop[0], pan_loop[1],
+                       self.env_type(self.vol_env, self.vol_sustain, self.vol_loop),
+                       self.env_type(self.pan_env, self.pan_sustain, self.pan_loop)])
+        body += bytes(self.vibrato) + struct.pack("<H", self.fadeout) + bytes(22)
+
+        out = struct.pack("<I", 4 + len(body)) + body
+        for i, s in enumerate(self.samples):
+            out += s.header(b"smp%d" % i)
+        for s in self.samples:
+            out += s.data()
+        return out
+
+
+def xm_pattern(rows, num_channels, cells):
+    """cells: {(row, channel): (note, instr, vol, efx, param)}, note as "C-4"/NOTE_OFF/0"""
+    data = bytearray()
+    for r in range(rows):
+        for c in range(num_channels):
+            note, ins, vol, efx, param = cells.get((r, c), (0, 0, 0, 0, 0))
+            if isinstance(note, str):
+                note = note_num(note)
+            if isinstance(efx, str):
+                efx = EFX[efx]
+            data += bytes([note, ins, vol, efx, param])  # unpacked notes are allowed in packed data
+    return struct.pack("<IBHH", 9, 0, rows, len(data)) + bytes(data)
+
+
+def xm_module(name, num_channels, orders, patterns, instruments, linear=True, speed=6, bpm=125, restart=0):
+    out = b"Extended Module: " + name.ljust(20, b" ") + b"\x1a" + b"FastTracker v2.00   " + struct.pack("<H", 0x0104)
+    out += struct.pack("<IHHHHHHHH", 276, len(orders), restart, num_channels, len(patterns),
+                       len(instruments), 1 if linear else 0, speed, bpm)
+    out += bytes(orders).ljust(256, b"\0")
+    for p in patterns:
+        out += p
+    for ins in instruments:
+        out += ins.encode()
+    return out
+
+
+def xm_instruments():
+    lead = XMInstrument(b"lead", [XMSample(sine(256, 32), loop=1, loop_start=0, loop_len=256)],
+                        vol_env=[(0, 64), (8, 48), (24, 32), (64, 0)], vol_sustain=2,
+                        pan_env=[(0, 16), (16, 48), (32, 16)], pan_loop=(0, 2),
+                        fadeout=2048, vibrato=(0, 16, 4, 8))
+    bass = XMInstrument(b"bass", [XMSample(square(512, 64), bits=16, loop=2, loop_start=64, loop_len=384,
+                                           volume=48, finetune=-16, rel_note=-12)])
+    drum = XMInstrument(b"drum", [XMSample(noise(3000)), XMSample(noise(800, seed=777), panning=200)],
+                        note_map=[0] * 48 + [1] * 48)
+    pad = XMInstrument(b"pad", [XMSample(saw16(1024, 128), bits=16, loop=1, loop_start=128, loop_len=768,
+                                         finetune=37, rel_note=5)],
+                       vol_env=[(0, 0), (16, 64), (40, 40), (80, 40)], vol_loop=(2, 3),
+                       fadeout=512, vibrato=(1, 0, 8, 4))
+    return [lead, bass, drum, pad]
+
+
+def effects_xm(linear):
+    nc = 8
+    pats = []
+
+    # 0: notes, the volume column
+    cells = {}
+    for r in range(0, 48, 4):
+        cells[(r, 0)] = ("C-4" if (r // 4) % 2 == 0 else "G-4", 1, 0, 0, 0)
+        cells[(r, 1)] = ("C-3", 2, 0, 0, 0)
+        cells[(r, 2)] = ("C-4" if (r // 4) % 3 else "C-5", 3, 0, 0, 0)
+    vol_col = [0x10, 0x30, 0x50, 0x64, 0x72, 0x83, 0x92, 0xA4, 0xB6, 0xC3, 0xDA, 0xE5, 0xF8]
+    for i, v in enumerate(vol_col):
+        cells[(i * 3, 3)] = ("E-4" if i % 4 == 0 else 0, 4 if i % 4 == 0 else 0, v, 0, 0)
+        cells[(i * 3 + 1, 3)] = (0, 0, v if v >= 0x60 else 0, 0, 0)
+    cells[(20, 4)] = ("A-4", 4, 0x40, 0, 0)
+    cells[(24, 4)] = ("C-5", 0, 0xF4, 0, 0)  # volume column tone portamento
+    cells[(32, 4)] = (NOTE_OFF, 0, 0, 0, 0)
+    cells[(40, 4)] = ("A-4", 1, 0, 0, 0)
+    cells[(46, 4)] = (NOTE_OFF, 0, 0, 0, 0)
+    pats.append(xm_pattern(48, nc, cells))
+
+    # 1: effects 0..F, G..X
+    cells = {}
+    e = [("0", 0x37), ("1", 0x08), ("2", 0x06), ("3", 0x10), ("4", 0x46), ("5", 0x02), ("6", 0x30), ("7", 0x58),
+         ("8", 0x20), ("9", 0x02), ("A", 0x0F), ("C", 0x20), ("E", 0x12), ("E", 0x23), ("E", 0x31), ("E", 0x41),
+         ("E", 0x56), ("E", 0x71), ("E", 0x88), ("E", 0x93), ("E", 0xA4), ("E", 0xB2), ("H", 0x04), ("G", 0x30),
+         ("K", 0x03), ("L", 0x10), ("P", 0x60), ("R", 0x83), ("T", 0x21), ("X", 0x12), ("X", 0x23), ("P", 0x05),
+         ("A", 0x30), ("4", 0x8F), ("0", 0xC0), ("1", 0xF3), ("2", 0xE4), ("7", 0x3F), ("H", 0x30), ("G", 0x40)]
+    for i, (efx, param) in enumerate(e):
+        row = i + (i // 8) * 2
+        ch = i % 4
+        note = ("C-4", "D#4", "G-3", "A#4")[ch] if i % 3 != 1 else 0
+        ins = (1, 2, 4, 1)[ch] if note else 0
+        if efx == "3":
+            note = "C-5"
+        cells[(row, ch)] = (note, ins, 0, efx, param)
+        if efx in "0123456789ACPRTX":  # carry some effects over a few rows (memory)
+            cells[(row + 1, ch)] = (0, 0, 0, efx, 0)
+    for r in range(0, 48, 6):
+        cells[(r, 5)] = ("C-5", 3, 0, 0, 0)
+        cells[(r + 3, 6)] = ("F-3", 2, 0, "8", (r * 5) & 0xFF)
+    cells[(10, 7)] = (0, 0, 0, "F", 0x05)
+    cells[(20, 7)] = (0, 0, 0, "F", 0x90)
+    cells[(30, 7)] = (0, 0, 0, "F", 0x7D)
+    pats.append(xm_pattern(52, nc, cells))
+
+    # 2: flow control: pattern loop, pattern delay, note delay and cut, break/jump
+    cells = {}
+    for r in range(0, 32, 2):
+        cells[(r, 0)] = ("C-4" if r % 4 == 0 else "E-4", 1, 0, 0, 0)
+        cells[(r, 1)] = ("G-2", 2, 0x20 + r, 0, 0)
+    cells[(4, 2)] = (0, 0, 0, "E", 0x60)
+    cells[(7, 2)] = (0, 0, 0, "E", 0x62)
+    cells[(9, 3)] = ("C-5", 3, 0, "E", 0xD3)
+    cells[(11, 3)] = ("C-5", 3, 0, "E", 0xC2)
+    cells[(13, 2)] = (0, 0, 0, "E", 0xE2)
+    cells[(16, 4)] = ("A-4", 4, 0, "E", 0x90)
+    cells[(17, 4)] = (0, 0, 0, "E", 0x93)
+    cells[(20, 5)] = ("F-4", 1, 0, "E", 0xD9)  # delay past the tick count, not played
+    cells[(24, 6)] = ("C-4", 4, 0, "K", 0x00)
+    cells[(26, 6)] = (0, 0, 0, "L", 0x05)
+    cells[(28, 7)] = (0, 0, 0, "D", 0x08)
+    pats.append(xm_pattern(32, nc, cells))
+
+    # 3: entered at row 8 by the break above, then jumps (Bxx) to the last position
+    cells = {}
+    for r in range(16):
+        cells[(r, r % nc)] = (("C-4", "E-4", "G-4", "B-4")[r % 4], 1 + (r % 4), 0x40 - r * 2, 0, 0)
+    cells[(15, 0)] = (0, 0, 0, "B", 0x04)
+    pats.append(xm_pattern(16, nc, cells))
+
+    # 4: the last position
+    cells = {(0, 0): ("C-4", 4, 0, 0, 0), (0, 1): ("C-3", 2, 0, 0, 0), (8, 0): (NOTE_OFF, 0, 0, 0, 0),
+             (15, 1): (0, 0, 0, "A", 0x0F)}
+    pats.append(xm_pattern(16, nc, cells))
+
+    name = b"tickhash effects" if linear else b"tickhash amiga"
+    return xm_module(name, nc, [0, 1, 2, 3, 4], pats, xm_instruments(), linear=linear, speed=6, bpm=140)
+
+
+# MOD
+
+PT_PERIODS = [856, 808, 762, 720, 678, 640, 604, 570, 538, 508, 480, 453,
+              428, 404, 381, 360, 339, 320, 302, 285, 269, 254, 240, 226,
+              214, 202, 190, 180, 170, 160, 151, 143, 135, 127, 120, 113]
+
+
+def mod_period(name):  # "C-1".."B-3"
+    return PT_PERIODS[note_num(name) - note_num("C-1")]
+
+
+def mod_module():
+    samples = [
+        (sine(512, 32, 100), 0, 0, 512),  # (points, finetune, loop start, loop length) in samples
+        (square(256, 32, 90), 3, 0, 256),
+        (noise(2000), 0, 0, 0),
+        (sine(1024, 64, 120), -4 & 15, 256, 768),
+    ]
+
+    out = b"tickhash protracker".ljust(20, b"\0")
+    for i in range(31):
+        if i < len(samples):
+            points, finetune, ls, ll = samples[i]
+            out += (b"smp%d" % i).ljust(22, b"\0") + struct.pack(">HBBHH", len(points) // 2, finetune, 64,
+                                                               ls // 2, max(ll // 2, 1))
+        else:
+            out += bytes(22) + struct.pack(">HBBHH", 0, 0, 0, 0, 1)
+
+    orders = [0, 1, 2, 1]
+    out += bytes([len(orders), 127]) + bytes(orders).ljust(128, b"\0") + b"M.K."
+
+    def pattern(cells):
+        data = bytearray()
+        for r in range(64):
+            for c in range(4):
+                note, smp, efx, param = cells.get((r, c), (0, 0, 0, 0))
+                period = mod_period(note) if note else 0
+                data += bytes([(smp & 0xF0) | (period >> 8), period & 0xFF, ((smp & 15) << 4) | efx, param])
+        return bytes(data)
+
+    cells = {}
+    for r in range(0, 64, 4):
+        cells[(r, 0)] = ("C-2" if r % 8 == 0 else "G-2", 1, 0, 0)
+        cells[(r, 1)] = ("C-1", 2, 0xC, 0x30)
+        cells[(r + 2, 2)] = ("C-3", 3, 0, 0) if r % 16 == 0 else (0, 0, 0, 0)
+    e = [(0, 0x47), (1, 0x04), (2, 0x03), (3, 0x08), (4, 0x38), (5, 0x02), (6, 0x20), (7, 0x66), (9, 0x04),
+         (0xA, 0x04), (0xE, 0x13), (0xE, 0x24), (0xE, 0x91), (0xE, 0xC3), (0xE, 0xD2), (0xE, 0x4), (0xE, 0x71)]
+    for i, (efx, param) in enumerate(e):
+        note = ("A-2", "E-2", "C#3")[i % 3] if i % 2 == 0 or efx == 3 else 0
+        cells[(i * 3 + 1, 3)] = (note, 4 if note else 0, efx, param)
+        cells[(i * 3 + 2, 3)] = (0, 0, efx if efx not in (0xE, 9) else 0, 0)
+    pat0 = pattern(cells)
+
+    cells = {}
+    for r in range(0, 64, 2):
+        cells[(r, 0)] = (("C-2", "D#2", "G-2", "A#2")[(r // 2) % 4], 4, 0, 0)
+    cells[(8, 1)] = ("C-2", 1, 0xE, 0x60)
+    cells[(12, 1)] = (0, 0, 0xE, 0x62)
+    cells[(16, 2)] = (0, 0, 0xE, 0xE3)
+    cells[(24, 2)] = (0, 0, 0xF, 0x04)
+    cells[(32, 2)] = (0, 0, 0xF, 0x90)
+    cells[(48, 3)] = (0, 0, 0xD, 0x08)
+    pat1 = pattern(cells)
+
+    cells = {(0, 0): ("C-3", 3, 0, 0), (4, 1): ("G-2", 2, 0xE, 0x8F), (16, 2): ("C-2", 1, 0xF, 0x03),
+             (32, 3): (0, 0, 0xB, 0x03)}
+    pat2 = pattern(cells)
+
+    out += pat0 + pat1 + pat2
+    for points, *_ in samples:
+        out += bytes(s & 0xFF for s in points)
+    return out
+
+
+def main():
+    outdir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    files = {
+        "effects.xm": effects_xm(True),
+        "amiga.xm": effects_xm(False),
+        "protracker.mod": mod_module(),
+    }
+    for name, data in files.items():
+        with open(os.path.join(outdir, name), "wb") as f:
+            f.write(data)
+        print("%s: %d bytes" % (name, len(data)))
+
+
+if __name__ == "__main__":
+    main()
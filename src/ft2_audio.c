@@ -5,18 +5,23 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <math.h>
 #include "ft2_header.h"
 #include "ft2_config.h"
 #include "scopes/ft2_scopes.h"
+#ifndef FT2_HEADLESS
 #include "ft2_video.h"
 #include "ft2_gui.h"
+#endif
 #include "ft2_midi.h"
 #include "ft2_wav_renderer.h"
 #include "ft2_tables.h"
 #include "ft2_structs.h"
+#include "ft2_hpc.h"
 #include "mixer/ft2_mix.h"
 #include "mixer/ft2_center_mix.h"
 #include "mixer/ft2_silence_mix.h"
+#include "mixer/ft2_halfband.h"
 
 // hide POSIX warnings
 #ifdef _MSC_VER
@@ -25,11 +30,27 @@
 
 #define INITIAL_DITHER_SEED 0x12345000
 
-static int32_t smpShiftValue;
+#ifndef FT2_HEADLESS
+static int32_t smpShiftValue; // bytes -> samples in the audio callback
+#endif
 static uint32_t oldAudioFreq, tickTimeLenInt, randSeed = INITIAL_DITHER_SEED;
 static uint64_t tickTimeLenFrac;
 static double dAudioNormalizeMul, dSqrtPanningTable[256+1], dPrngStateL, dPrngStateR;
-static voice_t voice[MAX_CHANNELS * 2];
+static uint32_t stemRandSeed[MAX_CHANNELS];
+static double dStemPrngStateL[MAX_CHANNELS], dStemPrngStateR[MAX_CHANNELS];
+static voice_t xmVoice[MAX_XM_CHANNELS * 2], *voice = xmVoice; // the channels' voices, then their volume ramp fadeout-voices
+static int32_t numVoiceChannels = MAX_XM_CHANNELS;
+
+// live voice events (playTone() etc.), applied at a sample offset inside the next audio buffer
+static bool liveEventPending[MAX_CHANNELS];
+static uint8_t liveStatus[MAX_CHANNELS];
+static int32_t numLiveEvents;
+#ifndef FT2_HEADLESS
+static uint8_t liveEventCh[MAX_CHANNELS];
+static uint32_t liveEventOffset[MAX_CHANNELS], lastCallbackSamples;
+static uint64_t lastCallbackTime64;
+#endif
+static float fHalfBandHistoryL[HALFBAND_HISTORY], fHalfBandHistoryR[HALFBAND_HISTORY];
 
 // globalized
 audio_t audio;
@@ -42,14 +63,36 @@ volatile bool pattQueueClearing, chQueueClearing;
 void resetCachedMixerVars(void)
 {
 	channel_t *ch = channel;
-	for (int32_t i = 0; i < MAX_CHANNELS; i++, ch++)
+	for (int32_t i = 0; i < numAllocatedChannels; i++, ch++)
 		ch->oldFinalPeriod = -1;
 
 	voice_t *v = voice;
-	for (int32_t i = 0; i < MAX_CHANNELS*2; i++, v++)
+	for (int32_t i = 0; i < numVoiceChannels*2; i++, v++)
 		v->oldDelta = 0;
 }
 
+bool allocateVoices(int32_t numChannels)
+{
+	voice_t *newVoice = xmVoice;
+	if (numChannels > MAX_XM_CHANNELS)
+	{
+		newVoice = (voice_t *)malloc(numChannels * 2 * sizeof (voice_t));
+		if (newVoice == NULL)
+			return false;
+	}
+
+	if (voice != xmVoice)
+		free(voice);
+
+	voice = newVoice;
+	numVoiceChannels = numChannels;
+
+	for (int32_t i = 0; i < numVoiceChannels; i++)
+		stopVoice(i);
+
+	return true;
+}
+
 void stopVoice(int32_t i)
 {
 	voice_t *v;
@@ -60,11 +103,18 @@ void stopVoice(int32_t i)
 
 	// clear "fade out" voice too
 
-	v = &voice[MAX_CHANNELS + i];
+	v = &voice[numVoiceChannels + i];
 	memset(v, 0, sizeof (voice_t));
 	v->panning = 128;
 }
 
+int32_t getVoicePosition(int32_t i) // -1 if the channel's voice isn't playing
+{
+	const voice_t *v = &voice[i];
+	return v->active ? v->position : -1;
+}
+
+#ifndef FT2_HEADLESS
 bool setNewAudioSettings(void) // only call this from the main input/video thread
 {
 	pauseAudio();
@@ -106,6 +156,7 @@ bool setNewAudioSettings(void) // only call this from the main input/video threa
 	setWavRenderBitDepth((config.specialFlags & BITDEPTH_32) ? 32 : 16);
 	return true;
 }
+#endif
 
 // amp = 1..32, masterVol = 0..256
 void setAudioAmp(int16_t amp, int16_t masterVol, bool bitDepth32Flag)
@@ -120,6 +171,12 @@ void setAudioAmp(int16_t amp, int16_t masterVol, bool bitDepth32Flag)
 	dAudioNormalizeMul = dAmp;
 }
 
+void scaleAudioAmp(double dGain) // f.ex. for loudness normalization, call after setAudioAmp()
+{
+	dAudioNormalizeMul *= dGain;
+}
+
+#ifndef FT2_HEADLESS
 void decreaseMasterVol(void)
 {
 	if (config.masterVol >= 16)
@@ -147,6 +204,7 @@ void increaseMasterVol(void)
 	if (ui.configScreenShown && editor.currConfigScreen == CONFIG_SCREEN_AUDIO)
 		drawScrollBar(SB_MASTERVOL_SCROLL);
 }
+#endif
 
 void setNewAudioFreq(uint32_t freq) // for song-to-WAV rendering
 {
@@ -199,13 +257,13 @@ void audioSetInterpolationType(uint8_t interpolationType)
 	audio.interpolationType = interpolationType;
 
 	// set sinc polyphase LUT pointers
-	if (config.interpolation == INTERPOLATION_SINC8)
+	if (interpolationType == INTERPOLATION_SINC8)
 	{
 		fKaiserSinc = fKaiserSinc_8;
 		fDownSample1 = fDownSample1_8;
 		fDownSample2 = fDownSample2_8;
 	}
-	else if (config.interpolation == INTERPOLATION_SINC16)
+	else if (interpolationType == INTERPOLATION_SINC16)
 	{
 		fKaiserSinc = fKaiserSinc_16;
 		fDownSample1 = fDownSample1_16;
@@ -215,6 +273,30 @@ void audioSetInterpolationType(uint8_t interpolationType)
 	unlockMixerCallback();
 }
 
+/* 2x oversampled mixing: the voices are mixed at twice the output rate, then decimated with
+** a half-band filter. This roughly doubles the mixing time and only helps the notes played
+** faster than the output rate. sinc8/sinc16 without it are much cleaner and about as cheap
+** (see libft2/tools/libft2_aliasing.c for the numbers).
+** Only the voice deltas and volume ramp lengths change, the replayer timing doesn't.
+*/
+void audioSetOversampling(bool oversampling)
+{
+	lockMixerCallback();
+
+	audio.oversamplingFlag = oversampling;
+	calcReplayerVars(audio.freq); // mixing rate changed
+	resetCachedMixerVars();
+	resetOversamplingFilter();
+
+	unlockMixerCallback();
+}
+
+void resetOversamplingFilter(void)
+{
+	memset(fHalfBandHistoryL, 0, sizeof (fHalfBandHistoryL));
+	memset(fHalfBandHistoryR, 0, sizeof (fHalfBandHistoryR));
+}
+
 void calcPanningTable(void)
 {
 	// same formula as FT2's panning table (with 0.0 .. 1.0 scale)
@@ -250,7 +332,7 @@ static void voiceUpdateVolumes(int32_t i, uint8_t status)
 		{
 			// setup fadeout voice
 
-			voice_t *f = &voice[MAX_CHANNELS+i];
+			voice_t *f = &voice[numVoiceChannels+i];
 
 			*f = *v; // store current voice in respective fadeout ramp voice
 
@@ -281,6 +363,8 @@ static void voiceUpdateVolumes(int32_t i, uint8_t status)
 
 		// IS_QuickVol = 5ms, otherwise the duration of a tick
 		v->volumeRampLength = (status & IS_QuickVol) ? audio.quickVolRampSamples : audio.samplesPerTickInt;
+		if (audio.oversamplingFlag && !(status & IS_QuickVol))
+			v->volumeRampLength *= 2; // quickVolRampSamples is already at the mixing rate
 		const float fVolumeRampLength = (float)(int32_t)v->volumeRampLength;
 
 		v->fVolumeLDelta = fVolumeLDiff / fVolumeRampLength;
@@ -352,72 +436,268 @@ void resetRampVolumes(void)
 	}
 }
 
+static void updateVoice(int32_t i, uint8_t status)
+{
+	channel_t *ch = &channel[i];
+	voice_t *v = &voice[i];
+
+	if (status & IS_Vol)
+	{
+		v->dVolume = ch->dFinalVol;
+
+		// set scope volume
+		const int32_t scopeVolume = (int32_t)((SCOPE_HEIGHT * ch->dFinalVol) + 0.5); // rounded
+		v->scopeVolume = (uint8_t)scopeVolume;
+	}
+
+	if (status & IS_Pan)
+		v->panning = ch->finalPan;
+
+	if (status & (IS_Vol + IS_Pan))
+		voiceUpdateVolumes(i, status);
+
+	if (status & IS_Period)
+	{
+		// use cached values when possible
+		if (ch->finalPeriod != ch->oldFinalPeriod)
+		{
+			ch->oldFinalPeriod = ch->finalPeriod;
+
+			if (ch->finalPeriod == 0) // in FT2, period 0 -> delta 0
+			{
+				v->scopeDelta = 0;
+				v->oldDelta = 0;
+				v->fSincLUT = fKaiserSinc;
+			}
+			else
+			{
+				const double dHz = dPeriod2Hz(ch->finalPeriod);
+				const uintCPUWord_t delta = v->oldDelta = (intCPUWord_t)((dHz * audio.dHz2MixDeltaMul) + 0.5); // Hz -> fixed-point delta (rounded)
+
+				// decide which polyphase sinc LUT to use according to resampling ratio
+				if (delta <= (uintCPUWord_t)(1.1875 * MIXER_FRAC_SCALE))
+					v->fSincLUT = fKaiserSinc;
+				else if (delta <= (uintCPUWord_t)(1.5 * MIXER_FRAC_SCALE))
+					v->fSincLUT = fDownSample1;
+				else
+					v->fSincLUT = fDownSample2;
+
+				// set scope delta
+				const double dHz2ScopeDeltaMul = SCOPE_FRAC_SCALE / (double)SCOPE_HZ;
+				v->scopeDelta = (intCPUWord_t)((dHz * dHz2ScopeDeltaMul) + 0.5); // Hz -> fixed-point delta (rounded)
+			}
+		}
+
+		v->delta = v->oldDelta;
+	}
+
+	if (status & IS_Trigger)
+		voiceTrigger(i, ch->smpPtr, ch->smpStartPos);
+}
+
 void updateVoices(void)
 {
 	channel_t *ch = channel;
-	voice_t *v = voice;
-
-	for (int32_t i = 0; i < song.numChannels; i++, ch++, v++)
+	for (int32_t i = 0; i < song.numChannels; i++, ch++)
 	{
-		const uint8_t status = ch->tmpStatus = ch->status; // (tmpStatus is used for audio/video sync queue)
+		const uint8_t status = ch->status;
+
+		// (tmpStatus is used for audio/video sync queue, include what live events did since the last tick)
+		ch->tmpStatus = status | liveStatus[i];
+		liveStatus[i] = 0;
+
 		if (status == 0)
 			continue;
 
 		ch->status = 0;
+		updateVoice(i, status);
+	}
+}
 
-		if (status & IS_Vol)
-		{
-			v->dVolume = ch->dFinalVol;
+/* Called (with the audio locked) after playTone() and friends have updated a channel.
+** Instead of waiting for the next replayer tick, the voice is updated inside the next
+** audio buffer, at the same offset from its start as this call was from the start of
+** the last one. This gives live input a fixed one-buffer latency with no tick quantization.
+*/
+void queueLiveVoiceEvent(int32_t chNum)
+{
+#ifdef FT2_HEADLESS
+	(void)chNum; // no audio device, the next replayer tick will update the voice
+#else
+	if (audio.dev == 0 || editor.wavIsRendering || liveEventPending[chNum])
+		return; // the next replayer tick will update the voice
+
+	uint32_t offset = 0;
+	if (lastCallbackSamples > 0 && hpcFreq.freq64 > 0)
+	{
+		const uint64_t elapsed = SDL_GetPerformanceCounter() - lastCallbackTime64;
+		const double dOffset = ((double)elapsed * audio.freq) / hpcFreq.freq64;
 
-			// set scope volume
-			const int32_t scopeVolume = (int32_t)((SCOPE_HEIGHT * ch->dFinalVol) + 0.5); // rounded
-			v->scopeVolume = (uint8_t)scopeVolume;
-		}
+		offset = (dOffset < lastCallbackSamples) ? (uint32_t)dOffset : lastCallbackSamples-1;
+	}
 
-		if (status & IS_Pan)
-			v->panning = ch->finalPan;
+	// insert sorted by offset
+	int32_t i = numLiveEvents;
+	while (i > 0 && liveEventOffset[i-1] > offset)
+	{
+		liveEventCh[i] = liveEventCh[i-1];
+		liveEventOffset[i] = liveEventOffset[i-1];
+		i--;
+	}
 
-		if (status & (IS_Vol + IS_Pan))
-			voiceUpdateVolumes(i, status);
+	liveEventCh[i] = (uint8_t)chNum;
+	liveEventOffset[i] = offset;
+	liveEventPending[chNum] = true;
+	numLiveEvents++;
+#endif
+}
 
-		if (status & IS_Period)
-		{
-			// use cached values when possible
-			if (ch->finalPeriod != ch->oldFinalPeriod)
-			{
-				ch->oldFinalPeriod = ch->finalPeriod;
+#ifndef FT2_HEADLESS
+static void applyLiveVoiceEvent(int32_t chNum)
+{
+	liveEventPending[chNum] = false;
 
-				if (ch->finalPeriod == 0) // in FT2, period 0 -> delta 0
-				{
-					v->scopeDelta = 0;
-					v->oldDelta = 0;
-					v->fSincLUT = fKaiserSinc;
-				}
-				else
-				{
-					const double dHz = dPeriod2Hz(ch->finalPeriod);
-					const uintCPUWord_t delta = v->oldDelta = (intCPUWord_t)((dHz * audio.dHz2MixDeltaMul) + 0.5); // Hz -> fixed-point delta (rounded)
-
-					// decide which polyphase sinc LUT to use according to resampling ratio
-					if (delta <= (uintCPUWord_t)(1.1875 * MIXER_FRAC_SCALE))
-						v->fSincLUT = fKaiserSinc;
-					else if (delta <= (uintCPUWord_t)(1.5 * MIXER_FRAC_SCALE))
-						v->fSincLUT = fDownSample1;
-					else
-						v->fSincLUT = fDownSample2;
-
-					// set scope delta
-					const double dHz2ScopeDeltaMul = SCOPE_FRAC_SCALE / (double)SCOPE_HZ;
-					v->scopeDelta = (intCPUWord_t)((dHz * dHz2ScopeDeltaMul) + 0.5); // Hz -> fixed-point delta (rounded)
-				}
-			}
+	channel_t *ch = &channel[chNum];
 
-			v->delta = v->oldDelta;
-		}
+	const uint8_t status = ch->status;
+	if (status == 0)
+		return; // a replayer tick already took care of it
+
+	ch->status = 0;
+	liveStatus[chNum] |= status;
+
+	updateVoice(chNum, status);
+}
+#endif
 
-		if (status & IS_Trigger)
-			voiceTrigger(i, ch->smpPtr, ch->smpStartPos);
+static void clearLiveVoiceEvents(void)
+{
+	memset(liveEventPending, 0, sizeof (liveEventPending));
+	memset(liveStatus, 0, sizeof (liveStatus));
+	numLiveEvents = 0;
+}
+
+struct mixerState_t
+{
+	voice_t *voice; // swapped, not copied
+	int32_t numVoiceChannels;
+	uint8_t liveStatus[MAX_CHANNELS];
+	uint32_t randSeed, tickTimeLenInt;
+	uint64_t tickTimeLenFrac;
+	double dAudioNormalizeMul, dPrngStateL, dPrngStateR;
+	float fHalfBandHistoryL[HALFBAND_HISTORY], fHalfBandHistoryR[HALFBAND_HISTORY];
+
+	// from audio_t
+	uint32_t freq, quickVolRampSamples, samplesPerTickInt, samplesPerTickIntTab[(MAX_BPM-MIN_BPM)+1];
+	uint32_t tickTimeIntTab[(MAX_BPM-MIN_BPM)+1];
+	uint64_t samplesPerTickFrac, samplesPerTickFracTab[(MAX_BPM-MIN_BPM)+1], tickTimeFracTab[(MAX_BPM-MIN_BPM)+1];
+	double dHz2MixDeltaMul;
+};
+
+static void storeMixerState(mixerState_t *s)
+{
+	s->voice = voice;
+	s->numVoiceChannels = numVoiceChannels;
+	memcpy(s->liveStatus, liveStatus, sizeof (liveStatus));
+	s->randSeed = randSeed;
+	s->dPrngStateL = dPrngStateL;
+	s->dPrngStateR = dPrngStateR;
+	s->dAudioNormalizeMul = dAudioNormalizeMul;
+	s->tickTimeLenInt = tickTimeLenInt;
+	s->tickTimeLenFrac = tickTimeLenFrac;
+	memcpy(s->fHalfBandHistoryL, fHalfBandHistoryL, sizeof (fHalfBandHistoryL));
+	memcpy(s->fHalfBandHistoryR, fHalfBandHistoryR, sizeof (fHalfBandHistoryR));
+
+	s->freq = audio.freq;
+	s->quickVolRampSamples = audio.quickVolRampSamples;
+	s->dHz2MixDeltaMul = audio.dHz2MixDeltaMul;
+	s->samplesPerTickInt = audio.samplesPerTickInt;
+	s->samplesPerTickFrac = audio.samplesPerTickFrac;
+	memcpy(s->samplesPerTickIntTab, audio.samplesPerTickIntTab, sizeof (audio.samplesPerTickIntTab));
+	memcpy(s->samplesPerTickFracTab, audio.samplesPerTickFracTab, sizeof (audio.samplesPerTickFracTab));
+	memcpy(s->tickTimeIntTab, audio.tickTimeIntTab, sizeof (audio.tickTimeIntTab));
+	memcpy(s->tickTimeFracTab, audio.tickTimeFracTab, sizeof (audio.tickTimeFracTab));
+}
+
+static void loadMixerState(const mixerState_t *s)
+{
+	voice = s->voice;
+	numVoiceChannels = s->numVoiceChannels;
+	memcpy(liveStatus, s->liveStatus, sizeof (liveStatus));
+	randSeed = s->randSeed;
+	dPrngStateL = s->dPrngStateL;
+	dPrngStateR = s->dPrngStateR;
+	dAudioNormalizeMul = s->dAudioNormalizeMul;
+	tickTimeLenInt = s->tickTimeLenInt;
+	tickTimeLenFrac = s->tickTimeLenFrac;
+	memcpy(fHalfBandHistoryL, s->fHalfBandHistoryL, sizeof (fHalfBandHistoryL));
+	memcpy(fHalfBandHistoryR, s->fHalfBandHistoryR, sizeof (fHalfBandHistoryR));
+
+	audio.freq = s->freq;
+	audio.quickVolRampSamples = s->quickVolRampSamples;
+	audio.dHz2MixDeltaMul = s->dHz2MixDeltaMul;
+	audio.samplesPerTickInt = s->samplesPerTickInt;
+	audio.samplesPerTickFrac = s->samplesPerTickFrac;
+	memcpy(audio.samplesPerTickIntTab, s->samplesPerTickIntTab, sizeof (audio.samplesPerTickIntTab));
+	memcpy(audio.samplesPerTickFracTab, s->samplesPerTickFracTab, sizeof (audio.samplesPerTickFracTab));
+	memcpy(audio.tickTimeIntTab, s->tickTimeIntTab, sizeof (audio.tickTimeIntTab));
+	memcpy(audio.tickTimeFracTab, s->tickTimeFracTab, sizeof (audio.tickTimeFracTab));
+}
+
+mixerState_t *copyMixerState(int32_t numChannels)
+{
+	numChannels = CLAMP(numChannels, MAX_XM_CHANNELS, MAX_CHANNELS);
+
+	mixerState_t *s = (mixerState_t *)malloc(sizeof (mixerState_t));
+	voice_t *newVoice = (voice_t *)calloc(numChannels * 2, sizeof (voice_t));
+
+	if (s == NULL || newVoice == NULL)
+	{
+		free(s);
+		free(newVoice);
+		return NULL;
 	}
+
+	const bool audioWasntLocked = !audio.locked;
+	if (audioWasntLocked)
+		lockAudio();
+
+	storeMixerState(s);
+	memset(s->liveStatus, 0, sizeof (s->liveStatus)); // live voice events belong to the live playback
+
+	const int32_t numCopied = MIN(numChannels, numVoiceChannels);
+	memcpy(newVoice, voice, numCopied * sizeof (voice_t));
+	memcpy(&newVoice[numChannels], &voice[numVoiceChannels], numCopied * sizeof (voice_t));
+
+	if (audioWasntLocked)
+		unlockAudio();
+
+	s->voice = newVoice;
+	s->numVoiceChannels = numChannels;
+
+	return s;
+}
+
+void freeMixerState(mixerState_t *s)
+{
+	if (s == NULL)
+		return;
+
+	if (s->voice != xmVoice) // only if it's still swapped in, which it shouldn't be
+		free(s->voice);
+
+	free(s);
+}
+
+void swapMixerState(mixerState_t *s)
+{
+	static mixerState_t tmpState; // only used from the main thread
+
+	assert(audio.locked);
+
+	storeMixerState(&tmpState);
+	loadMixerState(s);
+	*s = tmpState;
 }
 
 void resetAudioDither(void)
@@ -425,6 +705,12 @@ void resetAudioDither(void)
 	randSeed = INITIAL_DITHER_SEED;
 	dPrngStateL = 0.0;
 	dPrngStateR = 0.0;
+
+	for (int32_t i = 0; i < MAX_CHANNELS; i++)
+	{
+		stemRandSeed[i] = INITIAL_DITHER_SEED + i; // stems shouldn't have identical dither noise
+		dStemPrngStateL[i] = dStemPrngStateR[i] = 0.0;
+	}
 }
 
 static inline int32_t random32(void)
@@ -436,6 +722,45 @@ static inline int32_t random32(void)
 	return (int32_t)randSeed;
 }
 
+/* Advances the dither PRNGs (of the main mix and the stems) as if 'numSamples' stereo
+** samples were dithered. Used when rendering a song in parts.
+*/
+void skipAudioDither(uint64_t numSamples)
+{
+	if (numSamples == 0)
+		return;
+
+	// LCG jump-ahead to the last left channel random value
+	uint64_t steps = (numSamples * 2) - 1;
+	uint32_t mul = 1, add = 0, stepMul = 134775813, stepAdd = 1;
+
+	while (steps > 0)
+	{
+		if (steps & 1)
+		{
+			mul *= stepMul;
+			add = (add * stepMul) + stepAdd;
+		}
+
+		stepAdd *= stepMul + 1;
+		stepMul *= stepMul;
+		steps >>= 1;
+	}
+
+	for (int32_t i = 0; i < MAX_CHANNELS; i++)
+	{
+		stemRandSeed[i] = (stemRandSeed[i] * mul) + add;
+		dStemPrngStateL[i] = (int32_t)stemRandSeed[i] * (0.5 / INT32_MAX);
+
+		stemRandSeed[i] = (stemRandSeed[i] * 134775813) + 1;
+		dStemPrngStateR[i] = (int32_t)stemRandSeed[i] * (0.5 / INT32_MAX);
+	}
+
+	randSeed = (randSeed * mul) + add;
+	dPrngStateL = (int32_t)randSeed * (0.5 / INT32_MAX);
+	dPrngStateR = random32() * (0.5 / INT32_MAX);
+}
+
 static void sendSamples16BitDitherStereo(uint8_t *stream, uint32_t sampleBlockLength)
 {
 	int32_t out32;
@@ -490,40 +815,141 @@ static void sendSamples32BitStereo(uint8_t *stream, uint32_t sampleBlockLength)
 	}
 }
 
+// mixes a channel's voice and its volume ramp fadeout-voice
+static inline void mixChannel(voice_t *v, voice_t *r, int32_t bufferPosition, int32_t samplesToMix)
+{
+	if (v->active)
+	{
+		bool centerMixFlag;
+
+		const bool volRampFlag = (v->volumeRampLength > 0);
+		if (volRampFlag)
+		{
+			centerMixFlag = (v->fTargetVolumeL == v->fTargetVolumeR) && (v->fVolumeLDelta == v->fVolumeRDelta);
+		}
+		else // no volume ramping active
+		{
+			if (v->fCurrVolumeL == 0.0f && v->fCurrVolumeR == 0.0f)
+			{
+				silenceMixRoutine(v, samplesToMix);
+				return;
+			}
+
+			centerMixFlag = (v->fCurrVolumeL == v->fCurrVolumeR);
+		}
+
+		mixFuncTab[((int32_t)centerMixFlag * (3*4*2*2)) + ((int32_t)volRampFlag * (3*4*2)) + v->mixFuncOffset](v, bufferPosition, samplesToMix);
+	}
+
+	if (r->active) // volume ramp fadeout-voice
+	{
+		const bool centerMixFlag = (r->fTargetVolumeL == r->fTargetVolumeR) && (r->fVolumeLDelta == r->fVolumeRDelta);
+		mixFuncTab[((int32_t)centerMixFlag * (3*4*2*2)) + (3*4*2) + r->mixFuncOffset](r, bufferPosition, samplesToMix);
+	}
+}
+
+static void mixChannels(int32_t bufferPosition, int32_t samplesToMix)
+{
+	voice_t *v = voice; // normal voices
+	voice_t *r = &voice[numVoiceChannels]; // volume ramp fadeout-voices
+
+	for (int32_t i = 0; i < song.numChannels; i++, v++, r++)
+		mixChannel(v, r, bufferPosition, samplesToMix);
+}
+
+// mixes at 2x into the oversampling buffers, then decimates into the mixing buffers
+static void mixChannelsOversampled(int32_t bufferPosition, int32_t samplesToMix)
+{
+	float *fOversampleL = &audio.fOversampleBufferL[HALFBAND_HISTORY];
+	float *fOversampleR = &audio.fOversampleBufferR[HALFBAND_HISTORY];
+	float *fMixBufferL = audio.fMixBufferL;
+	float *fMixBufferR = audio.fMixBufferR;
+
+	const int32_t oversampledLen = samplesToMix * 2;
+
+	// the mixing routines always mix into audio.fMixBufferL/R
+	audio.fMixBufferL = fOversampleL;
+	audio.fMixBufferR = fOversampleR;
+	mixChannels(0, oversampledLen);
+	audio.fMixBufferL = fMixBufferL;
+	audio.fMixBufferR = fMixBufferR;
+
+	memcpy(audio.fOversampleBufferL, fHalfBandHistoryL, sizeof (fHalfBandHistoryL));
+	memcpy(audio.fOversampleBufferR, fHalfBandHistoryR, sizeof (fHalfBandHistoryR));
+
+	halfBandDecimate(fOversampleL, &fMixBufferL[bufferPosition], samplesToMix);
+	halfBandDecimate(fOversampleR, &fMixBufferR[bufferPosition], samplesToMix);
+
+	// keep the end of the input for the next call, and clear what we mixed
+	memcpy(fHalfBandHistoryL, &fOversampleL[oversampledLen - HALFBAND_HISTORY], sizeof (fHalfBandHistoryL));
+	memcpy(fHalfBandHistoryR, &fOversampleR[oversampledLen - HALFBAND_HISTORY], sizeof (fHalfBandHistoryR));
+	memset(fOversampleL, 0, oversampledLen * sizeof (float));
+	memset(fOversampleR, 0, oversampledLen * sizeof (float));
+}
+
 static void doChannelMixing(int32_t bufferPosition, int32_t samplesToMix)
+{
+	if (audio.oversamplingFlag)
+		mixChannelsOversampled(bufferPosition, samplesToMix);
+	else
+		mixChannels(bufferPosition, samplesToMix);
+}
+
+/* Advances the voices exactly like doChannelMixing() would (sample positions, loops,
+** volume ramps and voice shutdown), but without mixing anything. Sample positions
+** don't depend on the interpolation or the volume, so silenceMixRoutine() gives the
+** same result as the real mixing routines. Used for seeking through a song quickly.
+*/
+void skipMixerSamples(uint32_t numSamples)
 {
 	voice_t *v = voice; // normal voices
-	voice_t *r = &voice[MAX_CHANNELS]; // volume ramp fadeout-voices
+	voice_t *r = &voice[numVoiceChannels]; // volume ramp fadeout-voices
+
+	if (audio.oversamplingFlag)
+		numSamples *= 2; // the filter history isn't updated, so the first output samples after a skip differ
 
 	for (int32_t i = 0; i < song.numChannels; i++, v++, r++)
 	{
 		if (v->active)
 		{
-			bool centerMixFlag;
+			const bool silentFlag = (v->volumeRampLength == 0 && v->fCurrVolumeL == 0.0f && v->fCurrVolumeR == 0.0f);
 
-			const bool volRampFlag = (v->volumeRampLength > 0);
-			if (volRampFlag)
-			{
-				centerMixFlag = (v->fTargetVolumeL == v->fTargetVolumeR) && (v->fVolumeLDelta == v->fVolumeRDelta);
-			}
-			else // no volume ramping active
+			silenceMixRoutine(v, numSamples);
+
+			if (silentFlag)
+				continue; // the mixer skips the fadeout-voice in this case too
+
+			if (v->volumeRampLength > 0)
 			{
-				if (v->fCurrVolumeL == 0.0f && v->fCurrVolumeR == 0.0f)
+				if (v->volumeRampLength > numSamples)
 				{
-					silenceMixRoutine(v, samplesToMix);
-					continue;
+					v->volumeRampLength -= numSamples;
+				}
+				else
+				{
+					// not bit-exact to the mixer's ramp, but resetRampVolumes() sets it on the next tick anyway
+					v->fCurrVolumeL = v->fTargetVolumeL;
+					v->fCurrVolumeR = v->fTargetVolumeR;
+					v->volumeRampLength = 0;
 				}
-
-				centerMixFlag = (v->fCurrVolumeL == v->fCurrVolumeR);
 			}
-
-			mixFuncTab[((int32_t)centerMixFlag * (3*4*2*2)) + ((int32_t)volRampFlag * (3*4*2)) + v->mixFuncOffset](v, bufferPosition, samplesToMix);
 		}
 
 		if (r->active) // volume ramp fadeout-voice
 		{
-			const bool centerMixFlag = (r->fTargetVolumeL == r->fTargetVolumeR) && (r->fVolumeLDelta == r->fVolumeRDelta);
-			mixFuncTab[((int32_t)centerMixFlag * (3*4*2*2)) + (3*4*2) + r->mixFuncOffset](r, bufferPosition, samplesToMix);
+			if (r->volumeRampLength == 0)
+			{
+				r->active = false; // the mixer shuts it down on its next call
+				continue;
+			}
+
+			const uint32_t rampSamples = MIN(r->volumeRampLength, numSamples);
+
+			silenceMixRoutine(r, rampSamples);
+			r->volumeRampLength -= rampSamples;
+
+			if (r->volumeRampLength == 0 && rampSamples < numSamples)
+				r->active = false;
 		}
 	}
 }
@@ -540,6 +966,61 @@ void mixReplayerTickToBuffer(uint32_t samplesToMix, uint8_t *stream, uint8_t bit
 		sendSamples32BitStereo(stream, samplesToMix);
 }
 
+// for loudness analysis, same as a 32-bit mixReplayerTickToBuffer() but not clamped to -1.0 .. 1.0
+void mixReplayerTickToFloatBuffer(uint32_t samplesToMix, float *out)
+{
+	doChannelMixing(0, samplesToMix);
+
+	for (uint32_t i = 0; i < samplesToMix; i++)
+	{
+		*out++ = (float)((double)audio.fMixBufferL[i] * dAudioNormalizeMul);
+		*out++ = (float)((double)audio.fMixBufferR[i] * dAudioNormalizeMul);
+
+		audio.fMixBufferL[i] = 0.0f;
+		audio.fMixBufferR[i] = 0.0f;
+	}
+}
+
+/* Used for stem rendering. Same as mixReplayerTickToBuffer(), but each channel (with
+** its fadeout-voice) is mixed on its own and sent to streams[channel]. The replayer
+** only runs once for all stems. Each stem has its own dither PRNG. Oversampling isn't
+** supported here (the decimation filter has one history for the whole mix).
+*/
+void mixReplayerTickToStemBuffers(uint32_t samplesToMix, uint8_t **streams, uint8_t bitDepth)
+{
+	voice_t *v = voice; // normal voices
+	voice_t *r = &voice[numVoiceChannels]; // volume ramp fadeout-voices
+
+	for (int32_t i = 0; i < song.numChannels; i++, v++, r++)
+	{
+		mixChannel(v, r, 0, samplesToMix);
+
+		if (bitDepth == 16)
+		{
+			const uint32_t oldRandSeed = randSeed;
+			const double dOldPrngStateL = dPrngStateL, dOldPrngStateR = dPrngStateR;
+
+			randSeed = stemRandSeed[i];
+			dPrngStateL = dStemPrngStateL[i];
+			dPrngStateR = dStemPrngStateR[i];
+
+			sendSamples16BitDitherStereo(streams[i], samplesToMix);
+
+			stemRandSeed[i] = randSeed;
+			dStemPrngStateL[i] = dPrngStateL;
+			dStemPrngStateR[i] = dPrngStateR;
+
+			randSeed = oldRandSeed;
+			dPrngStateL = dOldPrngStateL;
+			dPrngStateR = dOldPrngStateR;
+		}
+		else
+		{
+			sendSamples32BitStereo(streams[i], samplesToMix);
+		}
+	}
+}
+
 int32_t pattQueueReadSize(void)
 {
 	while (pattQueueClearing);
@@ -718,16 +1199,20 @@ uint64_t getChQueueTimestamp(void)
 
 void lockAudio(void)
 {
+#ifndef FT2_HEADLESS
 	if (audio.dev != 0)
 		SDL_LockAudioDevice(audio.dev);
+#endif
 
 	audio.locked = true;
 }
 
 void unlockAudio(void)
 {
+#ifndef FT2_HEADLESS
 	if (audio.dev != 0)
 		SDL_UnlockAudioDevice(audio.dev);
+#endif
 
 	audio.locked = false;
 }
@@ -751,6 +1236,7 @@ void lockMixerCallback(void) // lock audio + clear voices/scopes (for short oper
 	audio.resetSyncTickTimeFlag = true;
 
 	stopVoices(); // VERY important! prevents potential crashes by purging pointers
+	clearLiveVoiceEvents();
 
 	// scopes, mixer and replayer are guaranteed to not be active at this point
 
@@ -773,12 +1259,15 @@ void pauseAudio(void) // lock audio + clear voices/scopes + render silence (for
 		return;
 	}
 
+#ifndef FT2_HEADLESS
 	if (audio.dev > 0)
 		SDL_PauseAudioDevice(audio.dev, true);
+#endif
 
 	audio.resetSyncTickTimeFlag = true;
 
 	stopVoices(); // VERY important! prevents potential crashes by purging pointers
+	clearLiveVoiceEvents();
 
 	// scopes, mixer and replayer are guaranteed to not be active at this point
 
@@ -791,12 +1280,15 @@ void resumeAudio(void) // unlock audio
 	if (!audioPaused)
 		return;
 
+#ifndef FT2_HEADLESS
 	if (audio.dev > 0)
 		SDL_PauseAudioDevice(audio.dev, false);
+#endif
 
 	audioPaused = false;
 }
 
+#ifndef FT2_HEADLESS
 static void fillVisualsSyncBuffer(void)
 {
 	pattSyncData_t pattSyncData;
@@ -830,7 +1322,8 @@ static void fillVisualsSyncBuffer(void)
 	channel_t *s = channel;
 	voice_t *v = voice;
 
-	for (int32_t i = 0; i < song.numChannels; i++, c++, s++, v++)
+	const int32_t numSyncedChannels = MIN(song.numChannels, MAX_XM_CHANNELS);
+	for (int32_t i = 0; i < numSyncedChannels; i++, c++, s++, v++)
 	{
 		c->scopeVolume = v->scopeVolume;
 		c->scopeDelta = v->scopeDelta;
@@ -870,7 +1363,10 @@ static void SDLCALL audioCallback(void *userdata, Uint8 *stream, int len)
 	if (len <= 0)
 		return;
 
-	int32_t bufferPosition = 0;
+	// live events queued from now on are timed against the start of this buffer
+	const uint64_t callbackTime64 = SDL_GetPerformanceCounter();
+
+	int32_t bufferPosition = 0, liveEvent = 0;
 
 	uint32_t samplesLeft = len;
 	while (samplesLeft > 0)
@@ -898,10 +1394,18 @@ static void SDLCALL audioCallback(void *userdata, Uint8 *stream, int len)
 			replayerBusy = false;
 		}
 
+		// (if a replayer tick came first, it already updated the voice)
+		while (liveEvent < numLiveEvents && liveEventOffset[liveEvent] <= (uint32_t)bufferPosition)
+			applyLiveVoiceEvent(liveEventCh[liveEvent++]);
+
 		uint32_t samplesToMix = samplesLeft;
 		if (samplesToMix > audio.tickSampleCounter)
 			samplesToMix = audio.tickSampleCounter;
 
+		// split the tick at the next live event
+		if (liveEvent < numLiveEvents && samplesToMix > liveEventOffset[liveEvent]-bufferPosition)
+			samplesToMix = liveEventOffset[liveEvent]-bufferPosition;
+
 		doChannelMixing(bufferPosition, samplesToMix);
 		bufferPosition += samplesToMix;
 		
@@ -909,6 +1413,15 @@ static void SDLCALL audioCallback(void *userdata, Uint8 *stream, int len)
 		samplesLeft -= samplesToMix;
 	}
 
+	// offsets past the end of this (smaller) buffer
+	while (liveEvent < numLiveEvents)
+		applyLiveVoiceEvent(liveEventCh[liveEvent++]);
+
+	numLiveEvents = 0;
+
+	lastCallbackTime64 = callbackTime64;
+	lastCallbackSamples = len;
+
 	if (config.specialFlags & BITDEPTH_16)
 		sendSamples16BitDitherStereo(stream, len);
 	else
@@ -916,6 +1429,7 @@ static void SDLCALL audioCallback(void *userdata, Uint8 *stream, int len)
 
 	(void)userdata;
 }
+#endif
 
 static bool setupAudioBuffers(void)
 {
@@ -925,9 +1439,14 @@ static bool setupAudioBuffers(void)
 	audio.fMixBufferL = (float *)calloc(maxSamplesPerTick, sizeof (float));
 	audio.fMixBufferR = (float *)calloc(maxSamplesPerTick, sizeof (float));
 
-	if (audio.fMixBufferL == NULL || audio.fMixBufferR == NULL)
+	// for 2x oversampling, with room for the decimation filter's history in front
+	audio.fOversampleBufferL = (float *)calloc(HALFBAND_HISTORY + (maxSamplesPerTick * 2), sizeof (float));
+	audio.fOversampleBufferR = (float *)calloc(HALFBAND_HISTORY + (maxSamplesPerTick * 2), sizeof (float));
+
+	if (audio.fMixBufferL == NULL || audio.fMixBufferR == NULL || audio.fOversampleBufferL == NULL || audio.fOversampleBufferR == NULL)
 		return false;
 
+	calcHalfBandFilter();
 	return true;
 }
 
@@ -944,8 +1463,21 @@ static void freeAudioBuffers(void)
 		free(audio.fMixBufferR);
 		audio.fMixBufferR = NULL;
 	}
+
+	if (audio.fOversampleBufferL != NULL)
+	{
+		free(audio.fOversampleBufferL);
+		audio.fOversampleBufferL = NULL;
+	}
+
+	if (audio.fOversampleBufferR != NULL)
+	{
+		free(audio.fOversampleBufferR);
+		audio.fOversampleBufferR = NULL;
+	}
 }
 
+#ifndef FT2_HEADLESS
 static void calcAudioLatencyVars(int32_t audioBufferSize, int32_t audioFreq)
 {
 	double dInt;
@@ -1089,7 +1621,7 @@ bool setupAudio(bool showErrorMsg)
 	setAudioAmp(config.boostLevel, config.masterVol, !!(config.specialFlags & BITDEPTH_32));
 
 	// don't call stopVoices() in this routine
-	for (int32_t i = 0; i < MAX_CHANNELS; i++)
+	for (int32_t i = 0; i < numVoiceChannels; i++)
 		stopVoice(i);
 
 	stopAllScopes();
@@ -1111,15 +1643,38 @@ bool setupAudio(bool showErrorMsg)
 
 	return true;
 }
+#endif
+
+bool setupHeadlessAudio(uint32_t freq) // mixing without an audio device (command-line modes)
+{
+	closeAudio();
+
+	if (!setupAudioBuffers())
+		return false;
+
+	audio.freq = freq;
+	calcReplayerVars(audio.freq);
+
+	// zero tick sample counter so that it will instantly initiate a tick
+	audio.tickSampleCounterFrac  = audio.tickSampleCounter = 0;
+
+	if (song.BPM == 0)
+		song.BPM = 125;
+
+	setMixerBPM(song.BPM);
+	return true;
+}
 
 void closeAudio(void)
 {
+#ifndef FT2_HEADLESS
 	if (audio.dev > 0)
 	{
 		SDL_PauseAudioDevice(audio.dev, true);
 		SDL_CloseAudioDevice(audio.dev);
 		audio.dev = 0;
 	}
+#endif
 
 	freeAudioBuffers();
 }
@@ -2,7 +2,9 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#ifndef FT2_HEADLESS
 #include <SDL2/SDL.h>
+#endif
 #include "ft2_replayer.h"
 #include "ft2_cpu.h"
 
@@ -42,7 +44,7 @@ typedef struct audio_t
 	char *currInputDevice, *currOutputDevice, *lastWorkingAudioDeviceName;
 	char *inputDeviceNames[MAX_AUDIO_DEVICES], *outputDeviceNames[MAX_AUDIO_DEVICES];
 	volatile bool locked, resetSyncTickTimeFlag, volumeRampingFlag;
-	bool linearPeriodsFlag, rescanAudioDevicesSupported;
+	bool linearPeriodsFlag, rescanAudioDevicesSupported, oversamplingFlag;
 	volatile uint8_t interpolationType;
 	int32_t inputDeviceNum, outputDeviceNum, lastWorkingAudioFreq, lastWorkingAudioBits;
 	uint32_t quickVolRampSamples, freq;
@@ -55,10 +57,12 @@ typedef struct audio_t
 
 	uint64_t tickTime64, tickTime64Frac;
 
-	float *fMixBufferL, *fMixBufferR;
+	float *fMixBufferL, *fMixBufferR, *fOversampleBufferL, *fOversampleBufferR;
 	double dHz2MixDeltaMul, dAudioLatencyMs;
 
+#ifndef FT2_HEADLESS
 	SDL_AudioDeviceID dev;
+#endif
 	uint32_t wantFreq, haveFreq, wantSamples, haveSamples;
 } audio_t;
 
@@ -105,9 +109,9 @@ typedef struct pattSync_t
 	pattSyncData_t data[SYNC_QUEUE_LEN+1];
 } pattSync_t;
 
-typedef struct chSyncData_t
+typedef struct chSyncData_t // only used for the tracker GUI, which is limited to FT2's channel count
 {
-	syncedChannel_t channels[MAX_CHANNELS];
+	syncedChannel_t channels[MAX_XM_CHANNELS];
 	uint64_t timestamp;
 } chSyncData_t;
 
@@ -117,6 +121,18 @@ typedef struct chSync_t
 	chSyncData_t data[SYNC_QUEUE_LEN+1];
 } chSync_t;
 
+/* The mixer's counterpart to replayerState_t: voices, dither, output scaling and the
+** mixing rate (with its tables). The stem dither states aren't included.
+*/
+typedef struct mixerState_t mixerState_t;
+
+// snapshot of the current state, with room for 'numChannels' channels (the voices that didn't exist are zeroed)
+mixerState_t *copyMixerState(int32_t numChannels);
+void freeMixerState(mixerState_t *s);
+void swapMixerState(mixerState_t *s); // exchanges 's' with the current state, the audio must be locked
+
+bool allocateVoices(int32_t numChannels); // for allocateChannels(), the audio must be locked
+
 void resetCachedMixerVars(void);
 int32_t pattQueueReadSize(void);
 int32_t pattQueueWriteSize(void);
@@ -138,13 +154,18 @@ void increaseMasterVol(void);
 
 void calcPanningTable(void);
 void setAudioAmp(int16_t amp, int16_t masterVol, bool bitDepth32Flag);
+void scaleAudioAmp(double dGain);
 void setNewAudioFreq(uint32_t freq);
 void setBackOldAudioFreq(void);
 void setMixerBPM(int32_t bpm);
 void audioSetVolRamp(bool volRamp);
 void audioSetInterpolationType(uint8_t interpolationType);
+void audioSetOversampling(bool oversampling);
+void resetOversamplingFilter(void);
 void stopVoice(int32_t i);
+int32_t getVoicePosition(int32_t i); // sampling position (in sample points), -1 if not playing
 bool setupAudio(bool showErrorMsg);
+bool setupHeadlessAudio(uint32_t freq);
 void closeAudio(void);
 void pauseAudio(void);
 void resumeAudio(void);
@@ -156,7 +177,12 @@ void lockMixerCallback(void);
 void unlockMixerCallback(void);
 void resetRampVolumes(void);
 void updateVoices(void);
+void queueLiveVoiceEvent(int32_t chNum);
 void mixReplayerTickToBuffer(uint32_t samplesToMix, uint8_t *stream, uint8_t bitDepth);
+void mixReplayerTickToFloatBuffer(uint32_t samplesToMix, float *out);
+void mixReplayerTickToStemBuffers(uint32_t samplesToMix, uint8_t **streams, uint8_t bitDepth);
+void skipMixerSamples(uint32_t numSamples);
+void skipAudioDither(uint64_t numSamples);
 
 // in ft2_audio.c
 extern audio_t audio;
@@ -39,6 +39,7 @@
 #include "ft2_video.h"
 #include "ft2_inst_ed.h"
 #include "ft2_structs.h"
+#include "ft2_flac_encoder.h"
 
 // hide POSIX warnings for chdir()
 #ifdef _MSC_VER
@@ -665,7 +666,7 @@ void diskOpSetFilename(uint8_t type, UNICHAR *pathU)
 				changeFilenameExt(modTmpFName, ".mod", PATH_MAX);
 			else if (editor.moduleSaveMode == MOD_SAVE_MODE_XM)
 				changeFilenameExt(modTmpFName, ".xm", PATH_MAX);
-			else if (editor.moduleSaveMode == MOD_SAVE_MODE_WAV)
+			else if (editor.moduleSaveMode == MOD_SAVE_MODE_WAV && !filenameIsFlac(modTmpFName))
 				changeFilenameExt(modTmpFName, ".wav", PATH_MAX);
 
 			updateWindowTitle(true);
@@ -684,7 +685,7 @@ void diskOpSetFilename(uint8_t type, UNICHAR *pathU)
 				changeFilenameExt(smpTmpFName, ".raw", PATH_MAX);
 			else if (editor.sampleSaveMode == SMP_SAVE_MODE_IFF)
 				changeFilenameExt(smpTmpFName, ".iff", PATH_MAX);
-			else if (editor.sampleSaveMode == SMP_SAVE_MODE_WAV)
+			else if (editor.sampleSaveMode == SMP_SAVE_MODE_WAV && !filenameIsFlac(smpTmpFName))
 				changeFilenameExt(smpTmpFName, ".wav", PATH_MAX);
 		}
 		break;
@@ -803,6 +804,12 @@ void diskOpChangeFilenameExt(char *ext)
 	changeFilenameExt(FReq_FileName, ext, PATH_MAX);
 }
 
+void diskOpChangeWavFilenameExt(void) // the WAV save modes save FLAC if the filename ends in ".flac"
+{
+	if (!filenameIsFlac(FReq_FileName))
+		changeFilenameExt(FReq_FileName, ".wav", PATH_MAX);
+}
+
 void trimEntryName(char *name, bool isDir)
 {
 	char extBuffer[24];
@@ -898,7 +905,7 @@ static void diskOpSave(bool checkOverwrite)
 			{
 				         case MOD_SAVE_MODE_MOD: diskOpChangeFilenameExt(".mod"); break;
 				default: case MOD_SAVE_MODE_XM:  diskOpChangeFilenameExt(".xm");  break;
-				         case MOD_SAVE_MODE_WAV: diskOpChangeFilenameExt(".wav"); break;
+				         case MOD_SAVE_MODE_WAV: diskOpChangeWavFilenameExt(); break;
 			}
 
 			// enter WAV renderer if needed
@@ -959,7 +966,7 @@ static void diskOpSave(bool checkOverwrite)
 			{
 				         case SMP_SAVE_MODE_RAW: diskOpChangeFilenameExt(".raw"); break;
 				         case SMP_SAVE_MODE_IFF: diskOpChangeFilenameExt(".iff"); break;
-				default: case SMP_SAVE_MODE_WAV: diskOpChangeFilenameExt(".wav"); break;
+				default: case SMP_SAVE_MODE_WAV: diskOpChangeWavFilenameExt(); break;
 			}
 
 			if (checkOverwrite && fileExistsAnsi(FReq_FileName))
@@ -1314,8 +1321,8 @@ static uint8_t handleEntrySkip(UNICHAR *nameU, bool isDir)
 			default:
 			case DISKOP_ITEM_MODULE:
 			{
-				if (editor.moduleSaveMode == MOD_SAVE_MODE_WAV && !_stricmp("wav", extPtr))
-					break; // show .wav files when save mode is "WAV"
+				if (editor.moduleSaveMode == MOD_SAVE_MODE_WAV && (!_stricmp("wav", extPtr) || !_stricmp("flac", extPtr)))
+					break; // show .wav/.flac files when save mode is "WAV"
 
 				if (!moduleExtensionAccepted(extPtr))
 					goto skipEntry;
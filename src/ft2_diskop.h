@@ -32,6 +32,7 @@ const UNICHAR *getDiskOpModPath(void);
 const UNICHAR *getDiskOpSmpPath(void);
 void changeFilenameExt(char *name, char *ext, int32_t nameMaxLen);
 void diskOpChangeFilenameExt(char *ext);
+void diskOpChangeWavFilenameExt(void);
 void freeDiskOp(void);
 bool setupDiskOp(void);
 void diskOpSetFilename(uint8_t type, UNICHAR *pathU);
@@ -35,8 +35,8 @@ static uint8_t lastInsMode, lastTranspMode;
 static uint32_t transpDelNotes; // count of under-/overflowing notes for warning message
 static note_t clearNote;
 
-static note_t blkCopyBuff[MAX_PATT_LEN * MAX_CHANNELS];
-static note_t ptnCopyBuff[MAX_PATT_LEN * MAX_CHANNELS];
+static note_t blkCopyBuff[MAX_PATT_LEN * MAX_XM_CHANNELS];
+static note_t ptnCopyBuff[MAX_PATT_LEN * MAX_XM_CHANNELS];
 static note_t trackCopyBuff[MAX_PATT_LEN];
 
 static const int8_t tickArr[16] = { 16, 8, 0, 4, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 1 };
@@ -55,7 +55,7 @@ static bool testNoteKeys(SDL_Scancode scancode)
 			if (!allocatePattern(editor.editPattern))
 				return true; // key pressed
 
-			pattern[editor.editPattern][(editor.row * MAX_CHANNELS) + cursor.ch].note = NOTE_OFF;
+			pattern[editor.editPattern][(editor.row * song.numChannels) + cursor.ch].note = NOTE_OFF;
 
 			const uint16_t numRows = patternNumRows[editor.editPattern];
 			if (playMode == PLAYMODE_EDIT && numRows >= 1)
@@ -160,7 +160,7 @@ static bool testEditKeys(SDL_Scancode scancode, SDL_Keycode keycode)
 
 	// insert slot data
 
-	note_t *p = &pattern[editor.editPattern][(editor.row * MAX_CHANNELS) + cursor.ch];
+	note_t *p = &pattern[editor.editPattern][(editor.row * song.numChannels) + cursor.ch];
 	switch (cursor.object)
 	{
 		case CURSOR_INST1:
@@ -447,7 +447,7 @@ void recordNote(uint8_t noteNum, int8_t vol) // directly ported from the origina
 			if (allocatePattern(pattNum))
 			{
 				const int16_t numRows = patternNumRows[pattNum];
-				p = &pattern[pattNum][(row * MAX_CHANNELS) + c];
+				p = &pattern[pattNum][(row * song.numChannels) + c];
 
 				// insert data
 				p->note = noteNum;
@@ -509,7 +509,7 @@ void recordNote(uint8_t noteNum, int8_t vol) // directly ported from the origina
 				// insert data
 
 				int16_t numRows = patternNumRows[pattNum];
-				p = &pattern[pattNum][(row * MAX_CHANNELS) + c];
+				p = &pattern[pattNum][(row * song.numChannels) + c];
 
 				if (p->note != 0)
 					row++;
@@ -529,8 +529,11 @@ void recordNote(uint8_t noteNum, int8_t vol) // directly ported from the origina
 					}
 				}
 
-				p = &pattern[pattNum][(row * MAX_CHANNELS) + c];
-				p->note = NOTE_OFF;
+				if (allocatePattern(pattNum))
+				{
+					p = &pattern[pattNum][(row * song.numChannels) + c];
+					p->note = NOTE_OFF;
+				}
 
 				if (!recmode)
 				{
@@ -563,10 +566,11 @@ bool handleEditKeys(SDL_Keycode keycode, SDL_Scancode scancode)
 		if (playMode != PLAYMODE_EDIT && playMode != PLAYMODE_RECSONG && playMode != PLAYMODE_RECPATT)
 			return false; // we're not editing, test other keys
 
-		if (pattern[editor.editPattern] == NULL)
+		note_t *pattPtr = getEditPattern(editor.editPattern);
+		if (pattPtr == NULL)
 			return true;
 
-		note_t *p = &pattern[editor.editPattern][(editor.row * MAX_CHANNELS) + cursor.ch];
+		note_t *p = &pattPtr[(editor.row * song.numChannels) + cursor.ch];
 
 		if (keyb.leftShiftPressed)
 		{
@@ -629,9 +633,10 @@ void writeToMacroSlot(uint8_t slot)
 	uint16_t writeVol = 0;
 	uint16_t writeEfx = 0;
 
-	if (pattern[editor.editPattern] != NULL)
+	note_t *pattPtr = getEditPattern(editor.editPattern);
+	if (pattPtr != NULL)
 	{
-		note_t *p = &pattern[editor.editPattern][(editor.row * MAX_CHANNELS) + cursor.ch];
+		note_t *p = &pattPtr[(editor.row * song.numChannels) + cursor.ch];
 		writeVol = p->vol;
 		writeEfx = (p->efx << 8) | p->efxData;
 	}
@@ -650,7 +655,7 @@ void writeFromMacroSlot(uint8_t slot)
 	if (!allocatePattern(editor.editPattern))
 		return;
 	
-	note_t *p = &pattern[editor.editPattern][(editor.row * MAX_CHANNELS) + cursor.ch];
+	note_t *p = &pattern[editor.editPattern][(editor.row * song.numChannels) + cursor.ch];
 	if (cursor.object == CURSOR_VOL1 || cursor.object == CURSOR_VOL2)
 	{
 		p->vol = (uint8_t)config.volMacro[slot];
@@ -686,7 +691,7 @@ void insertPatternNote(void)
 	if (playMode != PLAYMODE_EDIT && playMode != PLAYMODE_RECPATT && playMode != PLAYMODE_RECSONG)
 		return;
 
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p == NULL)
 		return;
 
@@ -696,10 +701,10 @@ void insertPatternNote(void)
 	if (numRows > 1)
 	{
 		for (int32_t i = numRows-2; i >= row; i--)
-			p[((i+1) * MAX_CHANNELS) + cursor.ch] = p[(i * MAX_CHANNELS) + cursor.ch];
+			p[((i+1) * song.numChannels) + cursor.ch] = p[(i * song.numChannels) + cursor.ch];
 	}
 
-	memset(&p[(row * MAX_CHANNELS) + cursor.ch], 0, sizeof (note_t));
+	memset(&p[(row * song.numChannels) + cursor.ch], 0, sizeof (note_t));
 
 	killPatternIfUnused(editor.editPattern);
 
@@ -714,7 +719,7 @@ void insertPatternLine(void)
 
 	setPatternLen(editor.editPattern, patternNumRows[editor.editPattern] + config.recTrueInsert); // config.recTrueInsert is 0 or 1
 
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p != NULL)
 	{
 		const int16_t row = editor.row;
@@ -724,12 +729,12 @@ void insertPatternLine(void)
 		{
 			for (int32_t i = numRows-2; i >= row; i--)
 			{
-				for (int32_t j = 0; j < MAX_CHANNELS; j++)
-					p[((i+1) * MAX_CHANNELS) + j] = p[(i * MAX_CHANNELS) + j];
+				for (int32_t j = 0; j < song.numChannels; j++)
+					p[((i+1) * song.numChannels) + j] = p[(i * song.numChannels) + j];
 			}
 		}
 
-		memset(&p[row * MAX_CHANNELS], 0, TRACK_WIDTH);
+		memset(&p[row * song.numChannels], 0, TRACK_WIDTH(song.numChannels));
 
 		killPatternIfUnused(editor.editPattern);
 	}
@@ -746,7 +751,7 @@ void deletePatternNote(void)
 	int16_t row = editor.row;
 	const int16_t numRows = patternNumRows[editor.editPattern];
 
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p != NULL)
 	{
 		if (row > 0)
@@ -755,9 +760,9 @@ void deletePatternNote(void)
 			editor.row = song.row = row;
 
 			for (int32_t i = row; i < numRows-1; i++)
-				p[(i * MAX_CHANNELS) + cursor.ch] = p[((i+1) * MAX_CHANNELS) + cursor.ch];
+				p[(i * song.numChannels) + cursor.ch] = p[((i+1) * song.numChannels) + cursor.ch];
 
-			memset(&p[((numRows-1) * MAX_CHANNELS) + cursor.ch], 0, sizeof (note_t));
+			memset(&p[((numRows-1) * song.numChannels) + cursor.ch], 0, sizeof (note_t));
 		}
 	}
 	else
@@ -783,7 +788,7 @@ void deletePatternLine(void)
 	int16_t row = editor.row;
 	const int16_t numRows = patternNumRows[editor.editPattern];
 
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p != NULL)
 	{
 		if (row > 0)
@@ -793,11 +798,11 @@ void deletePatternLine(void)
 
 			for (int32_t i = row; i < numRows-1; i++)
 			{
-				for (int32_t j = 0; j < MAX_CHANNELS; j++)
-					p[(i * MAX_CHANNELS) + j] = p[((i+1) * MAX_CHANNELS) + j];
+				for (int32_t j = 0; j < song.numChannels; j++)
+					p[(i * song.numChannels) + j] = p[((i+1) * song.numChannels) + j];
 			}
 
-			memset(&p[(numRows-1) * MAX_CHANNELS], 0, TRACK_WIDTH);
+			memset(&p[(numRows-1) * song.numChannels], 0, TRACK_WIDTH(song.numChannels));
 		}
 	}
 	else
@@ -827,14 +832,14 @@ static void countOverflowingNotes(uint8_t currInsOnly, uint8_t transpMode, int8_
 	{
 		case TRANSP_TRACK:
 		{
-			note_t *p = pattern[editor.editPattern];
+			note_t *p = getEditPattern(editor.editPattern);
 			if (p == NULL)
 				return; // empty pattern
 
 			p += cursor.ch;
 
 			const int32_t numRows = patternNumRows[editor.editPattern];
-			for (int32_t row = 0; row < numRows; row++, p += MAX_CHANNELS)
+			for (int32_t row = 0; row < numRows; row++, p += song.numChannels)
 			{
 				if ((p->note >= 1 && p->note <= 96) && (!currInsOnly || p->instr == editor.curInstr))
 				{
@@ -847,14 +852,12 @@ static void countOverflowingNotes(uint8_t currInsOnly, uint8_t transpMode, int8_
 
 		case TRANSP_PATT:
 		{
-			note_t *p = pattern[editor.editPattern];
+			note_t *p = getEditPattern(editor.editPattern);
 			if (p == NULL)
 				return; // empty pattern
 
 			const int32_t numRows = patternNumRows[editor.editPattern];
-			const int32_t pitch = MAX_CHANNELS-song.numChannels;
-
-			for (int32_t row = 0; row < numRows; row++, p += pitch)
+			for (int32_t row = 0; row < numRows; row++)
 			{
 				for (int32_t ch = 0; ch < song.numChannels; ch++, p++)
 				{
@@ -870,15 +873,14 @@ static void countOverflowingNotes(uint8_t currInsOnly, uint8_t transpMode, int8_
 
 		case TRANSP_SONG:
 		{
-			const int32_t pitch = MAX_CHANNELS-song.numChannels;
 			for (int32_t i = 0; i < MAX_PATTERNS; i++)
 			{
-				note_t *p = pattern[i];
+				note_t *p = getEditPattern(i);
 				if (p == NULL)
 					continue; // empty pattern
 
 				const int32_t numRows = patternNumRows[i];
-				for (int32_t row = 0; row < numRows; row++, p += pitch)
+				for (int32_t row = 0; row < numRows; row++)
 				{
 					for (int32_t ch = 0; ch < song.numChannels; ch++, p++)
 					{
@@ -898,13 +900,13 @@ static void countOverflowingNotes(uint8_t currInsOnly, uint8_t transpMode, int8_
 			if (pattMark.markY1 == pattMark.markY2)
 				return; // no pattern marking
 
-			note_t *p = pattern[editor.editPattern];
+			note_t *p = getEditPattern(editor.editPattern);
 			if (p == NULL)
 				return; // empty pattern
 
-			p += (pattMark.markY1 * MAX_CHANNELS) + pattMark.markX1;
+			p += (pattMark.markY1 * song.numChannels) + pattMark.markX1;
 
-			const int32_t pitch = MAX_CHANNELS - ((pattMark.markX2 + 1) - pattMark.markX1);
+			const int32_t pitch = song.numChannels - ((pattMark.markX2 + 1) - pattMark.markX1);
 			for (int32_t row = pattMark.markY1; row < pattMark.markY2; row++, p += pitch)
 			{
 				for (int32_t ch = pattMark.markX1; ch <= pattMark.markX2; ch++, p++)
@@ -940,14 +942,14 @@ void doTranspose(void)
 	{
 		case TRANSP_TRACK:
 		{
-			note_t *p = pattern[editor.editPattern];
+			note_t *p = getEditPattern(editor.editPattern);
 			if (p == NULL)
 				return; // empty pattern
 
 			p += cursor.ch;
 
 			const int32_t numRows = patternNumRows[editor.editPattern];
-			for (int32_t row = 0; row < numRows; row++, p += MAX_CHANNELS)
+			for (int32_t row = 0; row < numRows; row++, p += song.numChannels)
 			{
 				uint8_t note = p->note;
 				if ((note >= 1 && note <= 96) && (!lastInsMode || p->instr == editor.curInstr))
@@ -964,14 +966,12 @@ void doTranspose(void)
 
 		case TRANSP_PATT:
 		{
-			note_t *p = pattern[editor.editPattern];
+			note_t *p = getEditPattern(editor.editPattern);
 			if (p == NULL)
 				return; // empty pattern
 
 			const int32_t numRows = patternNumRows[editor.editPattern];
-			const int32_t pitch = MAX_CHANNELS - song.numChannels;
-
-			for (int32_t row = 0; row < numRows; row++, p += pitch)
+			for (int32_t row = 0; row < numRows; row++)
 			{
 				for (int32_t ch = 0; ch < song.numChannels; ch++, p++)
 				{
@@ -991,15 +991,14 @@ void doTranspose(void)
 
 		case TRANSP_SONG:
 		{
-			const int32_t pitch = MAX_CHANNELS - song.numChannels;
 			for (int32_t i = 0; i < MAX_PATTERNS; i++)
 			{
-				note_t *p = pattern[i];
+				note_t *p = getEditPattern(i);
 				if (p == NULL)
 					continue; // empty pattern
 
 				const int32_t numRows = patternNumRows[i];
-				for (int32_t row = 0; row < numRows; row++, p += pitch)
+				for (int32_t row = 0; row < numRows; row++)
 				{
 					for (int32_t ch = 0; ch < song.numChannels; ch++, p++)
 					{
@@ -1023,13 +1022,13 @@ void doTranspose(void)
 			if (pattMark.markY1 == pattMark.markY2)
 				return; // no pattern marking
 
-			note_t *p = pattern[editor.editPattern];
+			note_t *p = getEditPattern(editor.editPattern);
 			if (p == NULL)
 				return; // empty pattern
 
-			p += (pattMark.markY1 * MAX_CHANNELS) + pattMark.markX1;
+			p += (pattMark.markY1 * song.numChannels) + pattMark.markX1;
 
-			const int32_t pitch = MAX_CHANNELS - ((pattMark.markX2 + 1) - pattMark.markX1);
+			const int32_t pitch = song.numChannels - ((pattMark.markX2 + 1) - pattMark.markX1);
 			for (int32_t row = pattMark.markY1; row < pattMark.markY2; row++, p += pitch)
 			{
 				for (int32_t ch = pattMark.markX1; ch <= pattMark.markX2; ch++, p++)
@@ -1345,7 +1344,7 @@ void pasteNote(note_t *src, note_t *dst)
 
 void cutTrack(void)
 {
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p == NULL)
 		return;
 
@@ -1355,14 +1354,14 @@ void cutTrack(void)
 	{
 		memset(trackCopyBuff, 0, MAX_PATT_LEN * sizeof (note_t));
 		for (int16_t i = 0; i < numRows; i++)
-			copyNote(&p[(i * MAX_CHANNELS) + cursor.ch], &trackCopyBuff[i]);
+			copyNote(&p[(i * song.numChannels) + cursor.ch], &trackCopyBuff[i]);
 
 		trkBufLen = numRows;
 	}
 
 	pauseMusic();
 	for (int16_t i = 0; i < numRows; i++)
-		pasteNote(&clearNote, &p[(i * MAX_CHANNELS) + cursor.ch]);
+		pasteNote(&clearNote, &p[(i * song.numChannels) + cursor.ch]);
 	resumeMusic();
 
 	killPatternIfUnused(editor.editPattern);
@@ -1373,7 +1372,7 @@ void cutTrack(void)
 
 void copyTrack(void)
 {
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p == NULL)
 		return;
 
@@ -1381,7 +1380,7 @@ void copyTrack(void)
 
 	memset(trackCopyBuff, 0, MAX_PATT_LEN * sizeof (note_t));
 	for (int16_t i = 0; i < numRows; i++)
-		copyNote(&p[(i * MAX_CHANNELS) + cursor.ch], &trackCopyBuff[i]);
+		copyNote(&p[(i * song.numChannels) + cursor.ch], &trackCopyBuff[i]);
 
 	trkBufLen = numRows;
 }
@@ -1396,7 +1395,7 @@ void pasteTrack(void)
 
 	pauseMusic();
 	for (int16_t i = 0; i < numRows; i++)
-		pasteNote(&trackCopyBuff[i], &p[(i * MAX_CHANNELS) + cursor.ch]);
+		pasteNote(&trackCopyBuff[i], &p[(i * song.numChannels) + cursor.ch]);
 	resumeMusic();
 
 	killPatternIfUnused(editor.editPattern);
@@ -1407,7 +1406,7 @@ void pasteTrack(void)
 
 void cutPattern(void)
 {
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p == NULL)
 		return;
 
@@ -1415,11 +1414,11 @@ void cutPattern(void)
 
 	if (config.ptnCutToBuffer)
 	{
-		memset(ptnCopyBuff, 0, (MAX_PATT_LEN * MAX_CHANNELS) * sizeof (note_t));
+		memset(ptnCopyBuff, 0, sizeof (ptnCopyBuff));
 		for (int16_t x = 0; x < song.numChannels; x++)
 		{
 			for (int16_t i = 0; i < numRows; i++)
-				copyNote(&p[(i * MAX_CHANNELS) + x], &ptnCopyBuff[(i * MAX_CHANNELS) + x]);
+				copyNote(&p[(i * song.numChannels) + x], &ptnCopyBuff[(i * MAX_XM_CHANNELS) + x]);
 		}
 
 		ptnBufLen = numRows;
@@ -1429,7 +1428,7 @@ void cutPattern(void)
 	for (int16_t x = 0; x < song.numChannels; x++)
 	{
 		for (int16_t i = 0; i < numRows; i++)
-			pasteNote(&clearNote, &p[(i * MAX_CHANNELS) + x]);
+			pasteNote(&clearNote, &p[(i * song.numChannels) + x]);
 	}
 	resumeMusic();
 
@@ -1441,17 +1440,17 @@ void cutPattern(void)
 
 void copyPattern(void)
 {
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p == NULL)
 		return;
 
 	const int16_t numRows = patternNumRows[editor.editPattern];
 
-	memset(ptnCopyBuff, 0, (MAX_PATT_LEN * MAX_CHANNELS) * sizeof (note_t));
+	memset(ptnCopyBuff, 0, sizeof (ptnCopyBuff));
 	for (int16_t x = 0; x < song.numChannels; x++)
 	{
 		for (int16_t i = 0; i < numRows; i++)
-			copyNote(&p[(i * MAX_CHANNELS) + x], &ptnCopyBuff[(i * MAX_CHANNELS) + x]);
+			copyNote(&p[(i * song.numChannels) + x], &ptnCopyBuff[(i * MAX_XM_CHANNELS) + x]);
 	}
 
 	ptnBufLen = numRows;
@@ -1480,7 +1479,7 @@ void pastePattern(void)
 	for (int16_t x = 0; x < song.numChannels; x++)
 	{
 		for (int16_t i = 0; i < numRows; i++)
-			pasteNote(&ptnCopyBuff[(i * MAX_CHANNELS) + x], &p[(i * MAX_CHANNELS) + x]);
+			pasteNote(&ptnCopyBuff[(i * MAX_XM_CHANNELS) + x], &p[(i * song.numChannels) + x]);
 	}
 	resumeMusic();
 
@@ -1495,7 +1494,7 @@ void cutBlock(void)
 	if (pattMark.markY1 == pattMark.markY2 || pattMark.markY1 > pattMark.markY2)
 		return;
 
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p == NULL)
 		return;
 
@@ -1506,7 +1505,7 @@ void cutBlock(void)
 			for (int16_t y = pattMark.markY1; y < pattMark.markY2; y++)
 			{
 				assert(x < song.numChannels && y < patternNumRows[editor.editPattern]);
-				copyNote(&p[(y * MAX_CHANNELS) + x], &blkCopyBuff[((y - pattMark.markY1) * MAX_CHANNELS) + (x - pattMark.markX1)]);
+				copyNote(&p[(y * song.numChannels) + x], &blkCopyBuff[((y - pattMark.markY1) * MAX_XM_CHANNELS) + (x - pattMark.markX1)]);
 			}
 		}
 	}
@@ -1515,7 +1514,7 @@ void cutBlock(void)
 	for (int16_t x = pattMark.markX1; x <= pattMark.markX2; x++)
 	{
 		for (int16_t y = pattMark.markY1; y < pattMark.markY2; y++)
-			pasteNote(&clearNote, &p[(y * MAX_CHANNELS) + x]);
+			pasteNote(&clearNote, &p[(y * song.numChannels) + x]);
 	}
 	resumeMusic();
 
@@ -1534,7 +1533,7 @@ void copyBlock(void)
 	if (pattMark.markY1 == pattMark.markY2 || pattMark.markY1 > pattMark.markY2)
 		return;
 
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p == NULL)
 		return;
 
@@ -1543,7 +1542,7 @@ void copyBlock(void)
 		for (int16_t y = pattMark.markY1; y < pattMark.markY2; y++)
 		{
 			assert(x < song.numChannels && y < patternNumRows[editor.editPattern]);
-			copyNote(&p[(y * MAX_CHANNELS) + x], &blkCopyBuff[((y - pattMark.markY1) * MAX_CHANNELS) + (x - pattMark.markX1)]);
+			copyNote(&p[(y * song.numChannels) + x], &blkCopyBuff[((y - pattMark.markY1) * MAX_XM_CHANNELS) + (x - pattMark.markX1)]);
 		}
 	}
 
@@ -1578,7 +1577,7 @@ void pasteBlock(void)
 		for (int32_t y = ypos; y < ypos+k; y++)
 		{
 			assert(x < song.numChannels && y < numRows);
-			pasteNote(&blkCopyBuff[((y - ypos) * MAX_CHANNELS) + (x - xpos)], &p[(y * MAX_CHANNELS) + x]);
+			pasteNote(&blkCopyBuff[((y - ypos) * MAX_XM_CHANNELS) + (x - xpos)], &p[(y * song.numChannels) + x]);
 		}
 	}
 	resumeMusic();
@@ -1593,13 +1592,13 @@ static void remapInstrXY(uint16_t pattNum, uint16_t x1, uint16_t y1, uint16_t x2
 {
 	// this routine is only used sanely, so no need to check input
 
-	note_t *pattPtr = pattern[pattNum];
+	note_t *pattPtr = getEditPattern(pattNum);
 	if (pattPtr == NULL)
 		return;
 
-	note_t *p = &pattPtr[(y1 * MAX_CHANNELS) + x1];
+	note_t *p = &pattPtr[(y1 * song.numChannels) + x1];
 
-	const int32_t pitch = MAX_CHANNELS - ((x2 + 1) - x1);
+	const int32_t pitch = song.numChannels - ((x2 + 1) - x1);
 	for (uint16_t y = y1; y <= y2; y++, p += pitch)
 	{
 		for (uint16_t x = x1; x <= x2; x++, p++)
@@ -1732,7 +1731,7 @@ static void scaleNote(uint16_t pattNum, int8_t ch, int16_t row, double dScale)
 	if (row < 0 || row >= numRows || ch < 0 || ch >= song.numChannels)
 		return;
 
-	note_t *p = &pattern[pattNum][(row * MAX_CHANNELS) + ch];
+	note_t *p = &pattern[pattNum][(row * song.numChannels) + ch];
 
 	int32_t vol = getNoteVolume(p);
 	if (vol >= 0)
@@ -1778,7 +1777,7 @@ void scaleFadeVolumeTrack(void)
 	if (!askForScaleFade("Volume scale-fade track (start-, end scale)"))
 		return;
 
-	if (pattern[editor.editPattern] == NULL)
+	if (getEditPattern(editor.editPattern) == NULL)
 		return;
 
 	const int32_t numRows = patternNumRows[editor.editPattern];
@@ -1803,7 +1802,7 @@ void scaleFadeVolumePattern(void)
 	if (!askForScaleFade("Volume scale-fade pattern (start-, end scale)"))
 		return;
 
-	if (pattern[editor.editPattern] == NULL)
+	if (getEditPattern(editor.editPattern) == NULL)
 		return;
 
 	const int32_t numRows = patternNumRows[editor.editPattern];
@@ -1830,7 +1829,7 @@ void scaleFadeVolumeBlock(void)
 	if (!askForScaleFade("Volume scale-fade block (start-, end scale)"))
 		return;
 
-	if (pattern[editor.editPattern] == NULL || pattMark.markY1 == pattMark.markY2 || pattMark.markY1 > pattMark.markY2)
+	if (getEditPattern(editor.editPattern) == NULL || pattMark.markY1 == pattMark.markY2 || pattMark.markY1 > pattMark.markY2)
 		return;
 
 	const int32_t numRows = pattMark.markY2 - pattMark.markY1;
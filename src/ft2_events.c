@@ -31,6 +31,8 @@
 #include "ft2_keyboard.h"
 #include "ft2_sample_ed.h"
 #include "ft2_sample_ed_features.h"
+#include "ft2_wav_renderer.h"
+#include "ft2_render_queue.h"
 #include "ft2_structs.h"
 
 #define CRASH_TEXT "Oh no! The Fasttracker II clone has crashed...\nA backup .xm was hopefully " \
@@ -130,6 +132,9 @@ void handleEvents(void)
 
 	handleLoadMusicEvents();
 
+	if (updateRenderQueue() && ui.wavRendererShown)
+		drawWavRendererQueueStatus();
+
 	if (editor.samplingAudioFlag) handleSamplingUpdates();
 	if (ui.setMouseBusy) mouseAnimOn();
 	if (ui.setMouseIdle) mouseAnimOff();
@@ -0,0 +1,738 @@
+// for finding memory leaks in debug mode with Visual Studio
+#if defined _DEBUG && defined _MSC_VER
+#include <crtdbg.h>
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ft2_header.h"
+#include "ft2_flac_encoder.h"
+
+#define BLOCKS_PER_THREAD 4
+#define MAX_FIXED_ORDER 4
+#define MAX_PARTITION_ORDER 8
+#define MAX_RICE_PARAM 14 // 4-bit Rice parameters, 15 is the escape code
+#define STREAMINFO_SIZE 34
+#define MAX_FRAME_HEADER_SIZE 16
+
+// worst case frame size (a verbatim subframe per channel, the side channel has one extra bit)
+#define MAX_FRAME_SIZE (MAX_FRAME_HEADER_SIZE + (FLAC_MAX_CHANNELS * (2 + ((FLAC_BLOCK_SIZE * 25) + 7) / 8)) + 2)
+
+enum
+{
+	SUBFRAME_CONSTANT = 0,
+	SUBFRAME_VERBATIM = 1,
+	SUBFRAME_FIXED = 8 // + predictor order
+};
+
+enum
+{
+	CHANNELS_INDEPENDENT = 0, // + number of channels - 1
+	CHANNELS_LEFT_SIDE = 8,
+	CHANNELS_RIGHT_SIDE = 9,
+	CHANNELS_MID_SIDE = 10
+};
+
+typedef struct bitWriter_t
+{
+	uint8_t *ptr;
+	uint64_t bitBuffer;
+	int32_t numBits;
+} bitWriter_t;
+
+typedef struct subframe_t // how one channel of a block is going to be encoded
+{
+	int32_t type, order, partOrder;
+	uint8_t riceParam[1 << MAX_PARTITION_ORDER];
+	uint64_t numBits;
+} subframe_t;
+
+typedef struct block_t
+{
+	uint32_t frameNum, numSamples, numBytes;
+	const int32_t *smp[FLAC_MAX_CHANNELS];
+	uint8_t *out;
+} block_t;
+
+typedef struct worker_t
+{
+	flacEncoder_t *e;
+	int32_t firstBlock;
+	int32_t *mid, *side, *residual;
+	uint64_t partSum[1 << MAX_PARTITION_ORDER];
+	subframe_t subframe[4]; // left, right, mid, side
+	SDL_Thread *thread;
+} worker_t;
+
+struct flacEncoder_t
+{
+	FILE *f;
+	bool ioError;
+	int32_t numChannels, inputFormat, bitDepth, numThreads, numBlocks, blocksInBatch, activeWorkers;
+	uint32_t sampleRate, inputFrameSize, samplesInBatch, frameNum, minFrameSize, maxFrameSize;
+	uint64_t totalSamples;
+	int32_t *input[FLAC_MAX_CHANNELS];
+	uint8_t *outMem;
+	block_t block[FLAC_MAX_THREADS * BLOCKS_PER_THREAD];
+	worker_t worker[FLAC_MAX_THREADS];
+};
+
+static inline void putBits(bitWriter_t *bw, uint32_t value, int32_t numBits) // numBits = 0..32
+{
+	if (numBits < 32)
+		value &= (1UL << numBits) - 1;
+
+	bw->bitBuffer = (bw->bitBuffer << numBits) | value;
+	bw->numBits += numBits;
+
+	while (bw->numBits >= 8)
+	{
+		bw->numBits -= 8;
+		*bw->ptr++ = (uint8_t)(bw->bitBuffer >> bw->numBits);
+	}
+}
+
+static void putUTF8(bitWriter_t *bw, uint64_t value) // FLAC's extended UTF-8 coding (up to 36 bits)
+{
+	if (value < 0x80)
+	{
+		putBits(bw, (uint32_t)value, 8);
+		return;
+	}
+
+	int32_t numBytes = 2;
+	while (numBytes < 7 && value >= (1ULL << ((5 * numBytes) + 1)))
+		numBytes++;
+
+	putBits(bw, (uint8_t)(0xFF00 >> numBytes) | (uint32_t)(value >> (6 * (numBytes-1))), 8);
+	for (int32_t i = numBytes-2; i >= 0; i--)
+		putBits(bw, 0x80 | ((value >> (6 * i)) & 0x3F), 8);
+}
+
+static uint8_t crc8(const uint8_t *data, uint32_t length) // polynomial x^8 + x^2 + x^1 + x^0
+{
+	uint8_t crc = 0;
+	while (length--)
+	{
+		crc ^= *data++;
+		for (int32_t i = 0; i < 8; i++)
+			crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+	}
+
+	return crc;
+}
+
+static uint16_t crc16(const uint8_t *data, uint32_t length) // polynomial x^16 + x^15 + x^2 + x^0
+{
+	uint16_t crc = 0;
+	while (length--)
+	{
+		crc ^= (uint16_t)(*data++ << 8);
+		for (int32_t i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x8005) : (crc << 1);
+	}
+
+	return crc;
+}
+
+static void getFixedResidual(const int32_t *x, int32_t *residual, uint32_t numSamples, int32_t order)
+{
+	switch (order)
+	{
+		default:
+		case 0: for (uint32_t i = 0; i < numSamples; i++) residual[i] = x[i]; break;
+		case 1: for (uint32_t i = 1; i < numSamples; i++) residual[i-1] = x[i] - x[i-1]; break;
+		case 2: for (uint32_t i = 2; i < numSamples; i++) residual[i-2] = x[i] - 2*x[i-1] + x[i-2]; break;
+		case 3: for (uint32_t i = 3; i < numSamples; i++) residual[i-3] = x[i] - 3*x[i-1] + 3*x[i-2] - x[i-3]; break;
+		case 4: for (uint32_t i = 4; i < numSamples; i++) residual[i-4] = x[i] - 4*x[i-1] + 6*x[i-2] - 4*x[i-3] + x[i-4]; break;
+	}
+}
+
+static inline uint32_t foldResidual(int32_t value) // zig-zag: 0, -1, 1, -2, 2 ... -> 0, 1, 2, 3, 4 ...
+{
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+/* Estimates the Rice coded size of a partition. This is an upper bound, since the
+** sum of the (value >> k) terms is never bigger than (sum >> k).
+*/
+static uint64_t getRiceBits(uint64_t sum, uint32_t count, uint8_t *riceParamOut)
+{
+	if (count == 0)
+	{
+		*riceParamOut = 0;
+		return 0;
+	}
+
+	int32_t k = 0;
+	while (k < MAX_RICE_PARAM && ((uint64_t)count << (k+1)) <= sum)
+		k++;
+
+	// the best parameter is 'k' or one below it
+	uint64_t bestBits = (count * (uint64_t)(k+1)) + (sum >> k);
+	*riceParamOut = (uint8_t)k;
+
+	if (k > 0)
+	{
+		const uint64_t bits = (count * (uint64_t)k) + (sum >> (k-1));
+		if (bits < bestBits)
+		{
+			bestBits = bits;
+			*riceParamOut = (uint8_t)(k-1);
+		}
+	}
+
+	return bestBits;
+}
+
+static void planSubframe(worker_t *w, const int32_t *x, uint32_t n, int32_t bps, subframe_t *sf)
+{
+	uint32_t i;
+
+	for (i = 1; i < n; i++)
+	{
+		if (x[i] != x[0])
+			break;
+	}
+
+	if (i == n) // silence (or DC)
+	{
+		sf->type = SUBFRAME_CONSTANT;
+		sf->numBits = 8 + bps;
+		return;
+	}
+
+	sf->type = SUBFRAME_VERBATIM;
+	sf->numBits = 8 + ((uint64_t)n * bps);
+
+	if (n <= MAX_FIXED_ORDER)
+		return;
+
+	// find the best fixed predictor order (smallest sum of the absolute residuals)
+	uint64_t orderSum[MAX_FIXED_ORDER+1] = { 0 };
+	for (i = MAX_FIXED_ORDER; i < n; i++)
+	{
+		const int64_t e0 = x[i];
+		const int64_t e1 = e0 - x[i-1];
+		const int64_t e2 = e1 - (x[i-1] - x[i-2]);
+		const int64_t e3 = e2 - (x[i-1] - 2*(int64_t)x[i-2] + x[i-3]);
+		const int64_t e4 = e3 - (x[i-1] - 3*(int64_t)x[i-2] + 3*(int64_t)x[i-3] - x[i-4]);
+
+		orderSum[0] += (e0 < 0) ? -e0 : e0;
+		orderSum[1] += (e1 < 0) ? -e1 : e1;
+		orderSum[2] += (e2 < 0) ? -e2 : e2;
+		orderSum[3] += (e3 < 0) ? -e3 : e3;
+		orderSum[4] += (e4 < 0) ? -e4 : e4;
+	}
+
+	int32_t order = 0;
+	for (int32_t j = 1; j <= MAX_FIXED_ORDER; j++)
+	{
+		if (orderSum[j] < orderSum[order])
+			order = j;
+	}
+
+	getFixedResidual(x, w->residual, n, order);
+
+	// highest usable partition order (partitions must be equal-sized and hold more samples than the warm-up)
+	int32_t maxPartOrder = MAX_PARTITION_ORDER;
+	while (maxPartOrder > 0 && ((n & ((1 << maxPartOrder) - 1)) != 0 || (n >> maxPartOrder) <= (uint32_t)order))
+		maxPartOrder--;
+
+	// sum up the folded residuals of the smallest partitions, then merge them for each lower partition order
+	const uint32_t partSize = n >> maxPartOrder;
+	const int32_t *residual = w->residual;
+	for (int32_t j = 0; j < 1 << maxPartOrder; j++)
+	{
+		const uint32_t count = (j == 0) ? (partSize - order) : partSize;
+
+		uint64_t sum = 0;
+		for (i = 0; i < count; i++)
+			sum += foldResidual(*residual++);
+
+		w->partSum[j] = sum;
+	}
+
+	uint64_t bestBits = UINT64_MAX;
+	uint8_t riceParam[1 << MAX_PARTITION_ORDER];
+
+	for (int32_t p = maxPartOrder; p >= 0; p--)
+	{
+		const int32_t numParts = 1 << p;
+		uint64_t bits = 2 + 4; // coding method + partition order
+
+		for (int32_t j = 0; j < numParts; j++)
+		{
+			const uint32_t count = (j == 0) ? ((n >> p) - order) : (n >> p);
+			bits += 4 + getRiceBits(w->partSum[j], count, &riceParam[j]);
+		}
+
+		if (bits < bestBits)
+		{
+			bestBits = bits;
+			sf->partOrder = p;
+			memcpy(sf->riceParam, riceParam, numParts);
+		}
+
+		for (int32_t j = 0; j < numParts / 2; j++)
+			w->partSum[j] = w->partSum[j*2] + w->partSum[(j*2)+1];
+	}
+
+	const uint64_t fixedBits = 8 + ((uint64_t)order * bps) + bestBits;
+	if (fixedBits < sf->numBits)
+	{
+		sf->type = SUBFRAME_FIXED;
+		sf->order = order;
+		sf->numBits = fixedBits;
+	}
+}
+
+static void writeSubframe(worker_t *w, bitWriter_t *bw, const int32_t *x, uint32_t n, int32_t bps, const subframe_t *sf)
+{
+	putBits(bw, 0, 1); // zero bit padding
+	putBits(bw, (sf->type == SUBFRAME_FIXED) ? (SUBFRAME_FIXED + sf->order) : sf->type, 6);
+	putBits(bw, 0, 1); // no wasted bits
+
+	if (sf->type == SUBFRAME_CONSTANT)
+	{
+		putBits(bw, x[0], bps);
+	}
+	else if (sf->type == SUBFRAME_VERBATIM)
+	{
+		for (uint32_t i = 0; i < n; i++)
+			putBits(bw, x[i], bps);
+	}
+	else // fixed predictor
+	{
+		for (int32_t i = 0; i < sf->order; i++)
+			putBits(bw, x[i], bps); // warm-up samples
+
+		putBits(bw, 0, 2); // partitioned Rice coding, 4-bit parameters
+		putBits(bw, sf->partOrder, 4);
+
+		getFixedResidual(x, w->residual, n, sf->order);
+
+		const int32_t *residual = w->residual;
+		for (int32_t j = 0; j < 1 << sf->partOrder; j++)
+		{
+			const int32_t k = sf->riceParam[j];
+			putBits(bw, k, 4);
+
+			uint32_t count = n >> sf->partOrder;
+			if (j == 0)
+				count -= sf->order;
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const uint32_t value = foldResidual(*residual++);
+
+				uint32_t q = value >> k;
+				while (q + k + 1 > 32)
+				{
+					const uint32_t zeroes = MIN(q, 32);
+					putBits(bw, 0, zeroes);
+					q -= zeroes;
+				}
+
+				putBits(bw, (1UL << k) | (value & ((1UL << k) - 1)), q + k + 1); // unary quotient, stop bit, low bits
+			}
+		}
+	}
+}
+
+static uint8_t getSampleRateCode(uint32_t sampleRate)
+{
+	switch (sampleRate)
+	{
+		case 88200:  return 1;
+		case 176400: return 2;
+		case 192000: return 3;
+		case 8000:   return 4;
+		case 16000:  return 5;
+		case 22050:  return 6;
+		case 24000:  return 7;
+		case 32000:  return 8;
+		case 44100:  return 9;
+		case 48000:  return 10;
+		case 96000:  return 11;
+		default:     return 0; // get it from STREAMINFO
+	}
+}
+
+static void encodeBlock(worker_t *w, block_t *b)
+{
+	const flacEncoder_t *e = w->e;
+	const uint32_t n = b->numSamples;
+	const int32_t bps = e->bitDepth;
+
+	const int32_t *src[FLAC_MAX_CHANNELS];
+	const subframe_t *sf[FLAC_MAX_CHANNELS];
+	int32_t srcBps[FLAC_MAX_CHANNELS];
+	int32_t channelMode;
+
+	if (e->numChannels == 2)
+	{
+		const int32_t *L = b->smp[0], *R = b->smp[1];
+		for (uint32_t i = 0; i < n; i++)
+		{
+			w->mid[i] = (L[i] + R[i]) >> 1;
+			w->side[i] = L[i] - R[i];
+		}
+
+		subframe_t *s = w->subframe;
+		planSubframe(w, L, n, bps, &s[0]);
+		planSubframe(w, R, n, bps, &s[1]);
+		planSubframe(w, w->mid, n, bps, &s[2]);
+		planSubframe(w, w->side, n, bps+1, &s[3]);
+
+		// pick the smallest channel pair
+		const uint64_t LR = s[0].numBits + s[1].numBits;
+		const uint64_t LS = s[0].numBits + s[3].numBits;
+		const uint64_t RS = s[1].numBits + s[3].numBits;
+		const uint64_t MS = s[2].numBits + s[3].numBits;
+
+		if (MS < LR && MS <= LS && MS <= RS)
+		{
+			channelMode = CHANNELS_MID_SIDE;
+			src[0] = w->mid;  sf[0] = &s[2]; srcBps[0] = bps;
+			src[1] = w->side; sf[1] = &s[3]; srcBps[1] = bps+1;
+		}
+		else if (LS < LR && LS <= RS)
+		{
+			channelMode = CHANNELS_LEFT_SIDE;
+			src[0] = L;       sf[0] = &s[0]; srcBps[0] = bps;
+			src[1] = w->side; sf[1] = &s[3]; srcBps[1] = bps+1;
+		}
+		else if (RS < LR)
+		{
+			channelMode = CHANNELS_RIGHT_SIDE;
+			src[0] = w->side; sf[0] = &s[3]; srcBps[0] = bps+1;
+			src[1] = R;       sf[1] = &s[1]; srcBps[1] = bps;
+		}
+		else
+		{
+			channelMode = CHANNELS_INDEPENDENT + 1;
+			src[0] = L; sf[0] = &s[0]; srcBps[0] = bps;
+			src[1] = R; sf[1] = &s[1]; srcBps[1] = bps;
+		}
+	}
+	else
+	{
+		planSubframe(w, b->smp[0], n, bps, &w->subframe[0]);
+
+		channelMode = CHANNELS_INDEPENDENT;
+		src[0] = b->smp[0]; sf[0] = &w->subframe[0]; srcBps[0] = bps;
+	}
+
+	bitWriter_t bw;
+	bw.ptr = b->out;
+	bw.bitBuffer = 0;
+	bw.numBits = 0;
+
+	// frame header
+	putBits(&bw, 0xFFF8, 16); // sync code, fixed block size
+	putBits(&bw, (n == FLAC_BLOCK_SIZE) ? 12 : 7, 4); // 12 = 4096, 7 = 16-bit size at end of header
+	putBits(&bw, getSampleRateCode(e->sampleRate), 4);
+	putBits(&bw, channelMode, 4);
+	putBits(&bw, (bps == 8) ? 1 : ((bps == 16) ? 4 : 6), 3);
+	putBits(&bw, 0, 1);
+	putUTF8(&bw, b->frameNum);
+
+	if (n != FLAC_BLOCK_SIZE)
+		putBits(&bw, n - 1, 16);
+
+	putBits(&bw, crc8(b->out, (uint32_t)(bw.ptr - b->out)), 8);
+
+	for (int32_t i = 0; i < e->numChannels; i++)
+		writeSubframe(w, &bw, src[i], n, srcBps[i], sf[i]);
+
+	if (bw.numBits > 0)
+		putBits(&bw, 0, 8 - bw.numBits); // pad to byte boundary
+
+	putBits(&bw, crc16(b->out, (uint32_t)(bw.ptr - b->out)), 16);
+	b->numBytes = (uint32_t)(bw.ptr - b->out);
+}
+
+static void encodeWorkerBlocks(worker_t *w)
+{
+	flacEncoder_t *e = w->e;
+	for (int32_t i = w->firstBlock; i < e->blocksInBatch; i += e->activeWorkers)
+		encodeBlock(w, &e->block[i]);
+}
+
+static int32_t SDLCALL workerThread(void *ptr)
+{
+	encodeWorkerBlocks((worker_t *)ptr);
+	return true;
+}
+
+static void encodeBatch(flacEncoder_t *e)
+{
+	if (e->samplesInBatch == 0)
+		return;
+
+	e->blocksInBatch = (e->samplesInBatch + (FLAC_BLOCK_SIZE-1)) / FLAC_BLOCK_SIZE;
+	for (int32_t i = 0; i < e->blocksInBatch; i++)
+	{
+		block_t *b = &e->block[i];
+
+		b->frameNum = e->frameNum + i;
+		b->numSamples = MIN(FLAC_BLOCK_SIZE, e->samplesInBatch - (i * FLAC_BLOCK_SIZE));
+		for (int32_t ch = 0; ch < e->numChannels; ch++)
+			b->smp[ch] = &e->input[ch][i * FLAC_BLOCK_SIZE];
+	}
+
+	e->activeWorkers = MIN(e->numThreads, e->blocksInBatch);
+
+	// the calling thread does the first worker's blocks, and the blocks of any worker that couldn't be started
+	for (int32_t i = 1; i < e->activeWorkers; i++)
+		e->worker[i].thread = SDL_CreateThread(workerThread, NULL, &e->worker[i]);
+
+	encodeWorkerBlocks(&e->worker[0]);
+
+	for (int32_t i = 1; i < e->activeWorkers; i++)
+	{
+		if (e->worker[i].thread != NULL)
+			SDL_WaitThread(e->worker[i].thread, NULL);
+		else
+			encodeWorkerBlocks(&e->worker[i]);
+
+		e->worker[i].thread = NULL;
+	}
+
+	for (int32_t i = 0; i < e->blocksInBatch; i++)
+	{
+		const block_t *b = &e->block[i];
+		if (!e->ioError && fwrite(b->out, 1, b->numBytes, e->f) != b->numBytes)
+			e->ioError = true;
+
+		e->minFrameSize = MIN(e->minFrameSize, b->numBytes);
+		e->maxFrameSize = MAX(e->maxFrameSize, b->numBytes);
+	}
+
+	e->frameNum += e->blocksInBatch;
+	e->totalSamples += e->samplesInBatch;
+	e->samplesInBatch = 0;
+}
+
+static void writeStreamInfo(flacEncoder_t *e)
+{
+	uint8_t streamInfo[STREAMINFO_SIZE];
+
+	bitWriter_t bw;
+	bw.ptr = streamInfo;
+	bw.bitBuffer = 0;
+	bw.numBits = 0;
+
+	putBits(&bw, FLAC_BLOCK_SIZE, 16); // min. block size
+	putBits(&bw, FLAC_BLOCK_SIZE, 16); // max. block size
+	putBits(&bw, (e->frameNum > 0) ? e->minFrameSize : 0, 24);
+	putBits(&bw, e->maxFrameSize, 24);
+	putBits(&bw, e->sampleRate, 20);
+	putBits(&bw, e->numChannels - 1, 3);
+	putBits(&bw, e->bitDepth - 1, 5);
+	putBits(&bw, (uint32_t)(e->totalSamples >> 32), 4);
+	putBits(&bw, (uint32_t)e->totalSamples, 32);
+	memset(bw.ptr, 0, 16); // no MD5 signature
+
+	fwrite(streamInfo, 1, STREAMINFO_SIZE, e->f);
+}
+
+static void writeMetadataBlockHeader(FILE *f, uint8_t type, uint32_t length, bool lastBlock)
+{
+	uint8_t header[4];
+
+	header[0] = (lastBlock ? 0x80 : 0x00) | type;
+	header[1] = (uint8_t)(length >> 16);
+	header[2] = (uint8_t)(length >> 8);
+	header[3] = (uint8_t)length;
+
+	fwrite(header, 1, 4, f);
+}
+
+static void freeFlacEncoder(flacEncoder_t *e)
+{
+	for (int32_t i = 0; i < FLAC_MAX_CHANNELS; i++)
+	{
+		if (e->input[i] != NULL)
+			free(e->input[i]);
+	}
+
+	for (int32_t i = 0; i < FLAC_MAX_THREADS; i++)
+	{
+		worker_t *w = &e->worker[i];
+		if (w->mid != NULL) free(w->mid);
+		if (w->side != NULL) free(w->side);
+		if (w->residual != NULL) free(w->residual);
+	}
+
+	if (e->outMem != NULL)
+		free(e->outMem);
+
+	free(e);
+}
+
+flacEncoder_t *openFlacEncoder(FILE *f, uint32_t sampleRate, int32_t numChannels, int32_t inputFormat,
+	int32_t numThreads, const flacMetadata_t *metadata, int32_t numMetadata)
+{
+	if (f == NULL || numChannels < 1 || numChannels > FLAC_MAX_CHANNELS || sampleRate == 0 || sampleRate > 655350)
+		return NULL;
+
+	flacEncoder_t *e = (flacEncoder_t *)calloc(1, sizeof (flacEncoder_t));
+	if (e == NULL)
+		return NULL;
+
+	if (numThreads < 1)
+		numThreads = SDL_GetCPUCount();
+
+	e->f = f;
+	e->sampleRate = sampleRate;
+	e->numChannels = numChannels;
+	e->inputFormat = inputFormat;
+	e->numThreads = CLAMP(numThreads, 1, FLAC_MAX_THREADS);
+	e->numBlocks = e->numThreads * BLOCKS_PER_THREAD;
+	e->minFrameSize = UINT32_MAX;
+
+	switch (inputFormat)
+	{
+		case FLAC_INPUT_8BIT:  e->bitDepth = 8;  e->inputFrameSize = numChannels * sizeof (int8_t);  break;
+		case FLAC_INPUT_16BIT: e->bitDepth = 16; e->inputFrameSize = numChannels * sizeof (int16_t); break;
+		default: case FLAC_INPUT_FLOAT: e->bitDepth = 24; e->inputFrameSize = numChannels * sizeof (float); break;
+	}
+
+	bool allocFailed = false;
+	for (int32_t i = 0; i < numChannels; i++)
+	{
+		e->input[i] = (int32_t *)malloc(e->numBlocks * FLAC_BLOCK_SIZE * sizeof (int32_t));
+		if (e->input[i] == NULL)
+			allocFailed = true;
+	}
+
+	for (int32_t i = 0; i < e->numThreads; i++)
+	{
+		worker_t *w = &e->worker[i];
+
+		w->e = e;
+		w->firstBlock = i;
+		w->mid = (int32_t *)malloc(FLAC_BLOCK_SIZE * sizeof (int32_t));
+		w->side = (int32_t *)malloc(FLAC_BLOCK_SIZE * sizeof (int32_t));
+		w->residual = (int32_t *)malloc(FLAC_BLOCK_SIZE * sizeof (int32_t));
+
+		if (w->mid == NULL || w->side == NULL || w->residual == NULL)
+			allocFailed = true;
+	}
+
+	e->outMem = (uint8_t *)malloc((size_t)e->numBlocks * MAX_FRAME_SIZE);
+	if (e->outMem == NULL || allocFailed)
+	{
+		freeFlacEncoder(e);
+		return NULL;
+	}
+
+	for (int32_t i = 0; i < e->numBlocks; i++)
+		e->block[i].out = &e->outMem[i * MAX_FRAME_SIZE];
+
+	// "fLaC" marker and a STREAMINFO placeholder, then the extra metadata blocks
+	fwrite("fLaC", 1, 4, f);
+	writeMetadataBlockHeader(f, 0, STREAMINFO_SIZE, numMetadata == 0);
+	writeStreamInfo(e);
+
+	for (int32_t i = 0; i < numMetadata; i++)
+	{
+		writeMetadataBlockHeader(f, metadata[i].type, metadata[i].length, i == numMetadata-1);
+		fwrite(metadata[i].data, 1, metadata[i].length, f);
+	}
+
+	if (ferror(f))
+	{
+		freeFlacEncoder(e);
+		return NULL;
+	}
+
+	return e;
+}
+
+bool encodeFlacSamples(flacEncoder_t *e, const void *data, uint32_t numBytes)
+{
+	const int32_t numChannels = e->numChannels;
+	const uint32_t batchSize = e->numBlocks * FLAC_BLOCK_SIZE;
+
+	const int8_t *src8 = (const int8_t *)data;
+	const int16_t *src16 = (const int16_t *)data;
+	const float *fSrc = (const float *)data;
+
+	uint32_t numFrames = numBytes / e->inputFrameSize;
+	while (numFrames > 0)
+	{
+		const uint32_t framesToCopy = MIN(numFrames, batchSize - e->samplesInBatch);
+
+		for (int32_t ch = 0; ch < numChannels; ch++)
+		{
+			int32_t *dst = &e->input[ch][e->samplesInBatch];
+
+			if (e->inputFormat == FLAC_INPUT_8BIT)
+			{
+				for (uint32_t i = 0; i < framesToCopy; i++)
+					dst[i] = src8[(i * numChannels) + ch];
+			}
+			else if (e->inputFormat == FLAC_INPUT_16BIT)
+			{
+				for (uint32_t i = 0; i < framesToCopy; i++)
+					dst[i] = src16[(i * numChannels) + ch];
+			}
+			else // float -> 24-bit
+			{
+				for (uint32_t i = 0; i < framesToCopy; i++)
+				{
+					const double dSmp = fSrc[(i * numChannels) + ch] * 8388608.0;
+					if (dSmp <= -8388608.0)
+						dst[i] = -8388608;
+					else if (dSmp >= 8388607.0)
+						dst[i] = 8388607;
+					else
+						dst[i] = (int32_t)floor(dSmp + 0.5);
+				}
+			}
+		}
+
+		src8 += framesToCopy * numChannels;
+		src16 += framesToCopy * numChannels;
+		fSrc += framesToCopy * numChannels;
+
+		numFrames -= framesToCopy;
+		e->samplesInBatch += framesToCopy;
+
+		if (e->samplesInBatch == batchSize)
+			encodeBatch(e);
+	}
+
+	return !e->ioError;
+}
+
+bool closeFlacEncoder(flacEncoder_t *e)
+{
+	if (e == NULL)
+		return false;
+
+	encodeBatch(e);
+
+	// go back and fill in STREAMINFO
+	fseek(e->f, 4 + 4, SEEK_SET);
+	writeStreamInfo(e);
+	fseek(e->f, 0, SEEK_END);
+
+	const bool ok = !e->ioError && !ferror(e->f);
+	freeFlacEncoder(e);
+
+	return ok;
+}
+
+bool filenameIsFlac(const char *filename)
+{
+	const char *ext = strrchr(filename, '.');
+	return ext != NULL && !_stricmp(ext, ".flac");
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Small FLAC encoder for the song renderers and the sample saver. It only uses the
+** fixed predictors (order 0..4) with partitioned Rice coding and stereo decorrelation,
+** which gets close to "flac -3" on tracker output and doesn't need libFLAC's encoder.
+**
+** Input is buffered until there are enough blocks to give every thread a few, and
+** then the blocks (FLAC frames) are encoded in parallel and written in order.
+** The file must be empty, the STREAMINFO block is filled in when closing.
+*/
+
+#define FLAC_BLOCK_SIZE 4096
+#define FLAC_MAX_CHANNELS 2
+#define FLAC_MAX_THREADS 64
+
+enum
+{
+	FLAC_INPUT_8BIT = 0, // int8_t
+	FLAC_INPUT_16BIT = 1, // int16_t
+	FLAC_INPUT_FLOAT = 2 // float (-1.0 .. 1.0), written as 24-bit
+};
+
+typedef struct flacMetadata_t // extra metadata block, written after STREAMINFO
+{
+	uint8_t type; // FLAC_METADATA_*
+	uint32_t length;
+	const void *data;
+} flacMetadata_t;
+
+enum
+{
+	FLAC_METADATA_APPLICATION = 2,
+	FLAC_METADATA_VORBIS_COMMENT = 4
+};
+
+typedef struct flacEncoder_t flacEncoder_t;
+
+// 'numThreads' < 1 means one per CPU core, returns NULL if out of memory or the header couldn't be written
+flacEncoder_t *openFlacEncoder(FILE *f, uint32_t sampleRate, int32_t numChannels, int32_t inputFormat,
+	int32_t numThreads, const flacMetadata_t *metadata, int32_t numMetadata);
+
+bool encodeFlacSamples(flacEncoder_t *e, const void *data, uint32_t numBytes); // interleaved, whole sample frames
+bool closeFlacEncoder(flacEncoder_t *e); // encodes the rest and writes STREAMINFO, doesn't close the FILE
+bool filenameIsFlac(const char *filename); // ends in ".flac"
@@ -0,0 +1,172 @@
+// for finding memory leaks in debug mode with Visual Studio
+#if defined _DEBUG && defined _MSC_VER
+#include <crtdbg.h>
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include "ft2_hash.h"
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define ROTL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+static uint64_t read64(const uint8_t *p)
+{
+	uint64_t x;
+	memcpy(&x, p, 8); // little-endian, like the rest of the code
+	return x;
+}
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t x;
+	memcpy(&x, p, 4);
+	return x;
+}
+
+static uint64_t round64(uint64_t acc, uint64_t input)
+{
+	acc += input * PRIME64_2;
+	acc = ROTL64(acc, 31);
+	return acc * PRIME64_1;
+}
+
+static uint64_t mergeRound64(uint64_t acc, uint64_t val)
+{
+	acc ^= round64(0, val);
+	return (acc * PRIME64_1) + PRIME64_4;
+}
+
+// consumes whole 32-byte stripes, returns the number of bytes used
+static size_t hashStripes(uint64_t *acc, const uint8_t *p, size_t length)
+{
+	uint64_t v1 = acc[0], v2 = acc[1], v3 = acc[2], v4 = acc[3];
+
+	const uint8_t *start = p;
+	const uint8_t *end = p + (length & ~(size_t)31);
+	while (p < end)
+	{
+		v1 = round64(v1, read64(p +  0));
+		v2 = round64(v2, read64(p +  8));
+		v3 = round64(v3, read64(p + 16));
+		v4 = round64(v4, read64(p + 24));
+		p += 32;
+	}
+
+	acc[0] = v1; acc[1] = v2; acc[2] = v3; acc[3] = v4;
+	return p - start;
+}
+
+void hash64Init(hash64_t *h, uint64_t seed)
+{
+	memset(h, 0, sizeof (hash64_t));
+
+	h->seed = seed;
+	h->acc[0] = seed + PRIME64_1 + PRIME64_2;
+	h->acc[1] = seed + PRIME64_2;
+	h->acc[2] = seed;
+	h->acc[3] = seed - PRIME64_1;
+}
+
+void hash64Update(hash64_t *h, const void *data, size_t length)
+{
+	const uint8_t *p = (const uint8_t *)data;
+
+	h->totalLength += length;
+
+	if (h->bufferLength > 0) // fill up the last partial stripe first
+	{
+		size_t bytesToCopy = 32 - h->bufferLength;
+		if (bytesToCopy > length)
+			bytesToCopy = length;
+
+		memcpy(&h->buffer[h->bufferLength], p, bytesToCopy);
+		h->bufferLength += (uint32_t)bytesToCopy;
+		p += bytesToCopy;
+		length -= bytesToCopy;
+
+		if (h->bufferLength < 32)
+			return;
+
+		hashStripes(h->acc, h->buffer, 32);
+		h->bufferLength = 0;
+	}
+
+	const size_t bytesUsed = hashStripes(h->acc, p, length);
+	p += bytesUsed;
+	length -= bytesUsed;
+
+	if (length > 0)
+	{
+		memcpy(h->buffer, p, length);
+		h->bufferLength = (uint32_t)length;
+	}
+}
+
+uint64_t hash64Final(const hash64_t *h)
+{
+	uint64_t hash;
+
+	if (h->totalLength >= 32)
+	{
+		const uint64_t *acc = h->acc;
+
+		hash = ROTL64(acc[0], 1) + ROTL64(acc[1], 7) + ROTL64(acc[2], 12) + ROTL64(acc[3], 18);
+		hash = mergeRound64(hash, acc[0]);
+		hash = mergeRound64(hash, acc[1]);
+		hash = mergeRound64(hash, acc[2]);
+		hash = mergeRound64(hash, acc[3]);
+	}
+	else
+	{
+		hash = h->seed + PRIME64_5;
+	}
+
+	hash += h->totalLength;
+
+	// the remaining 0..31 bytes
+	const uint8_t *p = h->buffer;
+	uint32_t length = h->bufferLength;
+
+	for (; length >= 8; length -= 8, p += 8)
+	{
+		hash ^= round64(0, read64(p));
+		hash = (ROTL64(hash, 27) * PRIME64_1) + PRIME64_4;
+	}
+
+	if (length >= 4)
+	{
+		hash ^= (uint64_t)read32(p) * PRIME64_1;
+		hash = (ROTL64(hash, 23) * PRIME64_2) + PRIME64_3;
+		length -= 4;
+		p += 4;
+	}
+
+	for (; length > 0; length--, p++)
+	{
+		hash ^= *p * PRIME64_5;
+		hash = ROTL64(hash, 11) * PRIME64_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= PRIME64_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+uint64_t hash64(const void *data, size_t length, uint64_t seed)
+{
+	hash64_t h;
+
+	hash64Init(&h, seed);
+	hash64Update(&h, data, length);
+	return hash64Final(&h);
+}
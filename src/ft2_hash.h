@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Fast 64-bit non-cryptographic hashing (the XXH64 algorithm, same results as xxHash's
+** XXH64()). Used for content fingerprints of samples and patterns, so the results must
+** never change between versions. The data is hashed as little-endian.
+*/
+
+typedef struct hash64_t
+{
+	uint64_t acc[4], seed, totalLength;
+	uint8_t buffer[32];
+	uint32_t bufferLength;
+} hash64_t;
+
+void hash64Init(hash64_t *h, uint64_t seed);
+void hash64Update(hash64_t *h, const void *data, size_t length);
+uint64_t hash64Final(const hash64_t *h); // doesn't change the state, more data can be added after this
+
+uint64_t hash64(const void *data, size_t length, uint64_t seed); // the same in one call
@@ -2,6 +2,10 @@
 
 #ifndef FT2_HEADLESS
 #include <SDL2/SDL.h>
+#else
+#include <stdlib.h> // these come with SDL.h otherwise
+#include <string.h>
+#include <ctype.h>
 #endif
 #include <stdint.h>
 #include <stdbool.h>
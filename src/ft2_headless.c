@@ -0,0 +1,1129 @@
+// for finding memory leaks in debug mode with Visual Studio
+#if defined _DEBUG && defined _MSC_VER
+#include <crtdbg.h>
+#endif
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+#include "ft2_header.h"
+#include "ft2_audio.h"
+#include "ft2_config.h"
+#include "ft2_tables.h"
+#include "ft2_module_loader.h"
+#include "ft2_sysreqs.h"
+#include "ft2_wav_renderer.h"
+#include "ft2_render_writer.h"
+#include "ft2_flac_encoder.h"
+#include "ft2_loudness.h"
+#include "ft2_structs.h"
+#include "ft2_headless.h"
+#include "mixer/ft2_windowed_sinc.h"
+
+#define HEADLESS_AUDIO_FREQ 48000
+#define HEADLESS_MAX_SECONDS (60*60) // for songs that loop forever without wrapping the order list
+
+#define RENDER_TICKS_PER_CHUNK 64
+#define MAX_RENDER_TICKS_PER_CHUNK 1024
+#define MAX_RENDER_JOBS 64
+
+#define NORMALIZE_MIN_LUFS (-60.0)
+#define NORMALIZE_MIN_TRUE_PEAK (-20.0)
+#define NORMALIZE_DEFAULT_TRUE_PEAK (-1.0)
+
+enum
+{
+	CMD_NONE = 0,
+	CMD_RENDER = 1,
+	CMD_LOUDNESS = 2
+};
+
+typedef struct renderOpts_t
+{
+	bool stems, normalize, progress, oversample;
+	int16_t startPos, endPos; // -1 = song start/end
+	int32_t interpolation, amp, masterVol, volumeRamp; // -1 = config default
+	int32_t numJobs, ticksPerChunk, numBuffers;
+	uint8_t bitDepth;
+	uint32_t freq;
+	double dTargetLUFS, dMaxTruePeakDB; // for --normalize
+} renderOpts_t;
+
+typedef struct renderFiles_t // the output file, or one file per channel when rendering stems
+{
+	bool flac;
+	int32_t numFiles;
+	FILE *f[MAX_CHANNELS];
+	flacEncoder_t *encoder[MAX_CHANNELS]; // for FLAC output
+	char *path[MAX_CHANNELS];
+} renderFiles_t;
+
+typedef struct renderSegment_t
+{
+	uint32_t startTick, numTicks;
+	uint64_t startSample; // stereo samples rendered before this segment
+} renderSegment_t;
+
+static bool showProgress;
+static int16_t progressStartPos, progressEndPos;
+static int32_t lastProgress;
+static uint64_t tickSamplesFrac;
+
+static void headlessLoaderMsgBox(const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+
+	fputc('\n', stderr);
+}
+
+static int16_t headlessSysReq(int16_t type, const char *headline, const char *text)
+{
+	fprintf(stderr, "%s: %s\n", headline, text);
+	return 1; // first button
+
+	(void)type;
+}
+
+static int32_t getCommand(const char *arg)
+{
+	if (arg == NULL)
+		return CMD_NONE;
+
+	if (!strcmp(arg, "--render"))
+		return CMD_RENDER;
+
+	if (!strcmp(arg, "--loudness"))
+		return CMD_LOUDNESS;
+
+	return CMD_NONE;
+}
+
+static UNICHAR *argToUnichar(const char *arg)
+{
+	const uint32_t argLen = (const uint32_t)strlen(arg);
+
+	UNICHAR *strU = (UNICHAR *)malloc((argLen + 1) * sizeof (UNICHAR));
+	if (strU == NULL)
+		return NULL;
+
+#ifdef _WIN32
+	MultiByteToWideChar(CP_UTF8, 0, arg, -1, strU, argLen+1);
+#else
+	strcpy(strU, arg);
+#endif
+
+	return strU;
+}
+
+static bool setupHeadless(uint32_t audioFreq)
+{
+	if (!calcWindowedSincTables())
+		return false;
+
+	// always use the default FT2.CFG settings, so that the output doesn't depend on the user's config
+	memcpy(&config, defConfigData, CONFIG_FILE_SIZE);
+	config.interpolation &= 3;
+	config.boostLevel = CLAMP(config.boostLevel, 1, 32);
+	config.masterVol = CLAMP(config.masterVol, 0, 256);
+
+	if (!setupReplayer() || !setupHeadlessAudio(audioFreq))
+		return false;
+
+	audioSetInterpolationType(config.interpolation);
+	audioSetVolRamp((config.specialFlags & NO_VOLRAMP_FLAG) ? false : true);
+	setAudioAmp(config.boostLevel, config.masterVol, false);
+
+	loaderMsgBox = headlessLoaderMsgBox;
+	loaderSysReq = headlessSysReq;
+
+	return true;
+}
+
+static void closeHeadless(void)
+{
+	stopVoices();
+	closeAudio();
+	closeReplayer();
+}
+
+static void startHeadlessPlayback(int16_t songPos) // same as the WAV renderer
+{
+	setPos(songPos, 0, true);
+	playMode = PLAYMODE_SONG;
+	songPlaying = true;
+
+	resetChannels();
+	stopVoices();
+	song.globalVolume = 64;
+	setMixerBPM(song.BPM);
+	resetAudioDither();
+
+	editor.wavReachedEndFlag = false;
+	tickSamplesFrac = 0;
+}
+
+static uint32_t replayTick(void) // returns length of the tick in samples
+{
+	dump_TickReplayer();
+
+	uint32_t tickSamples = audio.samplesPerTickInt;
+
+	tickSamplesFrac += audio.samplesPerTickFrac;
+	if (tickSamplesFrac >= BPM_FRAC_SCALE)
+	{
+		tickSamplesFrac &= BPM_FRAC_MASK;
+		tickSamples++;
+	}
+
+	return tickSamples;
+}
+
+static uint32_t renderTick(uint8_t *stream, uint8_t bitDepth) // returns number of stereo samples mixed
+{
+	const uint32_t tickSamples = replayTick();
+	mixReplayerTickToBuffer(tickSamples, stream, bitDepth);
+
+	return tickSamples;
+}
+
+static uint32_t renderStemTick(uint8_t **streams, uint8_t bitDepth) // one stream per channel
+{
+	const uint32_t tickSamples = replayTick();
+	mixReplayerTickToStemBuffers(tickSamples, streams, bitDepth);
+
+	return tickSamples;
+}
+
+static uint32_t skipTick(void) // same as renderTick(), but only advances the voices
+{
+	const uint32_t tickSamples = replayTick();
+	skipMixerSamples(tickSamples);
+
+	return tickSamples;
+}
+
+static uint32_t getMaxSamplesPerTick(void)
+{
+	return (uint32_t)ceil(audio.freq / (MIN_BPM / 2.5)) + 1;
+}
+
+static bool loadModule(const char *modulePath)
+{
+	UNICHAR *filenameU = argToUnichar(modulePath);
+	if (filenameU == NULL)
+	{
+		fprintf(stderr, "Not enough memory!\n");
+		return false;
+	}
+
+	const bool loaded = loadMusicHeadless(filenameU);
+	free(filenameU);
+
+	if (!loaded)
+		fprintf(stderr, "Couldn't load \"%s\"\n", modulePath);
+
+	return loaded;
+}
+
+// checked before every tick, also by the pre-pass of parallel rendering (dump_EndOfTune() must be called once per tick)
+static bool renderEnded(int16_t endPos, uint64_t totalSamples, bool showMsg)
+{
+	if (dump_EndOfTune(endPos))
+		return true;
+
+	if (totalSamples >= (uint64_t)audio.freq * HEADLESS_MAX_SECONDS)
+	{
+		if (showMsg)
+			fprintf(stderr, "render: the song didn't end within %d minutes, stopping there\n", HEADLESS_MAX_SECONDS / 60);
+
+		return true;
+	}
+
+	return false;
+}
+
+/* For --progress: prints "progress <percent>" lines to stdout (f.ex. for the render queue,
+** which reads them from a pipe).
+*/
+static void printProgress(int32_t progress)
+{
+	progress = CLAMP(progress, 0, 99); // 100 is printed when the file is done
+
+	if (progress > lastProgress) // Bxx can jump backwards, never show that
+	{
+		lastProgress = progress;
+		printf("progress %d\n", progress);
+		fflush(stdout);
+	}
+}
+
+// based on the song position
+static void updateProgress(void)
+{
+	const int32_t numPositions = (progressEndPos - progressStartPos) + 1;
+	printProgress(((song.songPos - progressStartPos) * 100) / numPositions);
+}
+
+// renders 'numTicks' ticks (or until the end) to the current file positions, 'totalSamples' is updated
+static bool renderTicks(renderFiles_t *out, const char *outPath, int16_t endPos, const renderOpts_t *opts,
+	uint32_t numTicks, uint64_t *totalSamples)
+{
+	uint8_t *streams[MAX_CHANNELS];
+
+	const uint32_t bytesPerSample = (opts->bitDepth == 16) ? sizeof (int16_t) : sizeof (float);
+
+	// for stems, the chunk size is for all files together (to keep the buffer memory sane with many channels)
+	const int32_t ticksPerChunk = MAX(1, opts->ticksPerChunk / out->numFiles);
+	const uint32_t chunkSize = ticksPerChunk * getMaxSamplesPerTick() * 2 * bytesPerSample;
+
+	renderWriter_t *w = openRenderWriter(out->f, out->encoder, out->numFiles, chunkSize, opts->numBuffers);
+	if (w == NULL)
+	{
+		fprintf(stderr, "Not enough memory!\n");
+		return false;
+	}
+
+	bool renderDone = false;
+	while (!renderDone && !renderWriterFailed(w))
+	{
+		// render several ticks at once, the writer thread writes the previous chunks while we mix this one
+		uint8_t *chunk = getRenderWriterBuffer(w);
+		uint32_t bytesInChunk = 0;
+
+		for (int32_t i = 0; i < ticksPerChunk; i++)
+		{
+			if (numTicks == 0 || renderEnded(endPos, *totalSamples, true))
+			{
+				renderDone = true;
+				break;
+			}
+
+			uint32_t tickSamples;
+			if (opts->stems)
+			{
+				for (int32_t j = 0; j < out->numFiles; j++)
+					streams[j] = &chunk[(j * chunkSize) + bytesInChunk];
+
+				tickSamples = renderStemTick(streams, opts->bitDepth);
+			}
+			else
+			{
+				tickSamples = renderTick(&chunk[bytesInChunk], opts->bitDepth);
+			}
+
+			*totalSamples += tickSamples;
+			numTicks--;
+
+			if (showProgress)
+				updateProgress();
+
+			bytesInChunk += tickSamples * 2 * bytesPerSample;
+		}
+
+		queueRenderWriterBuffer(w, bytesInChunk);
+	}
+
+	if (!closeRenderWriter(w))
+	{
+		fprintf(stderr, "render: I/O error while writing \"%s\" (disk full?)\n", outPath);
+		return false;
+	}
+
+	return true;
+}
+
+// the analysis pass for --loudness and --normalize, measures the mix at the current amplification
+static bool measureLoudness(int16_t startPos, int16_t endPos, loudness_t *l)
+{
+	loudnessMeter_t *m = createLoudnessMeter(audio.freq);
+	float *tickBuffer = (float *)malloc(getMaxSamplesPerTick() * 2 * sizeof (float)); // stereo
+
+	if (m == NULL || tickBuffer == NULL)
+	{
+		freeLoudnessMeter(m);
+		if (tickBuffer != NULL)
+			free(tickBuffer);
+
+		fprintf(stderr, "Not enough memory!\n");
+		return false;
+	}
+
+	startHeadlessPlayback(startPos);
+
+	bool ok = true;
+	uint64_t totalSamples = 0;
+
+	while (ok && !renderEnded(endPos, totalSamples, true))
+	{
+		const uint32_t tickSamples = replayTick();
+		mixReplayerTickToFloatBuffer(tickSamples, tickBuffer);
+
+		ok = addLoudnessSamples(m, tickBuffer, tickSamples);
+		totalSamples += tickSamples;
+	}
+
+	if (ok)
+		getLoudness(m, l);
+	else
+		fprintf(stderr, "Not enough memory!\n");
+
+	songPlaying = false;
+	playMode = PLAYMODE_IDLE;
+
+	freeLoudnessMeter(m);
+	free(tickBuffer);
+
+	return ok;
+}
+
+static void printLoudness(const loudness_t *l)
+{
+	if (l->dIntegratedLUFS == -HUGE_VAL)
+		printf("loudness: integrated -inf LUFS (silent or too short)\n");
+	else
+		printf("loudness: integrated %.2f LUFS\n", l->dIntegratedLUFS);
+
+	if (l->dTruePeakDB == -HUGE_VAL)
+		printf("loudness: true peak -inf dBTP, sample peak -inf dBFS\n");
+	else
+		printf("loudness: true peak %.2f dBTP, sample peak %.2f dBFS\n", l->dTruePeakDB, l->dSamplePeakDB);
+
+	printf("loudness: %llu clipped samples\n", (unsigned long long)l->clippedSamples);
+}
+
+// the mixer options that override the FT2.CFG defaults (the render queue passes the user's settings)
+static void applyMixerOpts(const renderOpts_t *opts)
+{
+	if (opts->interpolation != -1)
+	{
+		config.interpolation = (uint8_t)opts->interpolation;
+		audioSetInterpolationType(config.interpolation);
+	}
+
+	if (opts->amp != -1)
+		config.boostLevel = (int16_t)opts->amp;
+
+	if (opts->masterVol != -1)
+		config.masterVol = (int16_t)opts->masterVol;
+
+	if (opts->volumeRamp != -1)
+		audioSetVolRamp(opts->volumeRamp != 0);
+
+	if (opts->oversample)
+		audioSetOversampling(true);
+}
+
+// returns false if the start/end positions are invalid (prints an error)
+static bool getRenderRange(const renderOpts_t *opts, int16_t *startPos, int16_t *endPos)
+{
+	*startPos = (opts->startPos == -1) ? 0 : opts->startPos;
+	*endPos = (opts->endPos == -1) ? song.songLength-1 : opts->endPos;
+
+	if (*startPos >= song.songLength || *endPos >= song.songLength || *endPos < *startPos)
+	{
+		fprintf(stderr, "render: invalid start/end position (the song has %d positions)\n", song.songLength);
+		return false;
+	}
+
+	return true;
+}
+
+static int32_t loudness(const char *modulePath, const renderOpts_t *opts)
+{
+	if (!loadModule(modulePath))
+		return 1;
+
+	applyMixerOpts(opts);
+
+	int16_t startPos, endPos;
+	if (!getRenderRange(opts, &startPos, &endPos))
+		return 1;
+
+	setAudioAmp(config.boostLevel, config.masterVol, true);
+
+	loudness_t l;
+	if (!measureLoudness(startPos, endPos, &l))
+		return 1;
+
+	printLoudness(&l);
+	return 0;
+}
+
+static char *getStemPath(const char *outPath, int32_t ch) // "song.wav" -> "song_ch01.wav", free() result
+{
+	const char *ext = strrchr(outPath, '.');
+	const char *lastSlash = strrchr(outPath, DIR_DELIMITER);
+
+	if (ext == NULL || (lastSlash != NULL && ext < lastSlash))
+		ext = &outPath[strlen(outPath)]; // no extension
+
+	const int32_t baseLen = (int32_t)(ext - outPath);
+
+	char *path = (char *)malloc(baseLen + 8 + strlen(ext) + 1);
+	if (path == NULL)
+		return NULL;
+
+	sprintf(path, "%.*s_ch%02d%s", baseLen, outPath, ch+1, ext);
+	return path;
+}
+
+static void closeRenderFiles(renderFiles_t *out)
+{
+	for (int32_t i = 0; i < out->numFiles; i++)
+	{
+		if (out->encoder[i] != NULL)
+		{
+			closeFlacEncoder(out->encoder[i]);
+			out->encoder[i] = NULL;
+		}
+
+		if (out->f[i] != NULL)
+		{
+			fclose(out->f[i]);
+			out->f[i] = NULL;
+		}
+
+		if (out->path[i] != NULL)
+		{
+			free(out->path[i]);
+			out->path[i] = NULL;
+		}
+	}
+}
+
+static bool openRenderFiles(renderFiles_t *out, const char *outPath, bool stems, uint8_t bitDepth)
+{
+	memset(out, 0, sizeof (renderFiles_t));
+	out->flac = filenameIsFlac(outPath);
+	out->numFiles = stems ? song.numChannels : 1;
+
+	// the writer thread encodes the stems one after another, so they share the CPU cores
+	const int32_t flacThreads = MAX(1, SDL_GetCPUCount() / out->numFiles);
+
+	for (int32_t i = 0; i < out->numFiles; i++)
+	{
+		out->path[i] = stems ? getStemPath(outPath, i) : strdup(outPath);
+		if (out->path[i] == NULL)
+		{
+			fprintf(stderr, "Not enough memory!\n");
+			closeRenderFiles(out);
+			return false;
+		}
+
+		out->f[i] = fopen(out->path[i], "wb");
+		if (out->f[i] == NULL)
+		{
+			fprintf(stderr, "render: couldn't open \"%s\" for writing\n", out->path[i]);
+			closeRenderFiles(out);
+			return false;
+		}
+
+		if (out->flac) // 32-bit float is written as 24-bit FLAC
+		{
+			out->encoder[i] = openFlacEncoder(out->f[i], audio.freq, 2, (bitDepth == 16) ? FLAC_INPUT_16BIT : FLAC_INPUT_FLOAT,
+				flacThreads, NULL, 0);
+
+			if (out->encoder[i] == NULL)
+			{
+				fprintf(stderr, "render: couldn't start the FLAC encoder for \"%s\"\n", out->path[i]);
+				closeRenderFiles(out);
+				return false;
+			}
+		}
+		else
+		{
+			fseek(out->f[i], WAV_HEADER_SIZE, SEEK_SET);
+		}
+	}
+
+	return true;
+}
+
+#ifndef _WIN32
+/* Fast pass over the song without mixing. Splits the render into up to 'numJobs'
+** segments of about the same length, each starting on a new pattern.
+*/
+static int32_t findRenderSegments(int16_t startPos, int16_t endPos, int32_t numJobs, renderSegment_t *segs,
+	uint64_t *totalSamplesOut)
+{
+	uint32_t numPattStarts = 0, pattStartsSize = 256;
+	renderSegment_t *pattStarts = (renderSegment_t *)malloc(pattStartsSize * sizeof (renderSegment_t));
+	if (pattStarts == NULL)
+		return 0;
+
+	const song_t oldSong = song; // playback changes speed/BPM etc., and they aren't reset on a new start
+
+	startHeadlessPlayback(startPos);
+
+	uint32_t numTicks = 0;
+	uint64_t totalSamples = 0;
+
+	while (!renderEnded(endPos, totalSamples, true))
+	{
+		if (song.row == 0 && song.tick == 1 && numTicks > 0) // a new pattern starts on this tick
+		{
+			if (numPattStarts == pattStartsSize)
+			{
+				pattStartsSize *= 2;
+				renderSegment_t *newPattStarts = (renderSegment_t *)realloc(pattStarts, pattStartsSize * sizeof (renderSegment_t));
+				if (newPattStarts == NULL)
+				{
+					free(pattStarts);
+					return 0;
+				}
+
+				pattStarts = newPattStarts;
+			}
+
+			pattStarts[numPattStarts].startTick = numTicks;
+			pattStarts[numPattStarts].startSample = totalSamples;
+			numPattStarts++;
+		}
+
+		totalSamples += skipTick();
+		numTicks++;
+	}
+
+	song = oldSong;
+
+	int32_t numSegs = 1;
+	segs[0].startTick = 0;
+	segs[0].startSample = 0;
+
+	uint32_t j = 0;
+	for (int32_t i = 1; i < numJobs; i++)
+	{
+		const uint64_t target = (totalSamples * i) / numJobs;
+		while (j < numPattStarts && (pattStarts[j].startSample < target || pattStarts[j].startTick <= segs[numSegs-1].startTick))
+			j++;
+
+		if (j == numPattStarts)
+			break;
+
+		segs[numSegs++] = pattStarts[j];
+	}
+
+	for (int32_t i = 0; i < numSegs; i++)
+	{
+		const uint32_t endTick = (i < numSegs-1) ? segs[i+1].startTick : numTicks;
+		segs[i].numTicks = endTick - segs[i].startTick;
+	}
+
+	free(pattStarts);
+
+	*totalSamplesOut = totalSamples;
+	return numSegs;
+}
+
+/* Renders the segments in forked worker processes. The replayer and mixer state lives
+** in globals, so each worker gets its own copy (the state snapshot) by being forked
+** while the main process seeks through the song with skipTick(). The output is the
+** same as for a normal render, down to the dither noise.
+*/
+static bool renderParallel(renderFiles_t *out, const char *outPath, int16_t startPos, int16_t endPos,
+	const renderOpts_t *opts, uint64_t *totalSamples)
+{
+	renderSegment_t segs[MAX_RENDER_JOBS];
+	pid_t pids[MAX_RENDER_JOBS];
+
+	const uint32_t bytesPerSample = (opts->bitDepth == 16) ? sizeof (int16_t) : sizeof (float);
+
+	const int32_t numSegs = findRenderSegments(startPos, endPos, opts->numJobs, segs, totalSamples);
+	if (numSegs == 0)
+	{
+		fprintf(stderr, "Not enough memory!\n");
+		return false;
+	}
+
+	// the workers write directly into the output files, so they have to exist before they start
+	for (int32_t i = 0; i < out->numFiles; i++)
+		fflush(out->f[i]);
+
+	fflush(stdout);
+	fflush(stderr);
+
+	startHeadlessPlayback(startPos);
+
+	bool ok = true;
+	uint32_t tickNum = 0;
+	uint64_t samplesSkipped = 0;
+	int32_t numWorkers = 0;
+
+	for (int32_t i = 0; i < numSegs; i++)
+	{
+		const renderSegment_t *seg = &segs[i];
+
+		for (; tickNum < seg->startTick; tickNum++)
+		{
+			renderEnded(endPos, samplesSkipped, false);
+			samplesSkipped += skipTick();
+		}
+
+		const pid_t pid = fork();
+		if (pid < 0)
+		{
+			fprintf(stderr, "render: couldn't start worker process\n");
+			ok = false;
+			break;
+		}
+
+		if (pid == 0) // worker process
+		{
+			renderFiles_t segOut;
+			uint64_t segSamples = seg->startSample;
+			bool workerOk = true;
+
+			if (opts->bitDepth == 16)
+				skipAudioDither(seg->startSample);
+
+			// the inherited FILEs share file positions with the main process, so open our own
+			memset(&segOut, 0, sizeof (segOut));
+			segOut.numFiles = out->numFiles;
+			for (int32_t j = 0; j < out->numFiles; j++)
+			{
+				segOut.f[j] = fopen(out->path[j], "r+b");
+				if (segOut.f[j] == NULL || fseeko(segOut.f[j], (off_t)(WAV_HEADER_SIZE + (seg->startSample * 2 * bytesPerSample)), SEEK_SET) != 0)
+					workerOk = false;
+			}
+
+			if (workerOk)
+				workerOk = renderTicks(&segOut, outPath, endPos, opts, seg->numTicks, &segSamples);
+
+			for (int32_t j = 0; j < out->numFiles; j++)
+			{
+				if (segOut.f[j] != NULL && fclose(segOut.f[j]) != 0)
+					workerOk = false;
+			}
+
+			fflush(stderr);
+			_exit(workerOk ? 0 : 1);
+		}
+
+		pids[numWorkers++] = pid;
+	}
+
+	// the workers finish in any order, with --progress the finished part of the song is shown
+	uint64_t samplesDone = 0;
+	lastProgress = -1;
+
+	for (int32_t numDone = 0; numDone < numWorkers; numDone++)
+	{
+		int status;
+		const pid_t pid = waitpid(-1, &status, 0);
+		if (pid < 0)
+		{
+			ok = false;
+			break;
+		}
+
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			ok = false;
+
+		for (int32_t i = 0; i < numWorkers; i++) // the worker for segs[i] is pids[i]
+		{
+			if (pids[i] != pid)
+				continue;
+
+			const uint64_t segEnd = (i < numSegs-1) ? segs[i+1].startSample : *totalSamples;
+			samplesDone += segEnd - segs[i].startSample;
+			break;
+		}
+
+		if (opts->progress && ok && *totalSamples > 0)
+			printProgress((int32_t)((samplesDone * 100) / *totalSamples));
+	}
+
+	if (!ok)
+	{
+		fprintf(stderr, "render: a worker process failed while writing \"%s\"\n", outPath);
+		return false;
+	}
+
+	return true;
+}
+#endif
+
+static int32_t render(const char *modulePath, const char *outPath, const renderOpts_t *opts)
+{
+	if (!loadModule(modulePath))
+		return 1;
+
+	applyMixerOpts(opts);
+
+	int16_t startPos, endPos;
+	if (!getRenderRange(opts, &startPos, &endPos))
+		return 1;
+
+	double dGain = 1.0;
+	if (opts->normalize)
+	{
+		// first pass: measure, then render with the gain that hits the target (stems get the gain of the mix)
+		setAudioAmp(config.boostLevel, config.masterVol, true);
+
+		loudness_t l;
+		if (!measureLoudness(startPos, endPos, &l))
+			return 1;
+
+		printLoudness(&l);
+
+		dGain = getLoudnessNormalizeGain(&l, opts->dTargetLUFS, opts->dMaxTruePeakDB);
+		printf("normalize: gain %+.2f dB\n", 20.0 * log10(dGain));
+	}
+
+	setAudioAmp(config.boostLevel, config.masterVol, (opts->bitDepth == 32));
+	scaleAudioAmp(dGain);
+
+	renderFiles_t out;
+	if (!openRenderFiles(&out, outPath, opts->stems, opts->bitDepth))
+		return 1;
+
+	uint64_t totalSamples = 0;
+	bool ok;
+
+	// FLAC frames have no fixed size, so the workers can't write their part in place
+	if (out.flac && opts->numJobs > 1)
+		fprintf(stderr, "render: --jobs isn't used for FLAC output (the encoder is multithreaded instead)\n");
+
+	// seeking doesn't run the decimation filter, so the parts wouldn't join seamlessly
+	if (opts->oversample && opts->numJobs > 1)
+		fprintf(stderr, "render: --jobs isn't used with --oversample\n");
+
+#ifndef _WIN32
+	if (opts->numJobs > 1 && !out.flac && !opts->oversample)
+	{
+		ok = renderParallel(&out, outPath, startPos, endPos, opts, &totalSamples);
+	}
+	else
+#endif
+	{
+		showProgress = opts->progress;
+		progressStartPos = startPos;
+		progressEndPos = endPos;
+		lastProgress = -1;
+
+		startHeadlessPlayback(startPos);
+		ok = renderTicks(&out, outPath, endPos, opts, UINT32_MAX, &totalSamples);
+		showProgress = false;
+	}
+
+	songPlaying = false;
+	playMode = PLAYMODE_IDLE;
+
+	for (int32_t i = 0; ok && i < out.numFiles; i++)
+	{
+		if (out.flac)
+		{
+			if (!closeFlacEncoder(out.encoder[i]))
+				ok = false;
+
+			out.encoder[i] = NULL;
+		}
+		else
+		{
+			writeWavHeader(out.f[i], audio.freq, opts->bitDepth, totalSamples * 2);
+		}
+
+		if (!ok || ferror(out.f[i]))
+		{
+			fprintf(stderr, "render: I/O error while writing \"%s\"\n", out.path[i]);
+			ok = false;
+		}
+	}
+
+	closeRenderFiles(&out);
+
+	if (ok && opts->progress)
+	{
+		printf("progress 100\n");
+		fflush(stdout);
+	}
+
+	return ok ? 0 : 1;
+}
+
+static bool parseIntArg(const char *arg, int32_t minVal, int32_t maxVal, int32_t *out)
+{
+	char *end;
+	const long val = strtol(arg, &end, 10);
+
+	if (end == arg || *end != '\0' || val < minVal || val > maxVal)
+		return false;
+
+	*out = (int32_t)val;
+	return true;
+}
+
+static bool parseDoubleArg(const char *arg, double minVal, double maxVal, double *out)
+{
+	char *end;
+	const double val = strtod(arg, &end);
+
+	if (end == arg || *end != '\0' || !(val >= minVal && val <= maxVal))
+		return false;
+
+	*out = val;
+	return true;
+}
+
+static bool parseRenderOpts(int argc, char **argv, int32_t firstOpt, renderOpts_t *opts)
+{
+	int32_t val;
+
+	opts->stems = false;
+	opts->normalize = false;
+	opts->progress = false;
+	opts->oversample = false;
+	opts->dTargetLUFS = 0.0;
+	opts->dMaxTruePeakDB = NORMALIZE_DEFAULT_TRUE_PEAK;
+	opts->startPos = opts->endPos = -1;
+	opts->interpolation = -1;
+	opts->amp = -1;
+	opts->masterVol = -1;
+	opts->volumeRamp = -1;
+	opts->numJobs = 1;
+	opts->ticksPerChunk = RENDER_TICKS_PER_CHUNK;
+	opts->numBuffers = RENDER_WRITER_DEFAULT_BUFFERS;
+	opts->bitDepth = 16;
+	opts->freq = HEADLESS_AUDIO_FREQ;
+
+	for (int32_t i = firstOpt; i < argc; i++)
+	{
+		const char *opt = argv[i];
+		if (!strcmp(opt, "--stems"))
+		{
+			opts->stems = true;
+			continue;
+		}
+
+		if (!strcmp(opt, "--progress"))
+		{
+			opts->progress = true;
+			continue;
+		}
+
+		if (!strcmp(opt, "--oversample"))
+		{
+			opts->oversample = true;
+			continue;
+		}
+
+		if (i+1 >= argc)
+		{
+			fprintf(stderr, "render: missing value for %s\n", opt);
+			return false;
+		}
+
+		const char *arg = argv[++i];
+
+		if (!strcmp(opt, "--rate"))
+		{
+			if (!parseIntArg(arg, MIN_WAV_RENDER_FREQ, MAX_WAV_RENDER_FREQ, &val))
+			{
+				fprintf(stderr, "render: --rate must be %d..%d\n", MIN_WAV_RENDER_FREQ, MAX_WAV_RENDER_FREQ);
+				return false;
+			}
+
+			opts->freq = val;
+		}
+		else if (!strcmp(opt, "--bits"))
+		{
+			if (!parseIntArg(arg, 16, 32, &val) || (val != 16 && val != 32))
+			{
+				fprintf(stderr, "render: --bits must be 16 or 32 (float)\n");
+				return false;
+			}
+
+			opts->bitDepth = (uint8_t)val;
+		}
+		else if (!strcmp(opt, "--start") || !strcmp(opt, "--end"))
+		{
+			if (!parseIntArg(arg, 0, MAX_ORDERS-1, &val))
+			{
+				fprintf(stderr, "render: %s must be a song position (0..%d)\n", opt, MAX_ORDERS-1);
+				return false;
+			}
+
+			if (opt[2] == 's')
+				opts->startPos = (int16_t)val;
+			else
+				opts->endPos = (int16_t)val;
+		}
+		else if (!strcmp(opt, "--amp"))
+		{
+			if (!parseIntArg(arg, 1, 32, &val))
+			{
+				fprintf(stderr, "render: --amp must be 1..32\n");
+				return false;
+			}
+
+			opts->amp = val;
+		}
+		else if (!strcmp(opt, "--master-vol"))
+		{
+			if (!parseIntArg(arg, 0, 256, &val))
+			{
+				fprintf(stderr, "render: --master-vol must be 0..256\n");
+				return false;
+			}
+
+			opts->masterVol = val;
+		}
+		else if (!strcmp(opt, "--vol-ramp"))
+		{
+			     if (!strcmp(arg, "on")) opts->volumeRamp = 1;
+			else if (!strcmp(arg, "off")) opts->volumeRamp = 0;
+			else
+			{
+				fprintf(stderr, "render: --vol-ramp must be on or off\n");
+				return false;
+			}
+		}
+		else if (!strcmp(opt, "--jobs"))
+		{
+			if (!parseIntArg(arg, 1, MAX_RENDER_JOBS, &val))
+			{
+				fprintf(stderr, "render: --jobs must be 1..%d\n", MAX_RENDER_JOBS);
+				return false;
+			}
+
+			opts->numJobs = val;
+#ifdef _WIN32
+			if (opts->numJobs > 1)
+				fprintf(stderr, "render: --jobs isn't supported on Windows, rendering in one process\n");
+#endif
+		}
+		else if (!strcmp(opt, "--chunk"))
+		{
+			if (!parseIntArg(arg, 1, MAX_RENDER_TICKS_PER_CHUNK, &val))
+			{
+				fprintf(stderr, "render: --chunk must be 1..%d (ticks)\n", MAX_RENDER_TICKS_PER_CHUNK);
+				return false;
+			}
+
+			opts->ticksPerChunk = val;
+		}
+		else if (!strcmp(opt, "--buffers"))
+		{
+			if (!parseIntArg(arg, RENDER_WRITER_MIN_BUFFERS, RENDER_WRITER_MAX_BUFFERS, &val))
+			{
+				fprintf(stderr, "render: --buffers must be %d..%d\n", RENDER_WRITER_MIN_BUFFERS, RENDER_WRITER_MAX_BUFFERS);
+				return false;
+			}
+
+			opts->numBuffers = val;
+		}
+		else if (!strcmp(opt, "--normalize"))
+		{
+			if (!parseDoubleArg(arg, NORMALIZE_MIN_LUFS, 0.0, &opts->dTargetLUFS))
+			{
+				fprintf(stderr, "render: --normalize must be %d..0 (LUFS)\n", (int32_t)NORMALIZE_MIN_LUFS);
+				return false;
+			}
+
+			opts->normalize = true;
+		}
+		else if (!strcmp(opt, "--true-peak"))
+		{
+			if (!parseDoubleArg(arg, NORMALIZE_MIN_TRUE_PEAK, 0.0, &opts->dMaxTruePeakDB))
+			{
+				fprintf(stderr, "render: --true-peak must be %d..0 (dBTP)\n", (int32_t)NORMALIZE_MIN_TRUE_PEAK);
+				return false;
+			}
+		}
+		else if (!strcmp(opt, "--interp"))
+		{
+			     if (!strcmp(arg, "none")) opts->interpolation = INTERPOLATION_DISABLED;
+			else if (!strcmp(arg, "linear")) opts->interpolation = INTERPOLATION_LINEAR;
+			else if (!strcmp(arg, "sinc8")) opts->interpolation = INTERPOLATION_SINC8;
+			else if (!strcmp(arg, "sinc16")) opts->interpolation = INTERPOLATION_SINC16;
+			else
+			{
+				fprintf(stderr, "render: --interp must be none, linear, sinc8 or sinc16\n");
+				return false;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "render: unknown option \"%s\"\n", opt);
+			return false;
+		}
+	}
+
+	if (opts->stems && opts->oversample)
+	{
+		fprintf(stderr, "render: --oversample can't be used with --stems\n");
+		return false;
+	}
+
+	return true;
+}
+
+bool isHeadlessCommand(int argc, char **argv)
+{
+	return argc >= 2 && getCommand(argv[1]) != CMD_NONE;
+}
+
+int32_t runHeadlessCommand(int argc, char **argv)
+{
+	renderOpts_t renderOpts;
+
+	const int32_t cmd = getCommand(argv[1]);
+
+	if (cmd == CMD_RENDER)
+	{
+		if (argc < 4)
+		{
+			fprintf(stderr, "usage: %s --render <module> <out.wav> [--rate hz] [--bits 16|32] [--start pos] [--end pos]\n"
+			                "       [--interp none|linear|sinc8|sinc16] [--jobs n] [--chunk ticks] [--buffers n] [--stems]\n"
+			                "       [--normalize lufs] [--true-peak dbtp] [--amp n] [--master-vol n] [--vol-ramp on|off]\n"
+			                "       [--oversample] [--progress]\n", argv[0]);
+			return 1;
+		}
+
+		if (!parseRenderOpts(argc, argv, 4, &renderOpts))
+			return 1;
+	}
+	else // CMD_LOUDNESS
+	{
+		if (argc < 3)
+		{
+			fprintf(stderr, "usage: %s --loudness <module> [--rate hz] [--start pos] [--end pos]\n"
+			                "       [--interp none|linear|sinc8|sinc16] [--amp n] [--master-vol n] [--vol-ramp on|off] [--oversample]\n", argv[0]);
+			return 1;
+		}
+
+		if (!parseRenderOpts(argc, argv, 3, &renderOpts))
+			return 1;
+	}
+
+	if (!setupHeadless(renderOpts.freq))
+	{
+		fprintf(stderr, "Not enough memory!\n");
+		closeHeadless();
+		return 1;
+	}
+
+	int32_t exitCode;
+	if (cmd == CMD_RENDER)
+		exitCode = render(argv[2], argv[3], &renderOpts);
+	else
+		exitCode = loudness(argv[2], &renderOpts);
+
+	closeHeadless();
+	return exitCode;
+}
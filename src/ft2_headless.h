@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Command-line modes that run without a window or an audio device. These are
+** handled in main() before SDL video/audio is initialized. (The replayer regression
+** test is libft2/tools/libft2_tickhash.c, it doesn't need the tracker.)
+**
+** --render <module> <out.wav> [--rate hz] [--bits 16|32] [--start pos] [--end pos]
+**          [--interp none|linear|sinc8|sinc16] [--jobs n] [--chunk ticks] [--buffers n] [--stems]
+**          [--normalize lufs] [--true-peak dbtp] [--amp n] [--master-vol n] [--vol-ramp on|off]
+**          [--oversample] [--progress]
+**   Renders the song (or a range of song positions) to a WAV file, like the WAV
+**   renderer screen does. Defaults are 48kHz, 16-bit and the FT2.CFG interpolation.
+**   Files over 2GB are written as RF64. If the output filename ends in ".flac", the
+**   song is written as FLAC instead (24-bit for --bits 32).
+**   With --jobs, the song is split on pattern starts and the parts are rendered in
+**   n worker processes (not on Windows, not for FLAC). The output is identical to a
+**   normal render.
+**   Audio is written in chunks of --chunk ticks (default 64) by a writer thread that
+**   has --buffers chunk buffers (default 3) to work with.
+**   With --stems, every channel is written to its own file ("out_ch01.wav" etc.),
+**   from a single replayer pass.
+**   With --normalize, the song is first measured (see --loudness) and then rendered
+**   with the gain that gives the target integrated loudness, lowered if needed to keep
+**   the true peak at or below --true-peak (default -1.0 dBTP). Stems get the gain of
+**   the whole mix.
+**   --amp sets the amplification (1..32, like on the WAV renderer screen) instead of
+**   the FT2.CFG default, --master-vol (0..256) and --vol-ramp override the FT2.CFG
+**   master volume and volume ramping the same way. With --progress, "progress <percent>" lines are printed to
+**   stdout while rendering (used by the render queue, see ft2_render_queue.h). With --jobs, they're
+**   printed as the parts of the song finish.
+**   With --oversample, the voices are mixed at twice the rate and decimated with a
+**   half-band filter (see audioSetOversampling()). This roughly doubles the mixing
+**   time and only helps the notes played faster than the output rate. --interp sinc8
+**   or sinc16 without it is much cleaner and about as cheap.
+**   Not for --stems, and --jobs isn't used.
+**
+** --loudness <module> [--rate hz] [--start pos] [--end pos] [--interp none|linear|sinc8|sinc16]
+**            [--amp n] [--master-vol n] [--vol-ramp on|off] [--oversample]
+**   Measures the song as --render would mix it: integrated loudness (ITU-R BS.1770),
+**   true peak, sample peak and the number of clipped samples. Nothing is written.
+*/
+
+bool isHeadlessCommand(int argc, char **argv);
+int32_t runHeadlessCommand(int argc, char **argv); // returns process exit code
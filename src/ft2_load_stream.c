@@ -0,0 +1,149 @@
+// for finding memory leaks in debug mode with Visual Studio
+#if defined _DEBUG && defined _MSC_VER
+#include <crtdbg.h>
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "ft2_load_stream.h"
+
+void lfopenFile(LFILE *f, FILE *file)
+{
+	memset(f, 0, sizeof (LFILE));
+	f->f = file;
+}
+
+void lfopenMemory(LFILE *f, const void *data, size_t size)
+{
+	memset(f, 0, sizeof (LFILE));
+	f->data = (const uint8_t *)data;
+	f->size = size;
+}
+
+void lfopenCallbacks(LFILE *f, size_t (*read)(void *, void *, size_t), int64_t (*seek)(void *, int64_t, int), void *user)
+{
+	memset(f, 0, sizeof (LFILE));
+	f->read = read;
+	f->seek = seek;
+	f->user = user;
+}
+
+size_t lfread(void *buffer, size_t size, size_t count, LFILE *f)
+{
+	if (f->f != NULL)
+		return fread(buffer, size, count, f->f);
+
+	if (size == 0 || count == 0)
+		return 0;
+
+	const size_t bytesWanted = size * count;
+	size_t bytesRead = 0;
+
+	if (f->read != NULL)
+	{
+		// callbacks may return less than asked for before the end
+		while (!f->pastEnd && bytesRead < bytesWanted)
+		{
+			const size_t n = f->read(f->user, (uint8_t *)buffer + bytesRead, bytesWanted - bytesRead);
+			if (n == 0 || n > bytesWanted-bytesRead)
+				break;
+
+			bytesRead += n;
+		}
+	}
+	else if ((uint64_t)f->pos < f->size)
+	{
+		bytesRead = f->size - (size_t)f->pos;
+		if (bytesRead > bytesWanted)
+			bytesRead = bytesWanted;
+
+		memcpy(buffer, &f->data[f->pos], bytesRead);
+	}
+
+	f->pos += bytesRead;
+	if (bytesRead < bytesWanted)
+		f->eof = true;
+
+	return bytesRead / size;
+}
+
+int lfseek(LFILE *f, int64_t offset, int whence)
+{
+	if (f->f != NULL)
+		return fseek(f->f, (long)offset, whence);
+
+	int64_t newPos;
+	if (whence == SEEK_SET)
+		newPos = offset;
+	else if (whence == SEEK_CUR)
+		newPos = f->pos + offset;
+	else if (whence == SEEK_END)
+		newPos = (int64_t)f->size + offset;
+	else
+		return -1;
+
+	if (newPos < 0 && whence != SEEK_END)
+		return -1;
+
+	f->pastEnd = false;
+	if (f->read != NULL)
+	{
+		// the callbacks know where the end is, and always get absolute positions otherwise
+		if (whence == SEEK_END)
+		{
+			newPos = f->seek(f->user, offset, SEEK_END);
+			if (newPos < 0)
+				return -1;
+		}
+		else if (f->seek(f->user, newPos, SEEK_SET) < 0)
+		{
+			f->pastEnd = true; // most streams can't seek past the end, files can (and reading there gives nothing)
+		}
+	}
+	else if (newPos < 0)
+	{
+		return -1;
+	}
+
+	f->pos = newPos;
+	f->eof = false;
+	return 0;
+}
+
+int64_t lftell(LFILE *f)
+{
+	if (f->f != NULL)
+		return ftell(f->f);
+
+	return f->pos;
+}
+
+void lfrewind(LFILE *f)
+{
+	if (f->f != NULL)
+		rewind(f->f);
+	else
+		lfseek(f, 0, SEEK_SET);
+}
+
+int lfgetc(LFILE *f)
+{
+	if (f->f != NULL)
+		return fgetc(f->f);
+
+	uint8_t byte;
+	if (lfread(&byte, 1, 1, f) != 1)
+		return EOF;
+
+	return byte;
+}
+
+bool lfeof(LFILE *f)
+{
+	if (f->f != NULL)
+		return feof(f->f) != 0;
+
+	return f->eof;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Input for the module loaders. The same loaders read from a file (the tracker, libft2's
+** file loads), straight from a memory buffer, or through read/seek callbacks (libft2's memory
+** and callback loads). The functions work like their stdio namesakes (fread() -> lfread() etc.):
+** seeking past the end is allowed, and reading there returns 0 and sets the EOF flag.
+*/
+
+typedef struct LFILE
+{
+	FILE *f; // file input (or NULL)
+
+	const uint8_t *data; // memory input (data != NULL)
+	size_t size;
+
+	size_t (*read)(void *user, void *buffer, size_t size); // callback input (read != NULL)
+	int64_t (*seek)(void *user, int64_t offset, int whence);
+	void *user;
+
+	int64_t pos; // memory and callback input
+	bool eof, pastEnd;
+} LFILE;
+
+void lfopenFile(LFILE *f, FILE *file); // the caller still owns (and closes) the FILE
+void lfopenMemory(LFILE *f, const void *data, size_t size); // data must stay valid while loading
+void lfopenCallbacks(LFILE *f, size_t (*read)(void *, void *, size_t), int64_t (*seek)(void *, int64_t, int), void *user);
+
+size_t lfread(void *buffer, size_t size, size_t count, LFILE *f);
+int lfseek(LFILE *f, int64_t offset, int whence);
+int64_t lftell(LFILE *f);
+void lfrewind(LFILE *f);
+int lfgetc(LFILE *f);
+bool lfeof(LFILE *f);
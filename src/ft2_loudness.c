@@ -0,0 +1,286 @@
+// for finding memory leaks in debug mode with Visual Studio
+#if defined _DEBUG && defined _MSC_VER
+#include <crtdbg.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ft2_header.h"
+#include "ft2_loudness.h"
+
+#define SUB_BLOCKS_PER_BLOCK 4 // 400ms gating blocks with 75% overlap, in 100ms steps
+#define RELATIVE_GATE_LU 10.0
+#define MY_PI 3.14159265358979323846264338327950288
+#define TP_PHASES 4 // true peak oversampling
+#define TP_TAPS 12 // taps per phase
+#define TP_CENTER ((TP_PHASES * TP_TAPS) / 2)
+
+struct loudnessMeter_t
+{
+	// K-weighting filter (high shelf + high-pass), state is x1, x2, y1, y2 per channel
+	double dShelfB[3], dShelfA[3], dHighpassB[3], dHighpassA[3];
+	double dShelfState[2][4], dHighpassState[2][4];
+
+	uint32_t subBlockLen, subBlockPos, numSubBlocks;
+	double dSubBlockSum, dSubBlocks[SUB_BLOCKS_PER_BLOCK];
+
+	double *dBlocks; // mean square of each gating block
+	uint32_t numBlocks, maxBlocks;
+
+	// true peak, the history is stored twice so that the newest TP_TAPS samples are always in one piece
+	float fTpCoeffs[TP_PHASES][TP_TAPS], fTpHistory[2][TP_TAPS*2];
+	int32_t tpPos;
+
+	double dTruePeak, dSamplePeak;
+	uint64_t clippedSamples;
+};
+
+static double blockLoudness(double dMeanSquare)
+{
+	return -0.691 + (10.0 * log10(dMeanSquare));
+}
+
+/* K-weighting for any sample rate, from the analog prototypes of the BS.1770 filters
+** (the coefficients in the standard are for 48kHz only).
+*/
+static void calcKWeightingFilter(loudnessMeter_t *m, uint32_t sampleRate)
+{
+	// stage 1: high shelf, +4dB above ~1.5kHz (head model)
+	double dK = tan(MY_PI * 1681.974450955533 / sampleRate);
+	const double dQ1 = 0.7071752369554196;
+	const double dVh = pow(10.0, 3.999843853973347 / 20.0);
+	const double dVb = pow(dVh, 0.4996667741545416);
+
+	double dA0 = 1.0 + (dK / dQ1) + (dK * dK);
+	m->dShelfB[0] = (dVh + (dVb * dK / dQ1) + (dK * dK)) / dA0;
+	m->dShelfB[1] = (2.0 * ((dK * dK) - dVh)) / dA0;
+	m->dShelfB[2] = (dVh - (dVb * dK / dQ1) + (dK * dK)) / dA0;
+	m->dShelfA[0] = 1.0;
+	m->dShelfA[1] = (2.0 * ((dK * dK) - 1.0)) / dA0;
+	m->dShelfA[2] = (1.0 - (dK / dQ1) + (dK * dK)) / dA0;
+
+	// stage 2: high-pass at ~38Hz (RLB weighting)
+	dK = tan(MY_PI * 38.13547087602444 / sampleRate);
+	const double dQ2 = 0.5003270373238773;
+
+	dA0 = 1.0 + (dK / dQ2) + (dK * dK);
+	m->dHighpassB[0] = 1.0;
+	m->dHighpassB[1] = -2.0;
+	m->dHighpassB[2] = 1.0;
+	m->dHighpassA[0] = 1.0;
+	m->dHighpassA[1] = (2.0 * ((dK * dK) - 1.0)) / dA0;
+	m->dHighpassA[2] = (1.0 - (dK / dQ2) + (dK * dK)) / dA0;
+}
+
+/* 4x oversampling filter for the true peak (a windowed sinc, like the example filter
+** in BS.1770 annex 2). Phase 0 is the input sample itself, so only phases 1..3 are
+** calculated, and the sample peak covers phase 0.
+*/
+static void calcTruePeakFilter(loudnessMeter_t *m)
+{
+	for (int32_t p = 0; p < TP_PHASES; p++)
+	{
+		double dSum = 0.0;
+		double dCoeffs[TP_TAPS];
+
+		for (int32_t j = 0; j < TP_TAPS; j++)
+		{
+			const double x = ((j * TP_PHASES) + p - TP_CENTER) / (double)TP_PHASES;
+			const double w = (x / (TP_TAPS / 2.0 + 0.5)) * MY_PI; // Blackman window
+
+			double dSinc = 1.0;
+			if (x != 0.0)
+				dSinc = sin(MY_PI * x) / (MY_PI * x);
+
+			dCoeffs[j] = dSinc * (0.42 + (0.5 * cos(w)) + (0.08 * cos(2.0 * w)));
+			dSum += dCoeffs[j];
+		}
+
+		for (int32_t j = 0; j < TP_TAPS; j++)
+			m->fTpCoeffs[p][j] = (float)(dCoeffs[j] / dSum); // unity gain at DC
+	}
+}
+
+loudnessMeter_t *createLoudnessMeter(uint32_t sampleRate)
+{
+	if (sampleRate == 0)
+		return NULL;
+
+	loudnessMeter_t *m = (loudnessMeter_t *)calloc(1, sizeof (loudnessMeter_t));
+	if (m == NULL)
+		return NULL;
+
+	calcKWeightingFilter(m, sampleRate);
+	calcTruePeakFilter(m);
+
+	m->subBlockLen = (sampleRate + 5) / 10; // 100ms
+	return m;
+}
+
+void freeLoudnessMeter(loudnessMeter_t *m)
+{
+	if (m == NULL)
+		return;
+
+	if (m->dBlocks != NULL)
+		free(m->dBlocks);
+
+	free(m);
+}
+
+static inline double biquad(double dIn, const double *dB, const double *dA, double *dState)
+{
+	const double dOut = (dB[0] * dIn) + (dB[1] * dState[0]) + (dB[2] * dState[1]) - (dA[1] * dState[2]) - (dA[2] * dState[3]);
+
+	dState[1] = dState[0];
+	dState[0] = dIn;
+	dState[3] = dState[2];
+	dState[2] = dOut;
+
+	return dOut;
+}
+
+static bool addSubBlock(loudnessMeter_t *m)
+{
+	memmove(&m->dSubBlocks[0], &m->dSubBlocks[1], (SUB_BLOCKS_PER_BLOCK-1) * sizeof (double));
+	m->dSubBlocks[SUB_BLOCKS_PER_BLOCK-1] = m->dSubBlockSum;
+	m->dSubBlockSum = 0.0;
+	m->subBlockPos = 0;
+
+	if (++m->numSubBlocks < SUB_BLOCKS_PER_BLOCK)
+		return true; // not a whole gating block yet
+
+	if (m->numBlocks >= m->maxBlocks)
+	{
+		const uint32_t newMaxBlocks = (m->maxBlocks == 0) ? 4096 : m->maxBlocks * 2;
+
+		double *dNewBlocks = (double *)realloc(m->dBlocks, newMaxBlocks * sizeof (double));
+		if (dNewBlocks == NULL)
+			return false;
+
+		m->dBlocks = dNewBlocks;
+		m->maxBlocks = newMaxBlocks;
+	}
+
+	double dSum = 0.0;
+	for (int32_t i = 0; i < SUB_BLOCKS_PER_BLOCK; i++)
+		dSum += m->dSubBlocks[i];
+
+	m->dBlocks[m->numBlocks++] = dSum / ((double)m->subBlockLen * SUB_BLOCKS_PER_BLOCK);
+	return true;
+}
+
+bool addLoudnessSamples(loudnessMeter_t *m, const float *data, uint32_t numSamples)
+{
+	for (uint32_t i = 0; i < numSamples; i++)
+	{
+		const int32_t hPos = m->tpPos;
+		m->tpPos = (m->tpPos + 1) % TP_TAPS;
+
+		for (int32_t ch = 0; ch < 2; ch++)
+		{
+			const float fSample = *data++;
+
+			// sample peak and clipping
+			const double dAbs = fabs(fSample);
+			if (dAbs > m->dSamplePeak)
+				m->dSamplePeak = dAbs;
+
+			if (dAbs > 1.0)
+				m->clippedSamples++;
+
+			// true peak
+			float *fHistory = m->fTpHistory[ch];
+			fHistory[hPos] = fHistory[hPos+TP_TAPS] = fSample;
+
+			const float *fWindow = &fHistory[hPos+1]; // oldest to newest
+			for (int32_t p = 1; p < TP_PHASES; p++)
+			{
+				const float *fCoeffs = m->fTpCoeffs[p];
+
+				float fOut = 0.0f;
+				for (int32_t j = 0; j < TP_TAPS; j++)
+					fOut += fWindow[TP_TAPS-1-j] * fCoeffs[j];
+
+				const double dTpAbs = fabs(fOut);
+				if (dTpAbs > m->dTruePeak)
+					m->dTruePeak = dTpAbs;
+			}
+
+			// K-weighted energy
+			double dOut = biquad(fSample, m->dShelfB, m->dShelfA, m->dShelfState[ch]);
+			dOut = biquad(dOut, m->dHighpassB, m->dHighpassA, m->dHighpassState[ch]);
+			m->dSubBlockSum += dOut * dOut;
+		}
+
+		if (++m->subBlockPos >= m->subBlockLen)
+		{
+			if (!addSubBlock(m))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void getLoudness(loudnessMeter_t *m, loudness_t *l)
+{
+	const double dAbsGateMeanSquare = pow(10.0, (LOUDNESS_MIN_LUFS + 0.691) / 10.0);
+
+	// absolute gate
+	double dSum = 0.0;
+	uint32_t numGated = 0;
+
+	for (uint32_t i = 0; i < m->numBlocks; i++)
+	{
+		if (m->dBlocks[i] > dAbsGateMeanSquare)
+		{
+			dSum += m->dBlocks[i];
+			numGated++;
+		}
+	}
+
+	l->dIntegratedLUFS = -HUGE_VAL;
+	if (numGated > 0)
+	{
+		// relative gate, 10 LU below the absolute-gated loudness
+		const double dRelGateMeanSquare = (dSum / numGated) * pow(10.0, -RELATIVE_GATE_LU / 10.0);
+		const double dGateMeanSquare = MAX(dAbsGateMeanSquare, dRelGateMeanSquare);
+
+		dSum = 0.0;
+		numGated = 0;
+
+		for (uint32_t i = 0; i < m->numBlocks; i++)
+		{
+			if (m->dBlocks[i] > dGateMeanSquare)
+			{
+				dSum += m->dBlocks[i];
+				numGated++;
+			}
+		}
+
+		if (numGated > 0)
+			l->dIntegratedLUFS = blockLoudness(dSum / numGated);
+	}
+
+	const double dTruePeak = MAX(m->dTruePeak, m->dSamplePeak);
+
+	l->dTruePeakDB = (dTruePeak > 0.0) ? 20.0 * log10(dTruePeak) : -HUGE_VAL;
+	l->dSamplePeakDB = (m->dSamplePeak > 0.0) ? 20.0 * log10(m->dSamplePeak) : -HUGE_VAL;
+	l->clippedSamples = m->clippedSamples;
+}
+
+double getLoudnessNormalizeGain(const loudness_t *l, double dTargetLUFS, double dMaxTruePeakDB)
+{
+	if (l->dIntegratedLUFS == -HUGE_VAL)
+		return 1.0; // nothing to normalize
+
+	double dGainDB = dTargetLUFS - l->dIntegratedLUFS;
+	if (l->dTruePeakDB + dGainDB > dMaxTruePeakDB)
+		dGainDB = dMaxTruePeakDB - l->dTruePeakDB;
+
+	return pow(10.0, dGainDB / 20.0);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Loudness meter for rendered songs: integrated loudness (ITU-R BS.1770-4, K-weighted
+** and gated, in LUFS), true peak (4x oversampled, in dBTP), sample peak and the number
+** of clipped samples. Feed it the whole song (interleaved stereo float), then read
+** the result.
+**
+** Loudness and peaks scale with the gain, so one measuring pass is enough to find
+** the exact gain for a target loudness (see getLoudnessNormalizeGain()).
+*/
+
+#define LOUDNESS_MIN_LUFS (-70.0) // absolute gate
+
+typedef struct loudness_t
+{
+	double dIntegratedLUFS; // -HUGE_VAL if the audio was silent or shorter than 400ms
+	double dTruePeakDB, dSamplePeakDB; // dBTP and dBFS, -HUGE_VAL if silent
+	uint64_t clippedSamples; // samples above full scale (counted per channel)
+} loudness_t;
+
+typedef struct loudnessMeter_t loudnessMeter_t;
+
+loudnessMeter_t *createLoudnessMeter(uint32_t sampleRate); // NULL if out of memory
+void freeLoudnessMeter(loudnessMeter_t *m);
+bool addLoudnessSamples(loudnessMeter_t *m, const float *data, uint32_t numSamples); // stereo samples, false if out of memory
+void getLoudness(loudnessMeter_t *m, loudness_t *l);
+
+// linear gain that gives 'dTargetLUFS', but lowered if the true peak would go above 'dMaxTruePeakDB'
+double getLoudnessNormalizeGain(const loudness_t *l, double dTargetLUFS, double dMaxTruePeakDB);
@@ -34,6 +34,8 @@
 #include "ft2_bmp.h"
 #include "ft2_structs.h"
 #include "ft2_hpc.h"
+#include "ft2_headless.h"
+#include "ft2_render_queue.h"
 
 #ifdef HAS_MIDI
 static SDL_Thread *initMidiThread;
@@ -71,6 +73,10 @@ int main(int argc, char *argv[])
 	initializeVars();
 	setupCrashHandler();
 
+	// command-line modes (no window or audio device needed)
+	if (isHeadlessCommand(argc, argv))
+		return runHeadlessCommand(argc, argv);
+
 	// on Windows and macOS, test what version SDL2.DLL is (against library version used in compilation)
 #if defined _WIN32 || defined __APPLE__
 	SDL_GetVersion(&sdlVer);
@@ -280,7 +286,7 @@ static void initializeVars(void)
 	memset(&song, 0, sizeof (song));
 
 	// used for scopes and sampling position line (sampler screen)
-	for (int32_t i = 0; i < MAX_CHANNELS; i++)
+	for (int32_t i = 0; i < MAX_XM_CHANNELS; i++)
 	{
 		lastChInstr[i].instrNum = 255;
 		lastChInstr[i].smpNum = 255;
@@ -337,6 +343,7 @@ static void cleanUpAndExit(void) // never call this inside the main loop!
 	}
 #endif
 
+	closeRenderQueue();
 	closeAudio();
 	closeReplayer();
 	closeVideo();
@@ -222,14 +222,14 @@ void recordMIDIEffect(uint8_t efx, uint8_t efxData)
 
 	if (config.multiRec)
 	{
-		note_t *p = &pattern[editor.editPattern][editor.row * MAX_CHANNELS];
+		if (!allocatePattern(editor.editPattern))
+			return;
+
+		note_t *p = &pattern[editor.editPattern][editor.row * song.numChannels];
 		for (int32_t i = 0; i < song.numChannels; i++, p++)
 		{
 			if (config.multiRecChn[i] && editor.chnMode[i])
 			{
-				if (!allocatePattern(editor.editPattern))
-					return;
-
 				if (p->efx == 0)
 				{
 					p->efx = efx;
@@ -244,7 +244,7 @@ void recordMIDIEffect(uint8_t efx, uint8_t efxData)
 		if (!allocatePattern(editor.editPattern))
 			return;
 
-		note_t *p = &pattern[editor.editPattern][(editor.row * MAX_CHANNELS) + cursor.ch];
+		note_t *p = &pattern[editor.editPattern][(editor.row * song.numChannels) + cursor.ch];
 		if (p->efx != efx || p->efxData != efxData)
 			setSongModifiedFlag();
 
@@ -10,6 +10,7 @@
 #include <unistd.h>
 #endif
 #include "ft2_header.h"
+#include "ft2_load_stream.h"
 #include "scopes/ft2_scopes.h"
 #include "ft2_trim.h"
 #include "ft2_inst_ed.h"
@@ -25,13 +26,14 @@
 #include "ft2_video.h"
 #include "ft2_structs.h"
 #include "ft2_sysreqs.h"
+#include "ft2_render_queue.h"
 
-bool loadDIGI(FILE *f, uint32_t filesize);
-bool loadMOD(FILE *f, uint32_t filesize);
-bool loadS3M(FILE *f, uint32_t filesize);
-bool loadSTK(FILE *f, uint32_t filesize);
-bool loadSTM(FILE *f, uint32_t filesize);
-bool loadXM(FILE *f, uint32_t filesize);
+bool loadDIGI(LFILE *f, uint32_t filesize);
+bool loadMOD(LFILE *f, uint32_t filesize);
+bool loadS3M(LFILE *f, uint32_t filesize);
+bool loadSTK(LFILE *f, uint32_t filesize);
+bool loadSTM(LFILE *f, uint32_t filesize);
+bool loadXM(LFILE *f, uint32_t filesize);
 
 enum
 {
@@ -60,29 +62,31 @@ int16_t patternNumRowsTmp[MAX_PATTERNS];
 note_t *patternTmp[MAX_PATTERNS];
 instr_t *instrTmp[1+256];
 song_t songTmp;
+uint8_t tmpLoaderFlags; // the tracker always loads everything
 // --------------------------
 
 static volatile bool musicIsLoading, moduleLoaded, moduleFailedToLoad;
 static SDL_Thread *thread;
 static uint8_t oldPlayMode;
+static void setupLoadedModuleData(void);
 static void setupLoadedModule(void);
 static void freeTmpModule(void);
 
 // Crude module detection routine. These aren't always accurate detections!
-static int8_t detectModule(FILE *f)
+static int8_t detectModule(LFILE *f)
 {
 	uint8_t D[256], I[4];
 
-	fseek(f, 0, SEEK_END);
-	uint32_t fileLength = (uint32_t)ftell(f);
-	rewind(f);
+	lfseek(f, 0, SEEK_END);
+	uint32_t fileLength = (uint32_t)lftell(f);
+	lfrewind(f);
 
 	memset(D, 0, sizeof (D));
-	fread(D, 1, sizeof (D), f);
-	fseek(f, 1080, SEEK_SET); // MOD ID
+	lfread(D, 1, sizeof (D), f);
+	lfseek(f, 1080, SEEK_SET); // MOD ID
 	I[0] = I[1] = I[2] = I[3] = 0;
-	fread(I, 1, 4, f);
-	rewind(f);
+	lfread(I, 1, 4, f);
+	lfrewind(f);
 
 	// DIGI Booster (non-Pro)
 	if (!memcmp("DIGI Booster module", &D[0x00], 19+1) && D[0x19] >= 1 && D[0x19] <= 8)
@@ -150,10 +154,10 @@ static int8_t detectModule(FILE *f)
 		return FORMAT_UNKNOWN;
 
 	// test STK numOrders+BPM for illegal values
-	fseek(f, 470, SEEK_SET);
+	lfseek(f, 470, SEEK_SET);
 	D[0] = D[1] = 0;
-	fread(D, 1, 2, f);
-	rewind(f);
+	lfread(D, 1, 2, f);
+	lfrewind(f);
 
 	if (D[0] <= 128 && D[1] <= 220)
 		return FORMAT_POSSIBLY_STK;
@@ -161,30 +165,29 @@ static int8_t detectModule(FILE *f)
 	return FORMAT_UNKNOWN;
 }
 
-static bool doLoadMusic(bool externalThreadFlag)
+static bool loadTmpModule(UNICHAR *filenameU, int32_t maxChannels)
 {
-	// setup message box functions
-	loaderMsgBox = externalThreadFlag ? myLoaderMsgBoxThreadSafe : myLoaderMsgBox;
-	loaderSysReq = externalThreadFlag ? okBoxThreadSafe : okBox;
-
-	if (editor.tmpFilenameU == NULL)
+	if (filenameU == NULL)
 	{
 		loaderMsgBox("Generic memory fault during loading!");
 		goto loadError;
 	}
 
-	FILE *f = UNICHAR_FOPEN(editor.tmpFilenameU, "rb");
-	if (f == NULL)
+	FILE *file = UNICHAR_FOPEN(filenameU, "rb");
+	if (file == NULL)
 	{
 		loaderMsgBox("General I/O error during loading! Is the file in use? Does it exist?");
 		goto loadError;
 	}
 
+	LFILE stream, *f = &stream;
+	lfopenFile(f, file);
+
 	int8_t format = detectModule(f);
-	fseek(f, 0, SEEK_END);
-	uint32_t filesize = ftell(f);
+	lfseek(f, 0, SEEK_END);
+	uint32_t filesize = (uint32_t)lftell(f);
 
-	rewind(f);
+	lfrewind(f);
 	switch (format)
 	{
 		case FORMAT_XM: moduleLoaded = loadXM(f, filesize); break;
@@ -198,11 +201,33 @@ static bool doLoadMusic(bool externalThreadFlag)
 			loaderMsgBox("This file is not a supported module!");
 		break;
 	}
-	fclose(f);
+	fclose(file);
 
 	if (!moduleLoaded)
 		goto loadError;
 
+	/* The tracker (its pattern editor and scopes) is limited to FT2's channel count, and it also
+	** needs an even number of channels. The command-line modes take the replayer's full count.
+	*/
+	int32_t numChannels = songTmp.numChannels;
+	if (numChannels & 1)
+		numChannels++;
+
+	if (numChannels > maxChannels)
+	{
+		loaderMsgBox("Warning: This module has %d channels. Only the first %d will be loaded and played, the rest is cut off!",
+			songTmp.numChannels, maxChannels);
+		numChannels = maxChannels;
+	}
+
+	numChannels = CLAMP(numChannels, 2, maxChannels);
+	if (!resizePatternChannels(patternTmp, songTmp.numChannels, numChannels))
+	{
+		loaderMsgBox("Not enough memory!");
+		goto loadError;
+	}
+	songTmp.numChannels = numChannels;
+
 	moduleLoaded = true;
 	return true;
 
@@ -212,6 +237,15 @@ loadError:
 	return false;
 }
 
+static bool doLoadMusic(bool externalThreadFlag)
+{
+	// setup message box functions
+	loaderMsgBox = externalThreadFlag ? myLoaderMsgBoxThreadSafe : myLoaderMsgBox;
+	loaderSysReq = externalThreadFlag ? okBoxThreadSafe : okBox;
+
+	return loadTmpModule(editor.tmpFilenameU, MAX_XM_CHANNELS);
+}
+
 static void clearTmpModule(void)
 {
 	memset(patternTmp, 0, sizeof (patternTmp));
@@ -277,9 +311,40 @@ bool loadMusicUnthreaded(UNICHAR *filenameU, bool autoPlay)
 	return false;
 }
 
+/* For the command-line modes (no window, no GUI updates). The caller must set
+** loaderMsgBox/loaderSysReq first. The replayer's full channel count is allowed here.
+*/
+bool loadMusicHeadless(UNICHAR *filenameU)
+{
+	if (filenameU == NULL)
+		return false;
+
+	clearTmpModule(); // clear stuff from last loading session (very important)
+
+	moduleLoaded = false;
+	moduleFailedToLoad = false;
+
+	if (!loadTmpModule(filenameU, MAX_CHANNELS))
+		return false;
+
+	// the tracker's modules always fit in the built-in channel storage, these may not
+	if (!allocateChannels(songTmp.numChannels))
+	{
+		freeTmpModule();
+		loaderMsgBox("Not enough memory!");
+		return false;
+	}
+
+	setupLoadedModuleData();
+
+	moduleLoaded = false;
+	return true;
+}
+
 bool allocateTmpPatt(int32_t pattNum, uint16_t numRows)
 {
-	patternTmp[pattNum] = (note_t *)calloc((MAX_PATT_LEN * TRACK_WIDTH) + 16, 1);
+	// the loader must have set songTmp.numChannels before allocating patterns (they are stored at the song's width)
+	patternTmp[pattNum] = (note_t *)calloc((MAX_PATT_LEN * TRACK_WIDTH(songTmp.numChannels)) + 16, 1);
 	if (patternTmp[pattNum] == NULL)
 		return false;
 
@@ -340,7 +405,7 @@ bool tmpPatternEmpty(uint16_t pattNum)
 		return true;
 
 	uint8_t *scanPtr = (uint8_t *)patternTmp[pattNum];
-	const uint32_t scanLen = patternNumRowsTmp[pattNum] * TRACK_WIDTH;
+	const uint32_t scanLen = patternNumRowsTmp[pattNum] * TRACK_WIDTH(songTmp.numChannels);
 
 	for (uint32_t i = 0; i < scanLen; i++)
 	{
@@ -351,20 +416,9 @@ bool tmpPatternEmpty(uint16_t pattNum)
 	return true;
 }
 
-void clearUnusedChannels(note_t *pattPtr, int16_t numRows, int32_t numChannels)
-{
-	if (pattPtr == NULL || numChannels >= MAX_CHANNELS)
-		return;
-
-	const int32_t width = sizeof (note_t) * (MAX_CHANNELS - numChannels);
-
-	note_t *p = &pattPtr[numChannels];
-	for (int32_t i = 0; i < numRows; i++, p += MAX_CHANNELS)
-		memset(p, 0, width);
-}
 
-// called from input/video thread after the module was done loading
-static void setupLoadedModule(void)
+// puts the loaded module in place and resets the replayer (no GUI updates)
+static void setupLoadedModuleData(void)
 {
 	lockMixerCallback();
 
@@ -415,15 +469,6 @@ static void setupLoadedModule(void)
 
 	// we are the owners of the allocated memory ptrs set by the loader thread now
 
-	// support non-even channel numbers
-	if (song.numChannels & 1)
-	{
-		song.numChannels++;
-		if (song.numChannels > MAX_CHANNELS)
-			song.numChannels = MAX_CHANNELS;
-	}
-
-	song.numChannels = CLAMP(song.numChannels, 2, MAX_CHANNELS);
 	song.songLength = CLAMP(song.songLength, 1, MAX_ORDERS);
 	song.BPM = CLAMP(song.BPM, MIN_BPM, MAX_BPM);
 	song.initialSpeed = song.speed = CLAMP(song.speed, 1, MAX_SPEED);
@@ -446,7 +491,7 @@ static void setupLoadedModule(void)
 			continue;
 
 		note_t *p = pattern[i];
-		for (int32_t j = 0; j < MAX_PATT_LEN * MAX_CHANNELS; j++, p++)
+		for (int32_t j = 0; j < MAX_PATT_LEN * song.numChannels; j++, p++)
 		{
 			if (p->note > 97)
 				p->note = 0;
@@ -462,8 +507,8 @@ static void setupLoadedModule(void)
 		}
 	}
 
-	setScrollBarEnd(SB_POS_ED, (song.songLength - 1) + 5);
-	setScrollBarPos(SB_POS_ED, 0, false);
+	// keep patterns compact in memory, they are unpacked again when edited
+	packAllPatterns();
 
 	resetChannels();
 	setPos(0, 0, true);
@@ -478,6 +523,15 @@ static void setupLoadedModule(void)
 	setLinearPeriods(tmpLinearPeriodsFlag);
 
 	unlockMixerCallback();
+}
+
+// called from input/video thread after the module was done loading
+static void setupLoadedModule(void)
+{
+	setupLoadedModuleData();
+
+	setScrollBarEnd(SB_POS_ED, (song.songLength - 1) + 5);
+	setScrollBarPos(SB_POS_ED, 0, false);
 
 	editor.currVolEnvPoint = 0;
 	editor.currPanEnvPoint = 0;
@@ -493,6 +547,7 @@ static void setupLoadedModule(void)
 	resetPlaybackTime();
 
 	diskOpSetFilename(DISKOP_ITEM_MODULE, editor.tmpFilenameU);
+	setRenderQueueSongPath(editor.tmpFilenameU);
 
 	// redraw top part of screen
 	if (ui.extended)
@@ -590,7 +645,10 @@ static bool fileIsModule(UNICHAR *pathU)
 	if (f == NULL)
 		return false;
 
-	int8_t modFormat = detectModule(f);
+	LFILE stream;
+	lfopenFile(&stream, f);
+
+	int8_t modFormat = detectModule(&stream);
 	fclose(f);
 
 	/* If the module was not identified (possibly STK type),
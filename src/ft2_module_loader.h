@@ -6,11 +6,11 @@
 #include "ft2_unicode.h"
 
 bool tmpPatternEmpty(uint16_t pattNum);
-void clearUnusedChannels(note_t *p, int16_t numRows, int32_t numChannels);
 bool allocateTmpInstr(int16_t insNum);
 bool allocateTmpPatt(int32_t pattNum, uint16_t numRows);
 void loadMusic(UNICHAR *filenameU);
 bool loadMusicUnthreaded(UNICHAR *filenameU, bool autoPlay);
+bool loadMusicHeadless(UNICHAR *filenameU);
 bool handleModuleLoadFromArg(int argc, char **argv);
 void loadDroppedFile(char *fullPathUTF8, bool songModifiedCheck);
 void handleLoadMusicEvents(void);
@@ -18,8 +18,34 @@ void handleLoadMusicEvents(void);
 // file extensions accepted by Disk Op. in module mode
 extern char *supportedModExtensions[];
 
-extern volatile bool tmpLinearPeriodsFlag;
-extern int16_t patternNumRowsTmp[MAX_PATTERNS];
-extern note_t *patternTmp[MAX_PATTERNS];
-extern instr_t *instrTmp[1+256];
-extern song_t songTmp;
+/* libft2 (FT2_HEADLESS) loads modules on several threads at once, so there the loaders'
+** temporary module and scratch buffers are thread-local. The tracker only loads one module
+** at a time, and hands it over from the loader thread to the main thread.
+*/
+#ifdef FT2_HEADLESS
+#ifdef _MSC_VER
+#define LOADER_THREAD_LOCAL __declspec(thread)
+#else
+#define LOADER_THREAD_LOCAL _Thread_local
+#endif
+#else
+#define LOADER_THREAD_LOCAL
+#endif
+
+extern LOADER_THREAD_LOCAL volatile bool tmpLinearPeriodsFlag;
+extern LOADER_THREAD_LOCAL int16_t patternNumRowsTmp[MAX_PATTERNS];
+extern LOADER_THREAD_LOCAL note_t *patternTmp[MAX_PATTERNS];
+extern LOADER_THREAD_LOCAL instr_t *instrTmp[1+256];
+extern LOADER_THREAD_LOCAL song_t songTmp;
+
+/* Flags for metadata-only loads (libft2), always 0 in the tracker. The loaders still read
+** all the headers, but seek past the sample data (samples are left without data, with their
+** lengths and loops set up as usual) and/or the pattern data (patterns are left empty).
+*/
+enum
+{
+	LOADER_SKIP_SAMPLE_DATA = 1,
+	LOADER_SKIP_PATTERNS = 2
+};
+
+extern LOADER_THREAD_LOCAL uint8_t tmpLoaderFlags;
@@ -13,6 +13,8 @@
 #include "ft2_module_loader.h"
 #include "ft2_tables.h"
 #include "ft2_structs.h"
+#include "ft2_render_queue.h"
+#include "ft2_pattern_pack.h"
 
 static int8_t smpChunkBuf[1024];
 static uint8_t packedPattData[65536], modPattData[64*32*4];
@@ -26,7 +28,7 @@ static const char modIDs[32][5] =
 	"25CH", "26CH", "27CH", "28CH", "29CH", "30CH", "31CH", "32CH"
 };
 
-static uint16_t packPatt(uint8_t *writePtr, uint8_t *pattPtr, uint16_t numRows);
+static uint16_t packPatt(uint8_t *writePtr, uint16_t pattNum, uint16_t numRows);
 
 bool saveXM(UNICHAR *filenameU)
 {
@@ -39,6 +41,12 @@ bool saveXM(UNICHAR *filenameU)
 	sample_t *s;
 	xmSmpHdr_t *dst;
 
+	if (song.numChannels > MAX_XM_CHANNELS)
+	{
+		okBoxThreadSafe(0, "System message", "Error: XMs can't have more than 32 channels! Module wasn't saved.");
+		return false;
+	}
+
 	FILE *f = UNICHAR_FOPEN(filenameU, "wb");
 	if (f == NULL)
 	{
@@ -108,12 +116,7 @@ bool saveXM(UNICHAR *filenameU)
 	{
 		if (patternEmpty(i))
 		{
-			if (pattern[i] != NULL)
-			{
-				free(pattern[i]);
-				pattern[i] = NULL;
-			}
-
+			freePattern(i);
 			patternNumRows[i] = 64;
 		}
 
@@ -121,7 +124,7 @@ bool saveXM(UNICHAR *filenameU)
 		ph.numRows = patternNumRows[i];
 		ph.type = 0;
 
-		if (pattern[i] == NULL)
+		if (pattern[i] == NULL && packedPattern[i] == NULL)
 		{
 			ph.dataSize = 0;
 			if (fwrite(&ph, ph.headerSize, 1, f) != 1)
@@ -133,7 +136,7 @@ bool saveXM(UNICHAR *filenameU)
 		}
 		else
 		{
-			ph.dataSize = packPatt(packedPattData, (uint8_t *)pattern[i], patternNumRows[i]);
+			ph.dataSize = packPatt(packedPattData, i, patternNumRows[i]);
 
 			result = fwrite(&ph, ph.headerSize, 1, f);
 			result += fwrite(packedPattData, ph.dataSize, 1, f);
@@ -289,6 +292,13 @@ static bool saveMOD(UNICHAR *filenameU)
 	instr_t *ins;
 	sample_t *smp;
 	modHdr_t hdr;
+	note_t rowBuf[MAX_CHANNELS];
+
+	if (song.numChannels > MAX_XM_CHANNELS)
+	{
+		okBoxThreadSafe(0, "System message", "Error: MODs can't have more than 32 channels! Module wasn't saved.");
+		return false;
+	}
 
 	// Commented out. This one was probably confusing to many people...
 	/*
@@ -383,7 +393,7 @@ static bool saveMOD(UNICHAR *filenameU)
 
 	for (i = 0; i < numPatterns; i++)
 	{
-		if (pattern[i] == NULL)
+		if (pattern[i] == NULL && packedPattern[i] == NULL)
 			continue;
 
 		if (patternNumRows[i] < 64)
@@ -397,10 +407,9 @@ static bool saveMOD(UNICHAR *filenameU)
 
 		for (j = 0; j < 64; j++)
 		{
-			for (k = 0; k < song.numChannels; k++)
+			const note_t *p = getPatternRow(i, (int16_t)j, rowBuf);
+			for (k = 0; k < song.numChannels; k++, p++)
 			{
-				note_t *p = &pattern[i][(j * MAX_CHANNELS) + k];
-
 				if (p->instr > 31)
 					tooManyInstr = true;
 
@@ -514,7 +523,7 @@ static bool saveMOD(UNICHAR *filenameU)
 	const int32_t patternBytes = song.numChannels * 64 * 4;
 	for (i = 0; i < numPatterns; i++)
 	{
-		if (pattern[i] == NULL) // empty pattern
+		if (pattern[i] == NULL && packedPattern[i] == NULL) // empty pattern
 		{
 			memset(modPattData, 0, patternBytes);
 		}
@@ -523,10 +532,9 @@ static bool saveMOD(UNICHAR *filenameU)
 			int32_t offs = 0;
 			for (j = 0; j < 64; j++)
 			{
-				for (k = 0; k < song.numChannels; k++)
+				const note_t *p = getPatternRow(i, (int16_t)j, rowBuf);
+				for (k = 0; k < song.numChannels; k++, p++)
 				{
-					note_t *p = &pattern[i][(j * MAX_CHANNELS) + k];
-
 					uint8_t inst = p->instr;
 					uint8_t note = p->note;
 
@@ -653,10 +661,14 @@ static int32_t SDLCALL saveMusicThread(void *ptr)
 
 	pauseAudio();
 
+	bool saved;
 	if (editor.moduleSaveMode == 1)
-		saveXM(editor.tmpFilenameU);
+		saved = saveXM(editor.tmpFilenameU);
 	else
-		saveMOD(editor.tmpFilenameU);
+		saved = saveMOD(editor.tmpFilenameU);
+
+	if (saved)
+		setRenderQueueSongPath(editor.tmpFilenameU);
 
 	resumeAudio();
 	return true;
@@ -679,60 +691,20 @@ void saveMusic(UNICHAR *filenameU)
 	SDL_DetachThread(thread);
 }
 
-static uint16_t packPatt(uint8_t *writePtr, uint8_t *pattPtr, uint16_t numRows)
+static uint16_t packPatt(uint8_t *writePtr, uint16_t pattNum, uint16_t numRows)
 {
-	uint8_t bytes[5];
+	note_t rowBuf[MAX_CHANNELS];
 
-	if (pattPtr == NULL)
-		return 0;
+	uint32_t totalPackLen = 0; // max. XM_PACKED_NOTES_BOUND(MAX_PATT_LEN * MAX_XM_CHANNELS), fits in packedPattData[]
 
-	uint16_t totalPackLen = 0;
-
-	const int32_t pitch = sizeof (note_t) * (MAX_CHANNELS - song.numChannels);
 	for (int32_t row = 0; row < numRows; row++)
 	{
-		for (int32_t chn = 0; chn < song.numChannels; chn++)
-		{
-			bytes[0] = *pattPtr++;
-			bytes[1] = *pattPtr++;
-			bytes[2] = *pattPtr++;
-			bytes[3] = *pattPtr++;
-			bytes[4] = *pattPtr++;
-
-			uint8_t *firstBytePtr = writePtr++;
-
-			uint8_t packBits = 0;
-			if (bytes[0] > 0) { packBits |= 1; *writePtr++ = bytes[0]; } // note
-			if (bytes[1] > 0) { packBits |= 2; *writePtr++ = bytes[1]; } // instrument
-			if (bytes[2] > 0) { packBits |= 4; *writePtr++ = bytes[2]; } // volume column
-			if (bytes[3] > 0) { packBits |= 8; *writePtr++ = bytes[3]; } // effect
-
-			if (packBits == 15) // first four bits set?
-			{
-				// no packing needed, write pattern data as is
-
-				// point to first byte (and overwrite data)
-				writePtr = firstBytePtr;
-
-				*writePtr++ = bytes[0];
-				*writePtr++ = bytes[1];
-				*writePtr++ = bytes[2];
-				*writePtr++ = bytes[3];
-				*writePtr++ = bytes[4];
-
-				totalPackLen += 5;
-				continue;
-			}
-
-			if (bytes[4] > 0) { packBits |= 16; *writePtr++ = bytes[4]; } // effect parameter
-
-			*firstBytePtr = packBits | 128; // write pack bits byte
-			totalPackLen += (uint16_t)(writePtr - firstBytePtr); // bytes writen
-		}
+		const note_t *pattPtr = getPatternRow(pattNum, (int16_t)row, rowBuf);
+		if (pattPtr == NULL)
+			return 0;
 
-		// skip unused channels (unpacked patterns always have 32 channels)
-		pattPtr += pitch;
+		totalPackLen += packXMNotes(pattPtr, song.numChannels, &writePtr[totalPackLen]);
 	}
 
-	return totalPackLen;
+	return (uint16_t)totalPackLen;
 }
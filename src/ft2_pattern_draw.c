@@ -14,7 +14,7 @@
 #include "ft2_bmp.h"
 #include "ft2_structs.h"
 
-static note_t emptyPattern[MAX_CHANNELS * MAX_PATT_LEN];
+static note_t emptyPatternRow[MAX_XM_CHANNELS];
 
 static const uint8_t *font4Ptr, *font5Ptr;
 static const uint8_t vol2charTab1[16] = { 39, 0, 1, 2, 3, 4, 36, 52, 53, 54, 28, 31, 25, 58, 59, 22 };
@@ -672,12 +672,8 @@ void writePattern(int32_t currRow, int32_t currPattern)
 	int32_t textY = pattCoord->upperRowsTextY;
 	const int32_t afterCurrRow = currRow + 1;
 	const int32_t numChannels = ui.numChannelsShown;
-	note_t *pattPtr = pattern[currPattern];
 	const int32_t numRows = patternNumRows[currPattern];
-
-	// increment pattern data pointer by horizontal scrollbar offset/channel
-	if (pattPtr != NULL)
-		pattPtr += ui.channelOffset;
+	note_t rowBuf[MAX_CHANNELS];
 
 	// set up function pointers for drawing
 	if (config.ptnShowVolColumn)
@@ -707,7 +703,12 @@ void writePattern(int32_t currRow, int32_t currPattern)
 
 			drawRowNums(textY, (uint8_t)row, selectedRowFlag);
 
-			const note_t *p = (pattPtr == NULL) ? emptyPattern : &pattPtr[(uint32_t)row * MAX_CHANNELS];
+			// the pattern may be packed, so fetch it row by row
+			const note_t *p = getPatternRow(currPattern, (int16_t)row, rowBuf);
+			if (p == NULL)
+				p = emptyPatternRow;
+			else
+				p += ui.channelOffset; // horizontal scrollbar offset/channel
 			const int32_t xWidth = ui.patternChannelWidth;
 			const uint32_t color = noteTextColors[selectedRowFlag];
 
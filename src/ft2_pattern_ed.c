@@ -48,16 +48,24 @@ bool allocatePattern(uint16_t pattNum) // for tracker use only, not in loader!
 	if (audioWasntLocked)
 		lockAudio();
 
+	if (!unpackPattern(pattNum)) // expand packed pattern for editing
+	{
+		if (audioWasntLocked)
+			unlockAudio();
+
+		return false;
+	}
+
 	if (pattern[pattNum] == NULL)
 	{
 		/* Original FT2 allocates only the amount of rows needed, but we don't
 		** do that to avoid out of bondary row look-up between out-of-sync replayer
 		** state and tracker state (yes it used to happen, rarely). We're not wasting
-		** too much RAM for a modern computer anyway. Worst case: 256 allocated
-		** patterns would be ~10MB.
+		** too much RAM for a modern computer anyway. Patterns are stored at the song's
+		** actual width, so worst case (256 allocated 32-channel patterns) is ~10MB.
 		**/
 
-		pattern[pattNum] = (note_t *)calloc((MAX_PATT_LEN * TRACK_WIDTH) + 16, 1);
+		pattern[pattNum] = (note_t *)calloc((MAX_PATT_LEN * TRACK_WIDTH(song.numChannels)) + 16, 1);
 		if (pattern[pattNum] == NULL)
 		{
 			if (audioWasntLocked)
@@ -75,6 +83,15 @@ bool allocatePattern(uint16_t pattNum) // for tracker use only, not in loader!
 	return true;
 }
 
+note_t *getEditPattern(uint16_t pattNum) // for tracker use only, not in loader!
+{
+	// returns NULL if the pattern is empty (or couldn't be unpacked)
+	if (!unpackPattern(pattNum))
+		return NULL;
+
+	return pattern[pattNum];
+}
+
 void killPatternIfUnused(uint16_t pattNum) // for tracker use only, not in loader!
 {
 	const bool audioWasntLocked = !audio.locked;
@@ -82,13 +99,7 @@ void killPatternIfUnused(uint16_t pattNum) // for tracker use only, not in loade
 		lockAudio();
 
 	if (patternEmpty(pattNum))
-	{
-		if (pattern[pattNum] != NULL)
-		{
-			free(pattern[pattNum]);
-			pattern[pattNum] = NULL;
-		}
-	}
+		freePattern(pattNum);
 
 	if (audioWasntLocked)
 		unlockAudio();
@@ -1195,7 +1206,7 @@ bool loadTrack(UNICHAR *filenameU)
 	lockMixerCallback();
 	for (int32_t i = 0; i < numRows; i++)
 	{
-		note_t *p = &pattern[editor.editPattern][(i * MAX_CHANNELS) + cursor.ch];
+		note_t *p = &pattern[editor.editPattern][(i * song.numChannels) + cursor.ch];
 
 		*p = loadBuff[i];
 
@@ -1232,11 +1243,10 @@ trackLoadError:
 
 bool saveTrack(UNICHAR *filenameU)
 {
-	note_t saveBuff[MAX_PATT_LEN];
+	note_t saveBuff[MAX_PATT_LEN], rowBuf[MAX_CHANNELS];
 	xtHdr_t h;
 
-	note_t *p = pattern[editor.editPattern];
-	if (p == NULL)
+	if (patternEmpty(editor.editPattern))
 	{
 		okBox(0, "System message", "The current pattern is empty!");
 		return false;
@@ -1253,7 +1263,7 @@ bool saveTrack(UNICHAR *filenameU)
 	h.numRows = patternNumRows[editor.editPattern];
 
 	for (int32_t i = 0; i < h.numRows; i++)
-		saveBuff[i] = p[(i * MAX_CHANNELS) + cursor.ch];
+		saveBuff[i] = getPatternRow(editor.editPattern, (int16_t)i, rowBuf)[cursor.ch];
 
 	if (fwrite(&h, sizeof (h), 1, f) !=  1)
 	{
@@ -1307,20 +1317,26 @@ bool loadPattern(UNICHAR *filenameU)
 
 	lockMixerCallback();
 
-	note_t *p = pattern[editor.editPattern];
-	if (fread(p, h.numRows * TRACK_WIDTH, 1, f) != 1)
+	// .XP patterns always have 32 channels, ours are stored at the song's width
+	note_t rowBuff[MAX_XM_CHANNELS];
+	for (int32_t row = 0; row < h.numRows; row++)
 	{
-		unlockMixerCallback();
-		okBox(0, "System message", "General I/O error during loading! Is the file in use?");
-		goto loadPattError;
+		if (fread(rowBuff, TRACK_WIDTH(MAX_XM_CHANNELS), 1, f) != 1)
+		{
+			unlockMixerCallback();
+			okBox(0, "System message", "General I/O error during loading! Is the file in use?");
+			goto loadPattError;
+		}
+
+		memcpy(&pattern[editor.editPattern][row * song.numChannels], rowBuff, TRACK_WIDTH(song.numChannels));
 	}
 
 	// sanitize data (FT2 doesn't do this!)
 	for (int32_t row = 0; row < h.numRows; row++)
 	{
-		for (int32_t ch = 0; ch < MAX_CHANNELS; ch++)
+		for (int32_t ch = 0; ch < song.numChannels; ch++)
 		{
-			p = &pattern[editor.editPattern][(row * MAX_CHANNELS) + ch];
+			note_t *p = &pattern[editor.editPattern][(row * song.numChannels) + ch];
 
 			if (p->note > 97)
 				p->note = 0;
@@ -1365,10 +1381,10 @@ loadPattError:
 
 bool savePattern(UNICHAR *filenameU)
 {
+	note_t rowBuf[MAX_CHANNELS];
 	xpHdr_t h;
 
-	note_t *p = pattern[editor.editPattern];
-	if (p == NULL)
+	if (patternEmpty(editor.editPattern))
 	{
 		okBox(0, "System message", "The current pattern is empty!");
 		return false;
@@ -1391,11 +1407,19 @@ bool savePattern(UNICHAR *filenameU)
 		return false;
 	}
 
-	if (fwrite(p, h.numRows * TRACK_WIDTH, 1, f) != 1)
+	// .XP patterns always have 32 channels, pad our rows to that
+	note_t rowBuff[MAX_XM_CHANNELS];
+	memset(rowBuff, 0, sizeof (rowBuff));
+
+	for (int32_t row = 0; row < h.numRows; row++)
 	{
-		fclose(f);
-		okBox(0, "System message", "General I/O error during saving! Is the file in use?");
-		return false;
+		memcpy(rowBuff, getPatternRow(editor.editPattern, (int16_t)row, rowBuf), TRACK_WIDTH(song.numChannels));
+		if (fwrite(rowBuff, TRACK_WIDTH(MAX_XM_CHANNELS), 1, f) != 1)
+		{
+			fclose(f);
+			okBox(0, "System message", "General I/O error during saving! Is the file in use?");
+			return false;
+		}
 	}
 
 	fclose(f);
@@ -1810,6 +1834,13 @@ void pbAddChan(void)
 		return;
 
 	lockMixerCallback();
+
+	if (!unpackAllPatterns() || !resizePatternChannels(pattern, song.numChannels, song.numChannels + 2))
+	{
+		unlockMixerCallback();
+		okBox(0, "System message", "Not enough memory!");
+		return;
+	}
 	song.numChannels += 2;
 
 	hideTopScreen();
@@ -1830,6 +1861,12 @@ void pbSubChan(void)
 
 	lockMixerCallback();
 
+	if (!unpackAllPatterns() || !resizePatternChannels(pattern, song.numChannels, song.numChannels - 2))
+	{
+		unlockMixerCallback();
+		okBox(0, "System message", "Not enough memory!");
+		return;
+	}
 	song.numChannels -= 2;
 
 	checkMarkLimits();
@@ -2701,14 +2738,14 @@ void shrinkPattern(void)
 
 	lockMixerCallback();
 
-	note_t *p = pattern[editor.editPattern];
+	note_t *p = getEditPattern(editor.editPattern);
 	if (p != NULL)
 	{
 		const int32_t length = numRows >> 1;
 		for (int32_t i = 0; i < length; i++)
 		{
-			for (int32_t j = 0; j < MAX_CHANNELS; j++)
-				p[(i * MAX_CHANNELS) + j] = p[((i*2) * MAX_CHANNELS) + j];
+			for (int32_t j = 0; j < song.numChannels; j++)
+				p[(i * song.numChannels) + j] = p[((i*2) * song.numChannels) + j];
 		}
 	}
 
@@ -2742,9 +2779,9 @@ void expandPattern(void)
 	{
 		lockMixerCallback();
 
-		if (pattern[editor.editPattern] != NULL)
+		if (getEditPattern(editor.editPattern) != NULL)
 		{
-			note_t *tmpPtn = (note_t *)malloc((numRows * 2) * TRACK_WIDTH);
+			note_t *tmpPtn = (note_t *)calloc((MAX_PATT_LEN * TRACK_WIDTH(song.numChannels)) + 16, 1);
 			if (tmpPtn == NULL)
 			{
 				unlockMixerCallback();
@@ -2754,10 +2791,10 @@ void expandPattern(void)
 
 			for (int32_t i = 0; i < numRows; i++)
 			{
-				for (int32_t j = 0; j < MAX_CHANNELS; j++)
-					tmpPtn[((i * 2) * MAX_CHANNELS) + j] = pattern[editor.editPattern][(i * MAX_CHANNELS) + j];
+				for (int32_t j = 0; j < song.numChannels; j++)
+					tmpPtn[((i * 2) * song.numChannels) + j] = pattern[editor.editPattern][(i * song.numChannels) + j];
 
-				memset(&tmpPtn[((i * 2) + 1) * MAX_CHANNELS], 0, TRACK_WIDTH);
+				memset(&tmpPtn[((i * 2) + 1) * song.numChannels], 0, TRACK_WIDTH(song.numChannels));
 			}
 
 			free(pattern[editor.editPattern]);
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "ft2_unicode.h"
+#include "ft2_replayer.h"
 
 enum
 {
@@ -62,6 +63,7 @@ extern pattMark_t pattMark; // ft2_pattern_ed.c
 void resetPlaybackTime(void);
 
 bool allocatePattern(uint16_t pattNum);
+note_t *getEditPattern(uint16_t pattNum);
 void killPatternIfUnused(uint16_t pattNum);
 uint8_t getMaxVisibleChannels(void);
 void updatePatternWidth(void);
@@ -0,0 +1,189 @@
+// for finding memory leaks in debug mode with Visual Studio
+#if defined _DEBUG && defined _MSC_VER
+#include <crtdbg.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft2_header.h"
+#include "ft2_pattern_pack.h"
+
+// same bits as XM pattern packing: note, instrument, volume column, effect, effect parameter
+#define CELL_NOTE 1
+#define CELL_INSTR 2
+#define CELL_VOL 4
+#define CELL_EFX 8
+#define CELL_EFXDATA 16
+
+static const uint8_t cellMaskBytes[32] = // number of set bits in mask
+{
+	0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+	1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5
+};
+
+static uint8_t getCellMask(const note_t *p)
+{
+	uint8_t mask = 0;
+	if (p->note    != 0) mask |= CELL_NOTE;
+	if (p->instr   != 0) mask |= CELL_INSTR;
+	if (p->vol     != 0) mask |= CELL_VOL;
+	if (p->efx     != 0) mask |= CELL_EFX;
+	if (p->efxData != 0) mask |= CELL_EFXDATA;
+
+	return mask;
+}
+
+/* Packs a dense pattern (MAX_PATT_LEN rows of numChannels notes). All rows are
+** scanned, not just the pattern length, so that data hidden by shortening a
+** pattern survives a pack/unpack cycle. The result is a single allocation, free()
+** it when done. Returns NULL on OOM, or if the packed form wouldn't be smaller.
+*/
+packedPatt_t *encodePackedPattern(const note_t *patt, int32_t numChannels)
+{
+	if (patt == NULL || numChannels < 1 || numChannels > MAX_CHANNELS)
+		return NULL;
+
+	// pass 1: find the last used row and the packed data size
+
+	int32_t numRows = 0;
+	uint32_t dataSize = 0;
+
+	const note_t *p = patt;
+	for (int32_t row = 0; row < MAX_PATT_LEN; row++)
+	{
+		for (int32_t ch = 0; ch < numChannels; ch++, p++)
+		{
+			const uint8_t mask = getCellMask(p);
+			if (mask != 0)
+			{
+				dataSize += 2 + cellMaskBytes[mask];
+				numRows = row + 1;
+			}
+		}
+	}
+
+	if (dataSize > UINT16_MAX)
+		return NULL;
+
+	const uint32_t rowOffsSize = (numRows + 1) * sizeof (uint16_t);
+	const uint32_t packedSize = sizeof (packedPatt_t) + rowOffsSize + dataSize;
+
+	if (packedSize >= (uint32_t)(MAX_PATT_LEN * TRACK_WIDTH(numChannels)) + 16)
+		return NULL; // not worth it, keep the dense pattern
+
+	packedPatt_t *pp = (packedPatt_t *)malloc(packedSize);
+	if (pp == NULL)
+		return NULL;
+
+	pp->numRows = (int16_t)numRows;
+	pp->numChannels = (int16_t)numChannels;
+	pp->dataSize = (uint16_t)dataSize;
+	pp->rowOffs = (uint16_t *)(pp + 1);
+	pp->data = (uint8_t *)pp->rowOffs + rowOffsSize;
+
+	// pass 2: write cells
+
+	uint8_t *dst = pp->data;
+
+	p = patt;
+	for (int32_t row = 0; row < numRows; row++)
+	{
+		pp->rowOffs[row] = (uint16_t)(dst - pp->data);
+
+		for (int32_t ch = 0; ch < numChannels; ch++, p++)
+		{
+			const uint8_t mask = getCellMask(p);
+			if (mask == 0)
+				continue;
+
+			*dst++ = (uint8_t)ch;
+			*dst++ = mask;
+
+			if (mask & CELL_NOTE)    *dst++ = p->note;
+			if (mask & CELL_INSTR)   *dst++ = p->instr;
+			if (mask & CELL_VOL)     *dst++ = p->vol;
+			if (mask & CELL_EFX)     *dst++ = p->efx;
+			if (mask & CELL_EFXDATA) *dst++ = p->efxData;
+		}
+	}
+	pp->rowOffs[numRows] = (uint16_t)dataSize;
+
+	return pp;
+}
+
+void decodePackedRow(const packedPatt_t *pp, int32_t row, note_t *dst)
+{
+	memset(dst, 0, TRACK_WIDTH(pp->numChannels));
+	if (row < 0 || row >= pp->numRows)
+		return;
+
+	const uint8_t *src = &pp->data[pp->rowOffs[row]];
+	const uint8_t *srcEnd = &pp->data[pp->rowOffs[row+1]];
+
+	while (src < srcEnd)
+	{
+		note_t *p = &dst[*src++];
+		const uint8_t mask = *src++;
+
+		if (mask & CELL_NOTE)    p->note    = *src++;
+		if (mask & CELL_INSTR)   p->instr   = *src++;
+		if (mask & CELL_VOL)     p->vol     = *src++;
+		if (mask & CELL_EFX)     p->efx     = *src++;
+		if (mask & CELL_EFXDATA) p->efxData = *src++;
+	}
+}
+
+void decodePackedPattern(const packedPatt_t *pp, note_t *dst)
+{
+	for (int32_t row = 0; row < pp->numRows; row++, dst += pp->numChannels)
+		decodePackedRow(pp, row, dst);
+}
+
+bool packedRowsEmpty(const packedPatt_t *pp, int32_t numRows) // are the first 'numRows' rows empty?
+{
+	if (numRows > pp->numRows)
+		numRows = pp->numRows;
+
+	return numRows <= 0 || pp->rowOffs[numRows] == 0;
+}
+
+uint32_t getPackedPatternMemSize(const packedPatt_t *pp)
+{
+	return sizeof (packedPatt_t) + ((pp->numRows + 1) * sizeof (uint16_t)) + pp->dataSize;
+}
+
+/* XM pattern packing (same output as FT2): a note is stored as-is if its first four
+** bytes are all non-zero, otherwise as a mask byte (bit 7 set) followed by the non-zero
+** bytes. Packs any number of notes in one go, f.ex. a whole pattern, since patterns are
+** stored at song width.
+*/
+uint32_t packXMNotes(const note_t *src, int32_t numNotes, uint8_t *dst)
+{
+	uint8_t *writePtr = dst;
+
+	for (int32_t i = 0; i < numNotes; i++, src++)
+	{
+		uint8_t *firstBytePtr = writePtr++;
+
+		uint8_t mask = 0;
+		if (src->note  != 0) { mask |= CELL_NOTE;  *writePtr++ = src->note;  }
+		if (src->instr != 0) { mask |= CELL_INSTR; *writePtr++ = src->instr; }
+		if (src->vol   != 0) { mask |= CELL_VOL;   *writePtr++ = src->vol;   }
+		if (src->efx   != 0) { mask |= CELL_EFX;   *writePtr++ = src->efx;   }
+
+		if (mask == 15) // first four bytes set, no packing needed (overwrite what was written)
+		{
+			memcpy(firstBytePtr, src, sizeof (note_t));
+			writePtr = firstBytePtr + sizeof (note_t);
+			continue;
+		}
+
+		if (src->efxData != 0) { mask |= CELL_EFXDATA; *writePtr++ = src->efxData; }
+
+		*firstBytePtr = mask | 128;
+	}
+
+	return (uint32_t)(writePtr - dst);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ft2_replayer.h"
+
+/* Compact in-memory pattern representation (packedPatt_t). Only non-empty cells
+** are stored, each as a channel byte, a mask byte telling which of the five note_t
+** bytes are non-zero, and then those bytes. A row offset table gives direct access
+** to any row, so the replayer can decode one row at a time.
+*/
+
+packedPatt_t *encodePackedPattern(const note_t *patt, int32_t numChannels); // returns NULL if the pattern doesn't pack (or on OOM), free() result
+void decodePackedRow(const packedPatt_t *pp, int32_t row, note_t *dst); // dst must hold pp->numChannels notes
+void decodePackedPattern(const packedPatt_t *pp, note_t *dst); // dst must be a zeroed MAX_PATT_LEN row pattern
+bool packedRowsEmpty(const packedPatt_t *pp, int32_t numRows);
+uint32_t getPackedPatternMemSize(const packedPatt_t *pp);
+
+#define XM_PACKED_NOTES_BOUND(numNotes) ((numNotes) * 5) // worst case size of packXMNotes() output
+
+uint32_t packXMNotes(const note_t *src, int32_t numNotes, uint8_t *dst); // returns the packed size
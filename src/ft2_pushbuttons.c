@@ -382,8 +382,9 @@ pushButton_t pushButtons[NUM_PUSHBUTTONS] =
 
 	// ------ WAV RENDERER PUSHBUTTONS ------
 	//x,   y,   w,  h,  p, d, text #1,           text #2, funcOnDown,         funcOnUp
-	{   3, 138, 73, 16, 0, 0, "Export",          NULL,    NULL,               pbWavRender },
-	{   3, 155, 73, 16, 0, 0, "Exit",            NULL,    NULL,               pbWavExit },
+	{   3, 138, 42, 16, 0, 0, "Export",          NULL,    NULL,               pbWavRender },
+	{  46, 155, 30, 16, 0, 0, "Exit",            NULL,    NULL,               pbWavExit },
+	{   3, 155, 42, 16, 0, 0, "Queue",           NULL,    NULL,               pbWavQueue },
 	{ 253, 114, 18, 13, 1, 6, ARROW_UP_STRING,   NULL,    pbWavFreqUp,        NULL },
 	{ 270, 114, 18, 13, 1, 6, ARROW_DOWN_STRING, NULL,    pbWavFreqDown,      NULL },
 	{ 253, 128, 18, 13, 1, 4, ARROW_UP_STRING,   NULL,    pbWavAmpUp,         NULL },
@@ -391,7 +392,9 @@ pushButton_t pushButtons[NUM_PUSHBUTTONS] =
 	{ 253, 142, 18, 13, 1, 4, ARROW_UP_STRING,   NULL,    pbWavSongStartUp,   NULL },
 	{ 270, 142, 18, 13, 1, 4, ARROW_DOWN_STRING, NULL,    pbWavSongStartDown, NULL },
 	{ 253, 156, 18, 13, 1, 4, ARROW_UP_STRING,   NULL,    pbWavSongEndUp,     NULL },
-	{ 270, 156, 18, 13, 1, 4, ARROW_DOWN_STRING, NULL,    pbWavSongEndDown,   NULL }
+	{ 270, 156, 18, 13, 1, 4, ARROW_DOWN_STRING, NULL,    pbWavSongEndDown,   NULL },
+	{  46, 138, 30, 16, 0, 0, "Jobs",            NULL,    NULL,               pbWavJobs },
+	{ 233, 155, 55, 16, 0, 0, "Cancel",          NULL,    NULL,               pbWavCancelJobs }
 };
 
 static uint32_t tmpCounter;
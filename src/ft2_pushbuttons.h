@@ -322,6 +322,7 @@ enum // PUSHBUTTONS
 	// WAV RENDERER
 	PB_WAV_RENDER,
 	PB_WAV_EXIT,
+	PB_WAV_QUEUE,
 	PB_WAV_FREQ_UP,
 	PB_WAV_FREQ_DOWN,
 	PB_WAV_AMP_UP,
@@ -330,6 +331,8 @@ enum // PUSHBUTTONS
 	PB_WAV_START_DOWN,
 	PB_WAV_END_UP,
 	PB_WAV_END_DOWN,
+	PB_WAV_JOBS,
+	PB_WAV_CANCEL_JOBS,
 
 	NUM_PUSHBUTTONS
 };
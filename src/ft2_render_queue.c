@@ -0,0 +1,504 @@
+// for finding memory leaks in debug mode with Visual Studio
+#if defined _DEBUG && defined _MSC_VER
+#include <crtdbg.h>
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h> // _NSGetExecutablePath()
+#endif
+#endif
+#include "ft2_header.h"
+#include "ft2_config.h"
+#include "ft2_sysreqs.h"
+#include "ft2_structs.h"
+#include "ft2_render_queue.h"
+
+#define JOB_LINE_LEN 256
+#define WORKER_NICE 10 // keep the workers from competing with the live audio/video
+
+typedef struct renderJob_t
+{
+	char *modulePath, *outPath;
+	renderJobSettings_t settings;
+	int32_t state, progress;
+#ifndef _WIN32
+	pid_t pid;
+	int32_t fd; // read end of the worker's stdout/stderr
+#endif
+	uint32_t lineLen;
+	char line[JOB_LINE_LEN], message[JOB_LINE_LEN]; // line being read, last line that wasn't progress
+} renderJob_t;
+
+static int32_t numJobs; // jobs in the current batch, cleared when all of them are done
+static renderJob_t jobs[RENDER_QUEUE_MAX_JOBS];
+static char *songPath, *exePath;
+
+static void freeJob(renderJob_t *j)
+{
+	if (j->modulePath != NULL)
+		free(j->modulePath);
+
+	if (j->outPath != NULL)
+		free(j->outPath);
+
+	memset(j, 0, sizeof (renderJob_t));
+}
+
+static int32_t countJobs(int32_t state)
+{
+	int32_t count = 0;
+	for (int32_t i = 0; i < numJobs; i++)
+	{
+		if (jobs[i].state == state)
+			count++;
+	}
+
+	return count;
+}
+
+#ifndef _WIN32
+static char *getExecutablePath(void) // free() result
+{
+#if defined __APPLE__
+	uint32_t size = 0;
+	_NSGetExecutablePath(NULL, &size);
+
+	char *path = (char *)malloc(size + 1);
+	if (path == NULL)
+		return NULL;
+
+	if (_NSGetExecutablePath(path, &size) != 0)
+	{
+		free(path);
+		return NULL;
+	}
+
+	return path;
+#elif defined __linux__
+	char *path = (char *)malloc(PATH_MAX + 1);
+	if (path == NULL)
+		return NULL;
+
+	const ssize_t len = readlink("/proc/self/exe", path, PATH_MAX);
+	if (len <= 0)
+	{
+		free(path);
+		return NULL;
+	}
+
+	path[len] = '\0';
+	return path;
+#else
+	return NULL;
+#endif
+}
+
+static char *getFullPath(const char *path) // free() result
+{
+	if (path[0] == '/')
+		return strdup(path);
+
+	char *fullPath = (char *)malloc(PATH_MAX + 1 + strlen(path) + 1);
+	if (fullPath == NULL)
+		return NULL;
+
+	if (getcwd(fullPath, PATH_MAX + 1) == NULL)
+	{
+		free(fullPath);
+		return NULL;
+	}
+
+	strcat(fullPath, "/");
+	strcat(fullPath, path);
+
+	return fullPath;
+}
+
+static const char *getInterpolationArg(uint8_t interpolation)
+{
+	switch (interpolation)
+	{
+		case INTERPOLATION_DISABLED: return "none";
+		case INTERPOLATION_LINEAR: return "linear";
+		case INTERPOLATION_SINC8: return "sinc8";
+		default: case INTERPOLATION_SINC16: return "sinc16";
+	}
+}
+
+static bool startJob(renderJob_t *j)
+{
+	char freqStr[16], bitsStr[8], ampStr[8], masterVolStr[8], startStr[8], endStr[8];
+	int32_t fds[2];
+
+	const renderJobSettings_t *s = &j->settings;
+
+	sprintf(freqStr, "%u", s->freq);
+	sprintf(bitsStr, "%d", s->bitDepth);
+	sprintf(ampStr, "%d", s->amp);
+	sprintf(masterVolStr, "%d", s->masterVol);
+	sprintf(startStr, "%d", s->startPos);
+	sprintf(endStr, "%d", s->endPos);
+
+	char *args[] =
+	{
+		exePath, "--render", j->modulePath, j->outPath,
+		"--rate", freqStr, "--bits", bitsStr, "--interp", (char *)getInterpolationArg(s->interpolation),
+		"--amp", ampStr, "--master-vol", masterVolStr, "--vol-ramp", s->volumeRamp ? "on" : "off",
+		"--start", startStr, "--end", endStr, "--progress", NULL
+	};
+
+	if (pipe(fds) != 0)
+		return false;
+
+	// the read end stays in this process only, and never blocks the main loop
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[0], F_SETFL, O_NONBLOCK);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC); // not inherited by the other workers (dup2() clears it for the worker)
+
+	const pid_t pid = fork();
+	if (pid < 0)
+	{
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if (pid == 0) // worker process, this process has other threads, so only async-signal-safe calls until exec
+	{
+		dup2(fds[1], STDOUT_FILENO);
+		dup2(fds[1], STDERR_FILENO);
+		setpriority(PRIO_PROCESS, 0, WORKER_NICE);
+
+		execv(exePath, args);
+		_exit(127);
+	}
+
+	close(fds[1]);
+
+	j->pid = pid;
+	j->fd = fds[0];
+	j->state = RENDER_JOB_RUNNING;
+	j->progress = 0;
+	j->lineLen = 0;
+
+	return true;
+}
+
+static void handleJobLine(renderJob_t *j)
+{
+	j->line[j->lineLen] = '\0';
+	j->lineLen = 0;
+
+	if (!strncmp(j->line, "progress ", 9))
+		j->progress = CLAMP(atoi(&j->line[9]), 0, 100);
+	else if (j->line[0] != '\0')
+		strcpy(j->message, j->line); // errors are printed last, so this ends up as the error message
+}
+
+static bool readJobOutput(renderJob_t *j) // returns true if the progress changed
+{
+	char buf[256];
+	ssize_t bytesRead;
+
+	const int32_t oldProgress = j->progress;
+
+	while ((bytesRead = read(j->fd, buf, sizeof (buf))) > 0)
+	{
+		for (ssize_t i = 0; i < bytesRead; i++)
+		{
+			if (buf[i] == '\n')
+				handleJobLine(j);
+			else if (j->lineLen < JOB_LINE_LEN-1)
+				j->line[j->lineLen++] = buf[i];
+		}
+	}
+
+	return j->progress != oldProgress;
+}
+
+static bool reapJob(renderJob_t *j) // returns true if the worker is done
+{
+	int status;
+	if (waitpid(j->pid, &status, WNOHANG) != j->pid)
+		return false;
+
+	readJobOutput(j); // what's left in the pipe
+	if (j->lineLen > 0)
+		handleJobLine(j);
+
+	close(j->fd);
+	j->fd = -1;
+
+	if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+	{
+		j->state = RENDER_JOB_DONE;
+		j->progress = 100;
+		editor.diskOpReadOnOpen = true; // show the new file
+	}
+	else
+	{
+		j->state = RENDER_JOB_FAILED;
+		if (WIFEXITED(status) && WEXITSTATUS(status) == 127)
+			strcpy(j->message, "Couldn't start the render process!");
+	}
+
+	return true;
+}
+
+static void stopJob(renderJob_t *j)
+{
+	kill(j->pid, SIGKILL); // the file is deleted anyway
+	waitpid(j->pid, NULL, 0);
+	close(j->fd);
+
+	remove(j->outPath); // it's not complete
+	j->state = RENDER_JOB_FAILED;
+}
+#endif
+
+bool renderQueueSupported(void)
+{
+#ifdef _WIN32
+	return false;
+#else
+	if (exePath == NULL)
+		exePath = getExecutablePath();
+
+	return exePath != NULL;
+#endif
+}
+
+bool addRenderJob(const char *modulePath, const char *outPath, const renderJobSettings_t *settings)
+{
+#ifdef _WIN32
+	(void)modulePath;
+	(void)outPath;
+	(void)settings;
+
+	return false;
+#else
+	if (!renderQueueSupported())
+		return false;
+
+	if (numJobs >= RENDER_QUEUE_MAX_JOBS)
+	{
+		okBox(0, "System message", "The render queue is full! Wait for the current jobs to finish.");
+		return false;
+	}
+
+	renderJob_t *j = &jobs[numJobs];
+	memset(j, 0, sizeof (renderJob_t));
+
+	// the workers may be started later, when our current directory has changed
+	j->modulePath = getFullPath(modulePath);
+	j->outPath = getFullPath(outPath);
+
+	if (j->modulePath == NULL || j->outPath == NULL)
+	{
+		freeJob(j);
+		okBox(0, "System message", "Not enough memory!");
+		return false;
+	}
+
+	for (int32_t i = 0; i < numJobs; i++)
+	{
+		if (jobs[i].state <= RENDER_JOB_RUNNING && !strcmp(jobs[i].outPath, j->outPath))
+		{
+			freeJob(j);
+			okBox(0, "System message", "A job in the render queue is already writing to this file!");
+			return false;
+		}
+	}
+
+	j->settings = *settings;
+	j->state = RENDER_JOB_QUEUED;
+	j->fd = -1;
+	numJobs++;
+
+	updateRenderQueue(); // start it now if a worker is free
+	return true;
+#endif
+}
+
+bool updateRenderQueue(void)
+{
+#ifdef _WIN32
+	return false;
+#else
+	if (numJobs == 0)
+		return false;
+
+	bool statusChanged = false;
+	int32_t numFailed = 0;
+	renderJob_t *failedJob = NULL;
+
+	for (int32_t i = 0; i < numJobs; i++)
+	{
+		renderJob_t *j = &jobs[i];
+		if (j->state != RENDER_JOB_RUNNING)
+			continue;
+
+		if (readJobOutput(j))
+			statusChanged = true;
+
+		if (reapJob(j))
+		{
+			statusChanged = true;
+			if (j->state == RENDER_JOB_FAILED)
+			{
+				failedJob = j;
+				numFailed++;
+			}
+		}
+	}
+
+	// start queued jobs (in order) on the free workers, leave one core for the tracker
+	const int32_t maxWorkers = CLAMP(SDL_GetCPUCount() - 1, 1, RENDER_QUEUE_MAX_WORKERS);
+	int32_t numRunning = countJobs(RENDER_JOB_RUNNING);
+
+	for (int32_t i = 0; i < numJobs && numRunning < maxWorkers; i++)
+	{
+		renderJob_t *j = &jobs[i];
+		if (j->state != RENDER_JOB_QUEUED)
+			continue;
+
+		if (!startJob(j))
+		{
+			j->state = RENDER_JOB_FAILED;
+			strcpy(j->message, "Couldn't start the render process!");
+			failedJob = j;
+			numFailed++;
+		}
+		else
+		{
+			numRunning++;
+		}
+
+		statusChanged = true;
+	}
+
+	if (failedJob != NULL)
+	{
+		char text[JOB_LINE_LEN + 64];
+
+		if (numFailed > 1)
+			sprintf(text, "%d render queue jobs failed! Last error: %s", numFailed, failedJob->message);
+		else
+			sprintf(text, "Render queue job failed: %s", (failedJob->message[0] != '\0') ? failedJob->message : "unknown error");
+
+		okBox(0, "System message", text);
+	}
+
+	// the batch is done, start counting from zero again
+	if (countJobs(RENDER_JOB_QUEUED) == 0 && countJobs(RENDER_JOB_RUNNING) == 0)
+	{
+		for (int32_t i = 0; i < numJobs; i++)
+			freeJob(&jobs[i]);
+
+		numJobs = 0;
+		statusChanged = true;
+	}
+
+	return statusChanged;
+#endif
+}
+
+void getRenderQueueStatus(int32_t *outNumJobs, int32_t *jobsDone, int32_t *progress)
+{
+	*outNumJobs = numJobs;
+	*jobsDone = countJobs(RENDER_JOB_DONE) + countJobs(RENDER_JOB_FAILED);
+	*progress = 0;
+
+	// progress of the oldest running job
+	for (int32_t i = 0; i < numJobs; i++)
+	{
+		if (jobs[i].state == RENDER_JOB_RUNNING)
+		{
+			*progress = jobs[i].progress;
+			break;
+		}
+	}
+}
+
+bool getRenderJob(int32_t jobNum, const char **outPath, int32_t *state, int32_t *progress)
+{
+	if (jobNum < 0 || jobNum >= numJobs)
+		return false;
+
+	const renderJob_t *j = &jobs[jobNum];
+
+	*outPath = j->outPath;
+	*state = j->state;
+	*progress = j->progress;
+
+	return true;
+}
+
+bool renderQueueBusy(void)
+{
+	return numJobs > 0;
+}
+
+void cancelRenderJobs(void)
+{
+	for (int32_t i = 0; i < numJobs; i++)
+	{
+#ifndef _WIN32
+		if (jobs[i].state == RENDER_JOB_RUNNING)
+			stopJob(&jobs[i]);
+#endif
+		freeJob(&jobs[i]);
+	}
+
+	numJobs = 0;
+}
+
+void closeRenderQueue(void)
+{
+	cancelRenderJobs();
+
+	if (songPath != NULL)
+	{
+		free(songPath);
+		songPath = NULL;
+	}
+
+	if (exePath != NULL)
+	{
+		free(exePath);
+		exePath = NULL;
+	}
+}
+
+void setRenderQueueSongPath(const UNICHAR *pathU)
+{
+	if (songPath != NULL)
+	{
+		free(songPath);
+		songPath = NULL;
+	}
+
+#ifdef _WIN32
+	(void)pathU;
+#else
+	if (pathU != NULL)
+		songPath = realpath(pathU, NULL); // the workers don't start in our current directory
+#endif
+}
+
+const char *getRenderQueueSongPath(void)
+{
+	return songPath;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ft2_unicode.h"
+
+/* Render queue for batch exporting in the background. Every job renders a module file
+** (or a range of its song positions) with its own rate, bit depth, interpolation and
+** amplification, in a worker process running the headless "--render" mode of our own
+** executable. The replayer and mixer state is global, so a separate process is the only
+** way to keep it isolated from the song that is being played/edited. The live audio is
+** never paused, and the workers run at a lower CPU priority.
+**
+** Progress is read from the workers' stdout ("--progress"). Only call these from the
+** main thread. Not supported on Windows (yet).
+*/
+
+#define RENDER_QUEUE_MAX_JOBS 32
+#define RENDER_QUEUE_MAX_WORKERS 4
+
+enum
+{
+	RENDER_JOB_QUEUED = 0,
+	RENDER_JOB_RUNNING = 1,
+	RENDER_JOB_DONE = 2,
+	RENDER_JOB_FAILED = 3
+};
+
+typedef struct renderJobSettings_t // everything that the WAV renderer's own export uses, so the output is the same
+{
+	uint32_t freq;
+	uint8_t bitDepth, interpolation; // 16/32, INTERPOLATION_*
+	bool volumeRamp;
+	int16_t amp, masterVol, startPos, endPos; // amp = 1..32, masterVol = 0..256
+} renderJobSettings_t;
+
+bool renderQueueSupported(void); // false on Windows, or if our executable can't be found
+
+// false if the queue is full or 'outPath' is already in it (shows a message), or if not supported
+bool addRenderJob(const char *modulePath, const char *outPath, const renderJobSettings_t *settings);
+
+// call this every frame, returns true if the status changed (also shows errors from failed jobs)
+bool updateRenderQueue(void);
+
+// number of jobs in the current batch and how many of them are done, 'progress' (0..100) is for the current job
+void getRenderQueueStatus(int32_t *numJobs, int32_t *jobsDone, int32_t *progress);
+
+// for the job list, 'jobNum' is 0..numJobs-1 (in the order they were queued), false if there's no such job
+bool getRenderJob(int32_t jobNum, const char **outPath, int32_t *state, int32_t *progress);
+
+bool renderQueueBusy(void);
+void cancelRenderJobs(void); // stops the running jobs and drops the queued ones (unfinished files are deleted)
+void closeRenderQueue(void); // same, and frees everything
+
+// the file that the current song was loaded from or saved to, used when queueing the song
+void setRenderQueueSongPath(const UNICHAR *pathU);
+const char *getRenderQueueSongPath(void); // NULL if unknown
@@ -0,0 +1,157 @@
+// for finding memory leaks in debug mode with Visual Studio
+#if defined _DEBUG && defined _MSC_VER
+#include <crtdbg.h>
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "ft2_header.h"
+#include "ft2_render_writer.h"
+
+struct renderWriter_t
+{
+	FILE *files[RENDER_WRITER_MAX_FILES];
+	flacEncoder_t *encoders[RENDER_WRITER_MAX_FILES];
+	uint8_t *bufferMem, *buffers[RENDER_WRITER_MAX_BUFFERS];
+	uint32_t bufferSize, bytesQueued[RENDER_WRITER_MAX_BUFFERS];
+	int32_t numFiles, numBuffers, fillIndex, writeIndex;
+	volatile bool ioError;
+	SDL_sem *freeBuffers, *queuedBuffers;
+	SDL_Thread *thread;
+};
+
+static int32_t SDLCALL writerThread(void *ptr)
+{
+	renderWriter_t *w = (renderWriter_t *)ptr;
+
+	while (true)
+	{
+		SDL_SemWait(w->queuedBuffers);
+
+		const uint32_t numBytes = w->bytesQueued[w->writeIndex];
+		if (numBytes == 0)
+			break; // end marker from closeRenderWriter()
+
+		const uint8_t *src = w->buffers[w->writeIndex];
+		for (int32_t i = 0; i < w->numFiles && !w->ioError; i++, src += w->bufferSize)
+		{
+			if (w->encoders[i] != NULL)
+			{
+				if (!encodeFlacSamples(w->encoders[i], src, numBytes))
+					w->ioError = true;
+			}
+			else if (fwrite(src, 1, numBytes, w->files[i]) != numBytes)
+			{
+				w->ioError = true;
+			}
+		}
+
+		w->writeIndex = (w->writeIndex + 1) % w->numBuffers;
+		SDL_SemPost(w->freeBuffers);
+	}
+
+	return true;
+}
+
+static void freeRenderWriter(renderWriter_t *w)
+{
+	if (w->freeBuffers != NULL)
+		SDL_DestroySemaphore(w->freeBuffers);
+
+	if (w->queuedBuffers != NULL)
+		SDL_DestroySemaphore(w->queuedBuffers);
+
+	if (w->bufferMem != NULL)
+		free(w->bufferMem);
+
+	free(w);
+}
+
+renderWriter_t *openRenderWriter(FILE **files, flacEncoder_t **encoders, int32_t numFiles, uint32_t bufferSize, int32_t numBuffers)
+{
+	if (files == NULL || numFiles < 1 || numFiles > RENDER_WRITER_MAX_FILES || bufferSize == 0)
+		return NULL;
+
+	numBuffers = CLAMP(numBuffers, RENDER_WRITER_MIN_BUFFERS, RENDER_WRITER_MAX_BUFFERS);
+
+	renderWriter_t *w = (renderWriter_t *)calloc(1, sizeof (renderWriter_t));
+	if (w == NULL)
+		return NULL;
+
+	for (int32_t i = 0; i < numFiles; i++)
+	{
+		w->files[i] = files[i];
+		w->encoders[i] = (encoders != NULL) ? encoders[i] : NULL;
+	}
+
+	w->numFiles = numFiles;
+	w->numBuffers = numBuffers;
+	w->bufferSize = bufferSize;
+
+	const size_t bufferMemSize = (size_t)bufferSize * numFiles;
+
+	w->bufferMem = (uint8_t *)malloc(bufferMemSize * numBuffers);
+	w->freeBuffers = SDL_CreateSemaphore(numBuffers);
+	w->queuedBuffers = SDL_CreateSemaphore(0);
+
+	if (w->bufferMem == NULL || w->freeBuffers == NULL || w->queuedBuffers == NULL)
+	{
+		freeRenderWriter(w);
+		return NULL;
+	}
+
+	for (int32_t i = 0; i < numBuffers; i++)
+		w->buffers[i] = w->bufferMem + (bufferMemSize * i);
+
+	w->thread = SDL_CreateThread(writerThread, NULL, w);
+	if (w->thread == NULL)
+	{
+		freeRenderWriter(w);
+		return NULL;
+	}
+
+	return w;
+}
+
+uint8_t *getRenderWriterBuffer(renderWriter_t *w)
+{
+	SDL_SemWait(w->freeBuffers);
+	return w->buffers[w->fillIndex];
+}
+
+void queueRenderWriterBuffer(renderWriter_t *w, uint32_t numBytes)
+{
+	if (numBytes == 0) // nothing to write, give the buffer back
+	{
+		SDL_SemPost(w->freeBuffers);
+		return;
+	}
+
+	w->bytesQueued[w->fillIndex] = numBytes;
+	w->fillIndex = (w->fillIndex + 1) % w->numBuffers;
+	SDL_SemPost(w->queuedBuffers);
+}
+
+bool renderWriterFailed(renderWriter_t *w)
+{
+	return w->ioError;
+}
+
+bool closeRenderWriter(renderWriter_t *w)
+{
+	if (w == NULL)
+		return false;
+
+	// queue an empty buffer as end marker, then wait for the writer thread to finish
+	getRenderWriterBuffer(w);
+	w->bytesQueued[w->fillIndex] = 0;
+	SDL_SemPost(w->queuedBuffers);
+	SDL_WaitThread(w->thread, NULL);
+
+	const bool ok = !w->ioError;
+	freeRenderWriter(w);
+
+	return ok;
+}
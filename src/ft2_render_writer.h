@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "ft2_flac_encoder.h"
+
+/* Pipelined file writer for the song renderers. The mixer fills one chunk buffer
+** while a writer thread flushes the previous ones to disk, so slow storage doesn't
+** stall rendering (unless all buffers are waiting to be written).
+**
+** Usage: get a buffer, fill up to 'bufferSize' bytes, queue it, repeat. Buffers are
+** written in the order they were queued. Close the writer before using the FILE again.
+**
+** A writer can also feed several files at once (f.ex. one per stem). The buffer then
+** holds one 'bufferSize' part per file, file n's part starts at n*bufferSize, and
+** every part must be filled with the same number of bytes.
+**
+** If 'encoders' is given, file n's data goes through encoders[n] (if not NULL) instead
+** of being written as is. Closing the writer doesn't close the encoders.
+*/
+
+#define RENDER_WRITER_MIN_BUFFERS 2
+#define RENDER_WRITER_MAX_BUFFERS 16
+#define RENDER_WRITER_DEFAULT_BUFFERS 3
+#define RENDER_WRITER_MAX_FILES 128
+
+typedef struct renderWriter_t renderWriter_t;
+
+renderWriter_t *openRenderWriter(FILE **files, flacEncoder_t **encoders, int32_t numFiles, uint32_t bufferSize, int32_t numBuffers); // NULL on failure
+uint8_t *getRenderWriterBuffer(renderWriter_t *w); // waits until a buffer is free
+void queueRenderWriterBuffer(renderWriter_t *w, uint32_t numBytes); // the buffer from getRenderWriterBuffer(), bytes per file
+bool renderWriterFailed(renderWriter_t *w); // a write failed (f.ex. disk full), later buffers are discarded
+bool closeRenderWriter(renderWriter_t *w); // waits for all writes, returns false if any of them failed
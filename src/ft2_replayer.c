@@ -8,8 +8,12 @@
 #include <math.h>
 #include "ft2_header.h"
 #include "ft2_config.h"
+#ifndef FT2_HEADLESS
 #include "ft2_gui.h"
 #include "ft2_video.h"
+#else
+#define showErrorMsgBox(...) // libft2, no message boxes
+#endif
 #include "ft2_pattern_ed.h"
 #include "ft2_sample_ed.h"
 #include "ft2_inst_ed.h"
@@ -18,28 +22,43 @@
 #include "scopes/ft2_scopes.h"
 #include "ft2_mouse.h"
 #include "ft2_sample_loader.h"
+#include "ft2_audio.h"
+#include "ft2_pattern_pack.h"
 #include "ft2_tables.h"
 #include "ft2_structs.h"
 #include "mixer/ft2_windowed_sinc.h"
 
 static double dLogTab[4*12*16], dExp2MulTab[32];
 static bool bxxOverflow;
-static note_t nilPatternLine[MAX_CHANNELS];
+static note_t nilPatternLine[MAX_CHANNELS], replayerRowBuf[MAX_CHANNELS];
 
 typedef void (*volColumnEfxRoutine)(channel_t *ch);
 typedef void (*volColumnEfxRoutine2)(channel_t *ch, uint8_t *volColumnData);
 typedef void (*efxRoutine)(channel_t *ch, uint8_t param);
 
+typedef struct rowCmd_t // a channel's non-zero tick effects, resolved once when the row is read
+{
+	volColumnEfxRoutine volColumnEfx; // NULL = none
+	efxRoutine efx; // NULL = none
+	uint8_t efxParam;
+} rowCmd_t;
+
+// the built-in channel storage, enough for the tracker (wider songs get theirs from allocateChannels())
+static channel_t xmChannel[MAX_XM_CHANNELS];
+static rowCmd_t xmRowCmd[MAX_XM_CHANNELS], *rowCmd = xmRowCmd;
+
 // globally accessed
 int8_t playMode = 0;
 bool songPlaying = false, audioPaused = false, musicPaused = false;
 volatile bool replayerBusy = false;
 const uint16_t *note2Period = NULL;
 int16_t patternNumRows[MAX_PATTERNS];
-channel_t channel[MAX_CHANNELS];
+channel_t *channel = xmChannel;
+int32_t numAllocatedChannels = MAX_XM_CHANNELS;
 song_t song;
 instr_t *instr[128+4];
 note_t *pattern[MAX_PATTERNS];
+packedPatt_t *packedPattern[MAX_PATTERNS];
 // ----------------------------------
 
 void fixString(char *str, int32_t lastChrPos) // removes leading spaces and 0x1A chars
@@ -76,10 +95,11 @@ void resetChannels(void)
 	if (audioWasntLocked)
 		lockAudio();
 
-	memset(channel, 0, sizeof (channel));
+	memset(channel, 0, numAllocatedChannels * sizeof (channel_t));
+	memset(rowCmd, 0, numAllocatedChannels * sizeof (rowCmd_t));
 
 	channel_t *ch = channel;
-	for (int32_t i = 0; i < MAX_CHANNELS; i++, ch++)
+	for (int32_t i = 0; i < numAllocatedChannels; i++, ch++)
 	{
 		ch->instrPtr = instr[0];
 		ch->status = IS_Vol;
@@ -94,6 +114,83 @@ void resetChannels(void)
 		unlockAudio();
 }
 
+bool allocateChannels(int32_t numChannels)
+{
+	numChannels = CLAMP(numChannels, MAX_XM_CHANNELS, MAX_CHANNELS);
+	if (numChannels == numAllocatedChannels)
+		return true;
+
+	channel_t *newChannel = xmChannel;
+	rowCmd_t *newRowCmd = xmRowCmd;
+
+	if (numChannels > MAX_XM_CHANNELS)
+	{
+		newChannel = (channel_t *)malloc(numChannels * sizeof (channel_t));
+		newRowCmd = (rowCmd_t *)malloc(numChannels * sizeof (rowCmd_t));
+
+		if (newChannel == NULL || newRowCmd == NULL)
+		{
+			free(newChannel);
+			free(newRowCmd);
+			return false;
+		}
+	}
+
+	const bool audioWasntLocked = !audio.locked;
+	if (audioWasntLocked)
+		lockAudio();
+
+	if (!allocateVoices(numChannels))
+	{
+		if (audioWasntLocked)
+			unlockAudio();
+
+		if (newChannel != xmChannel)
+		{
+			free(newChannel);
+			free(newRowCmd);
+		}
+
+		return false;
+	}
+
+	if (channel != xmChannel)
+	{
+		free(channel);
+		free(rowCmd);
+	}
+
+	channel = newChannel;
+	rowCmd = newRowCmd;
+	numAllocatedChannels = numChannels;
+	resetChannels();
+
+	if (audioWasntLocked)
+		unlockAudio();
+
+	return true;
+}
+
+void setChannelMute(channel_t *ch, bool mute)
+{
+	ch->channelOff = mute;
+	if (ch->channelOff)
+	{
+		ch->efx = 0;
+		ch->efxData = 0;
+		ch->realVol = 0;
+		ch->outVol = 0;
+		ch->oldVol = 0;
+		ch->dFinalVol = 0.0;
+		ch->outPan = 128;
+		ch->oldPan = 128;
+		ch->finalPan = 128;
+		ch->status = IS_Vol;
+
+		ch->keyOff = true; // non-FT2 bug fix for stuck piano keys
+	}
+}
+
 void setSongModifiedFlag(void)
 {
 	song.isModified = true;
@@ -176,6 +273,7 @@ void tuneSample(sample_t *s, const int32_t midCFreq, bool linearPeriodsFlag)
 	s->relativeNote = (int8_t)(((period & ~31) >> 4) - NOTE_C4);
 }
 
+#ifndef FT2_HEADLESS
 void setPatternLen(uint16_t pattNum, int16_t numRows)
 {
 	assert(pattNum < MAX_PATTERNS);
@@ -188,7 +286,7 @@ void setPatternLen(uint16_t pattNum, int16_t numRows)
 
 	patternNumRows[pattNum] = numRows;
 
-	if (pattern[pattNum] != NULL)
+	if (pattern[pattNum] != NULL || packedPattern[pattNum] != NULL) // a packed one can be empty in its new length too
 		killPatternIfUnused(pattNum);
 
 	// non-FT2 security
@@ -213,6 +311,7 @@ void setPatternLen(uint16_t pattNum, int16_t numRows)
 	ui.updatePatternEditor = true;
 	ui.updatePosSections = true;
 }
+#endif
 
 int16_t getUsedSamples(int16_t smpNum)
 {
@@ -308,6 +407,7 @@ void setLinearPeriods(bool linearPeriodsFlag)
 
 	resumeAudio();
 
+#ifndef FT2_HEADLESS
 	if (ui.configScreenShown && editor.currConfigScreen == CONFIG_SCREEN_AUDIO)
 	{
 		// update "frequency slides" radiobutton, if it's shown
@@ -317,6 +417,7 @@ void setLinearPeriods(bool linearPeriodsFlag)
 	// update mid-C freq. in instr. editor (it can slightly differ between Amiga/linear)
 	if (ui.instEditorShown)
 		drawC4Rate();
+#endif
 }
 
 static void retrigVolume(channel_t *ch)
@@ -411,8 +512,11 @@ void calcReplayerVars(int32_t audioFreq)
 	if (audioFreq <= 0)
 		return;
 
-	audio.dHz2MixDeltaMul = (double)MIXER_FRAC_SCALE / audioFreq;
-	audio.quickVolRampSamples = (uint32_t)round(audioFreq / (double)FT2_QUICKRAMP_SAMPLES);
+	// the voices are mixed at twice the rate when oversampling (the tick lengths stay at the output rate)
+	const int32_t mixFreq = audio.oversamplingFlag ? (audioFreq * 2) : audioFreq;
+
+	audio.dHz2MixDeltaMul = (double)MIXER_FRAC_SCALE / mixFreq;
+	audio.quickVolRampSamples = (uint32_t)round(mixFreq / (double)FT2_QUICKRAMP_SAMPLES);
 
 	for (int32_t bpm = MIN_BPM; bpm <= MAX_BPM; bpm++)
 	{
@@ -2144,19 +2248,50 @@ static const efxRoutine JumpTab_TickNonZero[36] =
 	dummy  // Z
 };
 
-static void handleEffects_TickNonZero(channel_t *ch)
+/* Resolves the channel's volume column and effect routines for the non-zero ticks.
+** Must be called whenever ch->volColumnVol, ch->efx or ch->efxData changes.
+*/
+static void decodeRowCmd(int32_t chNum)
 {
-	if (ch->channelOff)
-		return; // muted
+	const channel_t *ch = &channel[chNum];
+	rowCmd_t *cmd = &rowCmd[chNum];
 
 	// volume column effects
-	VJumpTab_TickNonZero[ch->volColumnVol >> 4](ch);
+	cmd->volColumnEfx = VJumpTab_TickNonZero[ch->volColumnVol >> 4];
+	if (cmd->volColumnEfx == v_dummy)
+		cmd->volColumnEfx = NULL;
 
 	// normal effects
+	cmd->efx = NULL;
+	cmd->efxParam = ch->efxData;
+
 	if ((ch->efx == 0 && ch->efxData == 0) || ch->efx > 35)
 		return; // no effect
 
-	JumpTab_TickNonZero[ch->efx](ch, ch->efxData);
+	if (ch->efx == 0x0E) // resolve Exy right away
+	{
+		cmd->efx = EJumpTab_TickNonZero[ch->efxData >> 4];
+		cmd->efxParam = ch->efxData & 0xF;
+	}
+	else
+	{
+		cmd->efx = JumpTab_TickNonZero[ch->efx];
+	}
+
+	if (cmd->efx == dummy)
+		cmd->efx = NULL;
+}
+
+static void handleEffects_TickNonZero(channel_t *ch, const rowCmd_t *cmd)
+{
+	if (ch->channelOff)
+		return; // muted
+
+	if (cmd->volColumnEfx != NULL)
+		cmd->volColumnEfx(ch);
+
+	if (cmd->efx != NULL)
+		cmd->efx(ch, cmd->efxParam);
 }
 
 static void getNextPos(void)
@@ -2274,23 +2409,28 @@ void tickReplayer(void) // periodically called from audio callback
 		song.curReplayerSongPos = (uint8_t)song.songPos;
 		// ----------------------------------------------
 
-		const note_t *p = nilPatternLine;
-		if (pattern[song.pattNum] != NULL)
-			p = &pattern[song.pattNum][song.row * MAX_CHANNELS];
+		const note_t *p = getPatternRow(song.pattNum, song.row, replayerRowBuf);
+		if (p == NULL)
+			p = nilPatternLine;
 
 		ch = channel;
 		for (i = 0; i < song.numChannels; i++, ch++, p++)
 		{
 			getNewNote(ch, p);
+			decodeRowCmd(i);
 			updateChannel(ch);
 		}
 	}
 	else
 	{
+		// channels are still updated in order, as effects like Hxy affect the channels after them
 		ch = channel;
-		for (i = 0; i < song.numChannels; i++, ch++)
+		const rowCmd_t *cmd = rowCmd;
+		for (i = 0; i < song.numChannels; i++, ch++, cmd++)
 		{
-			handleEffects_TickNonZero(ch);
+			if (cmd->volColumnEfx != NULL || cmd->efx != NULL)
+				handleEffects_TickNonZero(ch, cmd);
+
 			updateChannel(ch);
 		}
 	}
@@ -2298,6 +2438,33 @@ void tickReplayer(void) // periodically called from audio callback
 	getNextPos();
 }
 
+bool dump_EndOfTune(int16_t endSongPos)
+{
+	bool returnValue = (editor.wavReachedEndFlag && song.row == 0 && song.tick == 1) || (song.speed == 0);
+
+	// FT2 bugfix for EEx (pattern delay) on first row of a pattern
+	if (song.pattDelTime2 > 0)
+		returnValue = false;
+
+	if (song.songPos == endSongPos && song.row == 0 && song.tick == 1)
+		editor.wavReachedEndFlag = true;
+
+	return returnValue;
+}
+
+void dump_TickReplayer(void)
+{
+	replayerBusy = true;
+
+	if (audio.volumeRampingFlag)
+		resetRampVolumes();
+
+	tickReplayer();
+	updateVoices();
+
+	replayerBusy = false;
+}
+
 void resetMusic(void)
 {
 	const bool audioWasntLocked = !audio.locked;
@@ -2312,11 +2479,13 @@ void resetMusic(void)
 
 	setPos(0, 0, false);
 
+#ifndef FT2_HEADLESS
 	if (!songPlaying)
 	{
 		setScrollBarEnd(SB_POS_ED, (song.songLength - 1) + 5);
 		setScrollBarPos(SB_POS_ED, 0, false);
 	}
+#endif
 }
 
 void setPos(int16_t songPos, int16_t row, bool resetTimer)
@@ -2335,7 +2504,9 @@ void setPos(int16_t songPos, int16_t row, bool resetTimer)
 		assert(song.pattNum < MAX_PATTERNS);
 		song.currNumRows = patternNumRows[song.pattNum];
 
+#ifndef FT2_HEADLESS
 		checkMarkLimits(); // non-FT2 safety
+#endif
 	}
 
 	if (row > -1)
@@ -2477,6 +2648,272 @@ void samp2Delta(int8_t *p, int32_t length, uint8_t smpFlags)
 	}
 }
 
+static int32_t myMod(int32_t a, int32_t b) // works on negative numbers!
+{
+	int32_t c = a % b;
+	return (c < 0) ? (c + b) : c;
+}
+
+// modifies samples before index 0, and after loop/end (for branchless mixer interpolation (kinda))
+void fixSample(sample_t *s)
+{
+	int32_t pos;
+	bool backwards;
+
+	assert(s != NULL);
+	if (s->dataPtr == NULL || s->length <= 0)
+	{
+		s->isFixed = false;
+		s->fixedPos = 0;
+		return; // empty sample
+	}
+
+	const bool sample16Bit = !!(s->flags & SAMPLE_16BIT);
+	int16_t *ptr16 = (int16_t *)s->dataPtr;
+	uint8_t loopType = GET_LOOPTYPE(s->flags);
+	int32_t length = s->length;
+	int32_t loopStart = s->loopStart;
+	int32_t loopLength = s->loopLength;
+	int32_t loopEnd = s->loopStart + s->loopLength;
+
+	// treat loop as disabled if loopLen == 0 (FT2 does this)
+	if (loopType != 0 && loopLength <= 0)
+	{
+		loopType = 0;
+		loopStart = loopLength = loopEnd = 0;
+	}
+
+	/* All negative taps should be equal to the first sample point when at sampling
+	** position #0 (on sample trigger), until an eventual loop cycle, where we do
+	** a special left edge case with replaced tap data.
+	** The sample pointer is offset and has allocated data before it, so this is
+	** safe.
+	*/
+	if (sample16Bit)
+	{
+		for (int32_t i = 0; i < SINC_MAX_LEFT_TAPS; i++)
+			ptr16[i-SINC_MAX_LEFT_TAPS] = ptr16[0];
+	}
+	else
+	{
+		for (int32_t i = 0; i < SINC_MAX_LEFT_TAPS; i++)
+			s->dataPtr[i-SINC_MAX_LEFT_TAPS] = s->dataPtr[0];
+	}
+
+	if (loopType == LOOP_OFF) // no loop
+	{
+		if (sample16Bit)
+		{
+			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
+				ptr16[length+i] = ptr16[length-1];
+		}
+		else
+		{
+			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
+				s->dataPtr[length+i] = s->dataPtr[length-1];
+		}
+
+		s->fixedPos = 0; // this value is not used for non-looping samples, set to zero
+		s->isFixed = false; // no fixed samples inside actual sample data
+		return;
+	}
+
+	s->fixedPos = loopEnd;
+	s->isFixed = true;
+
+	if (loopType == LOOP_FWD) // forward loop
+	{
+		if (sample16Bit)
+		{
+			// left edge (we need SINC_MAX_TAPS amount of taps starting from the center tap)
+			for (int32_t i = -SINC_MAX_LEFT_TAPS; i < SINC_MAX_TAPS; i++)
+			{
+				pos = loopStart + myMod(i, loopLength);
+				s->leftEdgeTapSamples16[SINC_MAX_LEFT_TAPS+i] = ptr16[pos];
+			}
+
+			// right edge (change actual sample data since data after loop is never used)
+			pos = loopStart;
+			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
+			{
+				s->fixedSmp[i] = ptr16[loopEnd+i];
+				ptr16[loopEnd+i] = ptr16[pos];
+
+				if (++pos >= loopEnd)
+					pos -= loopLength;
+			}
+		}
+		else // 8-bit
+		{
+			// left edge (we need SINC_MAX_TAPS amount of taps starting from the center tap)
+			for (int32_t i = -SINC_MAX_LEFT_TAPS; i < SINC_MAX_TAPS; i++)
+			{
+				pos = loopStart + myMod(i, loopLength);
+				s->leftEdgeTapSamples8[SINC_MAX_LEFT_TAPS+i] = s->dataPtr[pos];
+			}
+
+			// right edge (change actual sample data since data after loop is never used)
+			pos = loopStart;
+			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
+			{
+				s->fixedSmp[i] = s->dataPtr[loopEnd+i];
+				s->dataPtr[loopEnd+i] = s->dataPtr[pos];
+
+				if (++pos >= loopEnd)
+					pos -= loopLength;
+			}
+		}
+	}
+	else // pingpong loop
+	{
+		if (sample16Bit)
+		{
+			// left edge (positive taps, we need SINC_MAX_TAPS amount of taps starting from the center tap)
+			pos = loopStart;
+			backwards = false;
+			for (int32_t i = 0; i < SINC_MAX_TAPS; i++)
+			{
+				if (backwards)
+				{
+					if (pos < loopStart)
+					{
+						pos = loopStart;
+						backwards = false;
+					}
+				}
+				else if (pos >= loopEnd) // forwards
+				{
+					pos = loopEnd-1;
+					backwards = true;
+				}
+
+				s->leftEdgeTapSamples16[SINC_MAX_LEFT_TAPS+i] = ptr16[pos];
+
+				if (backwards)
+					pos--;
+				else
+					pos++;
+			}
+
+			// left edge (negative taps)
+			for (int32_t i = 0; i < SINC_MAX_LEFT_TAPS; i++)
+				s->leftEdgeTapSamples16[(SINC_MAX_LEFT_TAPS-1)-i] = s->leftEdgeTapSamples16[SINC_MAX_LEFT_TAPS+1+i];
+
+			// right edge (change actual sample data since data after loop is never used)
+			pos = loopEnd-1;
+			backwards = true;
+			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
+			{
+				if (backwards)
+				{
+					if (pos < loopStart)
+					{
+						pos = loopStart;
+						backwards = false;
+					}
+				}
+				else if (pos >= loopEnd) // forwards
+				{
+					pos = loopEnd-1;
+					backwards = true;
+				}
+
+				s->fixedSmp[i] = ptr16[loopEnd+i];
+				ptr16[loopEnd+i] = ptr16[pos];
+
+				if (backwards)
+					pos--;
+				else
+					pos++;
+			}
+		}
+		else // 8-bit
+		{
+			// left edge (positive taps, we need SINC_MAX_TAPS amount of taps starting from the center tap)
+			pos = loopStart;
+			backwards = false;
+			for (int32_t i = 0; i < SINC_MAX_TAPS; i++)
+			{
+				if (backwards)
+				{
+					if (pos < loopStart)
+					{
+						pos = loopStart;
+						backwards = false;
+					}
+				}
+				else if (pos >= loopEnd) // forwards
+				{
+					pos = loopEnd-1;
+					backwards = true;
+				}
+
+				s->leftEdgeTapSamples8[SINC_MAX_LEFT_TAPS+i] = s->dataPtr[pos];
+
+				if (backwards)
+					pos--;
+				else
+					pos++;
+			}
+
+			// left edge (negative taps)
+			for (int32_t i = 0; i < SINC_MAX_LEFT_TAPS; i++)
+				s->leftEdgeTapSamples8[(SINC_MAX_LEFT_TAPS-1)-i] = s->leftEdgeTapSamples8[SINC_MAX_LEFT_TAPS+1+i];
+
+			// right edge (change actual sample data since data after loop is never used)
+			pos = loopEnd-1;
+			backwards = true;
+			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
+			{
+				if (backwards)
+				{
+					if (pos < loopStart)
+					{
+						pos = loopStart;
+						backwards = false;
+					}
+				}
+				else if (pos >= loopEnd) // forwards
+				{
+					pos = loopEnd-1;
+					backwards = true;
+				}
+
+				s->fixedSmp[i] = s->dataPtr[loopEnd+i];
+				s->dataPtr[loopEnd+i] = s->dataPtr[pos];
+
+				if (backwards)
+					pos--;
+				else
+					pos++;
+			}
+		}
+	}
+}
+
+// restores interpolation tap samples after loop/end
+void unfixSample(sample_t *s)
+{
+	assert(s != NULL);
+	if (s->dataPtr == NULL || !s->isFixed)
+		return; // empty sample or not fixed (f.ex. no loop)
+
+	if (s->flags & SAMPLE_16BIT)
+	{
+		int16_t *ptr16 = (int16_t *)s->dataPtr + s->fixedPos;
+		for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
+			ptr16[i] = s->fixedSmp[i];
+	}
+	else // 8-bit
+	{
+		int8_t *ptr8 = s->dataPtr + s->fixedPos;
+		for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
+			ptr8[i] = (int8_t)s->fixedSmp[i];
+	}
+
+	s->isFixed = false;
+}
+
 bool allocateInstr(int16_t insNum)
 {
 	if (instr[insNum] != NULL)
@@ -2559,18 +2996,173 @@ void freeSample(int16_t insNum, int16_t smpNum)
 	resumeAudio();
 }
 
+void freePattern(uint16_t pattNum) // lock the mixer first if the song is playing
+{
+	if (pattern[pattNum] != NULL)
+	{
+		free(pattern[pattNum]);
+		pattern[pattNum] = NULL;
+	}
+
+	if (packedPattern[pattNum] != NULL)
+	{
+		free(packedPattern[pattNum]);
+		packedPattern[pattNum] = NULL;
+	}
+}
+
 void freeAllPatterns(void)
 {
 	pauseAudio();
+	for (int32_t i = 0; i < MAX_PATTERNS; i++)
+		freePattern((uint16_t)i);
+	resumeAudio();
+}
+
+/* Patterns can be kept packed in memory (see ft2_pattern_pack.c), then pattern[x]
+** is NULL and packedPattern[x] holds the data. The replayer and pattern drawing
+** read rows through getPatternRow(), anything that edits a pattern must unpack it
+** first (allocatePattern() and getEditPattern() in the pattern editor do this).
+*/
+bool packPattern(uint16_t pattNum)
+{
+	if (pattern[pattNum] == NULL)
+		return true; // empty or already packed
+
+	packedPatt_t *pp = encodePackedPattern(pattern[pattNum], song.numChannels);
+	if (pp == NULL)
+		return false; // doesn't pack (or out of memory), keep it unpacked
+
+	note_t *oldPatt = pattern[pattNum];
+
+	const bool audioWasntLocked = !audio.locked;
+	if (audioWasntLocked)
+		lockAudio();
+
+	pattern[pattNum] = NULL;
+	if (pp->numRows > 0)
+	{
+		packedPattern[pattNum] = pp;
+		pp = NULL;
+	}
+
+	if (audioWasntLocked)
+		unlockAudio();
+
+	if (pp != NULL) // pattern was empty
+		free(pp);
+
+	free(oldPatt);
+	return true;
+}
+
+void packAllPatterns(void)
+{
+	for (int32_t i = 0; i < MAX_PATTERNS; i++)
+		packPattern((uint16_t)i);
+}
+
+bool unpackPattern(uint16_t pattNum)
+{
+	packedPatt_t *pp = packedPattern[pattNum];
+	if (pp == NULL)
+		return true; // empty or already unpacked
+
+	assert(pp->numChannels == song.numChannels);
+
+	note_t *p = (note_t *)calloc((MAX_PATT_LEN * TRACK_WIDTH(song.numChannels)) + 16, 1);
+	if (p == NULL)
+		return false;
+
+	decodePackedPattern(pp, p);
+
+	const bool audioWasntLocked = !audio.locked;
+	if (audioWasntLocked)
+		lockAudio();
+
+	pattern[pattNum] = p;
+	packedPattern[pattNum] = NULL;
+
+	if (audioWasntLocked)
+		unlockAudio();
+
+	free(pp);
+	return true;
+}
+
+bool unpackAllPatterns(void) // for operations that work on the whole song
+{
+	for (int32_t i = 0; i < MAX_PATTERNS; i++)
+	{
+		if (!unpackPattern((uint16_t)i))
+			return false;
+	}
+
+	return true;
+}
+
+const note_t *getPatternRow(uint16_t pattNum, int16_t row, note_t *rowBuf) // rowBuf must hold song.numChannels notes
+{
+	if (pattern[pattNum] != NULL)
+		return &pattern[pattNum][row * song.numChannels];
+
+	if (packedPattern[pattNum] != NULL)
+	{
+		decodePackedRow(packedPattern[pattNum], row, rowBuf);
+		return rowBuf;
+	}
+
+	return NULL;
+}
+
+/* Patterns are stored at the song's actual channel width, so changing the number
+** of channels means re-striding every allocated pattern. Channels beyond the new
+** width are lost. Lock the mixer first if these are the live song patterns.
+*/
+bool resizePatternChannels(note_t **patt, int32_t oldNumChannels, int32_t newNumChannels)
+{
+	note_t *newPatt[MAX_PATTERNS];
+
+	if (oldNumChannels == newNumChannels)
+		return true;
+
+	// allocate everything first, so that we can bail out without touching the song
 	for (int32_t i = 0; i < MAX_PATTERNS; i++)
 	{
-		if (pattern[i] != NULL)
+		newPatt[i] = NULL;
+		if (patt[i] == NULL)
+			continue;
+
+		newPatt[i] = (note_t *)calloc((MAX_PATT_LEN * TRACK_WIDTH(newNumChannels)) + 16, 1);
+		if (newPatt[i] == NULL)
 		{
-			free(pattern[i]);
-			pattern[i] = NULL;
+			for (int32_t j = 0; j < i; j++)
+			{
+				if (newPatt[j] != NULL)
+					free(newPatt[j]);
+			}
+
+			return false;
 		}
 	}
-	resumeAudio();
+
+	const int32_t copyWidth = TRACK_WIDTH(MIN(oldNumChannels, newNumChannels));
+	for (int32_t i = 0; i < MAX_PATTERNS; i++)
+	{
+		if (patt[i] == NULL)
+			continue;
+
+		const note_t *src = patt[i];
+		note_t *dst = newPatt[i];
+
+		for (int32_t row = 0; row < MAX_PATT_LEN; row++, src += oldNumChannels, dst += newNumChannels)
+			memcpy(dst, src, copyWidth);
+
+		free(patt[i]);
+		patt[i] = newPatt[i];
+	}
+
+	return true;
 }
 
 void setStdEnvelope(instr_t *ins, int16_t i, uint8_t type)
@@ -2578,6 +3170,10 @@ void setStdEnvelope(instr_t *ins, int16_t i, uint8_t type)
 	if (ins == NULL)
 		return;
 
+#ifdef FT2_HEADLESS
+	(void)i; // no config (with the standard envelopes) here
+	(void)type;
+#else
 	pauseMusic();
 
 	if (type & 1)
@@ -2606,6 +3202,7 @@ void setStdEnvelope(instr_t *ins, int16_t i, uint8_t type)
 	}
 
 	resumeMusic();
+#endif
 }
 
 void setNoEnvelope(instr_t *ins)
@@ -2613,20 +3210,24 @@ void setNoEnvelope(instr_t *ins)
 	if (ins == NULL)
 		return;
 
-	pauseMusic();
+#ifndef FT2_HEADLESS
+	pauseMusic(); // libft2 only calls this from the loaders, which mustn't pause other threads' playback
 
 	memcpy(ins->volEnvPoints, config.stdEnvPoints[0][0], 2*2*12);
 	ins->volEnvLength = (uint8_t)config.stdVolEnvLength[0];
 	ins->volEnvSustain = (uint8_t)config.stdVolEnvSustain[0];
 	ins->volEnvLoopStart = (uint8_t)config.stdVolEnvLoopStart[0];
 	ins->volEnvLoopEnd = (uint8_t)config.stdVolEnvLoopEnd[0];
+#endif
 	ins->volEnvFlags = 0;
 
+#ifndef FT2_HEADLESS
 	memcpy(ins->panEnvPoints, config.stdEnvPoints[0][1], 2*2*12);
 	ins->panEnvLength = (uint8_t)config.stdPanEnvLength[0];
 	ins->panEnvSustain = (uint8_t)config.stdPanEnvSustain[0];
 	ins->panEnvLoopStart = (uint8_t)config.stdPanEnvLoopStart[0];
 	ins->panEnvLoopEnd = (uint8_t)config.stdPanEnvLoopEnd[0];
+#endif
 	ins->panEnvFlags = 0;
 
 	ins->fadeout = 0;
@@ -2635,16 +3236,23 @@ void setNoEnvelope(instr_t *ins)
 	ins->autoVibSweep = 0;
 	ins->autoVibType = 0;
 
+#ifndef FT2_HEADLESS
 	resumeMusic();
+#endif
 }
 
 bool patternEmpty(uint16_t pattNum)
 {
 	if (pattern[pattNum] == NULL)
+	{
+		if (packedPattern[pattNum] != NULL)
+			return packedRowsEmpty(packedPattern[pattNum], patternNumRows[pattNum]);
+
 		return true;
+	}
 
 	const uint8_t *scanPtr = (const uint8_t *)pattern[pattNum];
-	const uint32_t scanLen = patternNumRows[pattNum] * TRACK_WIDTH;
+	const uint32_t scanLen = patternNumRows[pattNum] * TRACK_WIDTH(song.numChannels);
 
 	for (uint32_t i = 0; i < scanLen; i++)
 	{
@@ -2655,6 +3263,7 @@ bool patternEmpty(uint16_t pattNum)
 	return true;
 }
 
+#ifndef FT2_HEADLESS
 void updateChanNums(void)
 {
 	assert(!(song.numChannels & 1));
@@ -2700,6 +3309,7 @@ void updateChanNums(void)
 	if (cursor.ch >= ui.channelOffset+ui.numChannelsShown)
 		cursor.ch = ui.channelOffset+ui.numChannelsShown - 1;
 }
+#endif
 
 void conv8BitSample(int8_t *p, int32_t length, bool stereo) // changes sample sign
 {
@@ -2829,6 +3439,7 @@ bool setupReplayer(void)
 	return true;
 }
 
+#ifndef FT2_HEADLESS
 void startPlaying(int8_t mode, int16_t row)
 {
 	lockMixerCallback();
@@ -2872,8 +3483,8 @@ void stopPlaying(void)
 	}
 	else
 	{
-		for (uint8_t i = 0; i < MAX_CHANNELS; i++)
-			playTone(i, 0, NOTE_OFF, -1, 0, 0);
+		for (int32_t i = 0; i < numAllocatedChannels; i++)
+			playTone((uint8_t)i, 0, NOTE_OFF, -1, 0, 0);
 	}
 
 	// if song was playing, update local row (fixes certain glitches)
@@ -2908,7 +3519,7 @@ void playTone(uint8_t chNum, uint8_t insNum, uint8_t note, int8_t vol, uint16_t
 	if (ins == NULL)
 		return;
 
-	assert(chNum < MAX_CHANNELS && insNum <= MAX_INST && note <= NOTE_OFF);
+	assert(chNum < numAllocatedChannels && insNum <= MAX_INST && note <= NOTE_OFF);
 	channel_t *ch = &channel[chNum];
 
 	// FT2 bugfix: Don't play tone if certain requirements are not met
@@ -2936,6 +3547,7 @@ void playTone(uint8_t chNum, uint8_t insNum, uint8_t note, int8_t vol, uint16_t
 	ch->noteData = (ch->noteData & 0xFF00) | note;
 	ch->efx = 0;
 	ch->efxData = 0;
+	decodeRowCmd(chNum);
 
 	startTone(note, 0, 0, ch);
 
@@ -2956,6 +3568,7 @@ void playTone(uint8_t chNum, uint8_t insNum, uint8_t note, int8_t vol, uint16_t
 	ch->midiPitch = midiPitch;
 
 	updateChannel(ch);
+	queueLiveVoiceEvent(chNum);
 
 	unlockAudio();
 }
@@ -2972,7 +3585,7 @@ void playSample(uint8_t chNum, uint8_t insNum, uint8_t smpNum, uint8_t note, uin
 	editor.curPlayInstr = 255;
 	editor.curPlaySmp = 255;
 
-	assert(chNum < MAX_CHANNELS && insNum <= MAX_INST && smpNum < MAX_SMP_PER_INST && note <= NOTE_OFF);
+	assert(chNum < numAllocatedChannels && insNum <= MAX_INST && smpNum < MAX_SMP_PER_INST && note <= NOTE_OFF);
 	channel_t *ch = &channel[chNum];
 
 	memcpy(&instr[130]->smp[0], &instr[insNum]->smp[smpNum], sizeof (sample_t));
@@ -2984,6 +3597,7 @@ void playSample(uint8_t chNum, uint8_t insNum, uint8_t smpNum, uint8_t note, uin
 	ch->instrNum = 130;
 	ch->noteData = (ch->instrNum << 8) | note;
 	ch->efx = 0;
+	decodeRowCmd(chNum);
 
 	startTone(note, 0, 0, ch);
 
@@ -3001,6 +3615,7 @@ void playSample(uint8_t chNum, uint8_t insNum, uint8_t smpNum, uint8_t note, uin
 	ch->midiPitch = midiPitch;
 
 	updateChannel(ch);
+	queueLiveVoiceEvent(chNum);
 
 	unlockAudio();
 
@@ -3023,7 +3638,7 @@ void playRange(uint8_t chNum, uint8_t insNum, uint8_t smpNum, uint8_t note, uint
 	editor.curPlayInstr = 255;
 	editor.curPlaySmp = 255;
 
-	assert(chNum < MAX_CHANNELS && insNum <= MAX_INST && smpNum < MAX_SMP_PER_INST && note <= NOTE_OFF);
+	assert(chNum < numAllocatedChannels && insNum <= MAX_INST && smpNum < MAX_SMP_PER_INST && note <= NOTE_OFF);
 
 	channel_t *ch = &channel[chNum];
 	sample_t *s = &instr[130]->smp[0];
@@ -3045,6 +3660,7 @@ void playRange(uint8_t chNum, uint8_t insNum, uint8_t smpNum, uint8_t note, uint
 	ch->noteData = (ch->instrNum << 8) | note;
 	ch->efx = 0;
 	ch->efxData = 0;
+	decodeRowCmd(chNum);
 
 	startTone(note, 0, 0, ch);
 
@@ -3064,6 +3680,7 @@ void playRange(uint8_t chNum, uint8_t insNum, uint8_t smpNum, uint8_t note, uint
 	ch->midiPitch = midiPitch;
 
 	updateChannel(ch);
+	queueLiveVoiceEvent(chNum);
 
 	unlockAudio();
 
@@ -3073,6 +3690,7 @@ void playRange(uint8_t chNum, uint8_t insNum, uint8_t smpNum, uint8_t note, uint
 	editor.curPlayInstr = editor.curInstr;
 	editor.curPlaySmp = editor.curSmp;
 }
+#endif
 
 void stopVoices(void)
 {
@@ -3080,11 +3698,17 @@ void stopVoices(void)
 	if (audioWasntLocked)
 		lockAudio();
 
-	channel_t *ch = channel;
-	for (int32_t i = 0; i < MAX_CHANNELS; i++, ch++)
+#ifndef FT2_HEADLESS
+	for (int32_t i = 0; i < MAX_XM_CHANNELS; i++) // the scopes only show the tracker's channels
 	{
 		lastChInstr[i].smpNum = 255;
 		lastChInstr[i].instrNum = 255;
+	}
+#endif
+
+	channel_t *ch = channel;
+	for (int32_t i = 0; i < numAllocatedChannels; i++, ch++)
+	{
 
 		ch->noteData = 0;
 		ch->relativeNote = 0;
@@ -3108,16 +3732,21 @@ void stopVoices(void)
 		stopVoice(i);
 	}
 
+#ifndef FT2_HEADLESS
 	// for sampling playback line in Smp. Ed.
 	editor.curPlayInstr = 255;
 	editor.curPlaySmp = 255;
 
 	stopAllScopes();
+#endif
 	resetAudioDither();
 	resetCachedMixerVars();
+	resetOversamplingFilter();
 
+#ifndef FT2_HEADLESS
 	// wait for scope thread to finish, so that we know pointers aren't deprecated
 	while (editor.scopeThreadBusy);
+#endif
 
 	if (audioWasntLocked)
 		unlockAudio();
@@ -3129,6 +3758,7 @@ void resetReplayerState(void)
 	song.posJumpFlag = false;
 	song.pBreakPos = 0;
 	song.pBreakFlag = false;
+	bxxOverflow = false;
 
 	// reset pattern loops (E6x)
 	channel_t *ch = channel;
@@ -3149,6 +3779,103 @@ void resetReplayerState(void)
 	}
 }
 
+struct replayerState_t
+{
+	song_t song;
+	channel_t *channel; // swapped, not copied
+	rowCmd_t *rowCmd;
+	int32_t numAllocatedChannels;
+	int8_t playMode;
+	bool songPlaying, musicPaused, bxxOverflow, wavReachedEndFlag;
+};
+
+static void storeReplayerState(replayerState_t *s)
+{
+	s->song = song;
+	s->channel = channel;
+	s->rowCmd = rowCmd;
+	s->numAllocatedChannels = numAllocatedChannels;
+	s->playMode = playMode;
+	s->songPlaying = songPlaying;
+	s->musicPaused = musicPaused;
+	s->bxxOverflow = bxxOverflow;
+	s->wavReachedEndFlag = editor.wavReachedEndFlag;
+}
+
+static void loadReplayerState(const replayerState_t *s)
+{
+	song = s->song;
+	channel = s->channel;
+	rowCmd = s->rowCmd;
+	numAllocatedChannels = s->numAllocatedChannels;
+	playMode = s->playMode;
+	songPlaying = s->songPlaying;
+	musicPaused = s->musicPaused;
+	bxxOverflow = s->bxxOverflow;
+	editor.wavReachedEndFlag = s->wavReachedEndFlag;
+}
+
+replayerState_t *copyReplayerState(int32_t numChannels)
+{
+	numChannels = CLAMP(numChannels, MAX_XM_CHANNELS, MAX_CHANNELS);
+
+	replayerState_t *s = (replayerState_t *)malloc(sizeof (replayerState_t));
+	channel_t *newChannel = (channel_t *)calloc(numChannels, sizeof (channel_t));
+	rowCmd_t *newRowCmd = (rowCmd_t *)calloc(numChannels, sizeof (rowCmd_t));
+
+	if (s == NULL || newChannel == NULL || newRowCmd == NULL)
+	{
+		free(s);
+		free(newChannel);
+		free(newRowCmd);
+		return NULL;
+	}
+
+	const bool audioWasntLocked = !audio.locked;
+	if (audioWasntLocked)
+		lockAudio();
+
+	storeReplayerState(s);
+
+	const int32_t numCopied = MIN(numChannels, numAllocatedChannels);
+	memcpy(newChannel, channel, numCopied * sizeof (channel_t));
+	memcpy(newRowCmd, rowCmd, numCopied * sizeof (rowCmd_t));
+
+	if (audioWasntLocked)
+		unlockAudio();
+
+	s->channel = newChannel;
+	s->rowCmd = newRowCmd;
+	s->numAllocatedChannels = numChannels;
+
+	return s;
+}
+
+void freeReplayerState(replayerState_t *s)
+{
+	if (s == NULL)
+		return;
+
+	if (s->channel != xmChannel) // only if it's still swapped in, which it shouldn't be
+	{
+		free(s->channel);
+		free(s->rowCmd);
+	}
+
+	free(s);
+}
+
+void swapReplayerState(replayerState_t *s)
+{
+	static replayerState_t tmpState; // only used from the main thread
+
+	assert(audio.locked);
+
+	storeReplayerState(&tmpState);
+	loadReplayerState(s);
+	*s = tmpState;
+}
+
 void setNewSongPos(int32_t pos)
 {
 	resetReplayerState(); // FT2 bugfix
@@ -3191,6 +3918,7 @@ void incSongPos(void)
 		unlockAudio();
 }
 
+#ifndef FT2_HEADLESS
 void decCurIns(void)
 {
 	if (editor.curInstr <= 1)
@@ -3281,7 +4009,7 @@ void pbRecPtn(void)
 
 void setSyncedReplayerVars(void)
 {
-	uint8_t scopeUpdateStatus[MAX_CHANNELS];
+	uint8_t scopeUpdateStatus[MAX_XM_CHANNELS];
 
 	pattSyncEntry = NULL;
 	chSyncEntry = NULL;
@@ -3389,3 +4117,4 @@ void setSyncedReplayerVars(void)
 		ui.updatePatternEditor = true;
 	}
 }
+#endif
@@ -42,8 +42,9 @@ enum
 #define MIN_BPM 32
 #define MAX_BPM 255
 #define MAX_SPEED 31
-#define MAX_CHANNELS 32
-#define TRACK_WIDTH (5 * MAX_CHANNELS)
+#define MAX_CHANNELS 128 // replayer/mixer limit (for imported large arrangements)
+#define MAX_XM_CHANNELS 32 // FT2 limit (.XM format, tracker GUI/scopes)
+#define TRACK_WIDTH(numChannels) (5 * (numChannels)) // patterns are stored at the song's actual width
 #define C4_FREQ 8363
 #define NOTE_C4 (4*12)
 #define NOTE_OFF 97
@@ -192,6 +193,15 @@ __attribute__ ((packed))
 #endif
 note_t;
 
+typedef struct packedPatt_t // compact pattern storage, see ft2_pattern_pack.c
+{
+	int16_t numRows; // last non-empty row + 1 (rows after this are empty)
+	int16_t numChannels;
+	uint16_t dataSize;
+	uint16_t *rowOffs; // numRows+1 entries, points into the same allocation
+	uint8_t *data;
+} packedPatt_t;
+
 typedef struct syncedChannel_t // used for audio/video sync queue (pack to save RAM)
 {
 	uint8_t status, pianoNoteNum, smpNum, instrNum;
@@ -284,6 +294,18 @@ double getSampleC4Rate(sample_t *s);
 void setNewSongPos(int32_t pos);
 void resetReplayerState(void);
 
+/* A private copy of the replayer state (song position/timing, channels, play mode).
+** Swapping it in and out (with the audio locked) lets a song be played on the side
+** without disturbing the live playback (libft2's players use this). Swapping only
+** exchanges the channel arrays, it doesn't copy them.
+*/
+typedef struct replayerState_t replayerState_t;
+
+// snapshot of the current state, with room for 'numChannels' channels (the ones that didn't exist are zeroed)
+replayerState_t *copyReplayerState(int32_t numChannels);
+void freeReplayerState(replayerState_t *s);
+void swapReplayerState(replayerState_t *s); // exchanges 's' with the current state, the audio must be locked
+
 void fixString(char *str, int32_t lastChrPos); // removes leading spaces and 0x1A chars
 void fixSongName(void);
 void fixInstrAndSampleNames(int16_t insNum);
@@ -306,7 +328,14 @@ void freeInstr(int32_t insNum);
 void freeAllInstr(void);
 void freeSample(int16_t insNum, int16_t smpNum);
 
+void freePattern(uint16_t pattNum);
 void freeAllPatterns(void);
+bool packPattern(uint16_t pattNum);
+void packAllPatterns(void);
+bool unpackPattern(uint16_t pattNum);
+bool unpackAllPatterns(void);
+const note_t *getPatternRow(uint16_t pattNum, int16_t row, note_t *rowBuf); // returns NULL if pattern is empty
+bool resizePatternChannels(note_t **patt, int32_t oldNumChannels, int32_t newNumChannels);
 void updateChanNums(void);
 bool setupReplayer(void);
 void closeReplayer(void);
@@ -327,10 +356,22 @@ void conv8BitSample(int8_t *p, int32_t length, bool stereo); // changes sample s
 void conv16BitSample(int8_t *p, int32_t length, bool stereo); // changes sample sign
 void delta2Samp(int8_t *p, int32_t length, uint8_t smpFlags);
 void samp2Delta(int8_t *p, int32_t length, uint8_t smpFlags);
+void fixSample(sample_t *s); // modifies samples before index 0, and after loop/end (for branchless mixer interpolation)
+void unfixSample(sample_t *s); // restores samples after loop/end
 void setPatternLen(uint16_t pattNum, int16_t numRows);
 void setLinearPeriods(bool linearPeriodsFlag);
 void tickReplayer(void); // periodically called from audio callback
+bool dump_EndOfTune(int16_t endSongPos); // for the renderers, call before every tick
+void dump_TickReplayer(void); // for the renderers, a replayer tick outside of the audio callback
 void resetChannels(void);
+
+/* Sizes the replayer's and the mixer's channel arrays for a song with 'numChannels' channels,
+** and resets them. Up to MAX_XM_CHANNELS (all the tracker ever needs), the built-in storage
+** is used, wider songs (--render, libft2) get theirs allocated. Returns false (and changes
+** nothing) if there's not enough memory.
+*/
+bool allocateChannels(int32_t numChannels);
+void setChannelMute(channel_t *ch, bool mute); // silences the channel right away when muting
 bool patternEmpty(uint16_t pattNum);
 int16_t getUsedSamples(int16_t smpNum);
 int16_t getRealUsedSamples(int16_t smpNum);
@@ -354,7 +395,9 @@ extern bool songPlaying, audioPaused, musicPaused;
 extern volatile bool replayerBusy;
 extern const uint16_t *note2Period;
 extern int16_t patternNumRows[MAX_PATTERNS];
-extern channel_t channel[MAX_CHANNELS];
+extern channel_t *channel; // numAllocatedChannels entries
+extern int32_t numAllocatedChannels;
 extern song_t song;
 extern instr_t *instr[128+4];
 extern note_t *pattern[MAX_PATTERNS];
+extern packedPatt_t *packedPattern[MAX_PATTERNS];
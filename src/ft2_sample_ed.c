@@ -28,6 +28,7 @@
 #include "ft2_keyboard.h"
 #include "ft2_structs.h"
 #include "ft2_replayer.h"
+#include "ft2_flac_encoder.h"
 #include "mixer/ft2_windowed_sinc.h" // SINC_TAPS, SINC_NEGATIVE_TAPS
 
 static const char sharpNote1Char[12] = { 'C', 'C', 'D', 'D', 'E', 'F', 'F', 'G', 'G', 'A', 'A', 'B' };
@@ -217,272 +218,6 @@ void sanitizeSample(sample_t *s)
 	}
 }
 
-static int32_t myMod(int32_t a, int32_t b) // works on negative numbers!
-{
-	int32_t c = a % b;
-	return (c < 0) ? (c + b) : c;
-}
-
-// modifies samples before index 0, and after loop/end (for branchless mixer interpolation (kinda))
-void fixSample(sample_t *s)
-{
-	int32_t pos;
-	bool backwards;
-
-	assert(s != NULL);
-	if (s->dataPtr == NULL || s->length <= 0)
-	{
-		s->isFixed = false;
-		s->fixedPos = 0;
-		return; // empty sample
-	}
-
-	const bool sample16Bit = !!(s->flags & SAMPLE_16BIT);
-	int16_t *ptr16 = (int16_t *)s->dataPtr;
-	uint8_t loopType = GET_LOOPTYPE(s->flags);
-	int32_t length = s->length;
-	int32_t loopStart = s->loopStart;
-	int32_t loopLength = s->loopLength;
-	int32_t loopEnd = s->loopStart + s->loopLength;
-
-	// treat loop as disabled if loopLen == 0 (FT2 does this)
-	if (loopType != 0 && loopLength <= 0)
-	{
-		loopType = 0;
-		loopStart = loopLength = loopEnd = 0;
-	}
-
-	/* All negative taps should be equal to the first sample point when at sampling
-	** position #0 (on sample trigger), until an eventual loop cycle, where we do
-	** a special left edge case with replaced tap data.
-	** The sample pointer is offset and has allocated data before it, so this is
-	** safe.
-	*/
-	if (sample16Bit)
-	{
-		for (int32_t i = 0; i < SINC_MAX_LEFT_TAPS; i++)
-			ptr16[i-SINC_MAX_LEFT_TAPS] = ptr16[0];
-	}
-	else
-	{
-		for (int32_t i = 0; i < SINC_MAX_LEFT_TAPS; i++)
-			s->dataPtr[i-SINC_MAX_LEFT_TAPS] = s->dataPtr[0];
-	}
-
-	if (loopType == LOOP_OFF) // no loop
-	{
-		if (sample16Bit)
-		{
-			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
-				ptr16[length+i] = ptr16[length-1];
-		}
-		else
-		{
-			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
-				s->dataPtr[length+i] = s->dataPtr[length-1];
-		}
-
-		s->fixedPos = 0; // this value is not used for non-looping samples, set to zero
-		s->isFixed = false; // no fixed samples inside actual sample data
-		return;
-	}
-
-	s->fixedPos = loopEnd;
-	s->isFixed = true;
-
-	if (loopType == LOOP_FWD) // forward loop
-	{
-		if (sample16Bit)
-		{
-			// left edge (we need SINC_MAX_TAPS amount of taps starting from the center tap)
-			for (int32_t i = -SINC_MAX_LEFT_TAPS; i < SINC_MAX_TAPS; i++)
-			{
-				pos = loopStart + myMod(i, loopLength);
-				s->leftEdgeTapSamples16[SINC_MAX_LEFT_TAPS+i] = ptr16[pos];
-			}
-
-			// right edge (change actual sample data since data after loop is never used)
-			pos = loopStart;
-			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
-			{
-				s->fixedSmp[i] = ptr16[loopEnd+i];
-				ptr16[loopEnd+i] = ptr16[pos];
-
-				if (++pos >= loopEnd)
-					pos -= loopLength;
-			}
-		}
-		else // 8-bit
-		{
-			// left edge (we need SINC_MAX_TAPS amount of taps starting from the center tap)
-			for (int32_t i = -SINC_MAX_LEFT_TAPS; i < SINC_MAX_TAPS; i++)
-			{
-				pos = loopStart + myMod(i, loopLength);
-				s->leftEdgeTapSamples8[SINC_MAX_LEFT_TAPS+i] = s->dataPtr[pos];
-			}
-
-			// right edge (change actual sample data since data after loop is never used)
-			pos = loopStart;
-			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
-			{
-				s->fixedSmp[i] = s->dataPtr[loopEnd+i];
-				s->dataPtr[loopEnd+i] = s->dataPtr[pos];
-
-				if (++pos >= loopEnd)
-					pos -= loopLength;
-			}
-		}
-	}
-	else // pingpong loop
-	{
-		if (sample16Bit)
-		{
-			// left edge (positive taps, we need SINC_MAX_TAPS amount of taps starting from the center tap)
-			pos = loopStart;
-			backwards = false;
-			for (int32_t i = 0; i < SINC_MAX_TAPS; i++)
-			{
-				if (backwards)
-				{
-					if (pos < loopStart)
-					{
-						pos = loopStart;
-						backwards = false;
-					}
-				}
-				else if (pos >= loopEnd) // forwards
-				{
-					pos = loopEnd-1;
-					backwards = true;
-				}
-
-				s->leftEdgeTapSamples16[SINC_MAX_LEFT_TAPS+i] = ptr16[pos];
-
-				if (backwards)
-					pos--;
-				else
-					pos++;
-			}
-
-			// left edge (negative taps)
-			for (int32_t i = 0; i < SINC_MAX_LEFT_TAPS; i++)
-				s->leftEdgeTapSamples16[(SINC_MAX_LEFT_TAPS-1)-i] = s->leftEdgeTapSamples16[SINC_MAX_LEFT_TAPS+1+i];
-
-			// right edge (change actual sample data since data after loop is never used)
-			pos = loopEnd-1;
-			backwards = true;
-			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
-			{
-				if (backwards)
-				{
-					if (pos < loopStart)
-					{
-						pos = loopStart;
-						backwards = false;
-					}
-				}
-				else if (pos >= loopEnd) // forwards
-				{
-					pos = loopEnd-1;
-					backwards = true;
-				}
-
-				s->fixedSmp[i] = ptr16[loopEnd+i];
-				ptr16[loopEnd+i] = ptr16[pos];
-
-				if (backwards)
-					pos--;
-				else
-					pos++;
-			}
-		}
-		else // 8-bit
-		{
-			// left edge (positive taps, we need SINC_MAX_TAPS amount of taps starting from the center tap)
-			pos = loopStart;
-			backwards = false;
-			for (int32_t i = 0; i < SINC_MAX_TAPS; i++)
-			{
-				if (backwards)
-				{
-					if (pos < loopStart)
-					{
-						pos = loopStart;
-						backwards = false;
-					}
-				}
-				else if (pos >= loopEnd) // forwards
-				{
-					pos = loopEnd-1;
-					backwards = true;
-				}
-
-				s->leftEdgeTapSamples8[SINC_MAX_LEFT_TAPS+i] = s->dataPtr[pos];
-
-				if (backwards)
-					pos--;
-				else
-					pos++;
-			}
-
-			// left edge (negative taps)
-			for (int32_t i = 0; i < SINC_MAX_LEFT_TAPS; i++)
-				s->leftEdgeTapSamples8[(SINC_MAX_LEFT_TAPS-1)-i] = s->leftEdgeTapSamples8[SINC_MAX_LEFT_TAPS+1+i];
-
-			// right edge (change actual sample data since data after loop is never used)
-			pos = loopEnd-1;
-			backwards = true;
-			for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
-			{
-				if (backwards)
-				{
-					if (pos < loopStart)
-					{
-						pos = loopStart;
-						backwards = false;
-					}
-				}
-				else if (pos >= loopEnd) // forwards
-				{
-					pos = loopEnd-1;
-					backwards = true;
-				}
-
-				s->fixedSmp[i] = s->dataPtr[loopEnd+i];
-				s->dataPtr[loopEnd+i] = s->dataPtr[pos];
-
-				if (backwards)
-					pos--;
-				else
-					pos++;
-			}
-		}
-	}
-}
-
-// restores interpolation tap samples after loop/end
-void unfixSample(sample_t *s)
-{
-	assert(s != NULL);
-	if (s->dataPtr == NULL || !s->isFixed)
-		return; // empty sample or not fixed (f.ex. no loop)
-
-	if (s->flags & SAMPLE_16BIT)
-	{
-		int16_t *ptr16 = (int16_t *)s->dataPtr + s->fixedPos;
-		for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
-			ptr16[i] = s->fixedSmp[i];
-	}
-	else // 8-bit
-	{
-		int8_t *ptr8 = s->dataPtr + s->fixedPos;
-		for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
-			ptr8[i] = (int8_t)s->fixedSmp[i];
-	}
-
-	s->isFixed = false;
-}
-
 double getSampleValue(int8_t *smpData, int32_t position, bool sample16Bit)
 {
 	if (smpData == NULL)
@@ -1859,7 +1594,12 @@ void saveRange(void)
 	{
 		         case SMP_SAVE_MODE_RAW: changeFilenameExt(smpEd_SysReqText, ".raw", sizeof (smpEd_SysReqText) - 1); break;
 		         case SMP_SAVE_MODE_IFF: changeFilenameExt(smpEd_SysReqText, ".iff", sizeof (smpEd_SysReqText) - 1); break;
-		default: case SMP_SAVE_MODE_WAV: changeFilenameExt(smpEd_SysReqText, ".wav", sizeof (smpEd_SysReqText) - 1); break;
+		default: case SMP_SAVE_MODE_WAV:
+		{
+			if (!filenameIsFlac(smpEd_SysReqText)) // the WAV mode saves FLAC if the filename ends in ".flac"
+				changeFilenameExt(smpEd_SysReqText, ".wav", sizeof (smpEd_SysReqText) - 1);
+		}
+		break;
 	}
 
 	UNICHAR *filenameU = cp437ToUnichar(smpEd_SysReqText);
@@ -3052,7 +2792,7 @@ static void writeSamplePosLine(void)
 {
 	uint8_t ins, smp;
 
-	assert(editor.curSmpChannel < MAX_CHANNELS);
+	assert(editor.curSmpChannel < MAX_XM_CHANNELS);
 	lastChInstr_t *c = &lastChInstr[editor.curSmpChannel];
 
 	if (c->instrNum == 130) // "Play Wave/Range/Display" in Smp. Ed.
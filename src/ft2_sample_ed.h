@@ -22,8 +22,6 @@ void freeSmpData(sample_t *s);
 bool cloneSample(sample_t *src, sample_t *dst);
 sample_t *getCurSample(void);
 void sanitizeSample(sample_t *s);
-void fixSample(sample_t *s); // modifies samples before index 0, and after loop/end (for branchless mixer interpolation)
-void unfixSample(sample_t *s); // restores samples after loop/end
 void clearSample(void);
 void clearCopyBuffer(void);
 int32_t getSampleMiddleCRate(sample_t *s);
@@ -15,6 +15,7 @@
 #include "ft2_diskop.h"
 #include "ft2_mouse.h"
 #include "ft2_structs.h"
+#include "ft2_flac_encoder.h"
 
 typedef struct wavHeader_t
 {
@@ -48,7 +49,7 @@ typedef struct mptExtraChunk_t
 static const char *rangedDataStr = "Ranged data from FT2";
 
 // thread data
-static bool saveRangeFlag;
+static bool saveRangeFlag, saveAsFlac;
 static SDL_Thread *thread;
 
 // restores modified interpolation tap samples after loopEnd (for .RAW/.IFF/.WAV samples after save)
@@ -319,6 +320,36 @@ static bool saveIFFSample(UNICHAR *filenameU, bool saveRangedData)
 	return true;
 }
 
+static void setSamplerChunk(samplerChunk_t *samplerChunk, sample_t *smp, uint32_t sampleRate)
+{
+	memset(samplerChunk, 0, sizeof (samplerChunk_t));
+
+	samplerChunk->chunkID = 0x6C706D73; // "smpl"
+	samplerChunk->chunkSize = sizeof (samplerChunk_t) - 4 - 4;
+	samplerChunk->dwSamplePeriod = 1000000000 / sampleRate;
+	samplerChunk->dwMIDIUnityNote = 60; // 60 = MIDI middle-C
+	samplerChunk->cSampleLoops = 1;
+	samplerChunk->loop.dwType = GET_LOOPTYPE(smp->flags)-1; // 0 = forward, 1 = ping-pong
+	samplerChunk->loop.dwStart = smp->loopStart;
+	samplerChunk->loop.dwEnd = (smp->loopStart + smp->loopLength) - 1;
+}
+
+static void setMptExtraChunk(mptExtraChunk_t *mptExtraChunk, instr_t *ins, sample_t *smp)
+{
+	memset(mptExtraChunk, 0, sizeof (mptExtraChunk_t));
+
+	mptExtraChunk->chunkID = 0x61727478; // "xtra"
+	mptExtraChunk->chunkSize = sizeof (mptExtraChunk_t) - 4 - 4;
+	mptExtraChunk->flags = 0x20; // set pan flag
+	mptExtraChunk->defaultPan = smp->panning; // 0..255
+	mptExtraChunk->defaultVolume = smp->volume * 4; // 0..256
+	mptExtraChunk->globalVolume = 64; // 0..64
+	mptExtraChunk->vibratoType = ins->autoVibType; // 0..3    0 = sine, 1 = square, 2 = ramp up, 3 = ramp down
+	mptExtraChunk->vibratoSweep = ins->autoVibSweep; // 0..255
+	mptExtraChunk->vibratoDepth = ins->autoVibDepth; // 0..15
+	mptExtraChunk->vibratoRate = ins->autoVibRate; // 0..63
+}
+
 static bool saveWAVSample(UNICHAR *filenameU, bool saveRangedData)
 {
 	char *smpNamePtr;
@@ -394,16 +425,7 @@ static bool saveWAVSample(UNICHAR *filenameU, bool saveRangedData)
 	// write "smpl" chunk if loop is enabled
 	if (!saveRangedData && GET_LOOPTYPE(smp->flags) != LOOP_OFF)
 	{
-		memset(&samplerChunk, 0, sizeof (samplerChunk));
-
-		samplerChunk.chunkID = 0x6C706D73; // "smpl"
-		samplerChunk.chunkSize = sizeof (samplerChunk) - 4 - 4;
-		samplerChunk.dwSamplePeriod = 1000000000 / wavHeader.sampleRate;
-		samplerChunk.dwMIDIUnityNote = 60; // 60 = MIDI middle-C
-		samplerChunk.cSampleLoops = 1;
-		samplerChunk.loop.dwType = GET_LOOPTYPE(smp->flags)-1; // 0 = forward, 1 = ping-pong
-		samplerChunk.loop.dwStart = smp->loopStart;
-		samplerChunk.loop.dwEnd = (smp->loopStart + smp->loopLength) - 1;
+		setSamplerChunk(&samplerChunk, smp, wavHeader.sampleRate);
 
 		fwrite(&samplerChunk, sizeof (samplerChunk), 1, f);
 		if (samplerChunk.chunkSize & 1)
@@ -413,18 +435,7 @@ static bool saveWAVSample(UNICHAR *filenameU, bool saveRangedData)
 	// write modplug tracker "xtra" chunk
 	if (!saveRangedData)
 	{
-		memset(&mptExtraChunk, 0, sizeof (mptExtraChunk));
-
-		mptExtraChunk.chunkID = 0x61727478; // "xtra"
-		mptExtraChunk.chunkSize = sizeof (mptExtraChunk) - 4 - 4;
-		mptExtraChunk.flags = 0x20; // set pan flag
-		mptExtraChunk.defaultPan = smp->panning; // 0..255
-		mptExtraChunk.defaultVolume = smp->volume * 4; // 0..256
-		mptExtraChunk.globalVolume = 64; // 0..64
-		mptExtraChunk.vibratoType = ins->autoVibType; // 0..3    0 = sine, 1 = square, 2 = ramp up, 3 = ramp down
-		mptExtraChunk.vibratoSweep = ins->autoVibSweep; // 0..255
-		mptExtraChunk.vibratoDepth = ins->autoVibDepth; // 0..15
-		mptExtraChunk.vibratoRate = ins->autoVibRate; // 0..63
+		setMptExtraChunk(&mptExtraChunk, ins, smp);
 
 		fwrite(&mptExtraChunk, sizeof (mptExtraChunk), 1, f);
 		if (mptExtraChunk.chunkSize & 1)
@@ -499,6 +510,153 @@ static bool saveWAVSample(UNICHAR *filenameU, bool saveRangedData)
 	return true;
 }
 
+/* The sample name goes in a Vorbis comment, and the loop/panning/volume in RIFF "smpl" and
+** "xtra" chunks stored as "riff" application blocks (like "flac --keep-foreign-metadata").
+** The FLAC sample loader reads all of them back.
+*/
+static bool saveFLACSample(UNICHAR *filenameU, bool saveRangedData)
+{
+	const char *smpNamePtr;
+	uint8_t vorbisComment[4 + sizeof (PROG_NAME_STR) + 4 + 4 + 6 + 32];
+	uint8_t smplBlock[4 + sizeof (samplerChunk_t)], xtraBlock[4 + sizeof (mptExtraChunk_t)];
+	samplerChunk_t samplerChunk;
+	mptExtraChunk_t mptExtraChunk;
+	flacMetadata_t metadata[3];
+	uint32_t tmpLen;
+
+	instr_t *ins = instr[editor.curInstr];
+	if (ins == NULL || ins->smp[editor.curSmp].dataPtr == NULL || ins->smp[editor.curSmp].length == 0)
+	{
+		okBoxThreadSafe(0, "System message", "The sample is empty!");
+		return false;
+	}
+
+	sample_t *smp = &ins->smp[editor.curSmp];
+	bool sample16Bit = !!(smp->flags & SAMPLE_16BIT);
+
+	int32_t sampleStart = 0;
+	uint32_t sampleLen = smp->length;
+
+	if (saveRangedData)
+	{
+		sampleStart = getSampleRangeStart();
+		sampleLen = getSampleRangeLength();
+	}
+
+	/* The samples after the loop end are modified in memory for the interpolation, so
+	** the file is encoded from a copy with the original samples put back.
+	*/
+	int8_t *smpData = (int8_t *)malloc(sampleLen << sample16Bit);
+	if (smpData == NULL)
+	{
+		okBoxThreadSafe(0, "System message", "Not enough memory!");
+		return false;
+	}
+
+	memcpy(smpData, &smp->dataPtr[sampleStart << sample16Bit], sampleLen << sample16Bit);
+
+	if (smp->isFixed)
+	{
+		for (int32_t i = 0; i < SINC_MAX_RIGHT_TAPS; i++)
+		{
+			const int32_t pos = (smp->fixedPos + i) - sampleStart;
+			if (pos < 0 || pos >= (int32_t)sampleLen)
+				continue;
+
+			if (sample16Bit)
+				((int16_t *)smpData)[pos] = smp->fixedSmp[i];
+			else
+				smpData[pos] = (int8_t)smp->fixedSmp[i];
+		}
+	}
+
+	const uint32_t sampleRate = getSampleMiddleCRate(smp);
+
+	// Vorbis comment (little-endian lengths): vendor string, then one "TITLE=" comment
+	smpNamePtr = saveRangedData ? rangedDataStr : smp->name;
+
+	uint8_t *ptr8 = vorbisComment;
+	tmpLen = sizeof (PROG_NAME_STR) - 1;
+	memcpy(ptr8, &tmpLen, 4); ptr8 += 4;
+	memcpy(ptr8, PROG_NAME_STR, tmpLen); ptr8 += tmpLen;
+
+	const uint32_t smpNameLen = (uint32_t)strnlen(smpNamePtr, 22);
+	tmpLen = (smpNameLen > 0) ? 1 : 0; // number of comments
+	memcpy(ptr8, &tmpLen, 4); ptr8 += 4;
+
+	if (smpNameLen > 0)
+	{
+		tmpLen = 6 + smpNameLen;
+		memcpy(ptr8, &tmpLen, 4); ptr8 += 4;
+		memcpy(ptr8, "TITLE=", 6); ptr8 += 6;
+		memcpy(ptr8, smpNamePtr, smpNameLen); ptr8 += smpNameLen;
+	}
+
+	int32_t numMetadata = 0;
+	metadata[numMetadata].type = FLAC_METADATA_VORBIS_COMMENT;
+	metadata[numMetadata].length = (uint32_t)(ptr8 - vorbisComment);
+	metadata[numMetadata].data = vorbisComment;
+	numMetadata++;
+
+	if (!saveRangedData && GET_LOOPTYPE(smp->flags) != LOOP_OFF)
+	{
+		setSamplerChunk(&samplerChunk, smp, sampleRate);
+		memcpy(smplBlock, "riff", 4);
+		memcpy(&smplBlock[4], &samplerChunk, sizeof (samplerChunk_t));
+
+		metadata[numMetadata].type = FLAC_METADATA_APPLICATION;
+		metadata[numMetadata].length = sizeof (smplBlock);
+		metadata[numMetadata].data = smplBlock;
+		numMetadata++;
+	}
+
+	if (!saveRangedData)
+	{
+		setMptExtraChunk(&mptExtraChunk, ins, smp);
+		memcpy(xtraBlock, "riff", 4);
+		memcpy(&xtraBlock[4], &mptExtraChunk, sizeof (mptExtraChunk_t));
+
+		metadata[numMetadata].type = FLAC_METADATA_APPLICATION;
+		metadata[numMetadata].length = sizeof (xtraBlock);
+		metadata[numMetadata].data = xtraBlock;
+		numMetadata++;
+	}
+
+	FILE *f = UNICHAR_FOPEN(filenameU, "wb");
+	if (f == NULL)
+	{
+		free(smpData);
+		okBoxThreadSafe(0, "System message", "General I/O error during saving! Is the file in use?");
+		return false;
+	}
+
+	bool writeOk = false;
+
+	flacEncoder_t *e = openFlacEncoder(f, sampleRate, 1, sample16Bit ? FLAC_INPUT_16BIT : FLAC_INPUT_8BIT, 0, metadata, numMetadata);
+	if (e != NULL)
+	{
+		writeOk = encodeFlacSamples(e, smpData, sampleLen << sample16Bit);
+		if (!closeFlacEncoder(e))
+			writeOk = false;
+	}
+
+	if (fclose(f) != 0)
+		writeOk = false;
+
+	free(smpData);
+
+	if (!writeOk)
+	{
+		okBoxThreadSafe(0, "System message", "Error saving sample: General I/O error!");
+		return false;
+	}
+
+	editor.diskOpReadDir = true; // force diskop re-read
+
+	setMouseBusy(false);
+	return true;
+}
+
 static int32_t SDLCALL saveSampleThread(void *ptr)
 {
 	if (editor.tmpFilenameU == NULL)
@@ -517,7 +675,14 @@ static int32_t SDLCALL saveSampleThread(void *ptr)
 	{
 		         case SMP_SAVE_MODE_RAW: saveRawSample(editor.tmpFilenameU, saveRangeFlag); break;
 		         case SMP_SAVE_MODE_IFF: saveIFFSample(editor.tmpFilenameU, saveRangeFlag); break;
-		default: case SMP_SAVE_MODE_WAV: saveWAVSample(editor.tmpFilenameU, saveRangeFlag); break;
+		default: case SMP_SAVE_MODE_WAV:
+		{
+			if (saveAsFlac)
+				saveFLACSample(editor.tmpFilenameU, saveRangeFlag);
+			else
+				saveWAVSample(editor.tmpFilenameU, saveRangeFlag);
+		}
+		break;
 	}
 
 	// set back old working directory if we changed it
@@ -534,6 +699,12 @@ void saveSample(UNICHAR *filenameU, bool saveAsRange)
 	saveRangeFlag = saveAsRange;
 	UNICHAR_STRCPY(editor.tmpFilenameU, filenameU);
 
+	// the WAV save mode saves FLAC if the filename ends in ".flac"
+	char *filename = unicharToCp437(filenameU, false);
+	saveAsFlac = (filename != NULL) && filenameIsFlac(filename);
+	if (filename != NULL)
+		free(filename);
+
 	mouseAnimOn();
 	thread = SDL_CreateThread(saveSampleThread, NULL, NULL);
 	if (thread == NULL)
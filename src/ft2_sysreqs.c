@@ -86,7 +86,7 @@ void myLoaderMsgBoxThreadSafe(const char *fmt, ...)
 	vsnprintf(strBuf, sizeof (strBuf), fmt, args);
 	va_end(args);
 
-	okBoxThreadSafe(0, "System message", fmt);
+	okBoxThreadSafe(0, "System message", strBuf);
 }
 
 void myLoaderMsgBox(const char *fmt, ...)
@@ -99,7 +99,7 @@ void myLoaderMsgBox(const char *fmt, ...)
 	vsnprintf(strBuf, sizeof (strBuf), fmt, args);
 	va_end(args);
 
-	okBox(0, "System message", fmt);
+	okBox(0, "System message", strBuf);
 }
 
 static void drawWindow(uint16_t w)
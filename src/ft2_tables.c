@@ -694,7 +694,7 @@ const uint8_t pattCursorWTab[2 * 4 * 8] =
 };
 
 // these two are for channel numbering on pattern data/scopes
-const char chDecTab1[MAX_CHANNELS+1] = 
+const char chDecTab1[MAX_XM_CHANNELS+1] = 
 {
 	'0', '0', '0', '0', '0', '0', '0', '0', '0', '0',
 	'1', '1', '1', '1', '1', '1', '1', '1', '1', '1',
@@ -702,7 +702,7 @@ const char chDecTab1[MAX_CHANNELS+1] =
 	'3', '3', '3'
 };
 
-const char chDecTab2[MAX_CHANNELS+1] = 
+const char chDecTab2[MAX_XM_CHANNELS+1] = 
 {
 	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
 	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
@@ -710,6 +710,7 @@ const char chDecTab2[MAX_CHANNELS+1] =
 	'0', '1', '2'
 };
 
+#ifndef FT2_HEADLESS
 const SDL_Keycode key2VolTab[16] = 
 {
 	SDLK_0, SDLK_1, SDLK_2, SDLK_3, SDLK_4, SDLK_MINUS, SDLK_PLUS, SDLK_d,
@@ -730,6 +731,7 @@ const SDL_Keycode key2HexTab[16] =
 	SDLK_0, SDLK_1, SDLK_2, SDLK_3, SDLK_4, SDLK_5, SDLK_6, SDLK_7,
 	SDLK_8, SDLK_9, SDLK_a, SDLK_b, SDLK_c, SDLK_d, SDLK_e, SDLK_f
 };
+#endif
 
 const uint8_t scopeMuteBMP_Widths[16] =
 {
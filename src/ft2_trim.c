@@ -74,7 +74,7 @@ static void remapInstrInSong(uint8_t src, uint8_t dst, int32_t ap)
 		if (pattPtr == NULL)
 			continue;
 
-		const int32_t readLen = patternNumRows[i] * MAX_CHANNELS;
+		const int32_t readLen = patternNumRows[i] * song.numChannels;
 
 		note_t *p = pattPtr;
 		for (int32_t j = 0; j < readLen; j++, p++)
@@ -179,7 +179,7 @@ static void wipeInstrUnused(bool testWipeSize, int16_t *ai, int32_t ap, int32_t
 		{
 			for (k = 0; k < antChn; k++)
 			{
-				uint8_t ins = p[(j * MAX_CHANNELS) + k].instr;
+				uint8_t ins = p[(j * song.numChannels) + k].instr;
 				if (ins > 0 && ins <= MAX_INST)
 					instrUsed[ins-1] = true;
 			}
@@ -606,7 +606,7 @@ static uint16_t getPackedPattSize(note_t *p, int32_t numRows, int32_t antChn)
 		}
 
 		// skip unused channels
-		pattPtr += sizeof (note_t) * (MAX_CHANNELS - antChn);
+		pattPtr += sizeof (note_t) * (song.numChannels - antChn);
 	}
 
 	return totalPackLen;
@@ -621,7 +621,7 @@ static bool tmpPatternEmpty(uint16_t pattNum, int32_t numChannels)
 	int32_t scanLen = numChannels * sizeof (note_t);
 	int32_t numRows = tmpPattLens[pattNum];
 
-	for (int32_t i = 0; i < numRows; i++, scanPtr += TRACK_WIDTH)
+	for (int32_t i = 0; i < numRows; i++, scanPtr += TRACK_WIDTH(song.numChannels))
 	{
 		for (int32_t j = 0; j < scanLen; j++)
 		{
@@ -771,7 +771,7 @@ static int64_t calculateTrimSize(void)
 			{
 				for (k = 0; k < numChannels; k++)
 				{
-					note_t *p = &pattPtr[(j * MAX_CHANNELS) + k];
+					note_t *p = &pattPtr[(j * song.numChannels) + k];
 					if (p->note > 0 || p->instr > 0 || p->vol > 0 || p->efx > 0 || p->efxData > 0)
 					{
 						if (k > highestChan)
@@ -884,7 +884,7 @@ static int32_t SDLCALL trimThreadFunc(void *ptr)
 			{
 				for (k = 0; k < song.numChannels; k++)
 				{
-					note_t *p = &pattPtr[(j * MAX_CHANNELS) + k];
+					note_t *p = &pattPtr[(j * song.numChannels) + k];
 					if (p->note > 0 || p->vol > 0 || p->instr > 0 || p->efx > 0 || p->efxData > 0)
 					{
 						if (k > highestChan)
@@ -894,29 +894,18 @@ static int32_t SDLCALL trimThreadFunc(void *ptr)
 			}
 		}
 
-		// set new 'channels used' number
+		// set new 'channels used' number (this also drops the unused channel data)
 		if (highestChan >= 0)
 		{
 			highestChan++;
 			if (highestChan & 1)
 				highestChan++;
 
-			song.numChannels = (uint8_t)(CLAMP(highestChan, 2, song.numChannels));
-		}
-
-		// clear potentially unused channel data
-		if (song.numChannels < MAX_CHANNELS)
-		{
-			for (i = 0; i < MAX_PATTERNS; i++)
-			{
-				note_t *p = pattern[i];
-				if (p == NULL)
-					continue;
-
-				const int16_t numRows = patternNumRows[i];
-				for (j = 0; j < numRows; j++)
-					memset(&p[(j * MAX_CHANNELS) + song.numChannels], 0, sizeof (note_t) * (MAX_CHANNELS - song.numChannels));
-			}
+			const int32_t numChannels = CLAMP(highestChan, 2, song.numChannels);
+			if (resizePatternChannels(pattern, song.numChannels, numChannels))
+				song.numChannels = numChannels;
+			else
+				okBoxThreadSafe(0, "System message", "Not enough memory!");
 		}
 	}
 
@@ -1168,6 +1157,13 @@ void cbTrimSmpsTo8Bit(void)
 
 void pbTrimCalc(void)
 {
+	// trimming works on the whole song, so packed patterns are expanded first
+	if (!unpackAllPatterns())
+	{
+		okBox(0, "System message", "Not enough memory!");
+		return;
+	}
+
 	xmSize64 = calculateXMSize();
 	spaceSaved64 = calculateTrimSize();
 
@@ -1187,6 +1183,12 @@ void pbTrimDoTrim(void)
 	if (okBox(2, "System request", "Are you sure you want to trim the song? Making a backup of the song first is recommended.") != 1)
 		return;
 
+	if (!unpackAllPatterns())
+	{
+		okBox(0, "System message", "Not enough memory!");
+		return;
+	}
+
 	mouseAnimOn();
 	pauseAudio();
 
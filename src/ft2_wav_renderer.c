@@ -3,9 +3,12 @@
 #include <crtdbg.h>
 #endif
 
+#define _FILE_OFFSET_BITS 64
+
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "ft2_header.h"
 #include "ft2_audio.h"
 #include "ft2_gui.h"
@@ -18,10 +21,14 @@
 #include "ft2_inst_ed.h"
 #include "ft2_audio.h"
 #include "ft2_wav_renderer.h"
+#include "ft2_render_writer.h"
+#include "ft2_flac_encoder.h"
+#include "ft2_render_queue.h"
 #include "ft2_structs.h"
 
 #define UPDATE_VISUALS_AT_TICK 4
 #define TICKS_PER_RENDER_CHUNK 64
+#define JOB_LIST_LINES 4
 
 enum
 {
@@ -29,25 +36,37 @@ enum
 	WAV_FORMAT_IEEE_FLOAT = 0x0003
 };
 
+/* The length isn't known until the render is done, so there is always room for an
+** RF64 "ds64" chunk after the RIFF header. It's written as a "JUNK" chunk (which
+** readers skip), and turned into "ds64" if the file ends up too big for 32-bit sizes.
+** The 64-bit ds64 fields are split in two to avoid struct padding.
+*/
 typedef struct wavHeader_t
 {
-	uint32_t chunkID, chunkSize, format, subchunk1ID, subchunk1Size;
+	uint32_t chunkID, chunkSize, format;
+	uint32_t ds64ID, ds64Size, riffSizeLo, riffSizeHi, dataSizeLo, dataSizeHi, sampleCountLo, sampleCountHi, tableLength;
+	uint32_t subchunk1ID, subchunk1Size;
 	uint16_t audioFormat, numChannels;
 	uint32_t sampleRate, byteRate;
 	uint16_t blockAlign, bitsPerSample;
 	uint32_t subchunk2ID, subchunk2Size;
 } wavHeader_t;
 
-static bool useLegacyBPM = false;
-static uint8_t WDBitDepth = 16, WDStartPos, WDStopPos, *wavRenderBuffer;
+static bool useLegacyBPM = false, renderToFlac = false, showJobList = false;
+static uint8_t WDBitDepth = 16, WDStartPos, WDStopPos;
 static int16_t WDAmp;
 static uint32_t WDFrequency = 44100;
 static SDL_Thread *thread;
+static renderWriter_t *wavWriter;
+static flacEncoder_t *flacEncoder; // NULL when writing WAV
 
 static void updateWavRenderer(void)
 {
 	char str[16];
 
+	if (showJobList) // the settings are hidden
+		return;
+
 	fillRect(195, 116, 56, 8, PAL_DESKTOP);
 	textOut(237, 116, PAL_FORGRND, "Hz");
 	sprintf(str, "%6d", WDFrequency);
@@ -93,34 +112,130 @@ void updateWavRendererSettings(void) // called when changing config.boostLevel
 	WDAmp = config.boostLevel;
 }
 
+static void drawJobList(void) // shown instead of the settings while "Jobs" is toggled on
+{
+	char str[32];
+	int32_t numJobs, jobsDone, progress, state;
+	const char *outPath;
+
+	fillRect(80, 110, 210, 45, PAL_DESKTOP);
+	fillRect(80, 155, 152, 16, PAL_DESKTOP); // left of the "Cancel" button
+
+	getRenderQueueStatus(&numJobs, &jobsDone, &progress);
+	if (numJobs == 0)
+	{
+		textOut(85, 114, PAL_FORGRND, "The render queue is empty.");
+		return;
+	}
+
+	// start at the oldest job that isn't done, but keep the list filled
+	int32_t firstJob = 0;
+	while (firstJob < numJobs && getRenderJob(firstJob, &outPath, &state, &progress) && state >= RENDER_JOB_DONE)
+		firstJob++;
+
+	firstJob = MAX(0, MIN(firstJob, numJobs - JOB_LIST_LINES));
+
+	for (int32_t i = 0; i < JOB_LIST_LINES; i++)
+	{
+		if (!getRenderJob(firstJob + i, &outPath, &state, &progress))
+			break;
+
+		const uint16_t y = 114 + (i * 10);
+
+		const char *filename = strrchr(outPath, DIR_DELIMITER);
+		filename = (filename != NULL) ? (filename + 1) : outPath;
+		textOutClipX(85, y, PAL_FORGRND, filename, 246);
+
+		switch (state)
+		{
+			case RENDER_JOB_QUEUED: strcpy(str, "queued"); break;
+			case RENDER_JOB_RUNNING: sprintf(str, "%d%%", progress); break;
+			case RENDER_JOB_DONE: strcpy(str, "done"); break;
+			default: strcpy(str, "failed"); break;
+		}
+
+		textOut(287 - textWidth(str), y, PAL_FORGRND, str);
+	}
+
+	const int32_t jobsNotShown = numJobs - (firstJob + JOB_LIST_LINES);
+	if (jobsNotShown > 0)
+	{
+		sprintf(str, "%d more job%s", jobsNotShown, (jobsNotShown > 1) ? "s" : "");
+		textOut(85, 159, PAL_FORGRND, str);
+	}
+}
+
+void drawWavRendererQueueStatus(void) // the header shows the render queue progress while it's busy
+{
+	char str[32];
+	int32_t numJobs, jobsDone, progress;
+
+	if (showJobList)
+		drawJobList();
+
+	fillRect(4, 96, 122, 9, PAL_DESKTOP);
+
+	getRenderQueueStatus(&numJobs, &jobsDone, &progress);
+	if (numJobs == 0)
+	{
+		textOutShadow(4, 96, PAL_FORGRND, PAL_DSKTOP2, "WAV exporting:");
+		return;
+	}
+
+	sprintf(str, "Queue %d/%d: %d%%", MIN(jobsDone + 1, numJobs), numJobs, progress);
+	textOutShadow(4, 96, PAL_FORGRND, PAL_DSKTOP2, str);
+}
+
+static void hideSettingsButtons(void)
+{
+	hidePushButton(PB_WAV_FREQ_UP);
+	hidePushButton(PB_WAV_FREQ_DOWN);
+	hidePushButton(PB_WAV_AMP_UP);
+	hidePushButton(PB_WAV_AMP_DOWN);
+	hidePushButton(PB_WAV_START_UP);
+	hidePushButton(PB_WAV_START_DOWN);
+	hidePushButton(PB_WAV_END_UP);
+	hidePushButton(PB_WAV_END_DOWN);
+}
+
 void drawWavRenderer(void)
 {
 	drawFramework(0,   92, 291, 17, FRAMEWORK_TYPE1);
 	drawFramework(0,  109,  79, 64, FRAMEWORK_TYPE1);
 	drawFramework(79, 109, 212, 64, FRAMEWORK_TYPE1);
 
-	textOutShadow(4,   96, PAL_FORGRND, PAL_DSKTOP2, "WAV exporting:");
+	drawWavRendererQueueStatus();
 	textOutShadow(146, 96, PAL_FORGRND, PAL_DSKTOP2, "16-bit");
 	textOutShadow(211, 96, PAL_FORGRND, PAL_DSKTOP2, "32-bit (float)");
 
 	textOutShadow(19, 114, PAL_FORGRND, PAL_DSKTOP2, "Imprecise");
 	textOutShadow(4,  127, PAL_FORGRND, PAL_DSKTOP2, "BPM (FT2)");
 
-	textOutShadow(85, 116, PAL_FORGRND, PAL_DSKTOP2, "Audio output rate");
-	textOutShadow(85, 130, PAL_FORGRND, PAL_DSKTOP2, "Amplification");
-	textOutShadow(85, 144, PAL_FORGRND, PAL_DSKTOP2, "Start song position");
-	textOutShadow(85, 158, PAL_FORGRND, PAL_DSKTOP2, "Stop song position");
-
 	showPushButton(PB_WAV_RENDER);
 	showPushButton(PB_WAV_EXIT);
-	showPushButton(PB_WAV_FREQ_UP);
-	showPushButton(PB_WAV_FREQ_DOWN);
-	showPushButton(PB_WAV_AMP_UP);
-	showPushButton(PB_WAV_AMP_DOWN);
-	showPushButton(PB_WAV_START_UP);
-	showPushButton(PB_WAV_START_DOWN);
-	showPushButton(PB_WAV_END_UP);
-	showPushButton(PB_WAV_END_DOWN);
+	showPushButton(PB_WAV_QUEUE);
+	showPushButton(PB_WAV_JOBS);
+
+	if (showJobList)
+	{
+		showPushButton(PB_WAV_CANCEL_JOBS);
+	}
+	else
+	{
+		textOutShadow(85, 116, PAL_FORGRND, PAL_DSKTOP2, "Audio output rate");
+		textOutShadow(85, 130, PAL_FORGRND, PAL_DSKTOP2, "Amplification");
+		textOutShadow(85, 144, PAL_FORGRND, PAL_DSKTOP2, "Start song position");
+		textOutShadow(85, 158, PAL_FORGRND, PAL_DSKTOP2, "Stop song position");
+
+		showPushButton(PB_WAV_FREQ_UP);
+		showPushButton(PB_WAV_FREQ_DOWN);
+		showPushButton(PB_WAV_AMP_UP);
+		showPushButton(PB_WAV_AMP_DOWN);
+		showPushButton(PB_WAV_START_UP);
+		showPushButton(PB_WAV_START_DOWN);
+		showPushButton(PB_WAV_END_UP);
+		showPushButton(PB_WAV_END_DOWN);
+	}
 
 	showCheckBox(CB_WAV_BPM_MODE);
 
@@ -171,14 +286,10 @@ void hideWavRenderer(void)
 
 	hidePushButton(PB_WAV_RENDER);
 	hidePushButton(PB_WAV_EXIT);
-	hidePushButton(PB_WAV_FREQ_UP);
-	hidePushButton(PB_WAV_FREQ_DOWN);
-	hidePushButton(PB_WAV_AMP_UP);
-	hidePushButton(PB_WAV_AMP_DOWN);
-	hidePushButton(PB_WAV_START_UP);
-	hidePushButton(PB_WAV_START_DOWN);
-	hidePushButton(PB_WAV_END_UP);
-	hidePushButton(PB_WAV_END_DOWN);
+	hidePushButton(PB_WAV_QUEUE);
+	hidePushButton(PB_WAV_JOBS);
+	hidePushButton(PB_WAV_CANCEL_JOBS);
+	hideSettingsButtons();
 	hideCheckBox(CB_WAV_BPM_MODE);
 	hideRadioButtonGroup(RB_GROUP_WAV_RENDER_BITDEPTH);
 
@@ -191,15 +302,31 @@ void exitWavRenderer(void)
 	hideWavRenderer();
 }
 
-static bool dump_Init(uint32_t frq, int16_t amp, int16_t songPos)
+static bool dump_Init(FILE *f, bool flacFlag, uint32_t frq, int16_t amp, int16_t songPos)
 {
 	int32_t bytesPerSample = (WDBitDepth / 8) * 2; // 2 channels
 	int32_t maxSamplesPerTick = (int32_t)ceil(frq / (MIN_BPM / 2.5)) + 1;
 
+	flacEncoder = NULL;
+	if (flacFlag) // 32-bit float is written as 24-bit FLAC
+	{
+		flacEncoder = openFlacEncoder(f, frq, 2, (WDBitDepth == 16) ? FLAC_INPUT_16BIT : FLAC_INPUT_FLOAT, 0, NULL, 0);
+		if (flacEncoder == NULL)
+			return false;
+	}
+
 	// *2 for stereo
-	wavRenderBuffer = (uint8_t *)malloc((TICKS_PER_RENDER_CHUNK * maxSamplesPerTick) * bytesPerSample);
-	if (wavRenderBuffer == NULL)
+	wavWriter = openRenderWriter(&f, &flacEncoder, 1, (TICKS_PER_RENDER_CHUNK * maxSamplesPerTick) * bytesPerSample, RENDER_WRITER_DEFAULT_BUFFERS);
+	if (wavWriter == NULL)
+	{
+		if (flacEncoder != NULL)
+		{
+			closeFlacEncoder(flacEncoder);
+			flacEncoder = NULL;
+		}
+
 		return false;
+	}
 
 	editor.wavIsRendering = true;
 
@@ -219,52 +346,90 @@ static bool dump_Init(uint32_t frq, int16_t amp, int16_t songPos)
 	return true;
 }
 
-static void dump_Close(FILE *f, uint32_t totalSamples)
+/* Goes back and fills in the WAV header (WAV_HEADER_SIZE bytes must have been skipped).
+** 'totalSamples' counts both channels. Files over 2GB are written as RF64, since
+** a lot of WAV readers treat the 32-bit RIFF sizes as signed.
+*/
+void writeWavHeader(FILE *f, uint32_t sampleRate, uint8_t bitDepth, uint64_t totalSamples)
 {
 	wavHeader_t wavHeader;
 
-	if (wavRenderBuffer != NULL)
-	{
-		free(wavRenderBuffer);
-		wavRenderBuffer = NULL;
-	}
-
-	uint32_t totalBytes;
-	if (WDBitDepth == 16)
+	uint64_t totalBytes;
+	if (bitDepth == 16)
 		totalBytes = totalSamples * sizeof (int16_t);
 	else
 		totalBytes = totalSamples * sizeof (float);
 
-	if (totalBytes & 1)
-		fputc(0, f); // write pad byte
-
-	uint32_t tmpLen = ftell(f)-8;
+	const uint64_t riffSize = (sizeof (wavHeader_t) - 8) + totalBytes;
+	const bool rf64Flag = (sizeof (wavHeader_t) + totalBytes) > INT32_MAX;
 
-	// go back and fill in WAV header
-	rewind(f);
+	if (rf64Flag)
+	{
+		wavHeader.chunkID = 0x34364652; // "RF64"
+		wavHeader.chunkSize = 0xFFFFFFFF; // the real sizes are in the "ds64" chunk
+		wavHeader.ds64ID = 0x34367364; // "ds64"
+		wavHeader.subchunk2Size = 0xFFFFFFFF;
+	}
+	else
+	{
+		wavHeader.chunkID = 0x46464952; // "RIFF"
+		wavHeader.chunkSize = (uint32_t)riffSize;
+		wavHeader.ds64ID = 0x4B4E554A; // "JUNK"
+		wavHeader.subchunk2Size = (uint32_t)totalBytes;
+	}
 
-	wavHeader.chunkID = 0x46464952; // "RIFF"
-	wavHeader.chunkSize = tmpLen;
 	wavHeader.format = 0x45564157; // "WAVE"
+
+	// "ds64" chunk contents (zeroed as "JUNK")
+	const uint64_t sampleCount = totalSamples / 2; // sample frames
+	wavHeader.ds64Size = 28;
+	wavHeader.riffSizeLo = rf64Flag ? (uint32_t)riffSize : 0;
+	wavHeader.riffSizeHi = rf64Flag ? (uint32_t)(riffSize >> 32) : 0;
+	wavHeader.dataSizeLo = rf64Flag ? (uint32_t)totalBytes : 0;
+	wavHeader.dataSizeHi = rf64Flag ? (uint32_t)(totalBytes >> 32) : 0;
+	wavHeader.sampleCountLo = rf64Flag ? (uint32_t)sampleCount : 0;
+	wavHeader.sampleCountHi = rf64Flag ? (uint32_t)(sampleCount >> 32) : 0;
+	wavHeader.tableLength = 0;
+
 	wavHeader.subchunk1ID = 0x20746D66; // "fmt "
 	wavHeader.subchunk1Size = 16;
 
-	if (WDBitDepth == 16)
+	if (bitDepth == 16)
 		wavHeader.audioFormat = WAV_FORMAT_PCM;
 	else
 		wavHeader.audioFormat = WAV_FORMAT_IEEE_FLOAT;
 
 	wavHeader.numChannels = 2;
-	wavHeader.sampleRate = WDFrequency;
-	wavHeader.byteRate = (wavHeader.sampleRate * wavHeader.numChannels * WDBitDepth) / 8;
-	wavHeader.blockAlign = (wavHeader.numChannels * WDBitDepth) / 8;
-	wavHeader.bitsPerSample = WDBitDepth;
+	wavHeader.sampleRate = sampleRate;
+	wavHeader.byteRate = (wavHeader.sampleRate * wavHeader.numChannels * bitDepth) / 8;
+	wavHeader.blockAlign = (wavHeader.numChannels * bitDepth) / 8;
+	wavHeader.bitsPerSample = bitDepth;
 	wavHeader.subchunk2ID = 0x61746164; // "data"
-	wavHeader.subchunk2Size = totalBytes;
 
 	// write main header
+	rewind(f);
 	fwrite(&wavHeader, 1, sizeof (wavHeader_t), f);
-	fclose(f);
+}
+
+static bool dump_Close(FILE *f, uint64_t totalSamples) // returns false if writing the sample data failed
+{
+	bool writeOk = closeRenderWriter(wavWriter); // waits for the pending writes
+	wavWriter = NULL;
+
+	if (flacEncoder != NULL)
+	{
+		if (!closeFlacEncoder(flacEncoder))
+			writeOk = false;
+
+		flacEncoder = NULL;
+	}
+	else
+	{
+		writeWavHeader(f, WDFrequency, WDBitDepth, totalSamples);
+	}
+
+	if (fclose(f) != 0)
+		writeOk = false;
 
 	stopPlaying();
 
@@ -278,33 +443,7 @@ static void dump_Close(FILE *f, uint32_t totalSamples)
 	editor.wavIsRendering = false;
 
 	setMouseBusy(false);
-}
-
-static bool dump_EndOfTune(int16_t endSongPos)
-{
-	bool returnValue = (editor.wavReachedEndFlag && song.row == 0 && song.tick == 1) || (song.speed == 0);
-
-	// FT2 bugfix for EEx (pattern delay) on first row of a pattern
-	if (song.pattDelTime2 > 0)
-		returnValue = false;
-
-	if (song.songPos == endSongPos && song.row == 0 && song.tick == 1)
-		editor.wavReachedEndFlag = true;
-
-	return returnValue;
-}
-
-void dump_TickReplayer(void)
-{
-	replayerBusy = true;
-
-	if (audio.volumeRampingFlag)
-		resetRampVolumes();
-
-	tickReplayer();
-	updateVoices();
-
-	replayerBusy = false;
+	return writeOk;
 }
 
 static void updateVisuals(void)
@@ -330,31 +469,33 @@ static int32_t SDLCALL renderWavThread(void *ptr)
 	(void)ptr;
 
 	FILE *f = (FILE *)editor.wavRendererFileHandle;
-	fseek(f, sizeof (wavHeader_t), SEEK_SET);
+	if (!renderToFlac)
+		fseek(f, WAV_HEADER_SIZE, SEEK_SET);
 
 	pauseAudio();
 
-	if (!dump_Init(WDFrequency, WDAmp, WDStartPos))
+	if (!dump_Init(f, renderToFlac, WDFrequency, WDAmp, WDStartPos))
 	{
+		fclose(f);
 		resumeAudio();
 		okBoxThreadSafe(0, "System message", "Not enough memory!");
 		return true;
 	}
 
-	uint32_t sampleCounter = 0;
-	bool overflow = false, renderDone = false;
+	uint64_t sampleCounter = 0;
+	bool renderDone = false;
 	uint8_t tickCounter = UPDATE_VISUALS_AT_TICK;
 	uint64_t tickSamplesFrac = 0;
 
-	uint64_t bytesInFile = sizeof (wavHeader_t);
-
 	editor.wavReachedEndFlag = false;
 	while (!renderDone)
 	{
 		uint32_t samplesInChunk = 0;
 
-		// render several ticks at once to prevent frequent disk I/O (speeds up the process)
-		uint8_t *ptr8 = wavRenderBuffer;
+		/* Render several ticks at once to prevent frequent disk I/O (speeds up the process).
+		** The writer thread writes the previous chunks to disk while we render this one.
+		*/
+		uint8_t *ptr8 = getRenderWriterBuffer(wavWriter);
 		for (uint32_t i = 0; i < TICKS_PER_RENDER_CHUNK; i++)
 		{
 			if (!editor.wavIsRendering || dump_EndOfTune(WDStopPos))
@@ -384,22 +525,9 @@ static int32_t SDLCALL renderWavThread(void *ptr)
 
 			// increase buffer pointer
 			if (WDBitDepth == 16)
-			{
 				ptr8 += tickSamples * sizeof (int16_t);
-				bytesInFile += tickSamples * sizeof (int16_t);
-			}
 			else
-			{
 				ptr8 += tickSamples * sizeof (float);
-				bytesInFile += tickSamples * sizeof (float);
-			}
-
-			if (bytesInFile >= INT32_MAX)
-			{
-				renderDone = true;
-				overflow = true;
-				break;
-			}
 
 			if (++tickCounter >= UPDATE_VISUALS_AT_TICK)
 			{
@@ -408,24 +536,24 @@ static int32_t SDLCALL renderWavThread(void *ptr)
 			}
 		}
 
-		// write buffer to disk
-		if (samplesInChunk > 0)
-		{
-			if (WDBitDepth == 16)
-				fwrite(wavRenderBuffer, sizeof (int16_t), samplesInChunk, f);
-			else
-				fwrite(wavRenderBuffer, sizeof (float), samplesInChunk, f);
-		}
+		// hand buffer over to the writer thread
+		if (WDBitDepth == 16)
+			queueRenderWriterBuffer(wavWriter, samplesInChunk * sizeof (int16_t));
+		else
+			queueRenderWriterBuffer(wavWriter, samplesInChunk * sizeof (float));
+
+		if (renderWriterFailed(wavWriter))
+			break;
 	}
 
 	updateVisuals();
 	drawPlaybackTime(); // this is needed after the song stopped
 
-	dump_Close(f, sampleCounter);
+	const bool writeOk = dump_Close(f, sampleCounter);
 	resumeAudio();
 
-	if (overflow)
-		okBoxThreadSafe(0, "System message", "Rendering stopped, file exceeded 2GB!");
+	if (!writeOk)
+		okBoxThreadSafe(0, "System message", "Error writing audio file: general I/O error! Is the disk full?");
 
 	editor.diskOpReadOnOpen = true;
 	return true;
@@ -438,9 +566,12 @@ static void wavRender(bool checkOverwrite)
 
 	updateWavRenderer();
 
-	diskOpChangeFilenameExt(".wav");
-
 	char *filename = getDiskOpFilename();
+
+	renderToFlac = filenameIsFlac(filename); // typing a ".flac" filename renders to FLAC instead
+	if (!renderToFlac)
+		diskOpChangeFilenameExt(".wav");
+
 	if (checkOverwrite && fileExistsAnsi(filename))
 	{
 		char buf[256];
@@ -478,6 +609,90 @@ void pbWavExit(void)
 	exitWavRenderer();
 }
 
+/* Same as exporting, but the song file is rendered in the background by the render
+** queue, so the export settings can be changed and more jobs queued right away (other
+** songs or song position ranges). The "Imprecise BPM" mode isn't used for queued jobs.
+*/
+void pbWavQueue(void)
+{
+	renderJobSettings_t settings;
+
+	if (!renderQueueSupported())
+	{
+		okBox(0, "System message", "The render queue isn't supported on this system.");
+		return;
+	}
+
+	const char *songPath = getRenderQueueSongPath();
+	if (songPath == NULL)
+	{
+		okBox(0, "System message", "The song must be saved to disk before it can be queued!");
+		return;
+	}
+
+	if (song.isModified && okBox(2, "System request", "The song has unsaved changes. Queue the song as it was last saved?") != 1)
+		return;
+
+	WDStartPos = (uint8_t)(MAX(0, MIN(WDStartPos, song.songLength - 1)));
+	WDStopPos  = (uint8_t)(MAX(0, MIN(MAX(WDStartPos, WDStopPos), song.songLength - 1)));
+
+	updateWavRenderer();
+
+	char *filename = getDiskOpFilename();
+	if (!filenameIsFlac(filename))
+		diskOpChangeFilenameExt(".wav");
+
+	if (config.cfg_OverwriteWarning && fileExistsAnsi(filename))
+	{
+		char buf[256];
+		createFileOverwriteText(filename, buf);
+		if (okBox(2, "System request", buf) != 1)
+			return;
+	}
+
+	settings.freq = WDFrequency;
+	settings.bitDepth = WDBitDepth;
+	settings.interpolation = config.interpolation;
+	settings.volumeRamp = audio.volumeRampingFlag;
+	settings.amp = WDAmp;
+	settings.masterVol = config.masterVol;
+	settings.startPos = WDStartPos;
+	settings.endPos = WDStopPos;
+
+	addRenderJob(songPath, filename, &settings);
+	drawWavRendererQueueStatus();
+}
+
+void pbWavJobs(void) // toggles between the settings and the render queue's job list
+{
+	if (!renderQueueSupported())
+	{
+		okBox(0, "System message", "The render queue isn't supported on this system.");
+		return;
+	}
+
+	showJobList ^= 1;
+
+	if (showJobList)
+		hideSettingsButtons();
+	else
+		hidePushButton(PB_WAV_CANCEL_JOBS);
+
+	drawWavRenderer();
+}
+
+void pbWavCancelJobs(void)
+{
+	if (!renderQueueBusy())
+		return;
+
+	if (okBox(2, "System request", "Stop the render queue? The files that aren't done yet are deleted.") != 1)
+		return;
+
+	cancelRenderJobs();
+	drawWavRendererQueueStatus();
+}
+
 void pbWavFreqUp(void)
 {
 	if (WDFrequency < MAX_WAV_RENDER_FREQ)
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
 #include "ft2_header.h"
 #include "ft2_cpu.h"
 
 #define MIN_WAV_RENDER_FREQ 44100
+#define WAV_HEADER_SIZE 80 // RIFF/RF64 header with room for a "ds64" chunk
 
 #if CPU_64BIT
 #define MAX_WAV_RENDER_FREQ 384000
@@ -16,12 +18,16 @@ void cbToggleWavRenderBPMMode(void);
 void setWavRenderFrequency(int32_t freq);
 void setWavRenderBitDepth(uint8_t bitDepth);
 void updateWavRendererSettings(void);
+void drawWavRendererQueueStatus(void);
 void drawWavRenderer(void);
 void showWavRenderer(void);
 void hideWavRenderer(void);
 void exitWavRenderer(void);
 void pbWavRender(void);
 void pbWavExit(void);
+void pbWavQueue(void);
+void pbWavJobs(void);
+void pbWavCancelJobs(void);
 void pbWavFreqUp(void);
 void pbWavFreqDown(void);
 void pbWavAmpUp(void);
@@ -33,3 +39,6 @@ void pbWavSongEndDown(void);
 void resetWavRenderer(void);
 void rbWavRenderBitDepth16(void);
 void rbWavRenderBitDepth32(void);
+
+// also used by the headless command-line modes
+void writeWavHeader(FILE *f, uint32_t sampleRate, uint8_t bitDepth, uint64_t totalSamples);
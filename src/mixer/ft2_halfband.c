@@ -0,0 +1,60 @@
+#include <stdint.h>
+#include <math.h>
+#include "ft2_halfband.h"
+
+#define MY_PI 3.14159265358979323846264338327950288
+#define KAISER_BETA 10.0 // ~100dB stopband
+
+static float fCoeffs[HALFBAND_TAPS]; // taps at center +/- 1, 3, 5 ...
+
+static double Izero(double y) // Bessel function Izero(y), same as in ft2_windowed_sinc.c
+{
+	double s = 1.0, ds = 1.0, d = 0.0;
+
+	do
+	{
+		d = d + 2.0;
+		ds = ds * (y * y) / (d * d);
+		s = s + ds;
+	}
+	while (ds > 1E-9 * s);
+
+	return s;
+}
+
+void calcHalfBandFilter(void)
+{
+	double dCoeffs[HALFBAND_TAPS], dSum = 0.0;
+
+	const double dHalfLen = (HALFBAND_LEN + 1) / 2.0;
+	const double dIzeroBeta = Izero(KAISER_BETA);
+
+	for (int32_t i = 0; i < HALFBAND_TAPS; i++)
+	{
+		const double x = (i * 2) + 1; // distance from the center tap
+
+		const double dSinc = sin(x * (MY_PI / 2.0)) / (x * MY_PI); // ideal half-band: 0.5 * sinc(x/2)
+		const double dWindow = Izero(KAISER_BETA * sqrt(1.0 - ((x / dHalfLen) * (x / dHalfLen)))) / dIzeroBeta;
+
+		dCoeffs[i] = dSinc * dWindow;
+		dSum += dCoeffs[i];
+	}
+
+	// unity gain at DC: 0.5 (center tap) + 2 * sum = 1.0
+	for (int32_t i = 0; i < HALFBAND_TAPS; i++)
+		fCoeffs[i] = (float)(dCoeffs[i] * (0.25 / dSum));
+}
+
+void halfBandDecimate(const float *fIn, float *fOut, uint32_t numOutput)
+{
+	const float *fCenter = fIn - (HALFBAND_HISTORY / 2) + 1; // newest input sample of the filter is fCenter[HALFBAND_LEN/2]
+
+	for (uint32_t i = 0; i < numOutput; i++, fCenter += 2)
+	{
+		float fOut32 = fCenter[0] * 0.5f;
+		for (int32_t j = 0; j < HALFBAND_TAPS; j++)
+			fOut32 += fCoeffs[j] * (fCenter[-((j * 2) + 1)] + fCenter[(j * 2) + 1]);
+
+		*fOut++ = fOut32;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Half-band lowpass FIR for 2x oversampled mixing. Every other tap of a half-band
+** filter is zero (and the center tap is 0.5), so only the odd taps are stored, and
+** they're symmetric. That's HALFBAND_TAPS multiplies per output sample for a 127-tap
+** filter, since only every other output sample is calculated when decimating.
+**
+** Passband up to ~0.45 * output rate (21.6kHz at 48kHz), ~100dB stopband attenuation.
+** The filter delays the output by HALFBAND_HISTORY/2 (31.5) output samples.
+*/
+
+#define HALFBAND_TAPS 32 // non-zero taps on each side of the center tap
+#define HALFBAND_LEN ((HALFBAND_TAPS * 4) - 1)
+#define HALFBAND_HISTORY (HALFBAND_LEN - 1) // input samples needed before the first new one
+
+void calcHalfBandFilter(void);
+
+/* Writes 'numOutput' samples to fOut from numOutput*2 input samples at fIn. The
+** HALFBAND_HISTORY input samples before fIn (the end of the last call's input) are
+** read too.
+*/
+void halfBandDecimate(const float *fIn, float *fOut, uint32_t numOutput);
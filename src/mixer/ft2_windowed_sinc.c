@@ -9,7 +9,9 @@
 #include <stdlib.h>
 #include <math.h>
 #include "ft2_windowed_sinc.h"
+#ifndef FT2_HEADLESS
 #include "../ft2_video.h" // showErrorMsgBox()
+#endif
 
 #define MY_PI 3.14159265358979323846264338327950288
 
@@ -81,7 +83,9 @@ bool calcWindowedSincTables(void)
 	if (fKaiserSinc_8  == NULL || fDownSample1_8  == NULL || fDownSample2_8  == NULL ||
 		fKaiserSinc_16 == NULL || fDownSample1_16 == NULL || fDownSample2_16 == NULL)
 	{
+#ifndef FT2_HEADLESS
 		showErrorMsgBox("Not enough memory!");
+#endif
 		return false;
 	}
 
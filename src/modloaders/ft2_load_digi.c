@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../ft2_header.h"
+#include "../ft2_load_stream.h"
 #include "../ft2_module_loader.h"
 #include "../ft2_sample_ed.h"
 #include "../ft2_tables.h"
@@ -44,9 +45,10 @@ digiHdr_t;
 #pragma pack(pop)
 #endif
 
-static void readPatternNote(FILE *f, note_t *p);
+static void skipPattern(LFILE *f, bool packed);
+static void readPatternNote(LFILE *f, note_t *p);
 
-bool loadDIGI(FILE *f, uint32_t filesize)
+bool loadDIGI(LFILE *f, uint32_t filesize)
 {
 	int16_t i, j, k;
 	sample_t *s;
@@ -61,7 +63,7 @@ bool loadDIGI(FILE *f, uint32_t filesize)
 	}
 
 	memset(&hdr, 0, sizeof (hdr));
-	if (fread(&hdr, 1, sizeof (hdr), f) != sizeof (hdr))
+	if (lfread(&hdr, 1, sizeof (hdr), f) != sizeof (hdr))
 	{
 		loaderMsgBox("Error: This file is either not a module, or is not supported.");
 		return false;
@@ -92,6 +94,12 @@ bool loadDIGI(FILE *f, uint32_t filesize)
 	// load pattern data
 	for (i = 0; i < hdr.numPatterns; i++)
 	{
+		if (tmpLoaderFlags & LOADER_SKIP_PATTERNS)
+		{
+			skipPattern(f, hdr.packedPatternsFlag);
+			continue;
+		}
+
 		if (!allocateTmpPatt(i, 64))
 		{
 			loaderMsgBox("Not enough memory!");
@@ -103,15 +111,15 @@ bool loadDIGI(FILE *f, uint32_t filesize)
 			uint16_t pattSize;
 			uint8_t bitMasks[64];
 
-			fread(&pattSize, 2, 1, f); pattSize = SWAP16(pattSize);
-			fread(bitMasks, 1, 64, f);
+			lfread(&pattSize, 2, 1, f); pattSize = SWAP16(pattSize);
+			lfread(bitMasks, 1, 64, f);
 
 			for (j = 0; j < 64; j++)
 			{
 				uint8_t bit = 128;
 				for (k = 0; k < songTmp.numChannels; k++, bit >>= 1)
 				{
-					note_t *p = &patternTmp[i][(j * MAX_CHANNELS) + k];
+					note_t *p = &patternTmp[i][(j * songTmp.numChannels) + k];
 					if (bitMasks[j] & bit)
 						readPatternNote(f, p);
 				}
@@ -122,7 +130,7 @@ bool loadDIGI(FILE *f, uint32_t filesize)
 			for (j = 0; j < songTmp.numChannels; j++)
 			{
 				for (k = 0; k < 64; k++)
-					readPatternNote(f, &patternTmp[i][(k * MAX_CHANNELS) + j]);
+					readPatternNote(f, &patternTmp[i][(k * songTmp.numChannels) + j]);
 			}
 		}
 
@@ -146,7 +154,7 @@ bool loadDIGI(FILE *f, uint32_t filesize)
 		{
 			for (k = 0; k < songTmp.numChannels; k++)
 			{
-				note_t *p = &patternTmp[i][(j * MAX_CHANNELS) + k];
+				note_t *p = &patternTmp[i][(j * songTmp.numChannels) + k];
 
 				if (p->efx == 0x8) // Robot effect (not supported)
 				{
@@ -219,13 +227,19 @@ bool loadDIGI(FILE *f, uint32_t filesize)
 			s->loopLength = 0;
 		}
 
+		if (tmpLoaderFlags & LOADER_SKIP_SAMPLE_DATA)
+		{
+			lfseek(f, s->length, SEEK_CUR);
+			continue;
+		}
+
 		if (!allocateSmpData(s, s->length, false))
 		{
 			loaderMsgBox("Not enough memory!");
 			return false;
 		}
 
-		int32_t bytesRead = (int32_t)fread(s->dataPtr, 1, s->length, f);
+		int32_t bytesRead = (int32_t)lfread(s->dataPtr, 1, s->length, f);
 		if (bytesRead < s->length)
 		{
 			int32_t bytesToClear = s->length - bytesRead;
@@ -236,10 +250,38 @@ bool loadDIGI(FILE *f, uint32_t filesize)
 	return true;
 }
 
-static void readPatternNote(FILE *f, note_t *p)
+static void skipPattern(LFILE *f, bool packed) // for metadata-only loads
+{
+	if (packed)
+	{
+		uint8_t bitMasks[64];
+
+		lfseek(f, 2, SEEK_CUR); // pattern size
+		lfread(bitMasks, 1, 64, f);
+
+		int32_t numNotes = 0;
+		for (int32_t j = 0; j < 64; j++)
+		{
+			uint8_t bit = 128;
+			for (int32_t k = 0; k < songTmp.numChannels; k++, bit >>= 1)
+			{
+				if (bitMasks[j] & bit)
+					numNotes++;
+			}
+		}
+
+		lfseek(f, numNotes * 4, SEEK_CUR);
+	}
+	else
+	{
+		lfseek(f, songTmp.numChannels * 64 * 4, SEEK_CUR);
+	}
+}
+
+static void readPatternNote(LFILE *f, note_t *p)
 {
 	uint8_t bytes[4];
-	fread(bytes, 1, 4, f);
+	lfread(bytes, 1, 4, f);
 
 	// period to note
 	uint16_t period = ((bytes[0] & 0x0F) << 8) | bytes[1];
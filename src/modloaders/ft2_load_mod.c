@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../ft2_header.h"
+#include "../ft2_load_stream.h"
 #include "../ft2_module_loader.h"
 #include "../ft2_sample_ed.h"
 #include "../ft2_tables.h"
@@ -27,7 +28,7 @@ enum // supported 31-sample .MOD types
 
 static uint8_t getModType(uint8_t *numChannels, const char *id);
 
-bool loadMOD(FILE *f, uint32_t filesize)
+bool loadMOD(LFILE *f, uint32_t filesize)
 {
 	uint8_t bytes[4], modFormat, numChannels;
 	int16_t i, j, k;
@@ -44,7 +45,7 @@ bool loadMOD(FILE *f, uint32_t filesize)
 	}
 
 	memset(&hdr, 0, sizeof (hdr));
-	if (fread(&hdr, 1, sizeof (hdr), f) != sizeof (hdr))
+	if (lfread(&hdr, 1, sizeof (hdr), f) != sizeof (hdr))
 	{
 		loaderMsgBox("Error: This file is either not a module, or is not supported.");
 		return false;
@@ -99,6 +100,12 @@ bool loadMOD(FILE *f, uint32_t filesize)
 	}
 	b++;
 
+	if (tmpLoaderFlags & LOADER_SKIP_PATTERNS)
+	{
+		lfseek(f, b * 64 * numChannels * 4, SEEK_CUR); // FLT8 patterns are stored as two 4-channel halves, same size
+		b = 0;
+	}
+
 	// load pattern data
 	if (modFormat != FORMAT_FLT8)
 	{
@@ -116,8 +123,8 @@ bool loadMOD(FILE *f, uint32_t filesize)
 			{
 				for (k = 0; k < songTmp.numChannels; k++)
 				{
-					note_t *p = &patternTmp[a][(j * MAX_CHANNELS) + k];
-					fread(bytes, 1, 4, f);
+					note_t *p = &patternTmp[a][(j * songTmp.numChannels) + k];
+					lfread(bytes, 1, 4, f);
 
 					// period to note
 					uint16_t period = ((bytes[0] & 0x0F) << 8) | bytes[1];
@@ -138,7 +145,7 @@ bool loadMOD(FILE *f, uint32_t filesize)
 				if (tooManyChannels)
 				{
 					int32_t remainingChans = numChannels-songTmp.numChannels;
-					fseek(f, remainingChans*4, SEEK_CUR);
+					lfseek(f, remainingChans*4, SEEK_CUR);
 				}
 			}
 
@@ -174,8 +181,8 @@ bool loadMOD(FILE *f, uint32_t filesize)
 			{
 				for (k = 0; k < 4; k++)
 				{
-					note_t *p = &patternTmp[pattNum][(j * MAX_CHANNELS) + (k+chnOffset)];
-					fread(bytes, 1, 4, f);
+					note_t *p = &patternTmp[pattNum][(j * songTmp.numChannels) + (k+chnOffset)];
+					lfread(bytes, 1, 4, f);
 
 					// period to note
 					uint16_t period = ((bytes[0] & 0x0F) << 8) | bytes[1];
@@ -218,7 +225,7 @@ bool loadMOD(FILE *f, uint32_t filesize)
 		{
 			for (k = 0; k < songTmp.numChannels; k++)
 			{
-				note_t *p = &patternTmp[a][(j * MAX_CHANNELS) + k];
+				note_t *p = &patternTmp[a][(j * songTmp.numChannels) + k];
 
 				if (p->efx == 0xC)
 				{
@@ -338,17 +345,24 @@ bool loadMOD(FILE *f, uint32_t filesize)
 		if (s->loopStart+s->loopLength > 2)
 			s->flags |= LOOP_FWD; // enable loop
 
-		if (!allocateSmpData(s, s->length, false))
+		if (tmpLoaderFlags & LOADER_SKIP_SAMPLE_DATA)
 		{
-			loaderMsgBox("Not enough memory!");
-			return false;
+			lfseek(f, s->length, SEEK_CUR);
 		}
-
-		int32_t bytesRead = (int32_t)fread(s->dataPtr, 1, s->length, f);
-		if (bytesRead < s->length)
+		else
 		{
-			int32_t bytesToClear = s->length - bytesRead;
-			memset(&s->dataPtr[bytesRead], 0, bytesToClear);
+			if (!allocateSmpData(s, s->length, false))
+			{
+				loaderMsgBox("Not enough memory!");
+				return false;
+			}
+
+			int32_t bytesRead = (int32_t)lfread(s->dataPtr, 1, s->length, f);
+			if (bytesRead < s->length)
+			{
+				int32_t bytesToClear = s->length - bytesRead;
+				memset(&s->dataPtr[bytesRead], 0, bytesToClear);
+			}
 		}
 
 		if (GET_LOOPTYPE(s->flags) == LOOP_OFF) // clear loopLength and loopStart on non-looping samples...
@@ -359,7 +373,7 @@ bool loadMOD(FILE *f, uint32_t filesize)
 	}
 
 	if (tooManyChannels)
-		loaderMsgBox("Warning: Module contains >32 channels. The extra channels will be discarded!");
+		loaderMsgBox("Warning: Module contains >%d channels. The extra channels will be discarded!", MAX_CHANNELS);
 
 	return true;
 }
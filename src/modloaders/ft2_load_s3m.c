@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../ft2_header.h"
+#include "../ft2_load_stream.h"
 #include "../ft2_module_loader.h"
 #include "../ft2_sample_ed.h"
 #include "../ft2_tables.h"
@@ -51,11 +52,12 @@ s3mHdr_t;
 #pragma pack(pop)
 #endif
 
-static uint8_t pattBuff[12288];
+static LOADER_THREAD_LOCAL uint8_t pattBuff[12288];
 
 static int8_t countS3MChannels(uint16_t antPtn);
+static int8_t countS3MHeaderChannels(const s3mHdr_t *hdr);
 
-bool loadS3M(FILE *f, uint32_t filesize)
+bool loadS3M(LFILE *f, uint32_t filesize)
 {
 	uint8_t alastnfo[32], alastefx[32], alastvibnfo[32], s3mLastGInstr[32];
 	int16_t ii, kk, tmp;
@@ -74,13 +76,14 @@ bool loadS3M(FILE *f, uint32_t filesize)
 	}
 
 	memset(&hdr, 0, sizeof (hdr));
-	if (fread(&hdr, 1, sizeof (hdr), f) != sizeof (hdr))
+	if (lfread(&hdr, 1, sizeof (hdr), f) != sizeof (hdr))
 	{
 		loaderMsgBox("Error: This file is either not a module, or is not supported.");
 		return false;
 	}
 
-	if (hdr.numSamples > MAX_INST || hdr.numOrders > MAX_ORDERS || hdr.numPatterns > MAX_PATTERNS ||
+	// these are unsigned in the file, compare them as such so that 32768+ doesn't pass as negative
+	if ((uint16_t)hdr.numSamples > MAX_INST || (uint16_t)hdr.numOrders > MAX_ORDERS || (uint16_t)hdr.numPatterns > MAX_PATTERNS ||
 		hdr.type != 16 || hdr.version < 1 || hdr.version > 2)
 	{
 		loaderMsgBox("Error loading .s3m: Incompatible module!");
@@ -88,7 +91,7 @@ bool loadS3M(FILE *f, uint32_t filesize)
 	}
 
 	memset(songTmp.orders, 255, 256); // pad by 255
-	if (fread(songTmp.orders, hdr.numOrders, 1, f) != 1)
+	if (lfread(songTmp.orders, hdr.numOrders, 1, f) != 1)
 	{
 		loaderMsgBox("General I/O error during loading! Is the file in use?");
 		return false;
@@ -134,7 +137,7 @@ bool loadS3M(FILE *f, uint32_t filesize)
 	for (int32_t i = 0; i < hdr.numSamples; i++)
 	{
 		uint16_t offset;
-		if (fread(&offset, 2, 1, f) != 1)
+		if (lfread(&offset, 2, 1, f) != 1)
 		{
 			loaderMsgBox("General I/O error during loading! Is the file in use?");
 			return false;
@@ -147,7 +150,7 @@ bool loadS3M(FILE *f, uint32_t filesize)
 	for (int32_t i = 0; i < hdr.numPatterns; i++)
 	{
 		uint16_t offset;
-		if (fread(&offset, 2, 1, f) != 1)
+		if (lfread(&offset, 2, 1, f) != 1)
 		{
 			loaderMsgBox("General I/O error during loading! Is the file in use?");
 			return false;
@@ -158,22 +161,23 @@ bool loadS3M(FILE *f, uint32_t filesize)
 
 	// *** PATTERNS ***
 
+	songTmp.numChannels = 32; // load at S3M width, the real channel count is set after loading
 	k = 0;
 	for (int32_t i = 0; i < hdr.numPatterns; i++)
 	{
-		if (patternOffsets[i]  == 0)
-			continue; // empty pattern
+		if (patternOffsets[i]  == 0 || (tmpLoaderFlags & LOADER_SKIP_PATTERNS))
+			continue; // empty pattern (or not loaded)
 
 		memset(alastnfo, 0, sizeof (alastnfo));
 		memset(alastefx, 0, sizeof (alastefx));
 		memset(alastvibnfo, 0, sizeof (alastvibnfo));
 		memset(s3mLastGInstr, 0, sizeof (s3mLastGInstr));
 
-		fseek(f, patternOffsets[i], SEEK_SET);
-		if (feof(f))
+		lfseek(f, patternOffsets[i], SEEK_SET);
+		if (lfeof(f))
 			continue;
 
-		if (fread(&j, 2, 1, f) != 1)
+		if (lfread(&j, 2, 1, f) != 1)
 		{
 			loaderMsgBox("General I/O error during loading! Is the file in use?");
 			return false;
@@ -187,7 +191,7 @@ bool loadS3M(FILE *f, uint32_t filesize)
 				return false;
 			}
 
-			fread(pattBuff, j, 1, f);
+			lfread(pattBuff, j, 1, f);
 
 			k = 0;
 			kk = 0;
@@ -484,7 +488,7 @@ bool loadS3M(FILE *f, uint32_t filesize)
 					if (tmpNote.instr != 0 && tmpNote.efx != 0x3)
 						s3mLastGInstr[ii] = tmpNote.instr;
 
-					patternTmp[i][(kk * MAX_CHANNELS) + ii] = tmpNote;
+					patternTmp[i][(kk * 32) + ii] = tmpNote;
 				}
 			}
 
@@ -507,9 +511,9 @@ bool loadS3M(FILE *f, uint32_t filesize)
 		if (sampleOffsets[i] == 0)
 			continue;
 
-		fseek(f, sampleOffsets[i], SEEK_SET);
+		lfseek(f, sampleOffsets[i], SEEK_SET);
 
-		if (fread(&smpHdr, 1, sizeof (smpHdr), f) != sizeof (smpHdr))
+		if (lfread(&smpHdr, 1, sizeof (smpHdr), f) != sizeof (smpHdr))
 		{
 			loaderMsgBox("Not enough memory!");
 			return false;
@@ -529,7 +533,7 @@ bool loadS3M(FILE *f, uint32_t filesize)
 				loaderMsgBox("Error loading .s3m: Incompatible module!");
 				return false;
 			}
-			else if (offsetInFile > 0 && smpHdr.length > 0)
+			else if (offsetInFile > 0 && offsetInFile < (int32_t)filesize && smpHdr.length > 0) // no data in the file = empty sample
 			{
 				if (!allocateTmpInstr((int16_t)(1 + i)))
 				{
@@ -571,7 +575,8 @@ bool loadS3M(FILE *f, uint32_t filesize)
 					lengthInFile <<= 1;
 				}
 
-				if (!allocateSmpData(s, s->length, sample16Bit))
+				const bool loadSampleData = !(tmpLoaderFlags & LOADER_SKIP_SAMPLE_DATA);
+				if (loadSampleData && !allocateSmpData(s, s->length, sample16Bit))
 				{
 					loaderMsgBox("Not enough memory!");
 					return false;
@@ -587,15 +592,20 @@ bool loadS3M(FILE *f, uint32_t filesize)
 				if (hasLoop)
 					s->flags |= LOOP_FWD;
 
-				fseek(f, offsetInFile, SEEK_SET);
+				lfseek(f, offsetInFile, SEEK_SET);
 
 				if (hdr.version == 1)
 				{
-					fseek(f, lengthInFile, SEEK_CUR); // sample not supported
+					lfseek(f, lengthInFile, SEEK_CUR); // sample not supported
+				}
+				else if (!loadSampleData)
+				{
+					if (stereoSample) // same as after the downmixing below
+						s->length >>= 1;
 				}
 				else
 				{
-					if (fread(s->dataPtr, SAMPLE_LENGTH_BYTES(s), 1, f) != 1)
+					if (lfread(s->dataPtr, SAMPLE_LENGTH_BYTES(s), 1, f) != 1)
 					{
 						loaderMsgBox("General I/O error during loading! Is the file in use?");
 						return false;
@@ -617,7 +627,14 @@ bool loadS3M(FILE *f, uint32_t filesize)
 		}
 	}
 
-	songTmp.numChannels = countS3MChannels(hdr.numPatterns);
+	const int32_t numChannels = (tmpLoaderFlags & LOADER_SKIP_PATTERNS) ? countS3MHeaderChannels(&hdr) : countS3MChannels(hdr.numPatterns);
+	if (!resizePatternChannels(patternTmp, songTmp.numChannels, numChannels))
+	{
+		loaderMsgBox("Not enough memory!");
+		return false;
+	}
+	songTmp.numChannels = numChannels;
+
 #ifndef FT2_HEADLESS
 	if (adlibInsWarn)
 		loaderMsgBox("Warning: The module contains unsupported AdLib instruments!");
@@ -641,7 +658,7 @@ static int8_t countS3MChannels(uint16_t antPtn)
 		note_t *p = patternTmp[i];
 		for (int32_t j = 0; j < 64; j++)
 		{
-			for (int32_t k = 0; k < MAX_CHANNELS; k++, p++)
+			for (int32_t k = 0; k < 32; k++, p++)
 			{
 				if (p->note == 0 && p->instr == 0 && p->vol == 0 && p->efx == 0 && p->efxData == 0)
 					continue;
@@ -655,3 +672,18 @@ static int8_t countS3MChannels(uint16_t antPtn)
 
 	return (int8_t)channels;
 }
+
+/* Without the patterns, the channel count comes from the header's enabled channels.
+** These can include unused channels, so it's not always the same as countS3MChannels().
+*/
+static int8_t countS3MHeaderChannels(const s3mHdr_t *hdr)
+{
+	int32_t channels = 1;
+	for (int32_t i = 0; i < 32; i++)
+	{
+		if (hdr->chnSettings[i] < 16) // enabled PCM channel (bit 7 = disabled, 16+ = AdLib)
+			channels = i + 1;
+	}
+
+	return (int8_t)channels;
+}
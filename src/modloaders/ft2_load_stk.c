@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../ft2_header.h"
+#include "../ft2_load_stream.h"
 #include "../ft2_module_loader.h"
 #include "../ft2_sample_ed.h"
 #include "../ft2_tables.h"
@@ -31,7 +32,7 @@ stkHdr_t;
 #pragma pack(pop)
 #endif
 
-bool loadSTK(FILE *f, uint32_t filesize)
+bool loadSTK(LFILE *f, uint32_t filesize)
 {
 	uint8_t bytes[4];
 	int16_t i, j, k;
@@ -51,7 +52,7 @@ bool loadSTK(FILE *f, uint32_t filesize)
 	}
 
 	memset(&h, 0, sizeof (stkHdr_t));
-	if (fread(&h, 1, sizeof (h), f) != sizeof (h))
+	if (lfread(&h, 1, sizeof (h), f) != sizeof (h))
 	{
 		loaderMsgBox("Error: This file is either not a module, or is not supported.");
 		return false;
@@ -111,6 +112,12 @@ bool loadSTK(FILE *f, uint32_t filesize)
 	}
 	b++;
 
+	if (tmpLoaderFlags & LOADER_SKIP_PATTERNS)
+	{
+		lfseek(f, b * 64 * 4 * 4, SEEK_CUR);
+		b = 0;
+	}
+
 	for (a = 0; a < b; a++)
 	{
 		if (!allocateTmpPatt(a, 64))
@@ -123,9 +130,9 @@ bool loadSTK(FILE *f, uint32_t filesize)
 		{
 			for (k = 0; k < songTmp.numChannels; k++)
 			{
-				note_t *p = &patternTmp[a][(j * MAX_CHANNELS) + k];
+				note_t *p = &patternTmp[a][(j * songTmp.numChannels) + k];
 
-				if (fread(bytes, 1, 4, f) != 4)
+				if (lfread(bytes, 1, 4, f) != 4)
 				{
 					loaderMsgBox("Error: This file is either not a module, or is not supported.");
 					return false;
@@ -221,7 +228,7 @@ bool loadSTK(FILE *f, uint32_t filesize)
 		{
 			for (k = 0; k < songTmp.numChannels; k++)
 			{
-				note_t *p = &patternTmp[a][(j * MAX_CHANNELS) + k];
+				note_t *p = &patternTmp[a][(j * songTmp.numChannels) + k];
 
 				// convert STK effects to PT effects
 
@@ -328,17 +335,23 @@ bool loadSTK(FILE *f, uint32_t filesize)
 		if (s->loopStart > 0 && s->loopLength < s->length)
 		{
 			s->length -= s->loopStart;
-			fseek(f, s->loopStart, SEEK_CUR);
+			lfseek(f, s->loopStart, SEEK_CUR);
 			s->loopStart = 0;
 		}
 
+		if (tmpLoaderFlags & LOADER_SKIP_SAMPLE_DATA)
+		{
+			lfseek(f, s->length, SEEK_CUR);
+			continue;
+		}
+
 		if (!allocateSmpData(s, s->length, false))
 		{
 			loaderMsgBox("Not enough memory!");
 			return false;
 		}
 
-		int32_t bytesRead = (int32_t)fread(s->dataPtr, 1, s->length, f);
+		int32_t bytesRead = (int32_t)lfread(s->dataPtr, 1, s->length, f);
 		if (bytesRead < s->length)
 		{
 			int32_t bytesToClear = s->length - bytesRead;
@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../ft2_header.h"
+#include "../ft2_load_stream.h"
 #include "../ft2_module_loader.h"
 #include "../ft2_sample_ed.h"
 #include "../ft2_tables.h"
@@ -50,11 +51,11 @@ stmHdr_t;
 #endif
 
 static const uint8_t stmEfx[16] = { 0, 0, 11, 0, 10, 2, 1, 3, 4, 7, 0, 5, 6, 0, 0, 0 };
-static uint8_t pattBuff[64*4*4];
+static LOADER_THREAD_LOCAL uint8_t pattBuff[64*4*4];
 
 static uint16_t stmTempoToBPM(uint8_t tempo);
 
-bool loadSTM(FILE *f, uint32_t filesize)
+bool loadSTM(LFILE *f, uint32_t filesize)
 {
 	int16_t i, j, k;
 	stmHdr_t hdr;
@@ -67,7 +68,7 @@ bool loadSTM(FILE *f, uint32_t filesize)
 		return false;
 	}
 
-	if (fread(&hdr, 1, sizeof (hdr), f) != sizeof (hdr))
+	if (lfread(&hdr, 1, sizeof (hdr), f) != sizeof (hdr))
 	{
 		loaderMsgBox("Error: This file is either not a module, or is not supported.");
 		return false;
@@ -102,6 +103,12 @@ bool loadSTM(FILE *f, uint32_t filesize)
 	songTmp.BPM = stmTempoToBPM(tempo);
 	songTmp.speed = hdr.tempo >> 4;
 
+	if (tmpLoaderFlags & LOADER_SKIP_PATTERNS)
+	{
+		lfseek(f, hdr.numPatterns * (64 * 4 * 4), SEEK_CUR);
+		hdr.numPatterns = 0;
+	}
+
 	for (i = 0; i < hdr.numPatterns; i++)
 	{
 		if (!allocateTmpPatt(i, 64))
@@ -110,7 +117,7 @@ bool loadSTM(FILE *f, uint32_t filesize)
 			return false;
 		}
 
-		if (fread(pattBuff, 64 * 4 * 4, 1, f) != 1)
+		if (lfread(pattBuff, 64 * 4 * 4, 1, f) != 1)
 		{
 			loaderMsgBox("General I/O error during loading!");
 			return false;
@@ -121,7 +128,7 @@ bool loadSTM(FILE *f, uint32_t filesize)
 		{
 			for (k = 0; k < 4; k++, pattPtr += 4)
 			{
-				note_t *p = &patternTmp[i][(j * MAX_CHANNELS) + k];
+				note_t *p = &patternTmp[i][(j * songTmp.numChannels) + k];
 				
 				if (pattPtr[0] == 254)
 				{
@@ -200,7 +207,8 @@ bool loadSTM(FILE *f, uint32_t filesize)
 
 			sample_t *s = &instrTmp[1+i]->smp[0];
 
-			if (!allocateSmpData(s, hdr.smp[i].length, false))
+			const bool loadSampleData = !(tmpLoaderFlags & LOADER_SKIP_SAMPLE_DATA);
+			if (loadSampleData && !allocateSmpData(s, hdr.smp[i].length, false))
 			{
 				loaderMsgBox("Not enough memory!");
 				return false;
@@ -227,7 +235,11 @@ bool loadSTM(FILE *f, uint32_t filesize)
 				s->loopLength = 0;
 			}
 
-			if (fread(s->dataPtr, s->length, 1, f) != 1)
+			if (!loadSampleData)
+			{
+				lfseek(f, s->length, SEEK_CUR);
+			}
+			else if (lfread(s->dataPtr, s->length, 1, f) != 1)
 			{
 				loaderMsgBox("General I/O error during loading! Possibly corrupt module?");
 				return false;
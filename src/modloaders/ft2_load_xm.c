@@ -8,27 +8,27 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../ft2_header.h"
+#include "../ft2_load_stream.h"
 #include "../ft2_module_loader.h"
 #include "../ft2_sample_ed.h"
 #include "../ft2_tables.h"
 #include "../ft2_sysreqs.h"
 
-static uint8_t packedPattData[65536];
+static LOADER_THREAD_LOCAL uint8_t packedPattData[65536+4];
 
 /* ModPlug Tracker & OpenMPT supports up to 32 samples per instrument for XMs -  we don't.
 ** For such modules, we use a temporary array here to store the extra sample data lengths
 ** we need to skip to be able to load the file (we lose the extra samples, though...).
 */
-static uint32_t extraSampleLengths[32-MAX_SMP_PER_INST];
+static LOADER_THREAD_LOCAL uint32_t extraSampleLengths[32-MAX_SMP_PER_INST];
 
-static bool loadInstrHeader(FILE *f, uint16_t i);
-static bool loadInstrSample(FILE *f, uint16_t i);
-static void unpackPatt(uint8_t *dst, uint8_t *src, uint16_t len, int32_t antChn);
-static bool loadPatterns(FILE *f, uint16_t antPtn, uint16_t xmVersion);
-static void unpackPatt(uint8_t *dst, uint8_t *src, uint16_t len, int32_t antChn);
-static void loadADPCMSample(FILE *f, sample_t *s); // ModPlug Tracker
+static bool loadInstrHeader(LFILE *f, uint16_t i);
+static bool loadInstrSample(LFILE *f, uint16_t i);
+static bool loadPatterns(LFILE *f, uint16_t antPtn, uint16_t xmVersion, uint16_t antChn);
+static void unpackPatt(uint8_t *dst, uint8_t *src, uint16_t len, int32_t antChn, int32_t srcLen);
+static void loadADPCMSample(LFILE *f, sample_t *s); // ModPlug Tracker
 
-bool loadXM(FILE *f, uint32_t filesize)
+bool loadXM(LFILE *f, uint32_t filesize)
 {
 	xmHdr_t h;
 
@@ -38,7 +38,7 @@ bool loadXM(FILE *f, uint32_t filesize)
 		return false;
 	}
 
-	if (fread(&h, 1, sizeof (h), f) != sizeof (h))
+	if (lfread(&h, 1, sizeof (h), f) != sizeof (h))
 	{
 		loaderMsgBox("Error: This file is either not a module, or is not supported.");
 		return false;
@@ -74,8 +74,8 @@ bool loadXM(FILE *f, uint32_t filesize)
 		return false;
 	}
 
-	fseek(f, 60 + h.headerSize, SEEK_SET);
-	if (filesize != 336 && feof(f)) // 336 in length at this point = empty XM
+	lfseek(f, 60 + h.headerSize, SEEK_SET);
+	if (filesize != 336 && lfeof(f)) // 336 in length at this point = empty XM
 	{
 		loaderMsgBox("Error loading XM: The module is empty!");
 		return false;
@@ -86,7 +86,7 @@ bool loadXM(FILE *f, uint32_t filesize)
 
 	songTmp.songLength = h.numOrders;
 	songTmp.songLoopStart = h.songLoopStart;
-	songTmp.numChannels = (uint8_t)h.numChannels;
+	songTmp.numChannels = MIN(h.numChannels, MAX_CHANNELS); // patterns are allocated at this width
 	songTmp.BPM = h.BPM;
 	songTmp.speed = h.speed;
 	tmpLinearPeriodsFlag = h.flags & 1;
@@ -120,7 +120,7 @@ bool loadXM(FILE *f, uint32_t filesize)
 				return false;
 		}
 
-		if (!loadPatterns(f, h.numPatterns, h.version))
+		if (!loadPatterns(f, h.numPatterns, h.version, h.numChannels))
 			return false;
 
 		for (uint16_t i = 1; i <= h.numInstr; i++)
@@ -133,7 +133,7 @@ bool loadXM(FILE *f, uint32_t filesize)
 	{
 		// XM v1.04 (latest version)
 
-		if (!loadPatterns(f, h.numPatterns, h.version))
+		if (!loadPatterns(f, h.numPatterns, h.version, h.numChannels))
 			return false;
 
 		for (uint16_t i = 1; i <= h.numInstr; i++)
@@ -173,11 +173,8 @@ bool loadXM(FILE *f, uint32_t filesize)
 		}
 	}
 
-	if (songTmp.numChannels > MAX_CHANNELS)
-	{
-		songTmp.numChannels = MAX_CHANNELS;
-		loaderMsgBox("Warning: Module contains >32 channels. The extra channels will be discarded!");
-	}
+	if (h.numChannels > MAX_CHANNELS)
+		loaderMsgBox("Warning: Module contains >%d channels. The extra channels will be discarded!", MAX_CHANNELS);
 
 	if (h.numInstr > MAX_INST)
 		loaderMsgBox("Warning: Module contains >128 instruments. The extra instruments will be discarded!");
@@ -188,7 +185,7 @@ bool loadXM(FILE *f, uint32_t filesize)
 	return true;
 }
 
-static bool loadInstrHeader(FILE *f, uint16_t i)
+static bool loadInstrHeader(LFILE *f, uint16_t i)
 {
 	uint32_t readSize;
 	xmInsHdr_t ih;
@@ -199,8 +196,8 @@ static bool loadInstrHeader(FILE *f, uint16_t i)
 	memset(extraSampleLengths, 0, sizeof (extraSampleLengths));
 	memset(&ih, 0, sizeof (ih));
 
-	fread(&readSize, 4, 1, f);
-	fseek(f, -4, SEEK_CUR);
+	lfread(&readSize, 4, 1, f);
+	lfseek(f, -4, SEEK_CUR);
 
 	// yes, some XMs can have a header size of 0, and it usually means 263 bytes (INSTR_HEADER_SIZE)
 	if (readSize == 0 || readSize > INSTR_HEADER_SIZE)
@@ -212,11 +209,11 @@ static bool loadInstrHeader(FILE *f, uint16_t i)
 		return false;
 	}
 
-	fread(&ih, readSize, 1, f); // read instrument header
+	lfread(&ih, readSize, 1, f); // read instrument header
 
 	// FT2 bugfix: skip instrument header data if instrSize is above INSTR_HEADER_SIZE
 	if (ih.instrSize > INSTR_HEADER_SIZE)
-		fseek(f, ih.instrSize-INSTR_HEADER_SIZE, SEEK_CUR);
+		lfseek(f, ih.instrSize-INSTR_HEADER_SIZE, SEEK_CUR);
 
 	if (ih.numSamples < 0 || ih.numSamples > 32)
 	{
@@ -267,7 +264,7 @@ static bool loadInstrHeader(FILE *f, uint16_t i)
 		if (sampleHeadersToRead > MAX_SMP_PER_INST)
 			sampleHeadersToRead = MAX_SMP_PER_INST;
 
-		if (fread(ih.smp, sampleHeadersToRead * sizeof (xmSmpHdr_t), 1, f) != 1)
+		if (lfread(ih.smp, sampleHeadersToRead * sizeof (xmSmpHdr_t), 1, f) != 1)
 		{
 			loaderMsgBox("General I/O error during loading!");
 			return false;
@@ -279,8 +276,8 @@ static bool loadInstrHeader(FILE *f, uint16_t i)
 			const int32_t samplesToSkip = ih.numSamples-MAX_SMP_PER_INST;
 			for (int32_t j = 0; j < samplesToSkip; j++)
 			{
-				fread(&extraSampleLengths[j], 4, 1, f); // used for skipping data in loadInstrSample()
-				fseek(f, sizeof (xmSmpHdr_t)-4, SEEK_CUR);
+				lfread(&extraSampleLengths[j], 4, 1, f); // used for skipping data in loadInstrSample()
+				lfseek(f, sizeof (xmSmpHdr_t)-4, SEEK_CUR);
 			}
 		}
 
@@ -315,7 +312,7 @@ static bool loadInstrHeader(FILE *f, uint16_t i)
 	return true;
 }
 
-static bool loadInstrSample(FILE *f, uint16_t i)
+static bool loadInstrSample(LFILE *f, uint16_t i)
 {
 	if (instrTmp[i] == NULL)
 		return true; // empty instrument, let's just pretend it got loaded successfully
@@ -331,7 +328,7 @@ static bool loadInstrSample(FILE *f, uint16_t i)
 		for (uint16_t j = 0; j < k; j++, s++)
 		{
 			if (s->length > 0)
-				fseek(f, s->length, SEEK_CUR);
+				lfseek(f, s->length, SEEK_CUR);
 		}
 	}
 	else
@@ -363,23 +360,33 @@ static bool loadInstrSample(FILE *f, uint16_t i)
 				if (s->length > MAX_SAMPLE_LEN)
 					s->length = MAX_SAMPLE_LEN;
 
-				if (!allocateSmpData(s, s->length, sample16Bit))
+				if (tmpLoaderFlags & LOADER_SKIP_SAMPLE_DATA)
+				{
+					lfseek(f, adpcmSample ? 16 + ((s->length + 1) / 2) : lengthInFile, SEEK_CUR);
+
+					if (stereoSample) // same as after the downmixing below
+					{
+						s->length >>= 1;
+						s->loopStart >>= 1;
+						s->loopLength >>= 1;
+					}
+				}
+				else if (!allocateSmpData(s, s->length, sample16Bit))
 				{
 					loaderMsgBox("Not enough memory!");
 					return false;
 				}
-
-				if (adpcmSample)
+				else if (adpcmSample)
 				{
 					loadADPCMSample(f, s);
 				}
 				else
 				{
 					const int32_t sampleLengthInBytes = SAMPLE_LENGTH_BYTES(s);
-					fread(s->dataPtr, 1, sampleLengthInBytes, f);
+					lfread(s->dataPtr, 1, sampleLengthInBytes, f);
 
 					if (sampleLengthInBytes < lengthInFile)
-						fseek(f, lengthInFile-sampleLengthInBytes, SEEK_CUR);
+						lfseek(f, lengthInFile-sampleLengthInBytes, SEEK_CUR);
 
 					delta2Samp(s->dataPtr, s->length, s->flags);
 
@@ -407,14 +414,14 @@ static bool loadInstrSample(FILE *f, uint16_t i)
 		for (i = 0; i < samplesToSkip; i++)
 		{
 			if (extraSampleLengths[i] > 0)
-				fseek(f, extraSampleLengths[i], SEEK_CUR); 
+				lfseek(f, extraSampleLengths[i], SEEK_CUR); 
 		}
 	}
 
 	return true;
 }
 
-static bool loadPatterns(FILE *f, uint16_t antPtn, uint16_t xmVersion)
+static bool loadPatterns(LFILE *f, uint16_t antPtn, uint16_t xmVersion, uint16_t antChn)
 {
 	uint8_t tmpLen;
 	xmPatHdr_t ph;
@@ -422,43 +429,43 @@ static bool loadPatterns(FILE *f, uint16_t antPtn, uint16_t xmVersion)
 	bool pattLenWarn = false;
 	for (uint16_t i = 0; i < antPtn; i++)
 	{
-		if (fread(&ph.headerSize, 4, 1, f) != 1)
+		if (lfread(&ph.headerSize, 4, 1, f) != 1)
 			goto pattCorrupt;
 
-		if (fread(&ph.type, 1, 1, f) != 1)
+		if (lfread(&ph.type, 1, 1, f) != 1)
 			goto pattCorrupt;
 
 		ph.numRows = 0;
 		if (xmVersion == 0x0102)
 		{
-			if (fread(&tmpLen, 1, 1, f) != 1)
+			if (lfread(&tmpLen, 1, 1, f) != 1)
 				goto pattCorrupt;
 
-			if (fread(&ph.dataSize, 2, 1, f) != 1)
+			if (lfread(&ph.dataSize, 2, 1, f) != 1)
 				goto pattCorrupt;
 
 			ph.numRows = tmpLen + 1; // +1 in v1.02
 
 			if (ph.headerSize > 8)
-				fseek(f, ph.headerSize - 8, SEEK_CUR);
+				lfseek(f, ph.headerSize - 8, SEEK_CUR);
 		}
 		else
 		{
-			if (fread(&ph.numRows, 2, 1, f) != 1)
+			if (lfread(&ph.numRows, 2, 1, f) != 1)
 				goto pattCorrupt;
 
-			if (fread(&ph.dataSize, 2, 1, f) != 1)
+			if (lfread(&ph.dataSize, 2, 1, f) != 1)
 				goto pattCorrupt;
 
 			if (ph.headerSize > 9)
-				fseek(f, ph.headerSize - 9, SEEK_CUR);
+				lfseek(f, ph.headerSize - 9, SEEK_CUR);
 		}
 
-		if (feof(f))
+		if (lfeof(f))
 			goto pattCorrupt;
 
 		patternNumRowsTmp[i] = ph.numRows;
-		if (patternNumRowsTmp[i] > MAX_PATT_LEN)
+		if ((uint16_t)patternNumRowsTmp[i] > MAX_PATT_LEN) // unsigned in the file, don't let 32768+ go negative
 		{
 			patternNumRowsTmp[i] = MAX_PATT_LEN;
 			pattLenWarn = true;
@@ -466,17 +473,22 @@ static bool loadPatterns(FILE *f, uint16_t antPtn, uint16_t xmVersion)
 
 		if (ph.dataSize > 0)
 		{
+			if (tmpLoaderFlags & LOADER_SKIP_PATTERNS)
+			{
+				lfseek(f, ph.dataSize, SEEK_CUR); // the pattern keeps its length
+				continue;
+			}
+
 			if (!allocateTmpPatt(i, patternNumRowsTmp[i]))
 			{
 				loaderMsgBox("Not enough memory!");
 				return false;
 			}
 
-			if (fread(packedPattData, 1, ph.dataSize, f) != ph.dataSize)
+			if (lfread(packedPattData, 1, ph.dataSize, f) != ph.dataSize)
 				goto pattCorrupt;
 
-			unpackPatt((uint8_t *)patternTmp[i], packedPattData, patternNumRowsTmp[i], songTmp.numChannels);
-			clearUnusedChannels(patternTmp[i], patternNumRowsTmp[i], songTmp.numChannels);
+			unpackPatt((uint8_t *)patternTmp[i], packedPattData, patternNumRowsTmp[i], antChn, ph.dataSize);
 		}
 
 		if (tmpPatternEmpty(i))
@@ -501,26 +513,23 @@ pattCorrupt:
 	return false;
 }
 
-static void unpackPatt(uint8_t *dst, uint8_t *src, uint16_t len, int32_t antChn)
+static void unpackPatt(uint8_t *dst, uint8_t *src, uint16_t len, int32_t antChn, int32_t srcLen)
 {
 	int32_t j;
 
 	if (dst == NULL)
 		return;
 
-	const int32_t srcEnd = len * (sizeof (note_t) * antChn);
-	int32_t srcIdx = 0;
-
-	int32_t numChannels = antChn;
-	if (numChannels > MAX_CHANNELS)
-		numChannels = MAX_CHANNELS;
+	// stop at the end of the packed data (a note reads up to 5 bytes, packedPattData[] has room for that)
+	const uint8_t *srcEnd = src + srcLen;
 
-	const int32_t pitch = sizeof (note_t) * (MAX_CHANNELS - antChn);
+	// destination rows are songTmp.numChannels wide (the XM channel count, clamped to MAX_CHANNELS)
+	const int32_t numChannels = songTmp.numChannels;
 	for (int32_t i = 0; i < len; i++)
 	{
 		for (j = 0; j < numChannels; j++)
 		{
-			if (srcIdx >= srcEnd)
+			if (src >= srcEnd)
 				return; // error!
 
 			const uint8_t note = *src++;
@@ -540,14 +549,12 @@ static void unpackPatt(uint8_t *dst, uint8_t *src, uint16_t len, int32_t antChn)
 				*dst++ = *src++;
 				*dst++ = *src++;
 			}
-
-			srcIdx += sizeof (note_t);
 		}
 
-		// if more than 32 channels, skip rest of the channels for this row
+		// if more than MAX_CHANNELS channels, skip rest of the channels for this row
 		for (; j < antChn; j++)
 		{
-			if (srcIdx >= srcEnd)
+			if (src >= srcEnd)
 				return; // error!
 
 			const uint8_t note = *src++;
@@ -566,20 +573,15 @@ static void unpackPatt(uint8_t *dst, uint8_t *src, uint16_t len, int32_t antChn)
 				src++;
 				src++;
 			}
-
-			srcIdx += sizeof (note_t);
 		}
 
-		// if song has <32 channels, align pointer to next row (skip unused channels)
-		if (antChn < MAX_CHANNELS)
-			dst += pitch;
 	}
 }
 
-static void loadADPCMSample(FILE *f, sample_t *s) // ModPlug Tracker
+static void loadADPCMSample(LFILE *f, sample_t *s) // ModPlug Tracker
 {
 	int8_t deltaLUT[16];
-	fread(deltaLUT, 1, 16, f);
+	lfread(deltaLUT, 1, 16, f);
 
 	int8_t *dataPtr = s->dataPtr;
 	const int32_t dataLength = (s->length + 1) / 2;
@@ -587,7 +589,7 @@ static void loadADPCMSample(FILE *f, sample_t *s) // ModPlug Tracker
 	int8_t currSample = 0;
 	for (int32_t i = 0; i < dataLength; i++)
 	{
-		const uint8_t nibbles = (uint8_t)fgetc(f);
+		const uint8_t nibbles = (uint8_t)lfgetc(f);
 
 		currSample += deltaLUT[nibbles & 0x0F];
 		*dataPtr++ = currSample;
@@ -26,10 +26,10 @@
 
 static volatile bool scopesUpdatingFlag, scopesDisplayingFlag;
 static hpc_t scopeHpc;
-static volatile scope_t scope[MAX_CHANNELS];
+static volatile scope_t scope[MAX_XM_CHANNELS]; // the tracker never has more channels
 static SDL_Thread *scopeThread;
 
-lastChInstr_t lastChInstr[MAX_CHANNELS]; // global
+lastChInstr_t lastChInstr[MAX_XM_CHANNELS]; // global
 
 int32_t getSamplePosition(uint8_t ch)
 {
@@ -58,7 +58,7 @@ void stopAllScopes(void)
 	while (scopesUpdatingFlag);
 	
 	volatile scope_t *sc = scope;
-	for (int32_t i = 0; i < MAX_CHANNELS; i++, sc++)
+	for (int32_t i = 0; i < MAX_XM_CHANNELS; i++, sc++)
 		sc->active = false;
 
 	// wait for scope displaying to be done (safety)
@@ -68,25 +68,7 @@ void stopAllScopes(void)
 // toggle mute
 static void setChannel(int32_t chNr, bool on)
 {
-	channel_t *ch = &channel[chNr];
-
-	ch->channelOff = !on;
-	if (ch->channelOff)
-	{
-		ch->efx = 0;
-		ch->efxData = 0;
-		ch->realVol = 0;
-		ch->outVol = 0;
-		ch->oldVol = 0;
-		ch->dFinalVol = 0.0;
-		ch->outPan = 128;
-		ch->oldPan = 128;
-		ch->finalPan = 128;
-		ch->status = IS_Vol;
-
-		ch->keyOff = true; // non-FT2 bug fix for stuck piano keys
-	}
-
+	setChannelMute(&channel[chNr], !on);
 	scope[chNr].wasCleared = false;
 }
 
@@ -173,7 +155,7 @@ static void redrawScope(int32_t ch)
 
 void refreshScopes(void)
 {
-	for (int32_t i = 0; i < MAX_CHANNELS; i++)
+	for (int32_t i = 0; i < MAX_XM_CHANNELS; i++)
 		scope[i].wasCleared = false;
 }
 
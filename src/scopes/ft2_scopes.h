@@ -46,4 +46,4 @@ typedef struct lastChInstr_t
 	uint8_t smpNum, instrNum;
 } lastChInstr_t;
 
-extern lastChInstr_t lastChInstr[MAX_CHANNELS];
+extern lastChInstr_t lastChInstr[MAX_XM_CHANNELS];
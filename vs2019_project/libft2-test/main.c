@@ -1,24 +1,28 @@
 #include "../../libft2/libft2.h"
 
 int main(int argc, char* argv[]) {
-   //if (!libft2_startup()) {
-      if (!libft2_loadModule(L"D:/Downloads/Arpeggio.xm")) {
+   ft2_module_t* module = libft2_loadModule(L"D:/Downloads/Arpeggio.xm");
+   if (module != NULL) {
+      const song_t* song = libft2_getSong(module);
 
-         song;
-         instr;
-         pattern;
-         patternNumRows;
-         
-         //patterns = 0;
-         libft2_unloadModule();
-      }
+      int16_t numRows;
+      const note_t* pattern = libft2_getPattern(module, song->orders[0], &numRows);
+      const instr_t* instr = libft2_getInstr(module, 1);
+
+      (void)pattern;
+      (void)instr;
 
-      if (!libft2_loadModule(L"D:/Downloads/Arpeggio.xm")) {
-         int i = 'fuck';
-         i++;
+      ft2_player_t* player = libft2_createPlayer(module, 48000, LIBFT2_INTERPOLATION_SINC8);
+      if (player != NULL) {
+         static float buffer[1024 * 2];
+         while (libft2_renderPlayer(player, buffer, 1024) == 1024)
+            ;
 
-         libft2_unloadModule();
+         libft2_freePlayer(player);
       }
-      //libft2_shutdown();
-   //}
-}
\ No newline at end of file
+
+      libft2_unloadModule(module);
+   }
+
+   return 0;
+}